@@ -0,0 +1,539 @@
+/**
+*   @file    board_model.c
+*   @brief   RAM register models of the simulated board.
+*   @details Defines the register blocks the peripheral base pointers of a HOST_BUILD resolve
+*            to, their reset values and the side effects of the registers named by the hooks of
+*            core.h. The program flash of the user database, the data flash of the event log and
+*            the FlexRAM are byte arrays; the FTFC commands are executed on them at once, so
+*            CCIF reads set again right after the launch.
+*
+*            A trace opened with board_trace() receives every byte put on LPUART1, LPUART2 and
+*            LPI2C0, one line per burst: the virtual millisecond, the bus and direction (U1>
+*            sent on LPUART1, U2< received on LPUART2, I2C), then the bytes in hexadecimal,
+*            an I2C START as S and its address, a STOP as P.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clock_registers.h"
+#include "dwt_registers.h"
+#include "ftfc_registers.h"
+#include "gpio_registers.h"
+#include "i2c_registers.h"
+#include "lptmr_registers.h"
+#include "lpuart_registers.h"
+#include "nvic_registers.h"
+#include "pcc_registers.h"
+#include "port_registers.h"
+#include "rtc_registers.h"
+#include "scb_registers.h"
+#include "smc_registers.h"
+#include "systick_registers.h"
+#include "core.h"
+#include "flash.h"
+#include "userdb.h"
+#include "board_sim.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+/* Write access to a register the drivers see as read-only */
+#define SIM_REG(reg)            (*(volatile unsigned int *)(void *)&(reg))
+
+#define SCG_CSR_SCS_FIRC        (3U << 24)      /* System clock source out of reset */
+#define SCG_XCSR_VLD            (1U << 24)      /* Clock source valid */
+#define LPUART_STAT_RDRF        (1U << 21)
+#define LPUART_STAT_TC          (1U << 22)
+#define LPUART_STAT_TDRE        (1U << 23)
+#define LPI2C_MSR_TDF           (1U << 0)
+#define LPI2C_MSR_SDF           (1U << 9)
+#define LPI2C_MTDR_STOP         0x0200U         /* CMD field of a STOP */
+#define LPI2C_MTDR_START        0x0400U         /* CMD field of a START and address */
+#define SYST_CSR_COUNTFLAG      (1U << 16)
+#define RTC_SR_TIF              (1U << 0)       /* Set by the power-on reset */
+
+#define FTFC_DFLASH_BIT         0x800000U       /* FTFC address of the FlexNVM */
+#define FTFC_ERRORS             (FTFC_FSTAT_ACCERR | FTFC_FSTAT_FPVIOL | FTFC_FSTAT_RDCOLERR)
+#define PFLASH_SIZE             (USERDB_SECTORS * FLASH_PFLASH_SECTOR)
+#define FLEXRAM_SIZE            0x1000U
+
+/* Keypad on GPIOC: rows driven on PDOR 8-11, columns 1-4 read on PDIR 1, 2, 16, 15 */
+#define KEY_ROW_PIN(row)        (8U + (row))
+
+#define TRACE_LINE_ITEMS        16U             /* Bytes per line of a trace */
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static const unsigned char key_column_pin[4] = {1U, 2U, 16U, 15U};
+
+static unsigned char pflash[PFLASH_SIZE];
+static unsigned char dflash[FLASH_DFLASH_SIZE];
+static unsigned char flexram[FLEXRAM_SIZE];
+static unsigned char partitioned;
+static unsigned char fstat_errors;              /* Error flags of the last command, until cleared */
+
+static unsigned int key = BOARD_NO_KEY;
+static unsigned int lptmr_count;
+static unsigned char echo;
+
+static struct {
+    unsigned char byte[BOARD_RX_SIZE];
+    unsigned int at_ms[BOARD_RX_SIZE];
+    unsigned int head;
+    unsigned int tail;
+} rx[BOARD_UARTS];
+
+static board_traffic_t traffic;
+
+static FILE *trace;
+static const char *trace_bus;                   /* Bus of the line being written, 0 if none */
+static unsigned int trace_ms;
+static unsigned int trace_items;
+
+/*==================================================================================================
+*                                       GLOBAL VARIABLES
+==================================================================================================*/
+
+clock_type_t host_scg;
+dwt_type_t host_dwt;
+volatile unsigned int host_demcr;
+ftfc_type_t host_ftfc;
+GPIO_Type host_gpio[5];
+I2C_Type host_lpi2c[2];
+lptmr_type_t host_lptmr0;
+LPUART_t host_lpuart[3];
+NVIC_Type_t host_nvic;
+PCC_Type host_pcc;
+Port_Type host_port[5];
+RTC_Type host_rtc;
+scb_type_t host_scb;
+smc_type_t host_smc;
+pmc_type_t host_pmc;
+systick_type_t host_systick;
+unsigned int host_sim_lpoclks;
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+/* Flash bytes of a system address, 0 outside the modelled memories */
+static unsigned char *flash_bytes(unsigned int address, unsigned int size){
+    if((address >= USERDB_BASE) && (address - USERDB_BASE + size <= PFLASH_SIZE)){
+        return &pflash[address - USERDB_BASE];
+    }
+    if((address >= FLASH_DFLASH_BASE) && (address - FLASH_DFLASH_BASE + size <= FLASH_DFLASH_SIZE)){
+        return &dflash[address - FLASH_DFLASH_BASE];
+    }
+    if((address >= FLASH_FLEXRAM_BASE) && (address - FLASH_FLEXRAM_BASE + size <= FLEXRAM_SIZE)){
+        return &flexram[address - FLASH_FLEXRAM_BASE];
+    }
+    return 0;
+}
+
+/* Runs the command of the FCCOB registers, as launched by a write of CCIF */
+static void ftfc_execute(void){
+    unsigned int address = ((unsigned int)FTFC_FCCOB(1) << 16) | ((unsigned int)FTFC_FCCOB(2) << 8) | FTFC_FCCOB(3);
+    unsigned int sector = FLASH_PFLASH_SECTOR;
+    unsigned char *bytes;
+    unsigned int i;
+
+    if(address & FTFC_DFLASH_BIT){
+        address = FLASH_DFLASH_BASE + (address - FTFC_DFLASH_BIT);
+        sector = FLASH_DFLASH_SECTOR;
+    }
+    traffic.flash_commands++;
+    switch(FTFC_FCCOB(0)){
+    case FTFC_CMD_PROGRAM_PHRASE:
+        bytes = flash_bytes(address, FLASH_PHRASE_SIZE);
+        if((bytes == 0) || (address >= FLASH_FLEXRAM_BASE) || (address % FLASH_PHRASE_SIZE)){
+            fstat_errors |= FTFC_FSTAT_ACCERR;
+            break;
+        }
+        for(i = 0U; i < FLASH_PHRASE_SIZE; i++){
+            bytes[i] &= FTFC_FCCOB(4U + i);     /* Programming only clears bits */
+        }
+        break;
+    case FTFC_CMD_ERASE_SECTOR:
+        bytes = flash_bytes(address, sector);
+        if((bytes == 0) || (address >= FLASH_FLEXRAM_BASE) || (address % sector)){
+            fstat_errors |= FTFC_FSTAT_ACCERR;
+            break;
+        }
+        memset(bytes, 0xFF, sector);
+        break;
+    case FTFC_CMD_PROGRAM_PARTITION:
+        if(partitioned){
+            fstat_errors |= FTFC_FSTAT_ACCERR;
+        }
+        partitioned = 1U;
+        break;
+    case FTFC_CMD_SET_FLEXRAM:
+        if(FTFC_FCCOB(1) == FTFC_FLEXRAM_RAM){
+            host_ftfc.FCNFG = (unsigned char)((host_ftfc.FCNFG & ~FTFC_FCNFG_EEERDY) | FTFC_FCNFG_RAMRDY);
+        }else if(partitioned){
+            host_ftfc.FCNFG = (unsigned char)((host_ftfc.FCNFG & ~FTFC_FCNFG_RAMRDY) | FTFC_FCNFG_EEERDY);
+        }else{
+            fstat_errors |= FTFC_FSTAT_ACCERR;
+        }
+        break;
+    default:
+        fstat_errors |= FTFC_FSTAT_ACCERR;
+        break;
+    }
+}
+
+/* FSTAT write: the error flags are write 1 to clear, CCIF written 1 launches the command */
+static void ftfc_fstat_written(void){
+    unsigned char written = host_ftfc.FSTAT;
+
+    fstat_errors &= (unsigned char)~(written & FTFC_ERRORS);
+    if(written & FTFC_FSTAT_CCIF){
+        ftfc_execute();
+    }
+    host_ftfc.FSTAT = (unsigned char)(FTFC_FSTAT_CCIF | fstat_errors);
+}
+
+/* Ends the line of the trace being written */
+static void trace_flush(void){
+    if(trace_bus != 0){
+        fputc('\n', trace);
+        trace_bus = 0;
+    }
+}
+
+/* Appends a byte to the trace, as text */
+static void trace_item(const char *bus, const char *format, unsigned int value){
+    unsigned int now_ms = board_now_ms();
+
+    if(trace == 0){
+        return;
+    }
+    if((bus != trace_bus) || (now_ms != trace_ms) || (trace_items == TRACE_LINE_ITEMS)){
+        trace_flush();
+        fprintf(trace, "%7u %s", now_ms, bus);
+        trace_bus = bus;
+        trace_ms = now_ms;
+        trace_items = 0U;
+    }
+    fputc(' ', trace);
+    fprintf(trace, format, value);
+    trace_items++;
+}
+
+/* A byte written to the DATA register of an LPUART */
+static void uart_transmit(unsigned int uart){
+    unsigned char byte = (unsigned char)host_lpuart[uart].DATA_REGISTER;
+
+    traffic.uart_tx[uart]++;
+    trace_item((uart == BOARD_UART_CONSOLE) ? "U1>" : "U2>", "%02X", byte);
+    if(uart == BOARD_UART_SENSOR){
+        sensor_receive(byte);
+    }else if((uart == BOARD_UART_CONSOLE) && echo){
+        putchar((byte == '\r') ? '\n' : byte);
+    }
+}
+
+/* Column inputs of the keypad for the rows driven high */
+static unsigned int keypad_pdir(void){
+    unsigned int row;
+
+    if(key == BOARD_NO_KEY){
+        return 0U;
+    }
+    row = (key - 1U) / 4U;
+    if((GPIOC->PDOR & (1U << KEY_ROW_PIN(row))) == 0U){
+        return 0U;
+    }
+    return 1U << key_column_pin[(key - 1U) % 4U];
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Puts the registers and memories in their power-on state.
+ *
+ * @detail    The status flags the drivers poll are set ready: the clock sources valid, the
+ *            LPUART transmitters empty, the LPI2C stop detected, no flash command running.
+ *            The flash is blank and not partitioned, the RTC time invalid.
+ *
+ * @return    void
+ */
+void board_reset(void){
+    unsigned int uart;
+
+    memset(&host_scg, 0, sizeof(host_scg));
+    memset(&host_dwt, 0, sizeof(host_dwt));
+    memset(&host_ftfc, 0, sizeof(host_ftfc));
+    memset(host_gpio, 0, sizeof(host_gpio));
+    memset(host_lpi2c, 0, sizeof(host_lpi2c));
+    memset(&host_lptmr0, 0, sizeof(host_lptmr0));
+    memset(host_lpuart, 0, sizeof(host_lpuart));
+    memset(&host_nvic, 0, sizeof(host_nvic));
+    memset(&host_pcc, 0, sizeof(host_pcc));
+    memset(host_port, 0, sizeof(host_port));
+    memset(&host_rtc, 0, sizeof(host_rtc));
+    memset(&host_scb, 0, sizeof(host_scb));
+    memset(&host_smc, 0, sizeof(host_smc));
+    memset(&host_pmc, 0, sizeof(host_pmc));
+    memset(&host_systick, 0, sizeof(host_systick));
+    host_demcr = 0U;
+    host_sim_lpoclks = 0U;
+
+    SIM_REG(host_scg.SCG_CSR) = SCG_CSR_SCS_FIRC;
+    host_scg.SCG_SOSCCSR = SCG_XCSR_VLD;
+    host_scg.SCG_SIRCCSR = SCG_XCSR_VLD;
+    host_scg.SCG_FIRCCSR = SCG_XCSR_VLD;
+    host_scg.SCG_SPLLCSR = SCG_XCSR_VLD;
+    for(uart = 0U; uart < BOARD_UARTS; uart++){
+        SIM_REG(host_lpuart[uart].STAT) = LPUART_STAT_TDRE | LPUART_STAT_TC;
+        rx[uart].head = 0U;
+        rx[uart].tail = 0U;
+    }
+    host_lpi2c[0].MSR_REGISTER = LPI2C_MSR_TDF | LPI2C_MSR_SDF;
+    host_ftfc.FSTAT = FTFC_FSTAT_CCIF;
+    SIM_REG(host_systick.SYST_CSR_Register) = SYST_CSR_COUNTFLAG;
+    host_rtc.SR = RTC_SR_TIF;
+
+    memset(pflash, 0xFF, sizeof(pflash));
+    memset(dflash, 0xFF, sizeof(dflash));
+    memset(flexram, 0xFF, sizeof(flexram));
+    partitioned = 0U;
+    fstat_errors = 0U;
+    key = BOARD_NO_KEY;
+    lptmr_count = 0U;
+    memset(&traffic, 0, sizeof(traffic));
+}
+
+/*!
+ * @brief     Presses a key of the keypad, or releases it.
+ *
+ * @param[in]  position Key position 1-16, BOARD_NO_KEY to release.
+ * @return    void
+ */
+void board_set_key(unsigned int position){
+    key = position;
+}
+
+/*!
+ * @brief     Makes the board a device whose FlexNVM is partitioned and whose EEPROM emulation
+ *            holds data, as after a previous life.
+ *
+ * @detail    The FlexRAM is loaded from the EEE backup at reset, so it reads as EEPROM at once.
+ *
+ * @param[in]  offset Offset of the data in the FlexRAM.
+ * @param[in]  data The data.
+ * @param[in]  size Its size.
+ * @return    void
+ */
+void board_eee_load(unsigned int offset, const unsigned char *data, unsigned int size){
+    partitioned = 1U;
+    host_ftfc.FCNFG = (unsigned char)((host_ftfc.FCNFG & ~FTFC_FCNFG_RAMRDY) | FTFC_FCNFG_EEERDY);
+    memcpy(&flexram[offset], data, size);
+}
+
+/*!
+ * @brief     Sets the LPTMR0 counter read back by the latch write of CNR.
+ *
+ * @param[in]  count Counts since the timer was enabled.
+ * @return    void
+ */
+void board_lptmr_count(unsigned int count){
+    lptmr_count = count;
+    host_lptmr0.CNR = count;
+}
+
+/*!
+ * @brief     Queues bytes that an LPUART receives.
+ *
+ * @param[in]  uart LPUART instance.
+ * @param[in]  at_ms Virtual time at which the first byte is on the line.
+ * @param[in]  bytes The bytes.
+ * @param[in]  count Number of bytes.
+ * @return    void
+ */
+void board_uart_queue(unsigned int uart, unsigned int at_ms, const unsigned char *bytes, unsigned int count){
+    unsigned int i;
+    unsigned int next;
+
+    for(i = 0U; i < count; i++){
+        next = (rx[uart].head + 1U) % BOARD_RX_SIZE;
+        if(next == rx[uart].tail){
+            fprintf(stderr, "board sim: LPUART%u receive queue full\n", uart);
+            exit(2);
+        }
+        rx[uart].byte[rx[uart].head] = bytes[i];
+        rx[uart].at_ms[rx[uart].head] = at_ms;
+        rx[uart].head = next;
+    }
+}
+
+/*!
+ * @brief     Tells whether a queued byte is on the line.
+ *
+ * @param[in]  uart LPUART instance.
+ * @param[in]  now_ms Virtual time.
+ * @return    1 if a byte can be received, 0 otherwise.
+ */
+unsigned char board_uart_pending(unsigned int uart, unsigned int now_ms){
+    return ((rx[uart].tail != rx[uart].head) && ((int)(now_ms - rx[uart].at_ms[rx[uart].tail]) >= 0)) ? 1U : 0U;
+}
+
+/*!
+ * @brief     Loads the next queued byte in the receive registers.
+ *
+ * @detail    DATA holds the byte and RDRF is set until the interrupt handler has run; the
+ *            caller clears it with board_uart_taken().
+ *
+ * @param[in]  uart LPUART instance.
+ * @return    The byte.
+ */
+unsigned char board_uart_take(unsigned int uart){
+    unsigned char byte = rx[uart].byte[rx[uart].tail];
+
+    rx[uart].tail = (rx[uart].tail + 1U) % BOARD_RX_SIZE;
+    host_lpuart[uart].DATA_REGISTER = byte;
+    SIM_REG(host_lpuart[uart].STAT) |= LPUART_STAT_RDRF;
+    traffic.uart_rx[uart]++;
+    trace_item((uart == BOARD_UART_CONSOLE) ? "U1<" : "U2<", "%02X", byte);
+    return byte;
+}
+
+/*!
+ * @brief     Discards the next queued byte, lost by the receiver.
+ *
+ * @param[in]  uart LPUART instance.
+ * @return    void
+ */
+void board_uart_drop(unsigned int uart){
+    rx[uart].tail = (rx[uart].tail + 1U) % BOARD_RX_SIZE;
+}
+
+/*!
+ * @brief     Clears RDRF once the received byte has been read.
+ *
+ * @param[in]  uart LPUART instance.
+ * @return    void
+ */
+void board_uart_taken(unsigned int uart){
+    SIM_REG(host_lpuart[uart].STAT) &= ~LPUART_STAT_RDRF;
+}
+
+/*!
+ * @brief     Reads the bus traffic since the reset.
+ *
+ * @param[out] traffic_out Traffic counters.
+ * @return    void
+ */
+void board_get_traffic(board_traffic_t *traffic_out){
+    *traffic_out = traffic;
+}
+
+/*!
+ * @brief     Copies the console output to stdout, or stops doing so.
+ *
+ * @param[in]  on 1 to copy.
+ * @return    void
+ */
+void board_set_echo(unsigned char on){
+    echo = on;
+}
+
+/*!
+ * @brief     Writes the bus traffic to a trace file from now on, or stops doing so.
+ *
+ * @param[in]  out Trace file, 0 to stop.
+ * @return    void
+ */
+void board_trace(FILE *out){
+    if(trace != 0){
+        trace_flush();
+    }
+    trace = out;
+    trace_bus = 0;
+}
+
+/*!
+ * @brief     Maps a flash or FlexRAM address to the simulated memory, see FLASH_MAP().
+ *
+ * @param[in]  address System address.
+ * @return    The simulated byte; the program stops on an address outside the memories.
+ */
+const unsigned char *host_flash_map(unsigned int address){
+    const unsigned char *bytes = flash_bytes(address, 1U);
+
+    if(bytes == 0){
+        fprintf(stderr, "board sim: access outside the flash model: 0x%08X\n", address);
+        exit(2);
+    }
+    return bytes;
+}
+
+/*!
+ * @brief     Side effect of a register write, see CORE_REG_WRITTEN().
+ *
+ * @param[in]  reg The register written.
+ * @return    void
+ */
+void host_reg_written(volatile void *reg){
+    unsigned int uart;
+    unsigned int word;
+
+    for(uart = 0U; uart < BOARD_UARTS; uart++){
+        if(reg == &host_lpuart[uart].DATA_REGISTER){
+            uart_transmit(uart);
+            return;
+        }
+    }
+    if(reg == &host_lpi2c[0].MTDR_REGISTER){
+        word = host_lpi2c[0].MTDR_REGISTER;
+        traffic.i2c_words++;
+        traffic.i2c_last_ms = board_now_ms();
+        if(word == LPI2C_MTDR_STOP){
+            traffic.i2c_stops++;
+            host_lpi2c[0].MSR_REGISTER |= LPI2C_MSR_SDF;
+            trace_item("I2C", "P", 0U);
+        }else{
+            traffic.i2c_bytes++;
+            trace_item("I2C", (word & LPI2C_MTDR_START) ? "S%02X" : "%02X", word & 0xFFU);
+        }
+    }else if(reg == &host_scg.SCG_RCCR){
+        SIM_REG(host_scg.SCG_CSR) = host_scg.SCG_RCCR;
+        traffic.clock_switches++;
+    }else if(reg == &host_ftfc.FSTAT){
+        ftfc_fstat_written();
+    }else if(reg == &host_lptmr0.CNR){
+        host_lptmr0.CNR = lptmr_count;
+    }else if((reg >= (volatile void *)flexram) && (reg < (volatile void *)&flexram[FLEXRAM_SIZE])){
+        if(host_ftfc.FCNFG & FTFC_FCNFG_EEERDY){
+            traffic.eee_writes++;
+        }
+        host_ftfc.FSTAT = (unsigned char)(FTFC_FSTAT_CCIF | fstat_errors);
+    }
+}
+
+/*!
+ * @brief     Updates a register before it is read, see CORE_REG_READ().
+ *
+ * @detail    PDIR of GPIOC follows the keypad. The SysTick current value is read by the busy
+ *            waits of delay(): one millisecond of virtual time passes per read.
+ *
+ * @param[in]  reg The register about to be read.
+ * @return    void
+ */
+void host_reg_read(const volatile void *reg){
+    if(reg == &GPIOC->PDIR){
+        SIM_REG(GPIOC->PDIR) = keypad_pdir();
+    }else if(reg == &host_systick.SYST_CVR_Register){
+        board_spin();
+    }
+}
@@ -0,0 +1,711 @@
+/**
+*   @file    board_sim.c
+*   @brief   Runs the whole firmware as a native process on the simulated board.
+*   @details main.c is compiled with its main() renamed firmware_main() and linked with every
+*            driver of src/ and the host port of the kernel; the register models and the sensor
+*            model are in board_model.c and sensor_model.c. Virtual time advances one
+*            millisecond per step while the firmware sleeps or waits, and each step raises the
+*            interrupts due in it. The default scenario touches the sensor with an enrolled
+*            finger, sends an admin command on the console and touches it with an unknown
+*            finger. At the end of the run the program checks the outcome and prints the bus
+*            traffic and the host time taken.
+*
+*            The other scenarios are the flows of the bus traffic benchmark (make bench): the
+*            idle clock, an identification granted and one refused, an enrollment and the entry
+*            of a name. Each measures a window that starts once the board has booted: the bytes
+*            put on LPUART1, LPUART2 and LPI2C0, and the virtual time until the display settles
+*            (the last LCD write of the window). The enroll_hot flow, outside the benchmark,
+*            sends an enrollment ID that falls on a hot page of a 64 page library.
+*            With -t the traffic of the window is written as a trace (see board_trace()); with
+*            -b the totals are checked against the budgets of a file, one line per flow:
+*            name, LCD bytes, LPUART1 bytes, LPUART2 bytes (both directions), milliseconds.
+*
+*            Usage: board_sim [-v] [-f flow] [-t trace] [-b budgets] [-d dump] [seconds]; -v
+*            copies the console output to stdout, -d writes the trace ring of the firmware at the
+*            end of the run as ADMIN_CMD_TRACE sends it (see trace.h, host/trace_decode).
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "clock.h"
+#include "power.h"
+#include "latency.h"
+#include "users.h"
+#include "access.h"
+#include "trace.h"
+#include "hotset.h"
+#include "dwt_registers.h"
+#include "ftfc_registers.h"
+#include "gpio_registers.h"
+#include "lptmr_registers.h"
+#include "lpuart_registers.h"
+#include "port_registers.h"
+#include "rtc_registers.h"
+#include "scb_registers.h"
+#include "systick_registers.h"
+#include "host_port.h"
+#include "board_sim.h"
+#include "check.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define RUN_MS                  12000U          /* Default length of the run */
+#define FLOW_START_MS           3000U           /* Benchmark window, once the board has booted */
+#define UART_BYTES_PER_MS       5U              /* 57600 baud */
+#define LOCK_PIN                1U              /* GPIOD, low while the door is open */
+#define TOUCH_PIN               3U              /* PORTC, touch output of the sensor */
+#define FINGER_ENROLLED         3U              /* On page 3 of the sensor library */
+#define FINGER_UNKNOWN          42U
+#define FINGER_NEW              7U
+#define ENROLL_ID               10U             /* ID byte of the console enrollment */
+#define SIM_ENROLLED            5U              /* Fingers 1-5 in the sensor library at power-up */
+#define HOT_LIBRARY_PAGES       64U             /* User pages 1-48, hot pages 49-63 */
+#define HOT_PAGE                50U             /* Holds FINGER_ENROLLED, also an enrollment ID */
+#define KEY_HOLD_MS             200U            /* A keypad scan period */
+
+/* Keypad positions of the name entry, see keytap_character_mode() */
+#define KEY_MODE                4U
+#define KEY_AB                  1U
+#define KEY_HI                  5U
+#define KEY_DONE                15U
+
+#define CONSOLE_WAKE            0xFFU           /* Dummy byte that wakes the board */
+
+/* Frames of console_frames */
+#define CONSOLE_GET_TIME        0U
+#define CONSOLE_ENROLL          1U
+#define CONSOLE_SET_TIME        2U
+#define CONSOLE_ENROLL_HOT      3U
+
+#define RTC_SR_TAF              (1U << 2)
+#define RTC_SR_TCE              (1U << 4)
+#define RTC_IER_TAIE            (1U << 2)
+#define RTC_IER_TSIE            (1U << 4)
+
+#define STIMULI(array)          (sizeof(array) / sizeof((array)[0]))
+#define ENROLL_STIMULI          5U              /* Of enroll_stimuli, before the keys */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+typedef enum {
+    STIMULUS_TOUCH,                             /* Finger arg on the sensor, touch line edge */
+    STIMULUS_LIFT,                              /* Finger removed */
+    STIMULUS_CONSOLE,                           /* Frame arg of console_frames */
+    STIMULUS_KEY                                /* Key arg pressed for KEY_HOLD_MS */
+} stimulus_kind_t;
+
+typedef struct {
+    unsigned int at_ms;
+    stimulus_kind_t kind;
+    unsigned int arg;
+} stimulus_t;
+
+typedef struct {
+    const unsigned char *bytes;
+    unsigned int count;
+} console_frame_t;
+
+typedef struct {
+    const char *name;
+    const stimulus_t *stimuli;
+    unsigned int stimulus_count;
+    unsigned int start_ms;                      /* Start of the measured window */
+    unsigned int end_ms;                        /* End of the run */
+    void (*check)(void);                        /* Checks the outcome */
+    void (*setup)(void);                        /* Prepares the sensor, 0 for the default one */
+} flow_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+/* main.c, its main() renamed by the Makefile, and its interrupt handlers */
+int firmware_main();
+void SysTick_Handler(void);
+void LPUART1_RxTx_IRQHandler(void);
+void LPUART2_RxTx_IRQHandler(void);
+void RTC_Seconds_IRQHandler(void);
+void RTC_IRQHandler(void);
+void FTFC_IRQHandler(void);
+void PORTC_IRQHandler(void);
+void LPTMR0_IRQHandler(void);
+
+/* Outcome checks of the flows */
+static void demo_check(void);
+static void idle_check(void);
+static void identify_ok_check(void);
+static void identify_fail_check(void);
+static void enroll_check(void);
+static void name_entry_check(void);
+static void enroll_hot_check(void);
+static void hot_library_setup(void);
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+/* Admin frame GET_TIME: 99, CMD, LEN, CSUM; each frame starts with the byte lost in VLPS */
+static const unsigned char console_get_time[5] = {CONSOLE_WAKE, 99U, 0x02U, 0x00U, 0x02U};
+/* Enrollment under an ID */
+static const unsigned char console_enroll[2] = {CONSOLE_WAKE, ENROLL_ID};
+/* Admin frame SET_TIME to 2026-01-01 08:59:50, the idle window crosses the hour */
+static const unsigned char console_set_time[9] = {CONSOLE_WAKE, 99U, 0x01U, 0x04U, 0x69U, 0x56U, 0x37U, 0x86U, 0x81U};
+/* Enrollment under the ID of a hot page */
+static const unsigned char console_enroll_hot[2] = {CONSOLE_WAKE, HOT_PAGE};
+
+static const console_frame_t console_frames[] = {
+    {console_get_time, sizeof(console_get_time)},
+    {console_enroll, sizeof(console_enroll)},
+    {console_set_time, sizeof(console_set_time)},
+    {console_enroll_hot, sizeof(console_enroll_hot)},
+};
+
+static const stimulus_t demo_stimuli[] = {
+    {3000U, STIMULUS_TOUCH, FINGER_ENROLLED},
+    {3800U, STIMULUS_LIFT, 0U},
+    {6000U, STIMULUS_CONSOLE, CONSOLE_GET_TIME},
+    {8000U, STIMULUS_TOUCH, FINGER_UNKNOWN},
+    {8800U, STIMULUS_LIFT, 0U},
+};
+
+static const stimulus_t idle_stimuli[] = {
+    {1000U, STIMULUS_CONSOLE, CONSOLE_SET_TIME},
+};
+
+static const stimulus_t identify_ok_stimuli[] = {
+    {3000U, STIMULUS_TOUCH, FINGER_ENROLLED},
+    {3800U, STIMULUS_LIFT, 0U},
+};
+
+static const stimulus_t identify_fail_stimuli[] = {
+    {3000U, STIMULUS_TOUCH, FINGER_UNKNOWN},
+    {3800U, STIMULUS_LIFT, 0U},
+};
+
+/* The name entry flow enrolls first, its window starts with the keys */
+static const stimulus_t enroll_stimuli[] = {
+    {3000U, STIMULUS_CONSOLE, CONSOLE_ENROLL},
+    {3200U, STIMULUS_TOUCH, FINGER_NEW},
+    {3700U, STIMULUS_LIFT, 0U},
+    {4200U, STIMULUS_TOUCH, FINGER_NEW},
+    {4700U, STIMULUS_LIFT, 0U},
+    {6000U, STIMULUS_KEY, KEY_MODE},
+    {7000U, STIMULUS_KEY, KEY_AB},
+    {8000U, STIMULUS_KEY, KEY_HI},
+    {9000U, STIMULUS_KEY, KEY_DONE},
+};
+
+/* The new finger is presented twice as for an enrollment, then once more to be searched */
+static const stimulus_t enroll_hot_stimuli[] = {
+    {3000U, STIMULUS_CONSOLE, CONSOLE_ENROLL_HOT},
+    {3200U, STIMULUS_TOUCH, FINGER_NEW},
+    {3700U, STIMULUS_LIFT, 0U},
+    {4200U, STIMULUS_TOUCH, FINGER_NEW},
+    {4700U, STIMULUS_LIFT, 0U},
+    {6000U, STIMULUS_TOUCH, FINGER_NEW},
+    {6800U, STIMULUS_LIFT, 0U},
+};
+
+static const flow_t flows[] = {
+    {"demo", demo_stimuli, STIMULI(demo_stimuli), 0U, RUN_MS, demo_check, 0},
+    {"idle", idle_stimuli, STIMULI(idle_stimuli), FLOW_START_MS, 13000U, idle_check, 0},
+    {"identify_ok", identify_ok_stimuli, STIMULI(identify_ok_stimuli), FLOW_START_MS, 8000U, identify_ok_check, 0},
+    {"identify_fail", identify_fail_stimuli, STIMULI(identify_fail_stimuli), FLOW_START_MS, 8000U, identify_fail_check, 0},
+    {"enroll", enroll_stimuli, ENROLL_STIMULI, FLOW_START_MS, 6000U, enroll_check, 0},
+    {"name_entry", enroll_stimuli, STIMULI(enroll_stimuli), 6000U, 12000U, name_entry_check, 0},
+    {"enroll_hot", enroll_hot_stimuli, STIMULI(enroll_hot_stimuli), FLOW_START_MS, 9000U, enroll_hot_check,
+     hot_library_setup},
+};
+
+static const flow_t *flow = &flows[0];
+static unsigned int now_ms = 0U;
+static unsigned int end_ms;
+static unsigned int window_open = 0U;
+static board_traffic_t window_start;
+static FILE *trace_file;
+static const char *budgets_path;
+static const char *dump_path;
+static unsigned int key_release_ms;
+static unsigned int console_edge = 0U;          /* LPUART1 woke the board from VLPS */
+static unsigned int next_stimulus = 0U;
+static unsigned int next_second_ms = 1000U;
+static unsigned int touch_ms;
+static unsigned int unlocks = 0U;
+static unsigned int unlock_latency_ms = 0U;
+static unsigned int lock_pin_was = 0U;
+static unsigned int wfi_steps = 0U;
+static unsigned int vlps_steps = 0U;
+static unsigned int interrupts = 0U;
+static struct timespec host_start;
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+/* Runs an interrupt handler as the core would */
+static void board_irq(void (*handler)(void)){
+    interrupts++;
+    host_isr_enter();
+    handler();
+    host_isr_exit();
+}
+
+/* Delivers the bytes on the receive line of an LPUART, 1 if there were some */
+static unsigned int board_uart_receive(unsigned int uart, void (*handler)(void)){
+    unsigned int count = 0U;
+
+    while((count < UART_BYTES_PER_MS) && board_uart_pending(uart, now_ms)){
+        (void)board_uart_take(uart);
+        board_irq(handler);
+        board_uart_taken(uart);
+        count++;
+    }
+    return (count != 0U) ? 1U : 0U;
+}
+
+/* Applies the stimuli due now, 1 if there were some */
+static unsigned int board_stimulate(void){
+    unsigned int woken = 0U;
+    const stimulus_t *stimulus;
+
+    if((key_release_ms != 0U) && (now_ms >= key_release_ms)){
+        board_set_key(BOARD_NO_KEY);
+        key_release_ms = 0U;
+    }
+    while((next_stimulus < flow->stimulus_count) && (flow->stimuli[next_stimulus].at_ms <= now_ms)){
+        stimulus = &flow->stimuli[next_stimulus++];
+        switch(stimulus->kind){
+        case STIMULUS_TOUCH:
+            sensor_set_finger(stimulus->arg);
+            touch_ms = now_ms;
+            PORTC->ISFR |= 1U << TOUCH_PIN;
+            board_irq(PORTC_IRQHandler);
+            PORTC->ISFR = 0U;
+            break;
+        case STIMULUS_LIFT:
+            sensor_set_finger(BOARD_NO_FINGER);
+            break;
+        case STIMULUS_CONSOLE:
+            board_uart_queue(BOARD_UART_CONSOLE, now_ms, console_frames[stimulus->arg].bytes,
+                             console_frames[stimulus->arg].count);
+            break;
+        case STIMULUS_KEY:
+            board_set_key(stimulus->arg);
+            key_release_ms = now_ms + KEY_HOLD_MS;
+            break;
+        }
+        woken = 1U;
+    }
+    return woken;
+}
+
+/* Counts the falling edges of the lock output */
+static void board_watch_lock(void){
+    unsigned int pin = GPIOD->PDOR & (1U << LOCK_PIN);
+
+    if(lock_pin_was && !pin){
+        if(unlocks++ == 0U){
+            unlock_latency_ms = now_ms - touch_ms;
+        }
+    }
+    lock_pin_was = pin;
+}
+
+/* The RTC counts a second: seconds interrupt, then the alarm if it is due */
+static unsigned int board_rtc_second(void){
+    unsigned int woken = 0U;
+
+    if((RTC->SR & RTC_SR_TCE) == 0U){
+        return 0U;
+    }
+    RTC->TSR++;
+    if(RTC->IER & RTC_IER_TSIE){
+        board_irq(RTC_Seconds_IRQHandler);
+        woken = 1U;
+    }
+    if((RTC->IER & RTC_IER_TAIE) && (RTC->TSR >= RTC->TAR)){
+        RTC->SR |= RTC_SR_TAF;
+        board_irq(RTC_IRQHandler);
+        RTC->SR &= ~RTC_SR_TAF;
+        woken = 1U;
+    }
+    return woken;
+}
+
+static void board_finish(void);
+
+/*!
+ * @brief     Advances the virtual time by one millisecond.
+ *
+ * @detail    In run mode SysTick counts and the LPUARTs receive. In VLPS the core clock and
+ *            LPUART2 are stopped, and the LPUART1 receiver waits for an edge: the first byte
+ *            arriving on the console wakes the board and is lost, the next ones are received.
+ *
+ * @param[in]  running 0 in VLPS, 1 otherwise.
+ * @return    1 if an interrupt or a stimulus should end a VLPS sleep, 0 otherwise.
+ */
+static unsigned int board_step(unsigned int running){
+    unsigned int woken = 0U;
+
+    now_ms++;
+    if(running){
+        DWT->CYCCNT += Clock_GetCoreFreq() / 1000U;
+        if(SYSTICK->SYST_CSR.ENABLE && SYSTICK->SYST_CSR.TICKINT){
+            SYSTICK->SYST_CVR.CURRENT = SYSTICK->SYST_RVR.RELOAD;   /* Taken as the counter reloads */
+            board_irq(SysTick_Handler);
+        }
+        woken |= board_uart_receive(BOARD_UART_CONSOLE, LPUART1_RxTx_IRQHandler);
+        woken |= board_uart_receive(BOARD_UART_SENSOR, LPUART2_RxTx_IRQHandler);
+        console_edge = 0U;
+    }else if(console_edge){
+        woken |= board_uart_receive(BOARD_UART_CONSOLE, LPUART1_RxTx_IRQHandler);
+    }else if(board_uart_pending(BOARD_UART_CONSOLE, now_ms)){
+        board_uart_drop(BOARD_UART_CONSOLE);
+        console_edge = 1U;
+        woken = 1U;
+    }
+    if(now_ms >= next_second_ms){
+        next_second_ms += 1000U;
+        woken |= board_rtc_second();
+    }
+    if((FTFC->FCNFG & FTFC_FCNFG_CCIE) && (FTFC->FSTAT & FTFC_FSTAT_CCIF)){
+        board_irq(FTFC_IRQHandler);
+        woken = 1U;
+    }
+    if(!window_open && (now_ms >= flow->start_ms)){
+        window_open = 1U;
+        board_get_traffic(&window_start);
+        board_trace(trace_file);
+    }
+    woken |= board_stimulate();
+    board_watch_lock();
+    if(now_ms >= end_ms){
+        board_finish();
+    }
+    return woken;
+}
+
+/*!
+ * @brief     Sleeps in VLPS until LPTMR0 or another interrupt wakes the board.
+ *
+ * @return    void
+ */
+static void board_vlps(void){
+    unsigned int count = 0U;
+    unsigned int woken = 0U;
+
+    while(!woken){
+        count++;
+        vlps_steps++;
+        woken = board_step(0U);
+        if(LPTMR0->CSR.TEN && (count >= LPTMR0->CMR + 1U)){
+            LPTMR0->CSR.TCF = 1;
+            if(LPTMR0->CSR.TIE){
+                board_irq(LPTMR0_IRQHandler);
+            }
+            woken = 1U;
+        }
+    }
+    board_lptmr_count(count);
+}
+
+/* Number of records of an event in the trace ring, of one arg0 unless arg0 is TRACE_ANY */
+#define TRACE_ANY               0x100U
+static unsigned int trace_held(unsigned char event, unsigned int arg0){
+    trace_record_t record;
+    unsigned int held = 0U;
+    unsigned int i;
+
+    for(i = 0U; i < Trace_Count(); i++){
+        Trace_Get(i, &record);
+        if((record.event == event) && ((arg0 == TRACE_ANY) || (record.arg0 == arg0))){
+            held++;
+        }
+    }
+    return held;
+}
+
+static void demo_check(void){
+    board_traffic_t traffic;
+    power_stats_t power;
+    latency_report_t total;
+
+    board_get_traffic(&traffic);
+    Power_GetStats(&power);
+    Latency_GetReport(LATENCY_TOTAL, &total);
+    CHECK("sensor handshake retried until the sensor boots", sensor_instructions(0x0FU) == 1U);
+    CHECK("enrolled finger searched and unlocks once", unlocks == 1U);
+    CHECK("  touch to unlock under 500 ms", (unlock_latency_ms > 0U) && (unlock_latency_ms < 500U));
+    CHECK("unknown finger searched, door stays locked", (sensor_instructions(0x04U) >= 2U) && (unlocks == 1U));
+    CHECK("identification recorded by the latency tracker", total.count == 1U);
+    CHECK("console admin frame received", traffic.uart_rx[BOARD_UART_CONSOLE] == sizeof(console_get_time) - 1U);
+    CHECK("LCD written over LPI2C0", traffic.i2c_stops > 0U);
+    CHECK("event log programmed to the FlexNVM", traffic.flash_commands > 0U);
+    CHECK("board idles in VLPS between the events", (power.vlps_count > 0U) && (vlps_steps > end_ms / 2U));
+    CHECK("saved schedules restored, others never",
+          (Access_GetUserSchedule(1U) == ACCESS_SCHEDULE_ALWAYS) &&
+          (Access_GetUserSchedule(SIM_ENROLLED + 1U) == ACCESS_SCHEDULE_NEVER));
+    CHECK("boot, sensor commands and unlock traced",
+          (trace_held(TRACE_BOOT, TRACE_ANY) == 1U) && (trace_held(TRACE_LOCK, TRACE_LOCK_OPEN) == 1U) &&
+          (trace_held(TRACE_FP_COMMAND, TRACE_ANY) == sensor_commands() + trace_held(TRACE_FP_TIMEOUT, TRACE_ANY)));
+}
+
+static void idle_check(void){
+    board_traffic_t traffic;
+
+    board_get_traffic(&traffic);
+    CHECK("clock refreshed on the LCD", traffic.i2c_stops > window_start.i2c_stops);
+    CHECK("door stays locked", unlocks == 0U);
+}
+
+static void identify_ok_check(void){
+    CHECK("enrolled finger unlocks once", unlocks == 1U);
+}
+
+static void identify_fail_check(void){
+    CHECK("unknown finger searched", sensor_instructions(0x04U) + sensor_instructions(0x1BU) >= 1U);
+    CHECK("door stays locked", unlocks == 0U);
+}
+
+static void enroll_check(void){
+    CHECK("two images merged and stored", (sensor_instructions(0x05U) == 1U) && (sensor_instructions(0x06U) == 1U));
+    CHECK("switches to enrollment and to name entry traced", trace_held(TRACE_FINGER_MODE, TRACE_ANY) >= 2U);
+    CHECK("new user may always enter, schedule saved", (Access_GetUserSchedule(ENROLL_ID) == ACCESS_SCHEDULE_ALWAYS) &&
+          (Users_GetSchedule(ENROLL_ID) == ACCESS_SCHEDULE_ALWAYS));
+}
+
+static void name_entry_check(void){
+    char name[USERS_NAME_LENGTH];
+
+    Users_GetName(ENROLL_ID, name);
+    CHECK("name typed on the keypad saved", memcmp(name, "AH", 3U) == 0);
+    CHECK("key taps traced", trace_held(TRACE_KEY, TRACE_ANY) > 0U);
+}
+
+static void enroll_hot_check(void){
+    CHECK("enrollment under a hot page refused", sensor_instructions(0x06U) == 0U);
+    CHECK("hot page keeps the template of its user", sensor_get_page(HOT_PAGE) == FINGER_ENROLLED);
+    CHECK("new finger not taken for the hot user",
+          (sensor_instructions(0x04U) + sensor_instructions(0x1BU) >= 1U) && (unlocks == 0U));
+}
+
+/* A library of HOT_LIBRARY_PAGES whose hot page HOT_PAGE holds FINGER_ENROLLED */
+static void hot_library_setup(void){
+    unsigned char map[HOTSET_MAP_SIZE];
+
+    sensor_set_pages(HOT_LIBRARY_PAGES);
+    sensor_set_page(HOT_PAGE, FINGER_ENROLLED);
+    HotSet_Init();
+    HotSet_SetSlot(HOT_PAGE - (HOT_LIBRARY_PAGES - HOTSET_SLOTS), FINGER_ENROLLED);
+    HotSet_SaveMap(map);
+    sensor_set_notepad(0U, map);
+}
+
+/* Reads the budgets of the flow, 1 if the file has a line for it */
+static unsigned int read_budgets(unsigned int budgets[4]){
+    char line[128];
+    char name[32];
+    unsigned int found = 0U;
+    FILE *file = fopen(budgets_path, "r");
+
+    if(file == 0){
+        fprintf(stderr, "board sim: cannot read %s\n", budgets_path);
+        exit(2);
+    }
+    while(!found && (fgets(line, sizeof(line), file) != 0)){
+        if((line[0] != '#') &&
+           (sscanf(line, "%31s %u %u %u %u", name, &budgets[0], &budgets[1], &budgets[2], &budgets[3]) == 5) &&
+           (strcmp(name, flow->name) == 0)){
+            found = 1U;
+        }
+    }
+    fclose(file);
+    return found;
+}
+
+/* Prints the traffic of the measured window, checked against the budgets if there are some */
+static void report_window(void){
+    board_traffic_t traffic;
+    unsigned int totals[4];
+    unsigned int budgets[4];
+    static const char *const labels[4] = {"LCD bytes", "LPUART1 bytes", "LPUART2 bytes", "elapsed ms"};
+    char text[64];
+    unsigned int i;
+
+    board_trace(0);
+    board_get_traffic(&traffic);
+    totals[0] = traffic.i2c_bytes - window_start.i2c_bytes;
+    totals[1] = traffic.uart_tx[BOARD_UART_CONSOLE] + traffic.uart_rx[BOARD_UART_CONSOLE] -
+                window_start.uart_tx[BOARD_UART_CONSOLE] - window_start.uart_rx[BOARD_UART_CONSOLE];
+    totals[2] = traffic.uart_tx[BOARD_UART_SENSOR] + traffic.uart_rx[BOARD_UART_SENSOR] -
+                window_start.uart_tx[BOARD_UART_SENSOR] - window_start.uart_rx[BOARD_UART_SENSOR];
+    totals[3] = (traffic.i2c_last_ms > flow->start_ms) ? traffic.i2c_last_ms - flow->start_ms : 0U;
+
+    if(budgets_path == 0){
+        printf("%s  %u %u %u %u\n", flow->name, totals[0], totals[1], totals[2], totals[3]);
+        return;
+    }
+    if(!read_budgets(budgets)){
+        CHECK("flow has a budget", 0);
+        return;
+    }
+    for(i = 0U; i < 4U; i++){
+        snprintf(text, sizeof(text), "%s %s %u of %u", flow->name, labels[i], totals[i], budgets[i]);
+        CHECK(text, totals[i] <= budgets[i]);
+    }
+}
+
+/* Writes the trace ring as a dump stream */
+static void board_dump(void){
+    unsigned char frame[TRACE_DUMP_RECORD];
+    unsigned int i;
+    FILE *file = fopen(dump_path, "wb");
+
+    if(file == 0){
+        fprintf(stderr, "board sim: cannot write %s\n", dump_path);
+        return;
+    }
+    fwrite(frame, 1U, Trace_DumpHeader(frame), file);
+    for(i = 0U; i < Trace_Count(); i++){
+        fwrite(frame, 1U, Trace_DumpRecord(i, frame), file);
+    }
+    fclose(file);
+}
+
+/* Checks the outcome of the flow, prints the report and ends the program */
+static void board_finish(void){
+    struct timespec host_end;
+    board_traffic_t traffic;
+    power_stats_t power;
+    double host_s;
+
+    board_get_traffic(&traffic);
+    Power_GetStats(&power);
+    clock_gettime(CLOCK_MONOTONIC, &host_end);
+    host_s = (double)(host_end.tv_sec - host_start.tv_sec) + (double)(host_end.tv_nsec - host_start.tv_nsec) / 1e9;
+
+    if(dump_path != 0){
+        board_dump();
+    }
+    if(end_ms >= flow->end_ms){
+        flow->check();
+    }
+    if(flow != &flows[0]){
+        report_window();
+        exit(check_summary());
+    }
+
+    printf("virtual time        %u ms in %.3f s of host time\n", now_ms, host_s);
+    printf("idle                %u ms WFI, %u ms VLPS in %u sleeps, %u interrupts\n",
+           wfi_steps, vlps_steps, power.vlps_count, interrupts);
+    printf("LPUART1 console     %u bytes sent, %u received\n",
+           traffic.uart_tx[BOARD_UART_CONSOLE], traffic.uart_rx[BOARD_UART_CONSOLE]);
+    printf("LPUART2 sensor      %u bytes sent, %u received, %u commands\n",
+           traffic.uart_tx[BOARD_UART_SENSOR], traffic.uart_rx[BOARD_UART_SENSOR], sensor_commands());
+    printf("LPI2C0 LCD          %u words, %u transfers\n", traffic.i2c_words, traffic.i2c_stops);
+    printf("FTFC                %u commands, %u EEE words\n", traffic.flash_commands, traffic.eee_writes);
+    printf("SCG                 %u run clock switches\n", traffic.clock_switches);
+    printf("touch to unlock     %u ms\n", unlock_latency_ms);
+    exit(check_summary());
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Returns the virtual time.
+ *
+ * @return    Milliseconds since the power-up.
+ */
+unsigned int board_now_ms(void){
+    return now_ms;
+}
+
+/*!
+ * @brief     Lets one millisecond pass while the firmware busy-waits.
+ *
+ * @return    void
+ */
+void board_spin(void){
+    (void)board_step(1U);
+}
+
+/*!
+ * @brief     Sleep of the firmware, see CORE_WFI().
+ *
+ * @detail    With SLEEPDEEP set the board enters VLPS until the wake-up timer or another
+ *            interrupt; otherwise the core sleeps for one SysTick period.
+ *
+ * @return    void
+ */
+void host_wfi(void){
+    if(SCB->SCR & SCB_SCR_SLEEPDEEP){
+        board_vlps();
+    }else{
+        wfi_steps++;
+        (void)board_step(1U);
+    }
+}
+
+/*==================================================================================================
+*                                       MAIN FUNCTION
+==================================================================================================*/
+
+int main(int argc, char *argv[]){
+    unsigned char schedules[SIM_ENROLLED + 1U];
+    int arg;
+    unsigned int i;
+
+    for(arg = 1; arg < argc; arg++){
+        if(strcmp(argv[arg], "-v") == 0){
+            board_set_echo(1U);
+        }else if((strcmp(argv[arg], "-f") == 0) && (arg + 1 < argc)){
+            arg++;
+            for(i = 0U; (i < STIMULI(flows)) && (strcmp(flows[i].name, argv[arg]) != 0); i++){
+            }
+            if(i == STIMULI(flows)){
+                fprintf(stderr, "board sim: no flow %s\n", argv[arg]);
+                return 2;
+            }
+            flow = &flows[i];
+        }else if((strcmp(argv[arg], "-t") == 0) && (arg + 1 < argc)){
+            trace_file = fopen(argv[++arg], "w");
+            if(trace_file == 0){
+                fprintf(stderr, "board sim: cannot write %s\n", argv[arg]);
+                return 2;
+            }
+        }else if((strcmp(argv[arg], "-b") == 0) && (arg + 1 < argc)){
+            budgets_path = argv[++arg];
+        }else if((strcmp(argv[arg], "-d") == 0) && (arg + 1 < argc)){
+            dump_path = argv[++arg];
+        }else{
+            end_ms = (unsigned int)atoi(argv[arg]) * 1000U;
+        }
+    }
+    if(end_ms == 0U){
+        end_ms = flow->end_ms;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &host_start);
+    board_reset();
+    /* The fingers of the sensor library may always enter (schedule byte n of the EEE is user n) */
+    memset(schedules, 0xFF, sizeof(schedules));
+    memset(&schedules[1], ACCESS_SCHEDULE_ALWAYS, SIM_ENROLLED);
+    board_eee_load(0U, schedules, sizeof(schedules));
+    sensor_reset();
+    if(flow->setup != 0){
+        flow->setup();
+    }
+    firmware_main();
+    return 2;
+}
@@ -0,0 +1,86 @@
+/**
+*   @file    board_sim.h
+*   @brief   Simulated board of the host build of the firmware.
+*   @details The peripheral base pointers of a HOST_BUILD resolve to the RAM register models of
+*            board_model.c. The registers keep what the drivers write; the hooks of core.h
+*            (CORE_REG_WRITTEN, CORE_REG_READ) give the models the side effects of the hardware:
+*            a byte written to LPUARTn DATA is transmitted, a write of CCIF to FSTAT runs the
+*            flash command, PDIR follows the keypad rows driven on PDOR. The status flags the
+*            drivers poll (TDRE, TC, SDF, CCIF, the clock VLD bits) read as ready.
+*
+*            Time is virtual: it only moves while the firmware sleeps in CORE_WFI or waits in
+*            delay(), one millisecond per step, and board_sim.c raises the interrupts of that
+*            millisecond (SysTick, the RTC second, received bytes, the scenario stimuli).
+*            sensor_model.c answers the fingerprint sensor protocol on LPUART2.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef BOARD_SIM_H
+#define BOARD_SIM_H
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define BOARD_UART_CONSOLE      1U              /* LPUART1, the admin console */
+#define BOARD_UART_SENSOR       2U              /* LPUART2, the fingerprint sensor */
+#define BOARD_UARTS             3U
+#define BOARD_RX_SIZE           1024U           /* Bytes queued towards one LPUART */
+#define BOARD_NO_KEY            0U              /* Keypad position 1-16, 0 for none */
+#define BOARD_NO_FINGER         0U              /* Finger on the sensor, 0 for none */
+
+/* Bus traffic of a run */
+typedef struct {
+    unsigned int uart_tx[BOARD_UARTS];          /* Bytes written to LPUARTn DATA */
+    unsigned int uart_rx[BOARD_UARTS];          /* Bytes delivered to the LPUARTn interrupt */
+    unsigned int i2c_words;                     /* Words written to LPI2C0 MTDR */
+    unsigned int i2c_bytes;                     /* Address and data bytes put on the bus */
+    unsigned int i2c_stops;
+    unsigned int flash_commands;                /* FTFC commands launched */
+    unsigned int eee_writes;                    /* FlexRAM words written in EEPROM mode */
+    unsigned int clock_switches;                /* Writes of SCG_RCCR */
+    unsigned int i2c_last_ms;                   /* Virtual time of the last LPI2C0 word */
+} board_traffic_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+/* board_model.c */
+void board_reset(void);
+void board_set_key(unsigned int position);
+void board_eee_load(unsigned int offset, const unsigned char *data, unsigned int size);
+void board_lptmr_count(unsigned int count);
+void board_uart_queue(unsigned int uart, unsigned int at_ms, const unsigned char *bytes, unsigned int count);
+unsigned char board_uart_pending(unsigned int uart, unsigned int now_ms);
+unsigned char board_uart_take(unsigned int uart);
+void board_uart_drop(unsigned int uart);
+void board_uart_taken(unsigned int uart);
+void board_get_traffic(board_traffic_t *traffic);
+void board_set_echo(unsigned char on);
+void board_trace(FILE *out);
+
+/* board_sim.c */
+unsigned int board_now_ms(void);
+void board_spin(void);
+
+/* sensor_model.c */
+void sensor_reset(void);
+void sensor_set_pages(unsigned int count);
+void sensor_set_page(unsigned int page, unsigned int identity);
+unsigned int sensor_get_page(unsigned int page);
+void sensor_set_notepad(unsigned int page, const unsigned char *data);
+void sensor_set_finger(unsigned int finger);
+void sensor_receive(unsigned char byte);
+unsigned int sensor_commands(void);
+unsigned int sensor_instructions(unsigned char instruction);
+
+#endif /* BOARD_SIM_H */
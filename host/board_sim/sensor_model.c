@@ -0,0 +1,354 @@
+/**
+*   @file    sensor_model.c
+*   @brief   Model of the AS608 fingerprint sensor on LPUART2 of the simulated board.
+*   @details The model parses the command packets the firmware transmits and queues the
+*            acknowledge packets on the receive line of LPUART2, after the processing time of
+*            the instruction. A finger is an identity number: GetImage captures the finger on
+*            the sensor, GenChar copies it to a character buffer, Store and LoadChar move it
+*            between a buffer and a library page, and Search finds the page that holds it.
+*            Pages 1 to SENSOR_ENROLLED hold fingers 1 to SENSOR_ENROLLED at power-up, in a
+*            library of SENSOR_PAGES pages unless a scenario sets a smaller one. The sensor
+*            ignores the commands of its first SENSOR_BOOT_MS, as the real one does.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <string.h>
+#include "board_sim.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define SENSOR_PAGES            300U            /* Default and largest library size */
+#define SENSOR_ENROLLED         5U
+#define SENSOR_BOOT_MS          200U
+#define SENSOR_BUFFERS          3U
+#define SENSOR_NOTEPAD_PAGES    16U
+#define SENSOR_NOTEPAD_SIZE     32U
+#define SENSOR_FRAME_SIZE       64U
+#define SENSOR_SCORE            150U            /* Match score of a search reply */
+
+/* Packet: header (6), PID, length (2), then length bytes: instruction, parameters, sum (2) */
+#define PACKET_HEADER_SIZE      6U
+#define PACKET_PID_COMMAND      0x01U
+#define PACKET_PID_ACK          0x07U
+
+/* Instructions */
+#define INS_GET_IMAGE           0x01U
+#define INS_GEN_CHAR            0x02U
+#define INS_REG_MODEL           0x05U
+#define INS_STORE               0x06U
+#define INS_LOAD_CHAR           0x07U
+#define INS_SEARCH              0x04U
+#define INS_EMPTY               0x0DU
+#define INS_READ_SYS_PARA       0x0FU
+#define INS_WRITE_NOTEPAD       0x18U
+#define INS_READ_NOTEPAD        0x19U
+#define INS_HIGH_SPEED_SEARCH   0x1BU
+#define INS_TEMPLATE_NUM        0x1DU
+
+/* Confirmation codes */
+#define ACK_OK                  0x00U
+#define ACK_RECEIVE_ERROR       0x01U
+#define ACK_NO_FINGER           0x02U
+#define ACK_NOT_FOUND           0x09U
+#define ACK_MERGE_FAIL          0x0AU
+#define ACK_BAD_PAGE            0x0BU
+#define ACK_BAD_INSTRUCTION     0x1AU
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static const unsigned char packet_header[PACKET_HEADER_SIZE] = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static unsigned int finger;                     /* On the sensor, BOARD_NO_FINGER if none */
+static unsigned int image;
+static unsigned int buffers[SENSOR_BUFFERS];
+static unsigned int library[SENSOR_PAGES];
+static unsigned int pages;                      /* Library size reported by ReadSysPara */
+static unsigned char notepad[SENSOR_NOTEPAD_PAGES][SENSOR_NOTEPAD_SIZE];
+static unsigned char frame[SENSOR_FRAME_SIZE];
+static unsigned int frame_length;
+static unsigned int commands;
+static unsigned int instruction_count[256];
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+/* Queues an acknowledge packet, received busy_ms after now */
+static void sensor_reply(unsigned char code, const unsigned char *data, unsigned int count, unsigned int busy_ms){
+    unsigned char packet[PACKET_HEADER_SIZE + 6U + SENSOR_NOTEPAD_SIZE + 16U];
+    unsigned int length = 1U + count + 2U;
+    unsigned int sum;
+    unsigned int i;
+
+    memcpy(packet, packet_header, PACKET_HEADER_SIZE);
+    packet[6] = PACKET_PID_ACK;
+    packet[7] = (unsigned char)(length >> 8);
+    packet[8] = (unsigned char)length;
+    packet[9] = code;
+    if(count != 0U){
+        memcpy(&packet[10], data, count);
+    }
+    sum = 0U;
+    for(i = 6U; i < 10U + count; i++){
+        sum += packet[i];
+    }
+    packet[10U + count] = (unsigned char)(sum >> 8);
+    packet[11U + count] = (unsigned char)sum;
+    board_uart_queue(BOARD_UART_SENSOR, board_now_ms() + busy_ms, packet, 12U + count);
+}
+
+/* Buffer number of a GenChar, Store, LoadChar or Search, 0 if out of range */
+static unsigned int sensor_buffer(unsigned char number){
+    return ((number >= 1U) && (number < SENSOR_BUFFERS)) ? number : 0U;
+}
+
+/* Executes a complete command packet */
+static void sensor_execute(void){
+    const unsigned char *params = &frame[10];
+    unsigned char data[SENSOR_NOTEPAD_SIZE];
+    unsigned int buffer = sensor_buffer(params[0]);
+    unsigned int page = ((unsigned int)params[1] << 8) | params[2];
+    unsigned int count = ((unsigned int)params[3] << 8) | params[4];
+    unsigned int busy_ms;
+    unsigned int found;
+    unsigned int i;
+
+    commands++;
+    instruction_count[frame[9]]++;
+    switch(frame[9]){
+    case INS_GET_IMAGE:
+        image = finger;
+        sensor_reply((finger != BOARD_NO_FINGER) ? ACK_OK : ACK_NO_FINGER, 0, 0U, (finger != BOARD_NO_FINGER) ? 50U : 25U);
+        break;
+    case INS_GEN_CHAR:
+        buffers[buffer] = image;
+        sensor_reply(ACK_OK, 0, 0U, 40U);
+        break;
+    case INS_REG_MODEL:
+        sensor_reply((buffers[1] == buffers[2]) ? ACK_OK : ACK_MERGE_FAIL, 0, 0U, 30U);
+        break;
+    case INS_STORE:
+    case INS_LOAD_CHAR:
+        if(page >= pages){
+            sensor_reply(ACK_BAD_PAGE, 0, 0U, 5U);
+        }else if(frame[9] == INS_STORE){
+            library[page] = buffers[buffer];
+            sensor_reply(ACK_OK, 0, 0U, 20U);
+        }else{
+            buffers[buffer] = library[page];
+            sensor_reply(ACK_OK, 0, 0U, 10U);
+        }
+        break;
+    case INS_SEARCH:
+    case INS_HIGH_SPEED_SEARCH:
+        for(i = page; (i < page + count) && (i < pages); i++){
+            if((library[i] != BOARD_NO_FINGER) && (library[i] == buffers[buffer])){
+                break;
+            }
+        }
+        found = (i < page + count) && (i < pages);
+        /* About 4 pages per millisecond, 16 with the high speed search */
+        busy_ms = 5U + ((frame[9] == INS_SEARCH) ? (i - page) / 4U : (i - page) / 16U);
+        if(found){
+            data[0] = (unsigned char)(i >> 8);
+            data[1] = (unsigned char)i;
+            data[2] = (unsigned char)(SENSOR_SCORE >> 8);
+            data[3] = (unsigned char)SENSOR_SCORE;
+            sensor_reply(ACK_OK, data, 4U, busy_ms);
+        }else{
+            sensor_reply(ACK_NOT_FOUND, 0, 0U, busy_ms);
+        }
+        break;
+    case INS_EMPTY:
+        memset(library, 0, sizeof(library));
+        sensor_reply(ACK_OK, 0, 0U, 50U);
+        break;
+    case INS_READ_SYS_PARA:
+        memset(data, 0, 16U);
+        data[4] = (unsigned char)(pages >> 8);
+        data[5] = (unsigned char)pages;
+        data[7] = 3U;                           /* Security level */
+        memset(&data[8], 0xFF, 4U);             /* Device address */
+        data[13] = 2U;                          /* 128 byte data packets */
+        data[15] = 6U;                          /* 57600 baud */
+        sensor_reply(ACK_OK, data, 16U, 5U);
+        break;
+    case INS_WRITE_NOTEPAD:
+    case INS_READ_NOTEPAD:
+        if(params[0] >= SENSOR_NOTEPAD_PAGES){
+            sensor_reply(ACK_BAD_PAGE, 0, 0U, 5U);
+        }else if(frame[9] == INS_WRITE_NOTEPAD){
+            memcpy(notepad[params[0]], &params[1], SENSOR_NOTEPAD_SIZE);
+            sensor_reply(ACK_OK, 0, 0U, 10U);
+        }else{
+            sensor_reply(ACK_OK, notepad[params[0]], SENSOR_NOTEPAD_SIZE, 5U);
+        }
+        break;
+    case INS_TEMPLATE_NUM:
+        for(i = 0U, count = 0U; i < pages; i++){
+            count += (library[i] != BOARD_NO_FINGER) ? 1U : 0U;
+        }
+        data[0] = (unsigned char)(count >> 8);
+        data[1] = (unsigned char)count;
+        sensor_reply(ACK_OK, data, 2U, 5U);
+        break;
+    default:
+        sensor_reply(ACK_BAD_INSTRUCTION, 0, 0U, 5U);
+        break;
+    }
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Powers the sensor up with SENSOR_ENROLLED fingers in its library.
+ *
+ * @return    void
+ */
+void sensor_reset(void){
+    unsigned int page;
+
+    finger = BOARD_NO_FINGER;
+    image = BOARD_NO_FINGER;
+    memset(buffers, 0, sizeof(buffers));
+    memset(library, 0, sizeof(library));
+    memset(notepad, 0, sizeof(notepad));
+    pages = SENSOR_PAGES;
+    for(page = 1U; page <= SENSOR_ENROLLED; page++){
+        library[page] = page;
+    }
+    frame_length = 0U;
+    commands = 0U;
+    memset(instruction_count, 0, sizeof(instruction_count));
+}
+
+/*!
+ * @brief     Sets the library size, after sensor_reset().
+ *
+ * @param[in]  count Pages, up to SENSOR_PAGES.
+ * @return    void
+ */
+void sensor_set_pages(unsigned int count){
+    pages = (count < SENSOR_PAGES) ? count : SENSOR_PAGES;
+}
+
+/*!
+ * @brief     Stores the template of a finger in a library page, as an earlier Store did.
+ *
+ * @param[in]  page Library page.
+ * @param[in]  identity Finger, BOARD_NO_FINGER to empty the page.
+ * @return    void
+ */
+void sensor_set_page(unsigned int page, unsigned int identity){
+    if(page < pages){
+        library[page] = identity;
+    }
+}
+
+/*!
+ * @brief     Returns the finger whose template a library page holds.
+ *
+ * @param[in]  page Library page.
+ * @return    The finger, BOARD_NO_FINGER for an empty page or a page out of range.
+ */
+unsigned int sensor_get_page(unsigned int page){
+    return (page < pages) ? library[page] : BOARD_NO_FINGER;
+}
+
+/*!
+ * @brief     Writes a page of the notepad, as WriteNotepad does.
+ *
+ * @param[in]  page Notepad page.
+ * @param[in]  data SENSOR_NOTEPAD_SIZE bytes.
+ * @return    void
+ */
+void sensor_set_notepad(unsigned int page, const unsigned char *data){
+    if(page < SENSOR_NOTEPAD_PAGES){
+        memcpy(notepad[page], data, SENSOR_NOTEPAD_SIZE);
+    }
+}
+
+/*!
+ * @brief     Places a finger on the sensor, or removes it.
+ *
+ * @param[in]  identity Finger, BOARD_NO_FINGER to remove it.
+ * @return    void
+ */
+void sensor_set_finger(unsigned int identity){
+    finger = identity;
+}
+
+/*!
+ * @brief     Receives a byte transmitted by the firmware on LPUART2.
+ *
+ * @detail    A packet with a wrong checksum is answered with a receive error.
+ *
+ * @param[in]  byte The byte.
+ * @return    void
+ */
+void sensor_receive(unsigned char byte){
+    unsigned int length;
+    unsigned int sum = 0U;
+    unsigned int i;
+
+    if((frame_length < PACKET_HEADER_SIZE) && (byte != packet_header[frame_length])){
+        frame_length = (byte == packet_header[0]) ? 1U : 0U;
+        if(frame_length != 0U){
+            frame[0] = byte;
+        }
+        return;
+    }
+    frame[frame_length++] = byte;
+    if(frame_length < 9U){
+        return;
+    }
+    length = ((unsigned int)frame[7] << 8) | frame[8];
+    if((length < 3U) || (9U + length > SENSOR_FRAME_SIZE)){
+        frame_length = 0U;
+        return;
+    }
+    if(frame_length < 9U + length){
+        return;
+    }
+    frame_length = 0U;
+    if(board_now_ms() < SENSOR_BOOT_MS){
+        return;
+    }
+    for(i = 6U; i < 7U + length; i++){
+        sum += frame[i];
+    }
+    if((frame[6] != PACKET_PID_COMMAND) ||
+       ((sum & 0xFFFFU) != (((unsigned int)frame[7U + length] << 8) | frame[8U + length]))){
+        sensor_reply(ACK_RECEIVE_ERROR, 0, 0U, 5U);
+        return;
+    }
+    sensor_execute();
+}
+
+/*!
+ * @brief     Counts the command packets executed.
+ *
+ * @return    The number of commands.
+ */
+unsigned int sensor_commands(void){
+    return commands;
+}
+
+/*!
+ * @brief     Counts the command packets of one instruction.
+ *
+ * @param[in]  instruction Instruction code.
+ * @return    The number of commands.
+ */
+unsigned int sensor_instructions(unsigned char instruction){
+    return instruction_count[instruction];
+}
@@ -0,0 +1,57 @@
+/**
+*   @file    check.h
+*   @brief   Checks of the host test programs.
+*   @details CHECK() prints one line per check, its name and PASS or FAIL, and counts the
+*            failures; check_summary() prints the count and gives the exit status of the
+*            program, 1 if any check failed. A program includes this file in one source file
+*            only. check_detail, when set, is called after each failed check to print what the
+*            program knows about it.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef CHECK_H
+#define CHECK_H
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define CHECK(name, cond)       check((name), (cond))
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static unsigned int check_failures = 0U;
+static void (*check_detail)(void) = 0;
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+static inline void check(const char *name, int cond){
+    printf("%-48s %s\n", name, cond ? "PASS" : "FAIL");
+    if(!cond){
+        if(check_detail != 0){
+            check_detail();
+        }
+        check_failures++;
+    }
+}
+
+/* Prints the failure count, returns the exit status of the program */
+static inline int check_summary(void){
+    printf("%u failure(s)\n", check_failures);
+    fflush(stdout);
+    return (check_failures == 0U) ? 0 : 1;
+}
+
+#endif /* CHECK_H */
@@ -0,0 +1,313 @@
+/**
+*   @file    event_log_sim.c
+*   @brief   Behavioural and power-cut test of the event log on the host.
+*   @details Runs the real src/event_log.c on the flash simulator of the user database test
+*            against a model of the events appended. A random workload, long enough to reuse
+*            every sector of the ring, is read back after every reboot: each record read must
+*            be a record appended, in order, and every record flushed to the flash must be read
+*            unless the ring has reused its sector since. The power-cut test then replays the
+*            workload once per cut point, cutting the power in the middle of a program or erase
+*            operation; the records still staged in RAM or in the phrase being programmed may be
+*            lost, no other. The failure test makes one operation fail instead. EventLog_Seek() is
+*            checked against a full read, with the clock in order and set back.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "event_log.h"
+#include "flash_sim.h"
+#include "check.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define WORKLOAD_EVENTS 1500U           /* Events per run, more than the ring holds */
+#define FLUSH_EVERY     7U              /* Events between two flushes of the staged records */
+#define MODEL_SIZE      (3U * WORKLOAD_EVENTS)
+#define CUT_STRIDE      5U              /* Prime to the phrases of a sector, so every phase is cut */
+#define START_TIME      1700000000U
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static event_log_record_t model[MODEL_SIZE];
+static unsigned char optional[MODEL_SIZE];  /* May be lost: staged when the power was cut */
+static unsigned int model_count;
+static unsigned int flushed;                /* Records programmed at the last flush */
+static unsigned int now;
+static unsigned int seed;
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+static unsigned int next_random(void){
+    seed = seed * 1103515245U + 12345U;
+    return (seed >> 16) & 0x7FFFU;
+}
+
+/* Runs the background programming until it has nothing left, a failed command included */
+static void drain_service(void){
+    unsigned int steps = 0U;
+
+    while(EventLog_Service() || EventLog_Service()){
+        if(++steps > 10000U){
+            printf("    service does not finish\n");
+            exit(2);
+        }
+    }
+}
+
+static void flush(void){
+    EventLog_Flush();
+    drain_service();
+    flushed = model_count;
+}
+
+static void append(unsigned int time, unsigned short user_id, unsigned short score,
+                   unsigned char result){
+    if(model_count >= MODEL_SIZE){
+        printf("    model full\n");
+        exit(2);
+    }
+    if(EventLog_Append(time, user_id, score, result) != EVENT_LOG_OK){
+        return;
+    }
+    model[model_count].time = time;
+    model[model_count].user_id = user_id;
+    model[model_count].score = score;
+    model[model_count].result = result;
+    optional[model_count] = 0U;
+    model_count++;
+    drain_service();
+}
+
+static int same_record(const event_log_record_t *a, const event_log_record_t *b){
+    return (a->time == b->time) && (a->user_id == b->user_id) && (a->score == b->score) &&
+           (a->result == b->result);
+}
+
+/*
+ * Reads the whole log against the model: every record read is the next one of the model or a
+ * later one, the model records skipped in between may be lost, and so may the oldest records
+ * and the ones not flushed yet.
+ */
+static int log_matches(unsigned int *read_count){
+    event_log_cursor_t cursor;
+    event_log_record_t record;
+    unsigned int next = 0U;
+    unsigned int count = 0U;
+    unsigned int i;
+
+    EventLog_ReadFirst(&cursor);
+    while(EventLog_ReadNext(&cursor, &record) == EVENT_LOG_OK){
+        i = next;
+        while((i < model_count) && !same_record(&record, &model[i])){
+            i++;
+        }
+        if(i == model_count){
+            printf("    record %u not appended: time %u user %u\n", count, record.time,
+                   record.user_id);
+            return 0;
+        }
+        for(; (count != 0U) && (next < i); next++){
+            if(!optional[next]){
+                printf("    record %u of the model lost\n", next);
+                return 0;
+            }
+        }
+        next = i + 1U;
+        count++;
+    }
+    for(; next < flushed; next++){
+        if(!optional[next]){
+            printf("    flushed record %u of the model lost\n", next);
+            return 0;
+        }
+    }
+    if(read_count != 0){
+        *read_count = count;
+    }
+    return 1;
+}
+
+/* Tells whether the records at or after a time read from EventLog_Seek() are those of the log */
+static int seek_finds_all(unsigned int time, unsigned char *ordered){
+    event_log_cursor_t cursor;
+    event_log_record_t record;
+    unsigned int expected = 0U;
+    unsigned int found = 0U;
+
+    EventLog_ReadFirst(&cursor);
+    while(EventLog_ReadNext(&cursor, &record) == EVENT_LOG_OK){
+        expected += record.time >= time;
+    }
+    *ordered = EventLog_Seek(&cursor, time);
+    while(EventLog_ReadNext(&cursor, &record) == EVENT_LOG_OK){
+        found += record.time >= time;
+    }
+    return (found == expected) && (expected != 0U);
+}
+
+/* Appends events from the current seed, flushing now and then */
+static void run_workload(unsigned int events){
+    unsigned int i;
+    unsigned int step;
+
+    for(i = 0U; i < events; i++){
+        step = next_random() % 50U;
+        if(step == 0U){
+            now += 0x200000U + next_random();   /* Longer than a delta record */
+        }else{
+            now += 1U + next_random() % (step * 20U);
+        }
+        append(now, (unsigned short)(next_random() % 1000U), (unsigned short)(next_random() % 400U),
+               (unsigned char)(next_random() % 4U));
+        if((i % FLUSH_EVERY) == (FLUSH_EVERY - 1U)){
+            flush();
+        }
+    }
+    flush();
+}
+
+static void start_empty(unsigned int workload_seed){
+    flash_sim_erase_all();
+    model_count = 0U;
+    flushed = 0U;
+    now = START_TIME;
+    seed = workload_seed;
+    EventLog_Init();
+}
+
+/* After a power cut, the records not yet flushed may be lost */
+static void reboot_after_cut(void){
+    unsigned int i;
+
+    for(i = flushed; i < model_count; i++){
+        optional[i] = 1U;
+    }
+    flushed = model_count;
+    EventLog_Init();
+    drain_service();
+}
+
+/* Runs the workload with the power cut at one flash operation, then checks the reboot */
+static int cut_trial(unsigned int cut){
+    int ok;
+
+    start_empty(1U);
+    flash_sim_arm_cut(flash_sim_operations() + cut);
+    if(setjmp(flash_sim_cut) == 0){
+        run_workload(WORKLOAD_EVENTS);
+        return -1;                      /* The workload ended before the cut point */
+    }
+    reboot_after_cut();
+    ok = log_matches(0);
+    run_workload(50U);
+    EventLog_Init();
+    return ok && log_matches(0);
+}
+
+/* Runs the workload with one flash operation failing, then checks the log and a reboot */
+static int failure_trial(unsigned int operation){
+    int ok;
+
+    start_empty(1U);
+    flash_sim_arm_failure(flash_sim_operations() + operation);
+    run_workload(WORKLOAD_EVENTS);
+    ok = log_matches(0);
+    EventLog_Init();
+    return ok && log_matches(0);
+}
+
+/*==================================================================================================
+*                                       MAIN FUNCTION
+==================================================================================================*/
+
+int main(void){
+    event_log_cursor_t cursor;
+    event_log_record_t record;
+    event_log_stats_t stats;
+    unsigned int operations;
+    unsigned int trial;
+    unsigned int trials = 0U;
+    unsigned int bad = 0U;
+    unsigned int count = 0U;
+    unsigned int time;
+    unsigned char ordered;
+    int result;
+
+    start_empty(1U);
+    EventLog_ReadFirst(&cursor);
+    CHECK("empty log has no record", EventLog_ReadNext(&cursor, &record) == EVENT_LOG_END);
+    append(START_TIME, 12U, 87U, EVENT_LOG_GRANTED);
+    EventLog_ReadFirst(&cursor);
+    CHECK("staged record not read yet", EventLog_ReadNext(&cursor, &record) == EVENT_LOG_END);
+    flush();
+    CHECK("flushed record read back", log_matches(&count) && count == 1U);
+    append(START_TIME - 3600U, 0U, 0U, EVENT_LOG_NO_MATCH);
+    append(START_TIME + 0x300000U, 999U, 20000U, EVENT_LOG_DENIED);
+    model[model_count - 1U].score = 0x3FFFU;    /* Stored as 16383 */
+    flush();
+    CHECK("clock set back and long gap read back", log_matches(&count) && count == 3U);
+    EventLog_Init();
+    CHECK("  kept across a reboot", log_matches(&count) && count == 3U);
+
+    start_empty(1U);
+    operations = flash_sim_operations();
+    run_workload(WORKLOAD_EVENTS);
+    operations = flash_sim_operations() - operations;
+    EventLog_GetStats(&stats);
+    CHECK("workload matches the model", log_matches(&count) && count < model_count);
+    printf("%u of %u records kept by the ring\n", count, model_count);
+    EventLog_Init();
+    CHECK("  and still after a reboot", log_matches(0));
+    CHECK("  no record dropped", stats.dropped == 0U);
+    CHECK("  no phrase programmed twice", flash_sim_violations() == 0U);
+
+    time = model[model_count - 20U].time;
+    EventLog_Seek(&cursor, time);
+    CHECK("seek skips the older sectors", cursor.sectors_left < EVENT_LOG_SECTORS);
+    CHECK("  and finds every record after the time", seek_finds_all(time, &ordered) && ordered);
+    now = 100U;                         /* The RTC restarted at 1970 */
+    run_workload(20U);
+    CHECK("seek after the clock was set back", seek_finds_all(time, &ordered) && !ordered);
+    CHECK("  finds the records after the new time", seek_finds_all(200U, &ordered));
+    run_workload(WORKLOAD_EVENTS);
+    CHECK("  searches again once the old times are gone",
+          seek_finds_all(model[model_count - 20U].time, &ordered) && ordered);
+
+    for(trial = 1U; trial <= operations + 1U; trial += CUT_STRIDE){
+        result = cut_trial(trial);
+        if(result < 0){
+            break;
+        }
+        trials++;
+        if(!result){
+            bad++;
+            printf("    power cut at operation %u: mismatch\n", trial);
+        }
+    }
+    printf("%u power cuts of %u flash operations\n", trials, operations);
+    CHECK("every power cut keeps the flushed records", bad == 0U && trials > 0U);
+    CHECK("  no phrase programmed twice", flash_sim_violations() == 0U);
+
+    bad = 0U;
+    for(trial = 1U; trial <= operations; trial += CUT_STRIDE){
+        if(!failure_trial(trial)){
+            bad++;
+            printf("    failure of operation %u: mismatch\n", trial);
+        }
+    }
+    CHECK("a failed command loses no flushed record", bad == 0U);
+    CHECK("  no phrase programmed twice", flash_sim_violations() == 0U);
+
+    return check_summary();
+}
@@ -0,0 +1,440 @@
+/**
+*   @file    fp_reply_fuzz.c
+*   @brief   Fuzz target and throughput benchmark of the fingerprint reply parser.
+*   @details LLVMFuzzerTestOneInput() feeds an input to the parser of src/fp_reply.c, byte by
+*            byte as the LPUART2 interrupt does, and checks every reply it accepts against
+*            the input: the header before it, an acknowledge identifier, a length in range,
+*            the sum, and accessors that stay within the data of the reply. It then feeds
+*            RECOVERY_BYTES zero bytes and a valid reply, which must be accepted whatever the
+*            input left in the parser. A violated property aborts, as the fuzzers expect.
+*
+*            Built with -DFP_REPLY_LIBFUZZER the file is a libFuzzer target (make fuzz
+*            CC=clang). Otherwise main() runs:
+*              fp_reply_fuzz                the seed replies, each with the number of replies
+*                                           it must yield, then ITERATIONS mutations of them;
+*              fp_reply_fuzz file... | -    each file, or stdin, as one input (AFL, crashes);
+*              fp_reply_fuzz -c dir         writes the seeds to dir, the corpus;
+*              fp_reply_fuzz -b             the throughput over a stream of replies and noise.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fp_reply.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define MAX_INPUT               4096U           /* Longest input checked, the rest is ignored */
+#define FRAME_MAX               (FP_REPLY_HEADER_SIZE + 6U + FP_REPLY_MAX_DATA)
+#define RECOVERY_BYTES          FRAME_MAX       /* Bytes after which a frame in progress ends */
+#define SEEDS_MAX               16U
+#define ITERATIONS              200000U
+#define BENCH_SIZE              (1U << 20)
+#define BENCH_PASSES            20U
+
+#if defined(__i386__) || defined(__x86_64__)
+#define BENCH_CYCLES()          __builtin_ia32_rdtsc()
+#endif
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+typedef struct {
+    const char *name;
+    unsigned char bytes[2U * FRAME_MAX + 32U];
+    unsigned int size;
+    unsigned int replies;                       /* Replies the parser must accept */
+} seed_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static const unsigned char header[FP_REPLY_HEADER_SIZE] = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static seed_t seeds[SEEDS_MAX];
+static unsigned int seed_count;
+static unsigned int accepted;                   /* Replies accepted by the last input */
+static unsigned int rng = 0x2545F491U;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, unsigned long size);
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+static void fail(const char *property){
+    fprintf(stderr, "fp_reply: %s\n", property);
+    abort();
+}
+
+/* Appends a packet, with its header and sum, to a seed */
+static void seed_packet(seed_t *seed, unsigned char pid, unsigned char code, const unsigned char *data, unsigned int count){
+    unsigned char *out = &seed->bytes[seed->size];
+    unsigned int length = 1U + count + 2U;
+    unsigned int sum;
+    unsigned int i;
+
+    memcpy(out, header, FP_REPLY_HEADER_SIZE);
+    out[6] = pid;
+    out[7] = (unsigned char)(length >> 8);
+    out[8] = (unsigned char)length;
+    out[9] = code;
+    if(count != 0U){
+        memcpy(&out[10], data, count);
+    }
+    for(i = 6U, sum = 0U; i < 10U + count; i++){
+        sum += out[i];
+    }
+    out[10U + count] = (unsigned char)(sum >> 8);
+    out[11U + count] = (unsigned char)sum;
+    seed->size += 12U + count;
+}
+
+static void seed_bytes(seed_t *seed, const unsigned char *bytes, unsigned int count){
+    memcpy(&seed->bytes[seed->size], bytes, count);
+    seed->size += count;
+}
+
+static seed_t *seed_new(const char *name, unsigned int replies){
+    seed_t *seed = &seeds[seed_count++];
+
+    seed->name = name;
+    seed->size = 0U;
+    seed->replies = replies;
+    return seed;
+}
+
+/* Replies of the AS608 as the firmware receives them, and the line faults it must survive */
+static void seeds_build(void){
+    static const unsigned char match[4] = {0x00, 0x03, 0x00, 0x96};     /* Page 3, score 150 */
+    static const unsigned char count[2] = {0x00, 0x05};
+    static const unsigned char noise[15] = {0xEF, 0x01, 0xFF, 0xEF, 0x00, 0x12, 0xEF, 0x01,
+                                            0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x00, 0xFF};
+    unsigned char sys_para[16] = {0};
+    unsigned char notepad[FP_REPLY_MAX_DATA];
+    seed_t *seed;
+
+    seed_count = 0U;
+    seed_packet(seed_new("ack_ok", 1U), FP_REPLY_PID_ACK, 0x00U, 0, 0U);
+    seed_packet(seed_new("ack_no_finger", 1U), FP_REPLY_PID_ACK, 0x02U, 0, 0U);
+    seed_packet(seed_new("search_match", 1U), FP_REPLY_PID_ACK, 0x00U, match, sizeof(match));
+    seed_packet(seed_new("search_not_found", 1U), FP_REPLY_PID_ACK, 0x09U, 0, 0U);
+    sys_para[5] = 0x2CU;                        /* Library of 300 pages */
+    sys_para[4] = 0x01U;
+    seed_packet(seed_new("sys_para", 1U), FP_REPLY_PID_ACK, 0x00U, sys_para, sizeof(sys_para));
+    seed_packet(seed_new("template_num", 1U), FP_REPLY_PID_ACK, 0x00U, count, sizeof(count));
+
+    /* Hot tier map naming user 495 (EF 01) before an empty slot: the header inside a reply */
+    memset(notepad, 0xFF, sizeof(notepad));
+    notepad[0] = 'H';
+    notepad[1] = 'T';
+    notepad[2] = 0xEFU;
+    notepad[3] = 0x01U;
+    seed_packet(seed_new("notepad_header_inside", 1U), FP_REPLY_PID_ACK, 0x00U, notepad, sizeof(notepad));
+
+    seed = seed_new("noise_then_reply", 1U);
+    seed_bytes(seed, noise, sizeof(noise));
+    seed_packet(seed, FP_REPLY_PID_ACK, 0x00U, 0, 0U);
+
+    seed = seed_new("bad_sum_then_reply", 1U);
+    seed_packet(seed, FP_REPLY_PID_ACK, 0x00U, match, sizeof(match));
+    seed->bytes[seed->size - 1U] ^= 0x01U;
+    seed_packet(seed, FP_REPLY_PID_ACK, 0x02U, 0, 0U);
+
+    seed = seed_new("command_then_reply", 1U);
+    seed_packet(seed, 0x01U, 0x01U, 0, 0U);     /* A command packet, not a reply */
+    seed_packet(seed, FP_REPLY_PID_ACK, 0x00U, 0, 0U);
+
+    seed = seed_new("two_replies", 2U);
+    seed_packet(seed, FP_REPLY_PID_ACK, 0x00U, 0, 0U);
+    seed_packet(seed, FP_REPLY_PID_ACK, 0x00U, match, sizeof(match));
+}
+
+/* Checks the reply the parser accepted at the byte data[last] */
+static void check_reply(const unsigned char *data, unsigned int last){
+    unsigned int length = FpReply_DataLength() + 3U;
+    unsigned int start;
+    unsigned int sum;
+    unsigned int i;
+
+    if(length > FP_REPLY_MAX_DATA + 3U){
+        fail("data length out of range");
+    }
+    if(last + 1U < FP_REPLY_HEADER_SIZE + 3U + length){
+        fail("reply longer than the input");
+    }
+    start = last + 1U - 3U - length;
+    if(memcmp(&data[start - FP_REPLY_HEADER_SIZE], header, FP_REPLY_HEADER_SIZE) != 0){
+        fail("reply without its header");
+    }
+    if((data[start] != FP_REPLY_PID_ACK) || ((((unsigned int)data[start + 1U] << 8) | data[start + 2U]) != length)){
+        fail("identifier or length not those of the input");
+    }
+    for(i = start, sum = 0U; i < last - 1U; i++){
+        sum += data[i];
+    }
+    if((sum & 0xFFFFU) != (((unsigned int)data[last - 1U] << 8) | data[last])){
+        fail("reply with a wrong sum accepted");
+    }
+    if(FpReply_Code() != data[start + 3U]){
+        fail("code not that of the input");
+    }
+    for(i = 0U; i < FP_REPLY_MAX_DATA + 2U; i++){
+        if(FpReply_Word(i) != ((i + 2U <= length - 3U) ?
+                               (((unsigned int)data[start + 4U + i] << 8) | data[start + 5U + i]) : FP_REPLY_NO_WORD)){
+            fail("word not that of the input");
+        }
+    }
+    if((FpReply_Data(length - 3U) == 0) || (FpReply_Data(length - 2U) != 0)){
+        fail("data past the reply");
+    }
+}
+
+/* Runs an input, returns the number of replies accepted */
+static unsigned int run(const unsigned char *data, unsigned int size){
+    (void)LLVMFuzzerTestOneInput(data, size);
+    return accepted;
+}
+
+static unsigned int random_next(void){
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/* A random mutation of a seed: bit flips, dropped, repeated or random bytes, a splice */
+static unsigned int mutate(unsigned char *out, const seed_t *seed){
+    unsigned int size = seed->size;
+    unsigned int edits = 1U + random_next() % 4U;
+    unsigned int at;
+    const seed_t *other;
+
+    memcpy(out, seed->bytes, size);
+    while(edits-- != 0U){
+        at = random_next() % size;
+        switch(random_next() % 5U){
+        case 0:
+            out[at] ^= (unsigned char)(1U << (random_next() % 8U));
+            break;
+        case 1:
+            if(size > 1U){
+                memmove(&out[at], &out[at + 1U], size - at - 1U);
+                size--;
+            }
+            break;
+        case 2:
+            if(size < MAX_INPUT){
+                memmove(&out[at + 1U], &out[at], size - at);
+                size++;
+            }
+            break;
+        case 3:
+            out[at] = (unsigned char)random_next();
+            break;
+        default:
+            other = &seeds[random_next() % seed_count];
+            if(at + other->size <= MAX_INPUT){
+                memcpy(&out[at], other->bytes, other->size);
+                size = at + other->size;
+            }
+            break;
+        }
+    }
+    return size;
+}
+
+static int read_file(FILE *file, unsigned char *data, unsigned int *size){
+    *size = (unsigned int)fread(data, 1U, MAX_INPUT, file);
+    return ferror(file) ? 1 : 0;
+}
+
+static int write_corpus(const char *dir){
+    char path[256];
+    FILE *file;
+    unsigned int i;
+
+    for(i = 0U; i < seed_count; i++){
+        snprintf(path, sizeof(path), "%s/%s", dir, seeds[i].name);
+        file = fopen(path, "wb");
+        if((file == 0) || (fwrite(seeds[i].bytes, 1U, seeds[i].size, file) != seeds[i].size)){
+            fprintf(stderr, "fp_reply: cannot write %s\n", path);
+            return 2;
+        }
+        fclose(file);
+    }
+    return 0;
+}
+
+static int run_seeds(void){
+    static unsigned char input[MAX_INPUT];
+    unsigned int failures = 0U;
+    unsigned int replies = 0U;
+    unsigned int count;
+    unsigned int i;
+
+    for(i = 0U; i < seed_count; i++){
+        count = run(seeds[i].bytes, seeds[i].size);
+        printf("%-48s %s\n", seeds[i].name, (count == seeds[i].replies) ? "PASS" : "FAIL");
+        failures += (count == seeds[i].replies) ? 0U : 1U;
+    }
+    for(i = 0U; i < ITERATIONS; i++){
+        replies += run(input, mutate(input, &seeds[i % seed_count]));
+    }
+    printf("%u mutated inputs, %u replies accepted and checked\n", ITERATIONS, replies);
+    printf("%u failure(s)\n", failures);
+    return (failures == 0U) ? 0 : 1;
+}
+
+static double seconds_now(void){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/* Parses a stream of the seeds with a random byte of noise after every eighth */
+static int bench(void){
+    static unsigned char stream[BENCH_SIZE];
+    unsigned int size = 0U;
+    unsigned int replies = 0U;
+    unsigned int pass;
+    unsigned int i;
+    double best_s = 1e9;
+    double start_s;
+    double pass_s;
+#ifdef BENCH_CYCLES
+    unsigned long long cycles;
+    unsigned long long best_cycles = ~0ULL;
+#endif
+
+    for(i = 0U; size + seeds[i % seed_count].size + 1U <= BENCH_SIZE; i++){
+        memcpy(&stream[size], seeds[i % seed_count].bytes, seeds[i % seed_count].size);
+        size += seeds[i % seed_count].size;
+        if((i % 8U) == 7U){
+            stream[size++] = (unsigned char)random_next();
+        }
+    }
+    for(pass = 0U; pass < BENCH_PASSES; pass++){
+        FpReply_Reset();
+        replies = 0U;
+        start_s = seconds_now();
+#ifdef BENCH_CYCLES
+        cycles = BENCH_CYCLES();
+#endif
+        for(i = 0U; i < size; i++){
+            replies += FpReply_Feed(stream[i]);
+        }
+#ifdef BENCH_CYCLES
+        cycles = BENCH_CYCLES() - cycles;
+        best_cycles = (cycles < best_cycles) ? cycles : best_cycles;
+#endif
+        pass_s = seconds_now() - start_s;
+        best_s = (pass_s < best_s) ? pass_s : best_s;
+    }
+    printf("stream              %u bytes, %u replies, best of %u passes\n", size, replies, BENCH_PASSES);
+    printf("throughput          %.1f MB/s, %.2f ns/byte\n", (double)size / best_s / 1e6, best_s * 1e9 / (double)size);
+#ifdef BENCH_CYCLES
+    printf("host                %.2f TSC cycles/byte\n", (double)best_cycles / (double)size);
+#endif
+    return 0;
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Fuzz target: parses an input and checks the replies accepted.
+ *
+ * @param[in]  data The input.
+ * @param[in]  size Bytes of the input, the first MAX_INPUT are used.
+ * @return    0
+ */
+int LLVMFuzzerTestOneInput(const unsigned char *data, unsigned long size){
+    static unsigned char recovery[RECOVERY_BYTES + FRAME_MAX];
+    static unsigned int recovery_size;
+    unsigned int count = (size > MAX_INPUT) ? MAX_INPUT : (unsigned int)size;
+    unsigned int i;
+
+    if(recovery_size == 0U){
+        recovery_size = RECOVERY_BYTES;
+        recovery[recovery_size++] = 0xEF;
+        recovery[recovery_size++] = 0x01;
+        memset(&recovery[recovery_size], 0xFF, 4U);
+        recovery_size += 4U;
+        recovery[recovery_size++] = FP_REPLY_PID_ACK;
+        recovery[recovery_size++] = 0x00;
+        recovery[recovery_size++] = 0x03;
+        recovery[recovery_size++] = 0x02;       /* No finger */
+        recovery[recovery_size++] = 0x00;
+        recovery[recovery_size++] = 0x0C;
+    }
+
+    FpReply_Reset();
+    accepted = 0U;
+    for(i = 0U; i < count; i++){
+        if(FpReply_Feed(data[i])){
+            accepted++;
+            check_reply(data, i);
+        }
+    }
+    for(i = 0U; i < recovery_size; i++){
+        if(FpReply_Feed(recovery[i]) && (i != recovery_size - 1U)){
+            fail("reply accepted inside the recovery bytes");
+        }
+    }
+    if((FpReply_Code() != 0x02U) || (FpReply_DataLength() != 0U)){
+        fail("valid reply not accepted after the recovery bytes");
+    }
+    return 0;
+}
+
+/*==================================================================================================
+*                                       MAIN FUNCTION
+==================================================================================================*/
+
+#ifndef FP_REPLY_LIBFUZZER
+int main(int argc, char *argv[]){
+    static unsigned char input[MAX_INPUT];
+    unsigned int size;
+    FILE *file;
+    int arg;
+
+    seeds_build();
+    if(argc == 1){
+        return run_seeds();
+    }
+    if(strcmp(argv[1], "-b") == 0){
+        return bench();
+    }
+    if((strcmp(argv[1], "-c") == 0) && (argc == 3)){
+        return write_corpus(argv[2]);
+    }
+    for(arg = 1; arg < argc; arg++){
+        file = (strcmp(argv[arg], "-") == 0) ? stdin : fopen(argv[arg], "rb");
+        if((file == 0) || read_file(file, input, &size)){
+            fprintf(stderr, "fp_reply: cannot read %s\n", argv[arg]);
+            return 2;
+        }
+        if(file != stdin){
+            fclose(file);
+        }
+        printf("%-48s %u replies\n", argv[arg], run(input, size));
+    }
+    return 0;
+}
+#endif /* FP_REPLY_LIBFUZZER */
@@ -0,0 +1,24 @@
+/**
+*   @file    host_port.h
+*   @brief   Interrupt model of the kernel host port.
+*   @details The host port runs each kernel thread on its own ucontext. PRIMASK, the interrupt
+*            nesting and the pending PendSV are plain variables: a pending switch is taken when
+*            the last simulated interrupt handler returns or when a thread leaves its critical
+*            section, as on the Cortex-M4.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef HOST_PORT_H
+#define HOST_PORT_H
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void host_isr_enter(void);
+void host_isr_exit(void);
+unsigned int host_switch_count(void);
+
+#endif /* HOST_PORT_H */
@@ -0,0 +1,180 @@
+/**
+*   @file    kernel_model.c
+*   @brief   Behavioural test of the micro-kernel scheduler on the host.
+*   @details Three threads run the real src/kernel.c on the host port: H (priority 0) and
+*            M (priority 1) follow fixed scripts of blocking calls, D (lowest priority, the idle
+*            thread) drives them by giving semaphores, setting flags, putting messages, raising
+*            simulated interrupts and ticking, and checks after every action which thread ran.
+*            A failed check also prints the steps completed so far.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kernel.h"
+#include "host_port.h"
+#include "check.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define STACK_WORDS     16384U
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static unsigned int stack_h[STACK_WORDS];
+static unsigned int stack_m[STACK_WORDS];
+static unsigned int stack_d[STACK_WORDS];
+
+static kernel_sem_t sem_a, sem_b, sem_c, sem_m, sem_end;
+static kernel_flags_t flags;
+static kernel_queue_t queue;
+static unsigned int queue_storage[2];
+
+static char trace[64];                  /* One letter per script step completed */
+static unsigned int h_flags_received;
+static unsigned int h_timeout_status;
+static unsigned int m_messages[3];
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+static void mark(char step){
+    size_t len = strlen(trace);
+    trace[len] = step;
+    trace[len + 1] = '\0';
+}
+
+static void print_trace(void){
+    printf("    trace: \"%s\"\n", trace);
+}
+
+static void tick(void){
+    host_isr_enter();
+    Kernel_Tick();
+    host_isr_exit();
+}
+
+static void thread_h(void *arg){
+    (void)arg;
+    (void)Kernel_SemTake(&sem_a, KERNEL_WAIT_FOREVER);
+    mark('a');
+    h_flags_received = Kernel_FlagsWait(&flags, 0x3U, KERNEL_WAIT_FOREVER);
+    mark('f');
+    h_timeout_status = Kernel_SemTake(&sem_b, 3U);
+    mark('t');
+    (void)Kernel_SemTake(&sem_c, KERNEL_WAIT_FOREVER);
+    mark('c');
+    Kernel_Delay(2U);
+    mark('d');
+    (void)Kernel_SemTake(&sem_end, KERNEL_WAIT_FOREVER);
+}
+
+static void thread_m(void *arg){
+    unsigned int i;
+    (void)arg;
+    (void)Kernel_SemTake(&sem_m, KERNEL_WAIT_FOREVER);
+    for(i = 0; i < 3U; i++){
+        (void)Kernel_QueueGet(&queue, &m_messages[i], KERNEL_WAIT_FOREVER);
+        mark('q');
+    }
+    (void)Kernel_SemTake(&sem_c, KERNEL_WAIT_FOREVER);
+    mark('C');
+    (void)Kernel_SemTake(&sem_end, KERNEL_WAIT_FOREVER);
+}
+
+static void thread_d(void *arg){
+    unsigned int before;
+    stack_usage_t usage;
+    (void)arg;
+
+    CHECK("start: H and M block, idle thread runs", strcmp(trace, "") == 0 && Kernel_CurrentThread() == 2U);
+
+    before = host_switch_count();
+    Kernel_SemGive(&sem_a);
+    CHECK("semaphore give preempts the giver", strcmp(trace, "a") == 0);
+    CHECK("  two switches (to H and back)", host_switch_count() - before == 2U);
+
+    host_isr_enter();
+    Kernel_FlagsSet(&flags, 0x2U | 0x4U);
+    CHECK("no switch inside an interrupt handler", strcmp(trace, "a") == 0);
+    host_isr_exit();
+    CHECK("switch when the handler returns", strcmp(trace, "af") == 0);
+    CHECK("  waiter receives only its flags", h_flags_received == 0x2U);
+    CHECK("  other flags stay set", Kernel_FlagsWait(&flags, 0x4U, KERNEL_NO_WAIT) == 0x4U);
+
+    tick();
+    tick();
+    CHECK("no timeout before 3 ticks", strcmp(trace, "af") == 0);
+    tick();
+    CHECK("timeout after 3 ticks", strcmp(trace, "aft") == 0 && h_timeout_status == KERNEL_TIMEOUT);
+
+    CHECK("queue put", Kernel_QueuePut(&queue, 1U) == KERNEL_OK);
+    CHECK("queue put", Kernel_QueuePut(&queue, 2U) == KERNEL_OK);
+    CHECK("queue full", Kernel_QueuePut(&queue, 3U) == KERNEL_FULL);
+    Kernel_SemGive(&sem_m);
+    CHECK("queued messages received in order", strcmp(trace, "aftqq") == 0 &&
+          m_messages[0] == 1U && m_messages[1] == 2U);
+    CHECK("queue put to a waiting thread", Kernel_QueuePut(&queue, 3U) == KERNEL_OK);
+    CHECK("  waiting thread receives it at once", strcmp(trace, "aftqqq") == 0 && m_messages[2] == 3U);
+
+    Kernel_SemGive(&sem_c);
+    CHECK("highest priority waiter gets the unit", strcmp(trace, "aftqqqc") == 0);
+    Kernel_SemGive(&sem_c);
+    CHECK("next waiter gets the next unit", strcmp(trace, "aftqqqcC") == 0);
+
+    tick();
+    CHECK("delay not elapsed after 1 tick", strcmp(trace, "aftqqqcC") == 0);
+    tick();
+    CHECK("delay elapsed after 2 ticks", strcmp(trace, "aftqqqcCd") == 0);
+
+    Kernel_SemGive(&sem_b);
+    CHECK("give without waiter is counted", Kernel_SemTake(&sem_b, KERNEL_NO_WAIT) == KERNEL_OK);
+    CHECK("take without unit and no wait", Kernel_SemTake(&sem_b, KERNEL_NO_WAIT) == KERNEL_TIMEOUT);
+
+    Kernel_GetStackUsage(0, &usage);
+    CHECK("stack high-water mark of a thread", (usage.size == sizeof(stack_h)) &&
+          (usage.used > 0U) && (usage.used < usage.size));
+    Kernel_GetStackUsage(3, &usage);
+    CHECK("no stack without a thread", (usage.size == 0U) && (usage.used == 0U));
+
+    printf("%u context switches, ", host_switch_count());
+    exit(check_summary());
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/* Sleep of the idle code: the idle thread D never sleeps, it drives the test */
+void host_wfi(void){
+}
+
+/*==================================================================================================
+*                                       MAIN FUNCTION
+==================================================================================================*/
+
+int main(void){
+    check_detail = print_trace;
+    Kernel_Init();
+    Kernel_SemInit(&sem_a, 0);
+    Kernel_SemInit(&sem_b, 0);
+    Kernel_SemInit(&sem_c, 0);
+    Kernel_SemInit(&sem_m, 0);
+    Kernel_SemInit(&sem_end, 0);
+    Kernel_FlagsInit(&flags);
+    Kernel_QueueInit(&queue, queue_storage, 2U);
+    Kernel_ThreadCreate(0, thread_h, 0, stack_h, STACK_WORDS);
+    Kernel_ThreadCreate(1, thread_m, 0, stack_m, STACK_WORDS);
+    Kernel_ThreadCreate(2, thread_d, 0, stack_d, STACK_WORDS);
+    Kernel_Start();
+    return 2;
+}
@@ -0,0 +1,123 @@
+/**
+*   @file    kernel_port_host.c
+*   @brief   Host (Linux) port layer of the micro-kernel.
+*   @details Replaces the PendSV handler and the stack frames of src/kernel.c with ucontext
+*            switches, so that the scheduling decisions of the real kernel code can be checked
+*            on the host. The thread stacks given to Kernel_ThreadCreate() are used as the
+*            ucontext stacks and must be large enough for the C library. The harness provides
+*            host_wfi(), the sleep of the idle code.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include "kernel.h"
+#include "core.h"
+#include "host_port.h"
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static ucontext_t main_context;
+static ucontext_t thread_context[KERNEL_MAX_THREADS];
+static kernel_entry_t thread_entry[KERNEL_MAX_THREADS];
+static void *thread_arg[KERNEL_MAX_THREADS];
+static int running = -1;                /* Thread on the CPU, -1 before Kernel_Start() */
+static unsigned int primask = 0;
+static unsigned int isr_depth = 0;
+static unsigned int pendsv = 0;
+static unsigned int switches = 0;
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Takes the pending PendSV if nothing masks it.
+ *
+ * @return    void
+ */
+static void host_take_pendsv(void){
+    int previous;
+    while((pendsv != 0U) && (primask == 0U) && (isr_depth == 0U)){
+        pendsv = 0U;
+        primask = 1U;
+        (void)Kernel_SwitchContext(0);
+        primask = 0U;
+        previous = running;
+        running = (int)Kernel_CurrentThread();
+        if(previous != running){
+            switches++;
+            swapcontext((previous < 0) ? &main_context : &thread_context[previous],
+                        &thread_context[running]);
+        }
+    }
+}
+
+/*!
+ * @brief     Runs the entry point of the thread that was just switched to.
+ *
+ * @return    void
+ */
+static void host_thread_start(void){
+    thread_entry[running](thread_arg[running]);
+    fprintf(stderr, "kernel model: thread %d returned\n", running);
+    exit(2);
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+unsigned int host_irq_save(void){
+    unsigned int saved = primask;
+    primask = 1U;
+    return saved;
+}
+
+void host_irq_restore(unsigned int saved){
+    primask = saved;
+    host_take_pendsv();
+}
+
+void host_isr_enter(void){
+    isr_depth++;
+}
+
+void host_isr_exit(void){
+    isr_depth--;
+    host_take_pendsv();
+}
+
+unsigned int host_switch_count(void){
+    return switches;
+}
+
+void kernel_port_pend(void){
+    pendsv = 1U;
+}
+
+unsigned int *kernel_port_init_stack(unsigned char thread_id, kernel_entry_t entry, void *arg,
+                                     unsigned int *stack, unsigned int stack_words){
+    thread_entry[thread_id] = entry;
+    thread_arg[thread_id] = arg;
+    getcontext(&thread_context[thread_id]);
+    thread_context[thread_id].uc_stack.ss_sp = stack;
+    thread_context[thread_id].uc_stack.ss_size = stack_words * sizeof(unsigned int);
+    thread_context[thread_id].uc_link = 0;
+    makecontext(&thread_context[thread_id], host_thread_start, 0);
+    return stack;
+}
+
+void kernel_port_start(void){
+    primask = 0U;
+    pendsv = 1U;
+    host_take_pendsv();
+    fprintf(stderr, "kernel model: returned to main\n");
+    exit(2);
+}
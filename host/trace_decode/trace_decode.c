@@ -0,0 +1,328 @@
+/**
+*   @file    trace_decode.c
+*   @brief   Decoder of the trace ring dumps and self-test of the trace ring.
+*   @details A dump is the stream ADMIN_CMD_TRACE sends on the console, or board_sim -d
+*            writes (see trace.h). The decoder prints it as a timeline, one line per record
+*            and a rule at each boot, or with -j as Trace Event JSON, which chrome://tracing
+*            and ui.perfetto.dev open: one process per boot, one thread per source (sensor,
+*            keypad and LCD, lock), the door open as a slice from TRACE_LOCK_OPEN to
+*            TRACE_LOCK_CLOSE and the other records as instants.
+*
+*            The self-test links src/trace.c with a stub of the millisecond tick, fills the
+*            ring past its size, across a warm reset, and checks that the dump it encodes
+*            decodes to the records of the ring, oldest first.
+*
+*            Usage: trace_decode [-j] [file | -]; trace_decode -s runs the self-test.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+#include "check.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define DUMP_MAX                (TRACE_DUMP_HEADER + 0xFFFFU * TRACE_DUMP_RECORD)
+#define TEXT_SIZE               64U
+#define SELF_TEST_RECORDS       300U            /* More than the ring holds */
+
+/* Threads of the JSON output */
+#define TID_SENSOR              1U
+#define TID_UI                  2U
+#define TID_LOCK                3U
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static const char *const event_names[] = {
+    "?", "boot", "finger mode", "sensor command", "sensor reply", "sensor timeout", "key",
+    "lcd flush", "lock"
+};
+
+static const char *const mode_names[] = {"enroll", "search", "name entry"};
+
+static unsigned char dump[DUMP_MAX];
+static unsigned int tick;                       /* Millisecond tick of the self-test */
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+static const char *event_name(unsigned char event){
+    return (event < sizeof(event_names) / sizeof(event_names[0])) ? event_names[event] : event_names[0];
+}
+
+static const char *mode_name(unsigned int mode){
+    return (mode < sizeof(mode_names) / sizeof(mode_names[0])) ? mode_names[mode] : "?";
+}
+
+/* Checks a dump and decodes its records, 0 if it is not a complete dump */
+static unsigned int parse_dump(const unsigned char *data, unsigned int size, trace_record_t *records,
+                               unsigned int *count){
+    const unsigned char *in;
+    unsigned int i;
+
+    if((size < TRACE_DUMP_HEADER) || (data[0] != TRACE_DUMP_MAGIC) || (data[1] != TRACE_DUMP_VERSION)){
+        return 0U;
+    }
+    *count = ((unsigned int)data[2] << 8) | data[3];
+    if(size != TRACE_DUMP_HEADER + *count * TRACE_DUMP_RECORD){
+        return 0U;
+    }
+    for(i = 0U; i < *count; i++){
+        in = &data[TRACE_DUMP_HEADER + i * TRACE_DUMP_RECORD];
+        records[i].ms = ((unsigned int)in[0] << 24) | ((unsigned int)in[1] << 16) |
+                        ((unsigned int)in[2] << 8) | in[3];
+        records[i].event = in[4];
+        records[i].arg0 = in[5];
+        records[i].arg1 = (unsigned short)(((unsigned int)in[6] << 8) | in[7]);
+    }
+    return 1U;
+}
+
+/* Writes the arguments of a record as text */
+static void format_args(const trace_record_t *record, char *text){
+    switch(record->event){
+    case TRACE_BOOT:
+        snprintf(text, TEXT_SIZE, "%u since the ring was cleared", record->arg1);
+        break;
+    case TRACE_FINGER_MODE:
+        snprintf(text, TEXT_SIZE, "%s -> %s", mode_name(record->arg1), mode_name(record->arg0));
+        break;
+    case TRACE_FP_COMMAND:
+        snprintf(text, TEXT_SIZE, "instruction 0x%02X page %u", record->arg0, record->arg1);
+        break;
+    case TRACE_FP_REPLY:
+        if(record->arg1 == 0xFFFFU){
+            snprintf(text, TEXT_SIZE, "code 0x%02X", record->arg0);
+        }else{
+            snprintf(text, TEXT_SIZE, "code 0x%02X word %u", record->arg0, record->arg1);
+        }
+        break;
+    case TRACE_FP_TIMEOUT:
+        snprintf(text, TEXT_SIZE, "no valid reply");
+        break;
+    case TRACE_KEY:
+        snprintf(text, TEXT_SIZE, "key %u in %s mode", record->arg0, record->arg1 ? "letter" : "digit");
+        break;
+    case TRACE_LCD_FLUSH:
+        snprintf(text, TEXT_SIZE, "%u characters", record->arg1);
+        break;
+    case TRACE_LOCK:
+        if(record->arg0 == TRACE_LOCK_OPEN){
+            snprintf(text, TEXT_SIZE, "open, %u cycles from the signal%s", record->arg1,
+                     (record->arg1 == 0xFFFFU) ? " or more" : "");
+        }else{
+            snprintf(text, TEXT_SIZE, "closed %s", record->arg1 ? "on request" : "after the hold time");
+        }
+        break;
+    default:
+        snprintf(text, TEXT_SIZE, "%u %u", record->arg0, record->arg1);
+        break;
+    }
+}
+
+/* Prints the records as a timeline */
+static void print_text(const trace_record_t *records, unsigned int count){
+    char text[TEXT_SIZE];
+    unsigned int i;
+
+    for(i = 0U; i < count; i++){
+        if(records[i].event == TRACE_BOOT){
+            printf("---------------- boot --------------------------------------------------\n");
+        }
+        format_args(&records[i], text);
+        printf("%10u ms  %-15s %s\n", records[i].ms, event_name(records[i].event), text);
+    }
+}
+
+/* Prints the records as Trace Event JSON, timestamps in microseconds */
+static void print_json(const trace_record_t *records, unsigned int count){
+    char text[TEXT_SIZE];
+    unsigned int boot = 0U;
+    unsigned int tid;
+    const char *phase;
+    unsigned int i;
+
+    printf("{\"traceEvents\":[\n");
+    for(i = 0U; i < count; i++){
+        if(records[i].event == TRACE_BOOT){
+            boot++;
+        }
+        if((records[i].event == TRACE_FP_COMMAND) || (records[i].event == TRACE_FP_REPLY) ||
+           (records[i].event == TRACE_FP_TIMEOUT) || (records[i].event == TRACE_FINGER_MODE)){
+            tid = TID_SENSOR;
+        }else if(records[i].event == TRACE_LOCK){
+            tid = TID_LOCK;
+        }else{
+            tid = TID_UI;
+        }
+        if(records[i].event != TRACE_LOCK){
+            phase = "\"i\",\"s\":\"t\"";     /* Instant of the thread */
+        }else{
+            phase = (records[i].arg0 == TRACE_LOCK_OPEN) ? "\"B\"" : "\"E\"";
+        }
+        format_args(&records[i], text);
+        printf("%s{\"name\":\"%s\",\"ph\":%s,\"ts\":%llu,\"pid\":%u,\"tid\":%u,\"args\":{\"detail\":\"%s\"}}\n",
+               (i == 0U) ? "" : ",", (records[i].event == TRACE_LOCK) ? "door open" : event_name(records[i].event),
+               phase, (unsigned long long)records[i].ms * 1000ULL, boot, tid, text);
+    }
+    printf("],\"displayTimeUnit\":\"ms\"}\n");
+}
+
+/* Dumps the ring as the firmware does, returns the size of the dump */
+static unsigned int encode_ring(void){
+    unsigned int size;
+    unsigned int i;
+
+    size = Trace_DumpHeader(dump);
+    for(i = 0U; i < Trace_Count(); i++){
+        size += Trace_DumpRecord(i, &dump[size]);
+    }
+    return size;
+}
+
+static int self_test(void){
+    static trace_record_t decoded[TRACE_RECORDS];
+    trace_record_t record;
+    char text[TEXT_SIZE];
+    unsigned int count;
+    unsigned int size;
+    unsigned int same;
+    unsigned int i;
+
+    tick = 5U;
+    Trace_Init();
+    Trace_Get(0U, &record);
+    CHECK("first boot recorded", (Trace_Count() == 1U) && (record.event == TRACE_BOOT) &&
+          (record.arg1 == 1U) && (record.ms == 5U));
+    Trace_Record(TRACE_KEY, 3U, 1U);
+    tick = 0U;
+    Trace_Init();
+    Trace_Get(2U, &record);
+    CHECK("ring kept across a warm reset", (Trace_Count() == 3U) && (record.event == TRACE_BOOT) &&
+          (record.arg1 == 2U));
+
+    for(i = 0U; i < SELF_TEST_RECORDS; i++){
+        tick = 100U + i;
+        Trace_Record(TRACE_FP_COMMAND, (unsigned char)i, (unsigned short)(i * 257U));
+    }
+    Trace_Get(0U, &record);
+    CHECK("full ring holds the newest records", Trace_Count() == TRACE_RECORDS);
+    CHECK("  oldest first", (record.ms == 100U + SELF_TEST_RECORDS - TRACE_RECORDS) &&
+          (record.arg1 == (unsigned short)((SELF_TEST_RECORDS - TRACE_RECORDS) * 257U)));
+    Trace_Get(TRACE_RECORDS - 1U, &record);
+    CHECK("  newest last", (record.ms == 100U + SELF_TEST_RECORDS - 1U) &&
+          (record.arg0 == (unsigned char)(SELF_TEST_RECORDS - 1U)));
+
+    Trace_Freeze(1U);
+    Trace_Record(TRACE_LOCK, TRACE_LOCK_OPEN, 40U);
+    size = encode_ring();
+    Trace_Get(TRACE_RECORDS - 1U, &record);
+    CHECK("frozen ring drops the events", record.event == TRACE_FP_COMMAND);
+    CHECK("dump size", size == TRACE_DUMP_HEADER + TRACE_RECORDS * TRACE_DUMP_RECORD);
+    same = parse_dump(dump, size, decoded, &count) && (count == TRACE_RECORDS);
+    for(i = 0U; same && (i < count); i++){
+        Trace_Get(i, &record);
+        same = (decoded[i].ms == record.ms) && (decoded[i].event == record.event) &&
+               (decoded[i].arg0 == record.arg0) && (decoded[i].arg1 == record.arg1);
+    }
+    CHECK("dump decodes to the records of the ring", same);
+    CHECK("truncated dump refused", !parse_dump(dump, size - 1U, decoded, &count));
+    dump[0] = 'X';
+    CHECK("dump with a bad magic refused", !parse_dump(dump, size, decoded, &count));
+    Trace_Freeze(0U);
+
+    Trace_Clear();
+    CHECK("cleared ring is empty", Trace_Count() == 0U);
+    Trace_Init();
+    Trace_Record(TRACE_LOCK, TRACE_LOCK_OPEN, 0xFFFFU);
+    Trace_Record(TRACE_LOCK, TRACE_LOCK_CLOSE, 1U);
+    size = encode_ring();
+    CHECK("boot count restarts after a clear", parse_dump(dump, size, decoded, &count) && (count == 3U) &&
+          (decoded[0].arg1 == 1U));
+    format_args(&decoded[1], text);
+    CHECK("  lock opening printed", strcmp(text, "open, 65535 cycles from the signal or more") == 0);
+    format_args(&decoded[2], text);
+    CHECK("  lock closing printed", strcmp(text, "closed on request") == 0);
+
+    return check_summary();
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Millisecond tick of the self-test, see systick.h.
+ *
+ * @return    The tick.
+ */
+unsigned int SysTick_GetTick(void){
+    return tick;
+}
+
+/*!
+ * @brief     Interrupt masking of the self-test, see core.h: there are no interrupts.
+ *
+ * @return    0
+ */
+unsigned int host_irq_save(void){
+    return 0U;
+}
+
+/*!
+ * @brief     Interrupt unmasking of the self-test, see core.h.
+ *
+ * @param[in]  primask Unused.
+ * @return    void
+ */
+void host_irq_restore(unsigned int primask){
+    (void)primask;
+}
+
+/*==================================================================================================
+*                                       MAIN FUNCTION
+==================================================================================================*/
+
+int main(int argc, char *argv[]){
+    static trace_record_t records[0x10000U];
+    unsigned int json = 0U;
+    unsigned int count;
+    unsigned int size;
+    FILE *file = stdin;
+    int arg;
+
+    for(arg = 1; arg < argc; arg++){
+        if(strcmp(argv[arg], "-s") == 0){
+            return self_test();
+        }else if(strcmp(argv[arg], "-j") == 0){
+            json = 1U;
+        }else if(strcmp(argv[arg], "-") != 0){
+            file = fopen(argv[arg], "rb");
+            if(file == 0){
+                fprintf(stderr, "trace decode: cannot read %s\n", argv[arg]);
+                return 2;
+            }
+        }
+    }
+    size = (unsigned int)fread(dump, 1U, sizeof(dump), file);
+    if(!parse_dump(dump, size, records, &count)){
+        fprintf(stderr, "trace decode: not a complete trace dump, %u bytes\n", size);
+        return 1;
+    }
+    if(json){
+        print_json(records, count);
+    }else{
+        print_text(records, count);
+    }
+    return 0;
+}
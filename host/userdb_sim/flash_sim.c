@@ -0,0 +1,180 @@
+/**
+*   @file    flash_sim.c
+*   @brief   Flash simulator of the user database and event log host tests.
+*   @details Implements the program flash calls of flash.h used by src/userdb.c, the FlexNVM
+*            calls used by src/event_log.c and the address mapping of their HOST_BUILD.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "flash.h"
+#include "userdb.h"
+#include "event_log.h"
+#include "flash_sim.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define SIM_SIZE        (USERDB_SECTORS * FLASH_PFLASH_SECTOR)
+#define SIM_DFLASH_SIZE (EVENT_LOG_SECTORS * FLASH_DFLASH_SECTOR)
+
+/* Fault of an operation */
+#define SIM_NONE        0
+#define SIM_CUT         1               /* Power loss during the operation */
+#define SIM_FAIL        2               /* The operation fails */
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+jmp_buf flash_sim_cut;
+
+static unsigned char pflash[SIM_SIZE];
+static unsigned char dflash[SIM_DFLASH_SIZE];
+static unsigned int operations = 0;     /* Program and erase operations since the start */
+static unsigned int cut_at = 0;         /* Operation cut by the power loss, 0 for none */
+static unsigned int fail_at = 0;        /* Operation that fails, 0 for none */
+static unsigned int violations = 0;
+static unsigned char dflash_status = FLASH_OK;  /* Outcome of the last FlexNVM command */
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+static unsigned char *sim_map(unsigned int address, unsigned int size){
+    if((address >= USERDB_BASE) && (address - USERDB_BASE + size <= SIM_SIZE)){
+        return &pflash[address - USERDB_BASE];
+    }
+    if((address >= FLASH_DFLASH_BASE) && (address - FLASH_DFLASH_BASE + size <= SIM_DFLASH_SIZE)){
+        return &dflash[address - FLASH_DFLASH_BASE];
+    }
+    printf("access outside the simulated flash: 0x%08X\n", address);
+    exit(2);
+}
+
+/* Counts an operation and tells whether the power is cut during it or it fails */
+static int sim_fault_now(void){
+    operations++;
+    if((cut_at != 0U) && (operations == cut_at)){
+        cut_at = 0U;
+        return SIM_CUT;
+    }
+    if((fail_at != 0U) && (operations == fail_at)){
+        fail_at = 0U;
+        return SIM_FAIL;
+    }
+    return SIM_NONE;
+}
+
+static unsigned char sim_program(unsigned char *p, const unsigned char *data){
+    unsigned int i;
+    int fault;
+
+    for(i = 0U; i < FLASH_PHRASE_SIZE; i++){
+        if(p[i] != 0xFFU){
+            violations++;
+            return FLASH_ERROR;
+        }
+    }
+    fault = sim_fault_now();
+    if(fault != SIM_NONE){
+        for(i = 0U; i < FLASH_PHRASE_SIZE; i++){
+            if(rand() & 1){
+                p[i] &= (unsigned char)(data[i] | rand());
+            }
+        }
+        if(fault == SIM_CUT){
+            longjmp(flash_sim_cut, 1);
+        }
+        return FLASH_ERROR;
+    }
+    for(i = 0U; i < FLASH_PHRASE_SIZE; i++){
+        p[i] &= data[i];
+    }
+    return FLASH_OK;
+}
+
+static unsigned char sim_erase(unsigned char *p, unsigned int size){
+    unsigned int i;
+    int fault;
+
+    fault = sim_fault_now();
+    if(fault != SIM_NONE){
+        for(i = 0U; i < size; i++){
+            if(rand() & 1){
+                p[i] = 0xFFU;
+            }
+        }
+        if(fault == SIM_CUT){
+            longjmp(flash_sim_cut, 1);
+        }
+        return FLASH_ERROR;
+    }
+    memset(p, 0xFF, size);
+    return FLASH_OK;
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+const unsigned char *host_flash_map(unsigned int address){
+    return sim_map(address, 1U);
+}
+
+unsigned char Flash_ProgramPFlashPhrase(unsigned int address, const unsigned char *data){
+    return sim_program(sim_map(address, FLASH_PHRASE_SIZE), data);
+}
+
+unsigned char Flash_ErasePFlashSector(unsigned int address){
+    return sim_erase(sim_map(address, FLASH_PFLASH_SECTOR), FLASH_PFLASH_SECTOR);
+}
+
+unsigned char Flash_IsBusy(void){
+    return 0U;
+}
+
+unsigned char Flash_GetStatus(void){
+    return dflash_status;
+}
+
+unsigned char Flash_StartProgramPhrase(unsigned int address, const unsigned char *data){
+    dflash_status = sim_program(sim_map(address, FLASH_PHRASE_SIZE), data);
+    return FLASH_OK;
+}
+
+unsigned char Flash_StartEraseSector(unsigned int address){
+    dflash_status = sim_erase(sim_map(address, FLASH_DFLASH_SECTOR), FLASH_DFLASH_SECTOR);
+    return FLASH_OK;
+}
+
+void Flash_EnableDoneIrq(void){
+}
+
+void flash_sim_erase_all(void){
+    memset(pflash, 0xFF, sizeof(pflash));
+    memset(dflash, 0xFF, sizeof(dflash));
+    dflash_status = FLASH_OK;
+}
+
+void flash_sim_arm_cut(unsigned int operation){
+    cut_at = operation;
+}
+
+void flash_sim_arm_failure(unsigned int operation){
+    fail_at = operation;
+}
+
+unsigned int flash_sim_operations(void){
+    return operations;
+}
+
+unsigned int flash_sim_violations(void){
+    return violations;
+}
@@ -0,0 +1,38 @@
+/**
+*   @file    flash_sim.h
+*   @brief   Flash simulator of the user database and event log host tests.
+*   @details The simulator holds the USERDB_SECTORS program flash sectors of the database and
+*            the EVENT_LOG_SECTORS FlexNVM sectors of the event log. Programming only clears
+*            bits, as on the device, and programming a phrase that is not erased is counted as
+*            a violation. The FlexNVM commands complete at once, Flash_GetStatus() then returns
+*            their outcome. A power cut can be armed at any flash operation: that operation is
+*            left half done (some bytes of the phrase programmed, some bytes of the sector
+*            erased) and the simulator jumps back to flash_sim_cut, as the reset would. A
+*            failure can be armed the same way: the operation is left half done and fails.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef FLASH_SIM_H
+#define FLASH_SIM_H
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <setjmp.h>
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+extern jmp_buf flash_sim_cut;
+
+void flash_sim_erase_all(void);
+void flash_sim_arm_cut(unsigned int operation);
+void flash_sim_arm_failure(unsigned int operation);
+unsigned int flash_sim_operations(void);
+unsigned int flash_sim_violations(void);
+
+#endif /* FLASH_SIM_H */
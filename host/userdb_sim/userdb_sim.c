@@ -0,0 +1,263 @@
+/**
+*   @file    userdb_sim.c
+*   @brief   Behavioural and power-cut test of the user database on the host.
+*   @details Runs the real src/userdb.c on the program flash simulator against a model of the
+*            users kept in RAM. A random workload of saves, renames and deletes, with the
+*            background compaction run after each change, is checked after every reboot. The
+*            power-cut test then replays the workload once per cut point, cutting the power in
+*            the middle of a program or erase operation: after the reboot every user must match
+*            the model, except the one being changed, which must have its old or its new value.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "userdb.h"
+#include "flash_sim.h"
+#include "check.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define WORKLOAD_OPS    3000U           /* Changes per run, enough to compact every sector */
+#define HOT_USERS       40U             /* Most changes hit these users */
+#define SHARED_NAMES    4U              /* Names given to many users */
+#define CUT_STRIDE      7U              /* Prime to the 3 phrases of a save, so every phase is cut */
+#define NO_USER         0xFFFFU
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static const char shared_names[SHARED_NAMES][USERDB_NAME_LENGTH + 1U] = {
+    "ANNA", "JOHN SMITH", "NGUYEN VAN MINH", "ALEXANDER HAMMER"
+};
+static char model[USERDB_MAX_USERS][USERDB_NAME_LENGTH];
+static unsigned char present[USERDB_MAX_USERS];
+static unsigned int seed;
+static unsigned int full_count = 0;
+
+/* Change in progress, read after a power cut */
+static volatile unsigned int pending_id = NO_USER;
+static volatile unsigned char pending_delete;
+static char pending_name[USERDB_NAME_LENGTH];
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+static unsigned int next_random(void){
+    seed = seed * 1103515245U + 12345U;
+    return (seed >> 16) & 0x7FFFU;
+}
+
+static void drain_service(void){
+    unsigned int steps = 0U;
+
+    while(UserDb_Service(1U) != USERDB_SERVICE_DONE){
+        if(++steps > 10000U){
+            printf("    service does not finish\n");
+            exit(2);
+        }
+    }
+}
+
+/* Tells whether the database holds the model value of a user */
+static int user_matches(unsigned int id, unsigned char is_present, const char *name){
+    char stored[USERDB_NAME_LENGTH];
+    unsigned char status = UserDb_GetName(id, stored);
+
+    if(!is_present){
+        return status == USERDB_NOT_FOUND;
+    }
+    return (status == USERDB_OK) && (memcmp(stored, name, USERDB_NAME_LENGTH) == 0);
+}
+
+/* Counts the flash operations of a save */
+static unsigned int put_operations(unsigned int id, const char *name){
+    unsigned int operations = flash_sim_operations();
+
+    memset(model[id], 0, USERDB_NAME_LENGTH);
+    strncpy(model[id], name, USERDB_NAME_LENGTH);
+    present[id] = UserDb_Put(id, model[id]) == USERDB_OK;
+    return flash_sim_operations() - operations;
+}
+
+/* Counts the users that differ from the model, the pending one excepted */
+static unsigned int count_mismatches(unsigned int except){
+    unsigned int id;
+    unsigned int count = 0U;
+
+    for(id = 0U; id < USERDB_MAX_USERS; id++){
+        if((id != except) && !user_matches(id, present[id], model[id])){
+            count++;
+        }
+    }
+    return count;
+}
+
+static void reboot(void){
+    UserDb_Init();
+    drain_service();
+}
+
+/* Runs changes from the current seed, keeping the model in step */
+static void run_workload(unsigned int ops){
+    unsigned int i;
+    unsigned int j;
+    unsigned int length;
+    unsigned char status;
+
+    for(i = 0U; i < ops; i++){
+        memset(pending_name, 0, sizeof(pending_name));
+        pending_delete = (next_random() % 5U) == 0U;
+        pending_id = (next_random() % 4U == 0U) ? next_random() % USERDB_MAX_USERS
+                                                 : next_random() % HOT_USERS;
+        if(next_random() % 3U == 0U){
+            memcpy(pending_name, shared_names[next_random() % SHARED_NAMES], USERDB_NAME_LENGTH);
+        }else{
+            length = 1U + next_random() % USERDB_NAME_LENGTH;
+            for(j = 0U; j < length; j++){
+                pending_name[j] = (char)('A' + next_random() % 27U);
+                if(pending_name[j] > 'Z'){
+                    pending_name[j] = ' ';
+                }
+            }
+        }
+        status = pending_delete ? UserDb_Delete(pending_id) : UserDb_Put(pending_id, pending_name);
+        if(status == USERDB_OK){
+            present[pending_id] = !pending_delete;
+            memcpy(model[pending_id], pending_name, USERDB_NAME_LENGTH);
+        }else if(status == USERDB_FULL){
+            full_count++;
+        }
+        pending_id = NO_USER;
+        drain_service();
+    }
+}
+
+static void start_empty(unsigned int workload_seed){
+    flash_sim_erase_all();
+    memset(present, 0, sizeof(present));
+    memset(model, 0, sizeof(model));
+    seed = workload_seed;
+    UserDb_Init();
+}
+
+/* Runs the workload with the power cut at one flash operation, then checks the reboot */
+static int cut_trial(unsigned int cut){
+    unsigned int id;
+    int ok;
+
+    start_empty(1U);
+    flash_sim_arm_cut(flash_sim_operations() + cut);
+    if(setjmp(flash_sim_cut) == 0){
+        run_workload(WORKLOAD_OPS);
+        return -1;                      /* The workload ended before the cut point */
+    }
+    id = pending_id;
+    reboot();
+    ok = count_mismatches(id) == 0U;
+    if(id != NO_USER){
+        if(user_matches(id, !pending_delete, pending_name)){
+            present[id] = !pending_delete;
+            memcpy(model[id], pending_name, USERDB_NAME_LENGTH);
+        }else if(!user_matches(id, present[id], model[id])){
+            ok = 0;
+        }
+    }
+    pending_id = NO_USER;
+    run_workload(50U);
+    reboot();
+    return ok && (count_mismatches(NO_USER) == 0U);
+}
+
+/*==================================================================================================
+*                                       MAIN FUNCTION
+==================================================================================================*/
+
+int main(void){
+    char name[USERDB_NAME_LENGTH] = "ALICE";
+    unsigned int cut;
+    unsigned int trials = 0U;
+    unsigned int bad = 0U;
+    unsigned int operations;
+    int result;
+
+    start_empty(1U);
+    CHECK("empty database has no user", user_matches(3U, 0U, name));
+    CHECK("save a user", UserDb_Put(3U, name) == USERDB_OK);
+    CHECK("  name read back", user_matches(3U, 1U, name));
+    operations = flash_sim_operations();
+    CHECK("saving the same name writes nothing", UserDb_Put(3U, name) == USERDB_OK &&
+          flash_sim_operations() == operations);
+    memset(name, 0, sizeof(name));
+    strcpy(name, "BOB");
+    CHECK("rename", UserDb_Put(3U, name) == USERDB_OK && user_matches(3U, 1U, name));
+    reboot();
+    CHECK("  name kept across a reboot", user_matches(3U, 1U, name));
+    CHECK("delete", UserDb_Delete(3U) == USERDB_OK && user_matches(3U, 0U, name));
+    reboot();
+    CHECK("  deletion kept across a reboot", user_matches(3U, 0U, name));
+    CHECK("user out of range", UserDb_Put(USERDB_MAX_USERS, name) == USERDB_INVALID);
+    CHECK("empty name refused", UserDb_Put(3U, "") == USERDB_INVALID);
+
+    start_empty(1U);
+    put_operations(4U, "SECTOR HEADER");
+    CHECK("name of 12 characters packed in 2 phrases", put_operations(5U, "ANNA MARIA 2") == 2U);
+    CHECK("name of 16 characters packed in 3 phrases", put_operations(6U, "ALEXANDER HAMMER") == 3U);
+    CHECK("shared name stored once, 1 phrase", put_operations(7U, "ANNA MARIA 2") == 1U &&
+          put_operations(8U, "ANNA MARIA 2") == 1U);
+    put_operations(5U, "BOB");
+    CHECK("renaming the owner keeps the sharers", count_mismatches(NO_USER) == 0U);
+    UserDb_Delete(7U);
+    present[7] = 0U;
+    CHECK("deleting the new owner keeps the sharers", count_mismatches(NO_USER) == 0U);
+    reboot();
+    CHECK("  kept across a reboot", count_mismatches(NO_USER) == 0U);
+
+    start_empty(1U);
+    for(cut = 0U; cut < USERDB_MAX_USERS; cut++){
+        sprintf(model[cut], "USER %u", cut);
+        present[cut] = UserDb_Put(cut, model[cut]) == USERDB_OK;
+        drain_service();
+    }
+    CHECK("every user saved", count_mismatches(NO_USER) == 0U);
+    run_workload(WORKLOAD_OPS);
+    reboot();
+    CHECK("  and kept through changes and compaction", count_mismatches(NO_USER) == 0U);
+    CHECK("  no change refused", full_count == 0U);
+
+    start_empty(1U);
+    operations = flash_sim_operations();
+    run_workload(WORKLOAD_OPS);
+    operations = flash_sim_operations() - operations;
+    CHECK("workload matches the model", count_mismatches(NO_USER) == 0U);
+    reboot();
+    CHECK("  and still after a reboot", count_mismatches(NO_USER) == 0U);
+    CHECK("  no change refused with compaction keeping up", full_count == 0U);
+    CHECK("  no phrase programmed twice", flash_sim_violations() == 0U);
+
+    for(cut = 1U; cut <= operations + 1U; cut += CUT_STRIDE){
+        result = cut_trial(cut);
+        if(result < 0){
+            break;
+        }
+        trials++;
+        if(!result){
+            bad++;
+            printf("    power cut at operation %u: mismatch\n", cut);
+        }
+    }
+    printf("%u power cuts of %u flash operations\n", trials, operations);
+    CHECK("every power cut keeps old or new value", bad == 0U && trials > 0U);
+    CHECK("  no phrase programmed twice", flash_sim_violations() == 0U);
+    CHECK("  no change refused", full_count == 0U);
+
+    return check_summary();
+}
@@ -2,6 +2,10 @@
 *   @file    RTC.h
 *   @brief   Declaration of function prototypes and special parameters for the RTC module.
 *   @details This file contains the declarations for the RTC module, including function prototypes,
+*            and of the calendar kept by the RTC seconds interrupt. The calendar is a broken-down
+*            time advanced by one second per interrupt; epoch seconds (since 1970-01-01 00:00:00)
+*            are only computed on demand. The RTC seconds counter holds the epoch, so the time
+*            survives warm resets. Alarms raise the RTC alarm interrupt at given epoch seconds.
 *
 */
 
@@ -17,6 +21,33 @@
 
 #include "rtc_registers.h"
 
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define RTC_EPOCH_YEAR 1970U    /* Year of epoch second 0, a Thursday */
+#define RTC_VALID_EPOCH 1577836800U /* 2020-01-01 00:00:00, earlier times were never set */
+
+#define RTC_ALARM_SLOTS 8U      /* Number of alarms RTC_AlarmSet() can keep */
+#define RTC_ALARM_OFF 0xFFFFFFFFU
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/**
+ * @brief Broken-down calendar time.
+ */
+typedef struct {
+    unsigned short year;        /**< 1970 to 2105 */
+    unsigned char  month;       /**< 1 to 12 */
+    unsigned char  day;         /**< 1 to 31 */
+    unsigned char  weekday;     /**< 0 = Sunday to 6 = Saturday */
+    unsigned char  hour;        /**< 0 to 23 */
+    unsigned char  minute;      /**< 0 to 59 */
+    unsigned char  second;      /**< 0 to 59 */
+} rtc_time_t;
+
 /*==================================================================================================
 *                                    FUNCTION PROTOTYPES
 ==================================================================================================*/
@@ -29,4 +60,63 @@
  */
 void RTC_init(void);
 
+/**
+ * @brief Sets the calendar time.
+ *
+ * The weekday is computed from the date, the weekday field of time is ignored.
+ */
+void RTC_SetTime(const rtc_time_t *time);
+
+/**
+ * @brief Tells whether the time was set since the last power-on reset.
+ */
+unsigned char RTC_IsTimeValid(void);
+
+/**
+ * @brief Reads the calendar time.
+ *
+ * Returns 1 when the time changed since the previous call, 0 otherwise.
+ */
+unsigned char RTC_GetTime(rtc_time_t *time);
+
+/**
+ * @brief Advances the calendar to the RTC seconds counter; called by the seconds interrupt.
+ */
+void RTC_Tick(void);
+
+/**
+ * @brief Returns the hour of the week, weekday * 24 + hour with Sunday = 0.
+ */
+unsigned char RTC_GetHourOfWeek(void);
+
+/**
+ * @brief Returns the current time in epoch seconds.
+ */
+unsigned int RTC_GetEpoch(void);
+
+/**
+ * @brief Converts a calendar time to epoch seconds; the weekday field is ignored.
+ */
+unsigned int RTC_ToEpoch(const rtc_time_t *time);
+
+/**
+ * @brief Converts epoch seconds to a calendar time.
+ */
+void RTC_FromEpoch(unsigned int epoch, rtc_time_t *time);
+
+/**
+ * @brief Sets the alarm of a slot to an epoch second.
+ */
+void RTC_AlarmSet(unsigned char slot, unsigned int epoch);
+
+/**
+ * @brief Cancels the alarm of a slot.
+ */
+void RTC_AlarmCancel(unsigned char slot);
+
+/**
+ * @brief Returns the slots whose alarm is due; called by the RTC alarm interrupt.
+ */
+unsigned int RTC_AlarmService(void);
+
 #endif /* RTC_H */
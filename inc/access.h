@@ -0,0 +1,75 @@
+/**
+*   @file    access.h
+*   @brief   Declaration of the per-user weekly access schedules.
+*   @details A schedule is the set of hours of the week during which a user may enter, kept as
+*            a bitmap of 168 hour slots (Sunday 00:00-01:00 is slot 0). Schedules are compiled
+*            from lists of day and hour windows; every user refers to one schedule, so many
+*            users share a bitmap. Checking a match costs one table read and one bit test,
+*            whatever the number of users.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef ACCESS_H
+#define ACCESS_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define ACCESS_HOURS_PER_WEEK   168U
+#define ACCESS_BITMAP_BYTES     (ACCESS_HOURS_PER_WEEK / 8U)
+#define ACCESS_HOUR_UNKNOWN     0xFFU           /* The time of day is not known */
+
+#define ACCESS_MAX_USERS        1000U           /* Fingerprint IDs 0..999 */
+#define ACCESS_MAX_SCHEDULES    8U
+
+/* Schedules defined by Access_Init() */
+#define ACCESS_SCHEDULE_ALWAYS  0U              /* Every hour */
+#define ACCESS_SCHEDULE_NEVER   1U              /* No hour, the default of every user */
+
+/* Days of a window */
+#define ACCESS_DAY_SUN          (1U << 0)
+#define ACCESS_DAY_MON          (1U << 1)
+#define ACCESS_DAY_TUE          (1U << 2)
+#define ACCESS_DAY_WED          (1U << 3)
+#define ACCESS_DAY_THU          (1U << 4)
+#define ACCESS_DAY_FRI          (1U << 5)
+#define ACCESS_DAY_SAT          (1U << 6)
+#define ACCESS_WEEKDAYS         (ACCESS_DAY_MON | ACCESS_DAY_TUE | ACCESS_DAY_WED | \
+                                 ACCESS_DAY_THU | ACCESS_DAY_FRI)
+#define ACCESS_EVERY_DAY        0x7FU
+
+/* Status of the access calls */
+#define ACCESS_OK               0U
+#define ACCESS_INVALID          1U              /* User, schedule or window out of range */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Access window: the hours start_hour to end_hour - 1 of the given days.
+ *
+ * @detail end_hour may be lower than start_hour for a window that spans midnight; the hours
+ *         after midnight then belong to the next day.
+ */
+typedef struct {
+    unsigned char days;             /*!< ACCESS_DAY_xxx mask */
+    unsigned char start_hour;       /*!< 0 to 23 */
+    unsigned char end_hour;         /*!< 0 to 24 */
+} access_window_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Access_Init(void);
+unsigned char Access_DefineSchedule(unsigned char schedule, const access_window_t *windows,
+                                    unsigned char count);
+unsigned char Access_AssignUser(unsigned int user_id, unsigned char schedule);
+unsigned char Access_GetUserSchedule(unsigned int user_id);
+unsigned char Access_IsAllowed(unsigned int user_id, unsigned char hour_of_week);
+
+#endif /* ACCESS_H */
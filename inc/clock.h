@@ -16,6 +16,14 @@
 ==================================================================================================*/
 #include "clock_registers.h"
 
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+/* Run Clock Control Register (RCCR) values */
+#define SCG_RCCR_SPLL_80MHZ    0x06010012U  /* SPLL 160 MHz: core / 2 = 80 MHz, bus 40 MHz, flash 26.67 MHz */
+#define SCG_RCCR_SIRC_8MHZ     0x02000001U  /* SIRC 8 MHz: core 8 MHz, bus 8 MHz, flash 4 MHz */
+
 /*==================================================================================================
 *                                STRUCTURES AND OTHER TYPEDEFS
 ==================================================================================================*/
@@ -27,7 +35,18 @@
 
 void set_system_clock_source(unsigned int source);
 void SOSC_init_8MHz(void);
+void SOSC_start_8MHz(void);
 void SPLL_init_160MHz(void);
+void SPLL_config_160MHz(void);
+void SIRC_init_8MHz(void);
 void NormalRUNmode_80MHz (void);
+void set_run_clock(unsigned int rccr);
+void SPLL_enable(void);
+void SPLL_disable(void);
+void Clock_Invalidate(void);
+unsigned int Clock_GetCoreFreq(void);
+unsigned int Clock_GetBusFreq(void);
+unsigned int Clock_GetFlashFreq(void);
+unsigned int Clock_GetPeripheralFreq(volatile unsigned int *pcc);
 
 #endif
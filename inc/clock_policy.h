@@ -0,0 +1,57 @@
+/**
+*   @file    clock_policy.h
+*   @brief   Declaration of the clock policy manager.
+*   @details The firmware runs from a low frequency profile (SIRC 8 MHz, SPLL stopped) while it
+*            waits, and ramps to the SPLL 80 MHz profile while a burst of work is requested.
+*            Every profile switch also moves the LPUART functional clocks, re-derives the
+*            LPUART baud dividers and the LPI2C timing, and reloads SysTick so that the drivers
+*            and the 1 ms tick keep working.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef CLOCK_POLICY_H
+#define CLOCK_POLICY_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define CLOCK_LPUART_BAUD       57600U          /* Baud rate of LPUART1 and LPUART2 */
+
+/* Reasons that request the high profile (it is used while at least one is requested) */
+#define CLOCK_REQ_SENSOR        (1U << 0)       /* A finger is on the sensor, a match is running */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Clock profiles.
+ */
+typedef enum {
+    CLOCK_PROFILE_LOW = 0,                      /*!< SIRC 8 MHz core and bus, SPLL stopped */
+    CLOCK_PROFILE_HIGH,                         /*!< SPLL 80 MHz core, 40 MHz bus */
+    CLOCK_PROFILE_COUNT
+} clock_profile_t;
+
+/*!
+ * @brief Clock policy statistics.
+ */
+typedef struct {
+    unsigned int switch_count;                  /*!< Number of profile switches */
+    unsigned int high_ms;                       /*!< Time spent in the high profile, in ms */
+} clock_stats_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Clock_PolicyInit(void);
+void Clock_Request(unsigned int reason);
+void Clock_Release(unsigned int reason);
+clock_profile_t Clock_GetProfile(void);
+void Clock_GetStats(clock_stats_t *stats);
+
+#endif /* CLOCK_POLICY_H */
@@ -250,6 +250,11 @@ typedef struct {
 
 
 /** Peripheral SCG base pointer */
+#ifdef HOST_BUILD
+extern clock_type_t host_scg; /* RAM register model of the host build */
+#define SCG    (&host_scg)
+#else
 #define SCG    ((clock_type_t *)SCG_BASE)
+#endif /* HOST_BUILD */
 
 #endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+/**
+*   @file    core.h
+*   @brief   Cortex-M4 core intrinsics used by the drivers and the application.
+*   @details This file wraps the few core instructions the firmware needs (interrupt masking
+*            and wait-for-interrupt) so that the rest of the code does not contain inline
+*            assembly.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef CORE_H
+#define CORE_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+/*!
+ * @brief  Core instruction wrappers.
+ *
+ * @detail CORE_WFI puts the core to sleep until the next interrupt. CORE_ENTER_CRITICAL saves
+ *         PRIMASK into the given variable and masks interrupts; CORE_EXIT_CRITICAL restores it,
+ *         so critical sections may nest and may be used from interrupt handlers. CORE_ISB makes
+ *         an exception that became pending, or unmasked, be taken before the next instruction.
+ *         CORE_GET_SP reads the stack pointer; it has no host version, the host stacks are
+ *         those of the host process. CORE_FETCH_INC increments a word without masking the
+ *         interrupts (exclusive load and store, retried when another context wrote between
+ *         them) and gives the value before the increment.
+ *
+ *         In a host build the wrappers call the interrupt model of the host harness.
+ *
+ *         CORE_REG_WRITTEN follows a register write with a side effect beyond the stored value
+ *         (a transmit, a command launch, a flag cleared by writing 1); CORE_REG_READ precedes a
+ *         read of a register that the hardware updates on its own. Both compile to nothing on
+ *         the device; in a host build they let the register models react.
+ */
+#ifdef HOST_BUILD
+
+unsigned int host_irq_save(void);
+void host_irq_restore(unsigned int primask);
+void host_wfi(void);
+void host_reg_written(volatile void *reg);
+void host_reg_read(const volatile void *reg);
+
+#define CORE_REG_WRITTEN(reg)           host_reg_written(&(reg))
+#define CORE_REG_READ(reg)              host_reg_read(&(reg))
+
+#define CORE_WFI()                      host_wfi()
+#define CORE_DISABLE_IRQ()              (void)host_irq_save()
+#define CORE_ENABLE_IRQ()               host_irq_restore(0U)
+#define CORE_ISB()                      do { } while (0)
+#define CORE_FETCH_INC(var, old)        do { (old) = __atomic_fetch_add(&(var), 1U, __ATOMIC_RELAXED); } while (0)
+#define CORE_ENTER_CRITICAL(primask)    do { (primask) = host_irq_save(); } while (0)
+#define CORE_EXIT_CRITICAL(primask)     host_irq_restore(primask)
+
+#else
+
+#define CORE_WFI()                      __asm volatile ("wfi")
+#define CORE_DISABLE_IRQ()              __asm volatile ("cpsid i" : : : "memory")
+#define CORE_ENABLE_IRQ()               __asm volatile ("cpsie i" : : : "memory")
+#define CORE_ISB()                      __asm volatile ("isb" : : : "memory")
+#define CORE_GET_SP(sp)                 __asm volatile ("mov %0, sp" : "=r" (sp))
+#define CORE_FETCH_INC(var, old)        do { unsigned int core_failed_; \
+                                             do { __asm volatile ("ldrex %0, [%1]" : "=r" (old) : "r" (&(var)) : "memory"); \
+                                                  __asm volatile ("strex %0, %2, [%1]" : "=&r" (core_failed_) \
+                                                                  : "r" (&(var)), "r" ((old) + 1U) : "memory"); \
+                                             } while (core_failed_ != 0U); } while (0)
+
+#define CORE_ENTER_CRITICAL(primask)    do { __asm volatile ("mrs %0, primask" : "=r" (primask)); \
+                                             CORE_DISABLE_IRQ(); } while (0)
+#define CORE_EXIT_CRITICAL(primask)     __asm volatile ("msr primask, %0" : : "r" (primask) : "memory")
+
+#define CORE_REG_WRITTEN(reg)           do { } while (0)
+#define CORE_REG_READ(reg)              do { } while (0)
+
+#endif /* HOST_BUILD */
+
+/*!
+ * @brief  Counts the leading zero bits of a non-zero value, one CLZ instruction on the core.
+ */
+#define CORE_CLZ(value)                 ((unsigned int)__builtin_clz(value))
+
+#endif /* CORE_H */
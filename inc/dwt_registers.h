@@ -0,0 +1,50 @@
+/**
+*   @file    dwt_registers.h
+*   @brief   Register definitions for the Data Watchpoint and Trace (DWT) unit of the Cortex-M4 core.
+*   @details Defines the structure for the DWT control and cycle counter registers, the debug
+*            exception and monitor control register that powers the unit, base addresses, and
+*            includes guards to prevent multiple declarations.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef DWT_REGISTER_H
+#define DWT_REGISTER_H
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+/**
+* @brief          DWT structure.
+* @details        Structure defining the DWT registers and their offsets.
+*/
+typedef struct {
+  volatile unsigned int CTRL;           /* Offset: 0x00 - Control Register */
+  volatile unsigned int CYCCNT;         /* Offset: 0x04 - Cycle Count Register */
+} dwt_type_t;
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+#define DWT_BASE                (0xE0001000U) /* Base address for DWT registers */
+/** Pointer to the DWT base address */
+#ifdef HOST_BUILD
+extern dwt_type_t host_dwt;     /* RAM register model of the host build */
+#define DWT                     (&host_dwt)
+#else
+#define DWT                     ((dwt_type_t*)(DWT_BASE))
+#endif /* HOST_BUILD */
+
+#define DEMCR_ADDRESS           (0xE000EDFCU) /* Debug Exception and Monitor Control Register */
+#ifdef HOST_BUILD
+extern volatile unsigned int host_demcr;
+#define DEMCR                   host_demcr
+#else
+#define DEMCR                   (*(volatile unsigned int*)(DEMCR_ADDRESS))
+#endif /* HOST_BUILD */
+
+#define DEMCR_TRCENA            (1U << 24U)   /* Enables the DWT and ITM units */
+#define DWT_CTRL_CYCCNTENA      (1U << 0U)    /* Enables the cycle counter */
+
+#endif /* DWT_REGISTER_H */
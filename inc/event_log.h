@@ -0,0 +1,88 @@
+/**
+*   @file    event_log.h
+*   @brief   Declaration of the access event log.
+*   @details The log is an append-only record of the door events (time, fingerprint ID, match
+*            score and result) kept in a ring of FlexNVM sectors. EventLog_Append() only encodes
+*            the record into a RAM staging buffer, in constant time, so it never delays the
+*            unlock; EventLog_Service() then programs the staged flash phrases in the
+*            background. Records are delta-time and varint encoded, 4 to 7 bytes each, and a
+*            check byte ends every phrase so that a phrase torn by a power loss is never read.
+*            Records are read back from the oldest one or from a given time, see
+*            EventLog_Seek().
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define EVENT_LOG_SECTORS       4U              /* FlexNVM sectors of the ring, 2 KB each */
+#define EVENT_LOG_STAGE_PHRASES 4U              /* Phrases staged in RAM before programming */
+
+/* Results of a door event */
+#define EVENT_LOG_GRANTED       0U              /* Match, the door opened */
+#define EVENT_LOG_NO_MATCH      1U              /* The finger is not enrolled */
+#define EVENT_LOG_DENIED        2U              /* Match outside the access schedule of the user */
+#define EVENT_LOG_SENSOR_ERROR  3U              /* The search failed */
+
+/* Status of the event log calls */
+#define EVENT_LOG_OK            0U
+#define EVENT_LOG_FULL          1U              /* The staging buffer is full, the record is dropped */
+#define EVENT_LOG_END           2U              /* No more records to read */
+#define EVENT_LOG_BUSY          3U              /* The flash is busy, read again later */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Door event.
+ */
+typedef struct {
+    unsigned int   time;            /*!< Epoch seconds */
+    unsigned short user_id;         /*!< Fingerprint ID, 0 when there is no match */
+    unsigned short score;           /*!< Match score reported by the sensor */
+    unsigned char  result;          /*!< EVENT_LOG_GRANTED, ... */
+} event_log_record_t;
+
+/*!
+ * @brief Read position in the log, see EventLog_ReadFirst().
+ */
+typedef struct {
+    unsigned char  sector;          /*!< Sector being read */
+    unsigned char  sectors_left;    /*!< Sectors to read after this one */
+    unsigned short phrase;          /*!< Phrase being read in the sector */
+    unsigned char  offset;          /*!< Byte being read in the phrase */
+    unsigned int   time;            /*!< Time of the previous record */
+} event_log_cursor_t;
+
+/*!
+ * @brief Event log statistics.
+ */
+typedef struct {
+    unsigned int appended;          /*!< Records accepted by EventLog_Append() */
+    unsigned int dropped;           /*!< Records dropped because the staging buffer was full */
+    unsigned int flash_errors;      /*!< Failed program or erase commands */
+    unsigned int phrases_left;      /*!< Free phrases in the sector being written */
+} event_log_stats_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void EventLog_Init(void);
+unsigned char EventLog_Append(unsigned int time, unsigned short user_id, unsigned short score,
+                              unsigned char result);
+void EventLog_Flush(void);
+unsigned char EventLog_Service(void);
+void EventLog_ReadFirst(event_log_cursor_t *cursor);
+unsigned char EventLog_Seek(event_log_cursor_t *cursor, unsigned int time);
+unsigned char EventLog_ReadNext(event_log_cursor_t *cursor, event_log_record_t *record);
+void EventLog_GetStats(event_log_stats_t *stats);
+
+#endif /* EVENT_LOG_H */
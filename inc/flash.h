@@ -0,0 +1,65 @@
+/**
+*   @file    flash.h
+*   @brief   Declaration of the FTFC flash driver.
+*   @details The driver launches program and erase commands on the data flash (FlexNVM) and
+*            returns at once; the command completes in the background and the FTFC command
+*            complete interrupt tells when. The firmware runs from program flash, which stays
+*            readable while the FlexNVM is busy, so no code has to run from RAM. The FlexNVM
+*            itself must not be read until the command has completed.
+*
+*            The FlexNVM is partitioned once into data flash and the backup of the EEPROM
+*            emulation (EEE). The FlexRAM then reads as an EEPROM: it is loaded from the backup
+*            at reset and each write to it is saved to the backup by the FTFC.
+*
+*            Program flash commands are waited for, since the firmware runs from the program
+*            flash.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef FLASH_H
+#define FLASH_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define FLASH_DFLASH_BASE       0x10000000U     /* FlexNVM in the system memory map */
+#define FLASH_DFLASH_SIZE       0x8000U         /* 32 KB, the rest of the FlexNVM backs the EEE */
+#define FLASH_DFLASH_SECTOR     0x800U          /* Erase unit of the FlexNVM, 2 KB */
+#define FLASH_PHRASE_SIZE       8U              /* Program unit, programmed once between erases */
+#define FLASH_PFLASH_SECTOR     0x1000U         /* Erase unit of the program flash, 4 KB */
+#define FLASH_FLEXRAM_BASE      0x14000000U     /* FlexRAM in the system memory map */
+#define FLASH_EEE_SIZE          0x800U          /* EEPROM emulation size, 2 KB of the FlexRAM */
+
+/* Status of the flash calls */
+#define FLASH_OK                0U
+#define FLASH_BUSY              1U              /* A command is still running */
+#define FLASH_ERROR             2U              /* Access error, protection violation or failed verify */
+
+/* Contents of a flash or FlexRAM address; a host build maps the addresses to its flash model */
+#ifdef HOST_BUILD
+const unsigned char *host_flash_map(unsigned int address);
+#define FLASH_MAP(address)      host_flash_map(address)
+#else
+#define FLASH_MAP(address)      ((const unsigned char *)(address))
+#endif
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Flash_Init(void);
+unsigned char Flash_IsBusy(void);
+unsigned char Flash_GetStatus(void);
+unsigned char Flash_StartProgramPhrase(unsigned int address, const unsigned char *data);
+unsigned char Flash_StartEraseSector(unsigned int address);
+void Flash_EnableDoneIrq(void);
+void Flash_DisableDoneIrq(void);
+unsigned char Flash_EeeInit(void);
+unsigned char Flash_EeeWrite(unsigned int address, const unsigned char *data, unsigned int size);
+unsigned char Flash_ProgramPFlashPhrase(unsigned int address, const unsigned char *data);
+unsigned char Flash_ErasePFlashSector(unsigned int address);
+
+#endif /* FLASH_H */
@@ -0,0 +1,43 @@
+/**
+*   @file    fp_reply.h
+*   @brief   Declaration of the parser of the fingerprint sensor replies.
+*   @details The LPUART2 interrupt feeds every received byte to FpReply_Feed(). A reply is the
+*            header EF 01 FF FF FF FF, the packet identifier, a big-endian length, then length
+*            bytes: the confirmation code, the data and a big-endian sum of every byte from the
+*            identifier to the last data byte. The parser only accepts an acknowledge packet
+*            whose length fits FP_REPLY_MAX_DATA and whose sum is right; anything else is line
+*            noise and is dropped. The last accepted reply is kept apart from the frame being
+*            received, and is read through accessors that check the offsets against the data
+*            the reply actually carried.
+*
+*            The module has no register access, so the host build compiles it as it is.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef FP_REPLY_H
+#define FP_REPLY_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define FP_REPLY_HEADER_SIZE    6U
+#define FP_REPLY_PID_ACK        0x07U           /* Packet identifier of an acknowledge packet */
+#define FP_REPLY_MAX_DATA       32U             /* Data bytes of the longest reply, a notepad page */
+#define FP_REPLY_NO_WORD        0xFFFFU         /* FpReply_Word() past the data of the reply */
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void FpReply_Reset(void);
+unsigned char FpReply_Feed(unsigned char byte);
+void FpReply_Invalidate(void);
+unsigned char FpReply_Code(void);
+unsigned int FpReply_DataLength(void);
+unsigned int FpReply_Word(unsigned int offset);
+const unsigned char *FpReply_Data(unsigned int size);
+
+#endif /* FP_REPLY_H */
@@ -0,0 +1,77 @@
+/**
+*   @file    ftfc_registers.h
+*   @brief   Register definitions for the Flash Memory Module (FTFC).
+*   @details Defines the structure for the FTFC registers, base address, and includes guards
+*            to prevent multiple declarations.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef FTFC_REGISTER_H
+#define FTFC_REGISTER_H
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+/**
+* @brief          FTFC structure.
+* @details        Structure defining the FTFC registers and their offsets. The command registers
+*                 are byte registers stored in big-endian order inside each word, see
+*                 FTFC_FCCOB().
+*/
+typedef struct {
+  volatile unsigned char FSTAT;             /* Offset: 0x00 - Flash Status Register */
+  volatile unsigned char FCNFG;             /* Offset: 0x01 - Flash Configuration Register */
+  volatile const unsigned char FSEC;        /* Offset: 0x02 - Flash Security Register */
+  volatile const unsigned char FOPT;        /* Offset: 0x03 - Flash Option Register */
+  volatile unsigned char FCCOB[12];         /* Offset: 0x04 - Flash Common Command Object Registers */
+  volatile unsigned char FPROT[4];          /* Offset: 0x10 - Program Flash Protection Registers */
+  volatile const unsigned char RESERVED0[2];
+  volatile unsigned char FEPROT;            /* Offset: 0x16 - EEPROM Protection Register */
+  volatile unsigned char FDPROT;            /* Offset: 0x17 - Data Flash Protection Register */
+  volatile const unsigned char RESERVED1[20];
+  volatile const unsigned char FCSESTAT;    /* Offset: 0x2C - Flash CSEc Status Register */
+  volatile const unsigned char RESERVED2;
+  volatile unsigned char FERSTAT;           /* Offset: 0x2E - Flash Error Status Register */
+  volatile unsigned char FERCNFG;           /* Offset: 0x2F - Flash Error Configuration Register */
+} ftfc_type_t;
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+#define FTFC_BASE              (0x40020000U) /* Base address for FTFC registers */
+/** Pointer to the FTFC base address */
+#ifdef HOST_BUILD
+extern ftfc_type_t host_ftfc;  /* RAM register model of the host build */
+#define FTFC                   (&host_ftfc)
+#else
+#define FTFC                   ((ftfc_type_t*)(FTFC_BASE))
+#endif /* HOST_BUILD */
+
+/* FCCOBn register, n = 0 to 11 as numbered in the reference manual */
+#define FTFC_FCCOB(n)          (FTFC->FCCOB[((n) & ~3U) + 3U - ((n) & 3U)])
+
+/* FSTAT bits */
+#define FTFC_FSTAT_CCIF        (0x80U)       /* Command complete, write 1 to launch a command */
+#define FTFC_FSTAT_RDCOLERR    (0x40U)       /* Read collision error, write 1 to clear */
+#define FTFC_FSTAT_ACCERR      (0x20U)       /* Access error, write 1 to clear */
+#define FTFC_FSTAT_FPVIOL      (0x10U)       /* Protection violation, write 1 to clear */
+#define FTFC_FSTAT_MGSTAT0     (0x01U)       /* Command completion status */
+
+/* FCNFG bits */
+#define FTFC_FCNFG_CCIE        (0x80U)       /* Command complete interrupt enable */
+#define FTFC_FCNFG_RAMRDY      (0x02U)       /* FlexRAM available as traditional RAM */
+#define FTFC_FCNFG_EEERDY      (0x01U)       /* FlexRAM available for EEPROM emulation */
+
+/* Flash commands */
+#define FTFC_CMD_PROGRAM_PHRASE (0x07U)      /* Program 8 bytes */
+#define FTFC_CMD_ERASE_SECTOR  (0x09U)       /* Erase a flash sector */
+#define FTFC_CMD_PROGRAM_PARTITION (0x80U)   /* Split the FlexNVM between data flash and EEPROM backup */
+#define FTFC_CMD_SET_FLEXRAM   (0x81U)       /* Select the FlexRAM function */
+
+/* Set FlexRAM function codes (FCCOB1) */
+#define FTFC_FLEXRAM_EEE       (0x00U)       /* EEPROM emulation */
+#define FTFC_FLEXRAM_RAM       (0xFFU)       /* Traditional RAM */
+
+#endif /* FTFC_REGISTER_H */
@@ -41,10 +41,19 @@ typedef struct {
 
 
 /** Peripheral GPIOA base pointer */
+#ifdef HOST_BUILD
+extern GPIO_Type host_gpio[5]; /* RAM register model of the host build */
+#define GPIOA    (&host_gpio[0])
+#define GPIOB    (&host_gpio[1])
+#define GPIOC    (&host_gpio[2])
+#define GPIOD    (&host_gpio[3])
+#define GPIOE    (&host_gpio[4])
+#else
 #define GPIOA    ((GPIO_Type *)GPIOA_BASE)
 #define GPIOB    ((GPIO_Type *)GPIOB_BASE)
 #define GPIOC    ((GPIO_Type *)GPIOC_BASE)
 #define GPIOD    ((GPIO_Type *)GPIOD_BASE)
 #define GPIOE    ((GPIO_Type *)GPIOE_BASE)
+#endif /* HOST_BUILD */
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+/**
+*   @file    hotset.h
+*   @brief   Declaration of the hot tier of the fingerprint library.
+*   @details The last HOTSET_SLOTS pages of the sensor library hold copies of the templates of
+*            the users who enter most often. An identification searches these few pages first
+*            and the whole user range only when none of them matches, so the frequent users are
+*            found in a search of constant length whatever the size of the library.
+*
+*            The module keeps a hit count per user and the map of the slots (the user whose
+*            template each hot page holds); the application moves the templates. The map is
+*            saved as one page of the sensor notepad, so it stays with the templates it
+*            describes. A slot is emptied in the map before its page is written and filled
+*            after, so a map read back never names a user for a page holding someone else.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef HOTSET_H
+#define HOTSET_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define HOTSET_SLOTS            15U             /* Hot pages, the map fills one notepad page */
+#define HOTSET_MAP_SIZE         32U             /* Bytes of a saved map */
+#define HOTSET_MAX_USERS        1000U           /* Fingerprint IDs 0..999 */
+#define HOTSET_NO_USER          0xFFFFU         /* Empty slot */
+#define HOTSET_REBALANCE        16U             /* Identifications between two rebalances */
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void HotSet_Init(void);
+void HotSet_LoadMap(const unsigned char *map);
+void HotSet_SaveMap(unsigned char *map);
+unsigned int HotSet_GetUser(unsigned int slot);
+unsigned char HotSet_Count(void);
+unsigned char HotSet_Forget(unsigned int user_id);
+unsigned char HotSet_Hit(unsigned int user_id);
+unsigned char HotSet_Plan(unsigned int *slot, unsigned int *user_id);
+void HotSet_SetSlot(unsigned int slot, unsigned int user_id);
+
+#endif /* HOTSET_H */
@@ -17,6 +17,14 @@
 ==================================================================================================*/
 #include "i2c_registers.h"
 
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define LCD_ROWS 2      /* Number of character rows of the LCD1602 */
+#define LCD_COLS 16     /* Number of character columns of the LCD1602 */
+#define LCD_INIT_DONE 0 /* Returned by lcd_init_step() after the last command */
+
 /*==================================================================================================
 *                                STRUCTURES AND OTHER TYPEDEFS
 ==================================================================================================*/
@@ -36,6 +44,7 @@
 ==================================================================================================*/
 
 void init_LPI2C0(void);
+void LPI2C0_set_timing(void);
 unsigned char bus_busy(void);
 void generate_start_ACK(unsigned char address);
 void transmit_data(unsigned char data);
@@ -47,7 +56,14 @@ void lcd_send_data(char data);
 void lcd_clear(void);
 void lcd_clear_rtc(void);
 void lcd_init(void);
+unsigned int lcd_init_start(void);
+unsigned int lcd_init_step(void);
 void lcd_send_string(char *str);
 void lcd_put_cur(unsigned char row, unsigned char col);
+void lcd_fb_init(void);
+void lcd_fb_clear_row(unsigned char row);
+void lcd_fb_write(unsigned char row, unsigned char col, const char *str);
+void lcd_fb_write_field(unsigned char row, unsigned char col, const char *str, unsigned char width);
+unsigned int lcd_fb_flush(void);
 
 #endif /* I2C_H_ */
@@ -385,7 +385,13 @@ typedef struct {
 /**
 * @brief Peripheral I2C base pointers
 */
+#ifdef HOST_BUILD
+extern I2C_Type host_lpi2c[2]; /* RAM register model of the host build */
+#define LPI2C0        (&host_lpi2c[0])
+#define LPI2C1        (&host_lpi2c[1])
+#else
 #define LPI2C0        ((I2C_Type*)(LPI2C0_BASE))  /**< Peripheral base pointer for LPI2C0 */
 #define LPI2C1        ((I2C_Type*)(LPI2C1_BASE))  /**< Peripheral base pointer for LPI2C1 */
+#endif /* HOST_BUILD */
 
 #endif /* I2C_REGISTER_H_ */
\ No newline at end of file
@@ -0,0 +1,88 @@
+/**
+*   @file    isr_stats.h
+*   @brief   Declaration of the interrupt latency and duration statistics.
+*   @details ISR_STATS_ENTER() at the start of a handler and ISR_STATS_EXIT() at its end measure,
+*            with the DWT cycle counter, the duration of the handler and the entry latency of
+*            its request:
+*            - SysTick: the cycles since the counter reloaded, read from its current value.
+*              SysTick counts the core clock, so this is the exact latency, whatever delayed
+*              the entry (another handler, or the interrupts masked by a critical section). It
+*              is raised every millisecond at a phase unrelated to the application, with the
+*              priority of the other interrupts, so its worst latency also bounds the time the
+*              interrupts stay masked;
+*            - the other interrupts: the time the request waited behind other handlers, seen in
+*              the NVIC pending bits. A request pending when a handler starts waits from then;
+*              one raised while the handler runs is counted from the start of that handler,
+*              which errs on the long side. A wait in a critical section is not seen, see
+*              SysTick.
+*            All the handlers have the reset priority and do not preempt each other, so the
+*            durations are those of the handlers alone.
+*
+*            The statistics cost about 20 cycles per handler, 60 more when another request is
+*            pending, and are compiled out with the probes unless PROBE_ENABLE is 1, see
+*            probe.h.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef ISR_STATS_H
+#define ISR_STATS_H
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "probe.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+/* Handler IDs */
+#define ISR_SYSTICK             0U
+#define ISR_LPUART2             1U
+#define ISR_LPUART1             2U
+#define ISR_RTC_SECONDS         3U
+#define ISR_RTC                 4U
+#define ISR_FTFC                5U
+#define ISR_PORTC               6U
+#define ISR_LPTMR0              7U
+#define ISR_COUNT               8U
+
+#if PROBE_ENABLE
+#define ISR_STATS_ENTER(id)     IsrStats_Enter(id)
+#define ISR_STATS_EXIT(id)      IsrStats_Exit(id)
+#else
+#define ISR_STATS_ENTER(id)     do { } while (0)
+#define ISR_STATS_EXIT(id)      do { } while (0)
+#endif
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Statistics of a handler, in core clock cycles.
+ */
+typedef struct {
+    unsigned int count;                     /*!< Handler runs */
+    unsigned int duration_max;
+    unsigned long long duration_total;      /*!< Sum of the durations, for the mean */
+    unsigned int latency_count;             /*!< Runs with a latency measured */
+    unsigned int latency_max;
+} isr_stats_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+#if PROBE_ENABLE
+void IsrStats_Enter(unsigned int id);
+void IsrStats_Exit(unsigned int id);
+void IsrStats_Get(unsigned int id, isr_stats_t *stats);
+const char *IsrStats_GetName(unsigned int id);
+void IsrStats_Reset(void);
+#endif
+
+#endif /* ISR_STATS_H */
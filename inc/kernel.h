@@ -0,0 +1,129 @@
+/**
+*   @file    kernel.h
+*   @brief   Declaration of the preemptive fixed-priority micro-kernel.
+*   @details The kernel runs a few threads with statically allocated stacks. The highest
+*            priority ready thread always runs: a thread made ready by an interrupt or by
+*            another thread preempts the running one through a PendSV context switch. Threads
+*            synchronise with counting semaphores, event flags and message queues; giving,
+*            setting and putting never block and may be done from interrupt handlers.
+*
+*            The lowest priority thread must never block: it is the idle thread of the kernel
+*            (in this firmware it runs the cooperative task scheduler, see scheduler.h).
+*
+*            The thread stacks are painted when the threads are created, for their high-water
+*            marks, see stack.h.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "stack.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define KERNEL_MAX_THREADS      8U              /* Thread IDs 0..7, ID 0 has the highest priority */
+
+/* Timeouts of the blocking calls, in SysTick milliseconds */
+#define KERNEL_NO_WAIT          0U              /* Return at once if the call would block */
+#define KERNEL_WAIT_FOREVER     0xFFFFFFFFU     /* Never time out */
+
+/* Status of the kernel calls */
+#define KERNEL_OK               0U
+#define KERNEL_TIMEOUT          1U              /* Nothing was available before the timeout */
+#define KERNEL_FULL             2U              /* The queue has no free slot */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Thread entry point.
+ *
+ * @param[in] arg: Argument given to Kernel_ThreadCreate().
+ */
+typedef void (*kernel_entry_t)(void *arg);
+
+/*!
+ * @brief Counting semaphore.
+ */
+typedef struct {
+    volatile unsigned int count;        /*!< Number of available units */
+    volatile unsigned int waiters;      /*!< Bit mask of the threads waiting for a unit */
+} kernel_sem_t;
+
+/*!
+ * @brief Event flags.
+ *
+ * @detail A waiting thread is woken as soon as one of the flags it waits for is set; the
+ *         flags it receives are cleared.
+ */
+typedef struct {
+    volatile unsigned int flags;        /*!< Flags set and not yet received */
+    volatile unsigned int waiters;      /*!< Bit mask of the threads waiting for flags */
+} kernel_flags_t;
+
+/*!
+ * @brief Message queue of unsigned int messages.
+ *
+ * @detail The storage is provided by the application, see Kernel_QueueInit().
+ */
+typedef struct {
+    unsigned int          *buffer;      /*!< Message storage */
+    unsigned char          size;        /*!< Number of messages the storage holds */
+    volatile unsigned char head;        /*!< Index of the oldest message */
+    volatile unsigned char count;       /*!< Number of messages in the queue */
+    volatile unsigned int  waiters;     /*!< Bit mask of the threads waiting for a message */
+} kernel_queue_t;
+
+/*!
+ * @brief Context switch cost measured by the PendSV handler with the DWT cycle counter.
+ *
+ * @detail The cycles are counted from the first to the last instruction of the handler; the
+ *         exception entry and return add 12 cycles each on the Cortex-M4 (more when the FPU
+ *         context is stacked). The layout is used by the PendSV handler.
+ */
+typedef struct {
+    unsigned int start;                 /*!< Cycle count at the entry of the last switch */
+    unsigned int last;                  /*!< Cycles of the last switch */
+    unsigned int max;                   /*!< Cycles of the slowest switch */
+} kernel_switch_stats_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Kernel_Init(void);
+void Kernel_ThreadCreate(unsigned char thread_id, kernel_entry_t entry, void *arg,
+                         unsigned int *stack, unsigned int stack_words);
+void Kernel_Start(void) __attribute__((noreturn));
+void Kernel_Tick(void);
+unsigned int Kernel_NextTimeout(void);
+void Kernel_Delay(unsigned int ms);
+unsigned char Kernel_CurrentThread(void);
+
+void Kernel_SemInit(kernel_sem_t *sem, unsigned int count);
+void Kernel_SemGive(kernel_sem_t *sem);
+unsigned int Kernel_SemTake(kernel_sem_t *sem, unsigned int timeout);
+
+void Kernel_FlagsInit(kernel_flags_t *flags);
+void Kernel_FlagsSet(kernel_flags_t *flags, unsigned int mask);
+unsigned int Kernel_FlagsWait(kernel_flags_t *flags, unsigned int mask, unsigned int timeout);
+
+void Kernel_QueueInit(kernel_queue_t *queue, unsigned int *buffer, unsigned char size);
+unsigned int Kernel_QueuePut(kernel_queue_t *queue, unsigned int message);
+unsigned int Kernel_QueueGet(kernel_queue_t *queue, unsigned int *message, unsigned int timeout);
+
+void Kernel_GetSwitchStats(kernel_switch_stats_t *stats);
+void Kernel_GetStackUsage(unsigned char thread_id, stack_usage_t *usage);
+unsigned int *Kernel_SwitchContext(unsigned int *sp);
+
+#endif /* KERNEL_H */
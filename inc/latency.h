@@ -0,0 +1,64 @@
+/**
+*   @file    latency.h
+*   @brief   Declaration of the touch to unlock latency statistics.
+*   @details The application timestamps each identification at LATENCY_MARKS points, from the
+*            finger touching the sensor to the lock output going low, and hands the marks of
+*            a granted attempt to Latency_Record(). The module keeps the last LATENCY_WINDOW
+*            durations of each phase and of the whole, and computes their percentiles on
+*            request; recording is a few stores, so the statistics stay on in production.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define LATENCY_WINDOW          64U             /* Attempts kept, must be a power of two */
+#define LATENCY_MAX_MS          0xFFFFU         /* Longer durations are kept as this */
+
+/* Marks of an attempt, milliseconds of SysTick_GetTick() */
+#define LATENCY_MARK_TOUCH      0U              /* Touch line edge, or the GetImage that found the finger */
+#define LATENCY_MARK_IMAGE      1U              /* GetImage reply with an image */
+#define LATENCY_MARK_FEATURES   2U              /* CreateChar reply */
+#define LATENCY_MARK_MATCH      3U              /* Search reply with the match */
+#define LATENCY_MARK_UNLOCK     4U              /* Lock output low */
+#define LATENCY_MARKS           5U
+
+/* Metrics: the phase between a mark and the next one, then the whole */
+#define LATENCY_IMAGE           0U              /* GetImage retries included */
+#define LATENCY_FEATURES        1U
+#define LATENCY_SEARCH          2U              /* Hot then full search */
+#define LATENCY_UNLOCK          3U
+#define LATENCY_TOTAL           4U
+#define LATENCY_METRICS         5U
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Percentiles of a metric over the window, in milliseconds.
+ */
+typedef struct {
+    unsigned int count;             /*!< Attempts recorded since the start */
+    unsigned short p50;
+    unsigned short p90;
+    unsigned short p99;
+    unsigned short max;
+} latency_report_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Latency_Init(void);
+void Latency_Record(const unsigned int marks[LATENCY_MARKS]);
+void Latency_GetReport(unsigned char metric, latency_report_t *report);
+const char *Latency_GetName(unsigned char metric);
+
+#endif /* LATENCY_H */
@@ -0,0 +1,63 @@
+/**
+*   @file    lptmr_registers.h
+*   @brief   Register definitions for the Low Power Timer (LPTMR) module.
+*   @details Defines the structure for the LPTMR registers, base address, and includes guards
+*            to prevent multiple declarations.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef LPTMR_REGISTER_H
+#define LPTMR_REGISTER_H
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+/**
+* @brief          LPTMR structure.
+* @details        Structure defining the LPTMR registers and their offsets.
+*/
+typedef struct {
+  union {
+    volatile unsigned int CSR_Register;     /* Offset: 0x00 - Control Status Register */
+    struct {
+        volatile unsigned int TEN     : 1;  /* Timer enable */
+        volatile unsigned int TMS     : 1;  /* Timer mode: 0 time counter, 1 pulse counter */
+        volatile unsigned int TFC     : 1;  /* Free running counter */
+        volatile unsigned int TPP     : 1;  /* Pulse pin polarity */
+        volatile unsigned int TPS     : 2;  /* Pulse pin select */
+        volatile unsigned int TIE     : 1;  /* Interrupt enable */
+        volatile unsigned int TCF     : 1;  /* Compare flag, write 1 to clear */
+        volatile unsigned int TDRE    : 1;  /* DMA request enable */
+        volatile const unsigned int RESERVED : 23;
+    } CSR;
+  };
+  union {
+    volatile unsigned int PSR_Register;     /* Offset: 0x04 - Prescale Register */
+    struct {
+        volatile unsigned int PCS      : 2; /* Clock select: 0 SIRCDIV2, 1 LPO1K, 2 RTC, 3 PCC */
+        volatile unsigned int PBYP     : 1; /* Prescaler bypass */
+        volatile unsigned int PRESCALE : 4; /* Prescale value */
+        volatile const unsigned int RESERVED : 25;
+    } PSR;
+  };
+  volatile unsigned int CMR;                /* Offset: 0x08 - Compare Register */
+  volatile unsigned int CNR;                /* Offset: 0x0C - Counter Register, write before reading */
+} lptmr_type_t;
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+#define LPTMR0_BASE            (0x40040000U) /* Base address for LPTMR0 registers */
+/** Pointer to the LPTMR0 base address */
+#ifdef HOST_BUILD
+extern lptmr_type_t host_lptmr0; /* RAM register model of the host build */
+#define LPTMR0                 (&host_lptmr0)
+#else
+#define LPTMR0                 ((lptmr_type_t*)(LPTMR0_BASE))
+#endif /* HOST_BUILD */
+
+#define LPTMR_PCS_LPO1K        (1U)          /* 1 kHz low power oscillator, runs in VLPS */
+
+#endif /* LPTMR_REGISTER_H */
@@ -19,6 +19,12 @@
 ==================================================================================================*/
 #include "lpuart_registers.h"
 
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+#define FP_NOTEPAD_PAGES 16     /* Pages of the user notepad of the fingerprint module */
+#define FP_NOTEPAD_SIZE 32      /* Bytes of a notepad page */
+
 /*==================================================================================================
 *                                    ENUMERATIONS
 ==================================================================================================*/
@@ -64,12 +70,30 @@ typedef enum {
     FINGERPRINT_UNDEFINED_ERROR = 0x19        /*!< Non-defined error */
 } fingerprint_response_t;
 
+/*!
+ * @brief Fixed fingerprint sensor commands
+ *
+ * This enumeration lists the commands that can be sent with sendFPCommand().
+ */
+typedef enum {
+    FP_CMD_GET_IMAGE = 0,                     /*!< Capture a finger image */
+    FP_CMD_CREATE_CHAR_FILE_1,                /*!< Generate features into character buffer 1 */
+    FP_CMD_CREATE_CHAR_FILE_2,                /*!< Generate features into character buffer 2 */
+    FP_CMD_CREATE_TEMPLATE,                   /*!< Merge both character buffers into a template */
+    FP_CMD_DELETE_ALL_FINGER,                 /*!< Empty the fingerprint library */
+    FP_CMD_SEARCH_FINGER,                     /*!< Search the library with character buffer 1 */
+    FP_CMD_GET_NUMBER_OF_FINGER,              /*!< Read the number of stored templates */
+    FP_CMD_READ_SYS_PARA,                     /*!< Read the system parameters (16 bytes) */
+    FP_CMD_COUNT
+} fp_command_t;
+
 /*==================================================================================================
 *                                    FUNCTION PROTOTYPES
 ==================================================================================================*/
 void LPUART_init_clock(volatile unsigned int* PCC_LPUARTx);
 void LPUART_config_baud9600(LPUART_t* LPUARTx);
 void LPUART_config_baud57600(LPUART_t* LPUARTx);
+void LPUART_config_baud(LPUART_t* LPUARTx, unsigned int baud);
 void LPUART_enable_transmitter(LPUART_t* LPUARTx);
 void LPUART_enable_receiver(LPUART_t* LPUARTx);
 void LPUART_send_byte(LPUART_t* LPUARTx, unsigned char send);
@@ -77,13 +101,11 @@ void LPUART_send_string(LPUART_t* LPUARTx, unsigned char data_string[]);
 char LPUART_receive_char(LPUART_t* LPUARTx);
 void lpuart_receive_string(LPUART_t* LPUARTx, unsigned char* buffer, unsigned int* buffer_index, unsigned int buffer_size);
 void sendFPHeader(LPUART_t* LPUARTx);
-unsigned char sendFPGetImage(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock);
-unsigned char sendFPCreateCharFile1(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock);
-unsigned char sendFPCreateCharFile2(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock);
-unsigned char sendFPCreateTemplate(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock);
-unsigned char sendFPDeleteAllFinger(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock);
-unsigned char sendFPSearchFinger(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock);
-unsigned char SendStoreFinger(unsigned char IDStore, LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock);
-void check_response_fingerprint(unsigned char response) ;
+void sendFPCommand(LPUART_t* LPUARTx, fp_command_t command);
+void sendFPStoreCommand(unsigned short IDStore, LPUART_t* LPUARTx);
+void sendFPSearchCommand(LPUART_t* LPUARTx, unsigned char high_speed, unsigned short start, unsigned short pages);
+void sendFPLoadCharCommand(LPUART_t* LPUARTx, unsigned short page);
+void sendFPWriteNotepadCommand(LPUART_t* LPUARTx, unsigned char page, const unsigned char data[]);
+void sendFPReadNotepadCommand(LPUART_t* LPUARTx, unsigned char page);
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -194,8 +194,15 @@ typedef struct {
 #define LPUART2_BASE        (0x4006C000U)
 
 /** Peripheral LPUART base pointers */
+#ifdef HOST_BUILD
+extern LPUART_t host_lpuart[3]; /* RAM register model of the host build */
+#define LPUART0             (&host_lpuart[0])
+#define LPUART1             (&host_lpuart[1])
+#define LPUART2             (&host_lpuart[2])
+#else
 #define LPUART0             ((LPUART_t *)(LPUART0_BASE))
 #define LPUART1             ((LPUART_t *)(LPUART1_BASE))
 #define LPUART2             ((LPUART_t *)(LPUART2_BASE))
+#endif /* HOST_BUILD */
 
 #endif /* LPUART_REGISTER_H_ */
\ No newline at end of file
@@ -0,0 +1,32 @@
+/**
+*   @file    namepack.h
+*   @brief   Declaration of the 6-bit packed encoding of the user names.
+*   @details The keypad only enters uppercase letters, digits and spaces, so a name character
+*            is stored as its SIXBIT code (ASCII 0x20 to 0x5F minus 0x20) and four characters
+*            take three bytes. The codes are packed from the least significant bit of the first
+*            byte on; the length is kept apart by the caller, as a prefix of the record. A name
+*            of NAMEPACK_MAX_LENGTH characters takes 12 bytes instead of 16.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef NAMEPACK_H
+#define NAMEPACK_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define NAMEPACK_MAX_LENGTH     16U             /* Characters of a name */
+#define NAMEPACK_SIZE(length)   (((length) * 6U + 7U) / 8U)     /* Bytes of a packed name */
+#define NAMEPACK_MAX_SIZE       NAMEPACK_SIZE(NAMEPACK_MAX_LENGTH)
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+unsigned char NamePack_Encode(const char *name, unsigned char *packed);
+void NamePack_Decode(const unsigned char *packed, unsigned char length, char *name);
+
+#endif /* NAMEPACK_H */
@@ -43,6 +43,11 @@ typedef struct {
 
 
 /** NVIC base pointer */
+#ifdef HOST_BUILD
+extern NVIC_Type_t host_nvic; /* RAM register model of the host build */
+#define NVIC    (&host_nvic)
+#else
 #define NVIC    ((NVIC_Type_t *)NVIC_BASE)
+#endif /* HOST_BUILD */
 
 #endif
\ No newline at end of file
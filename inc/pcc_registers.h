@@ -90,6 +90,11 @@ typedef struct {
 /** Peripheral PCC base address */
 #define PCC_BASE_ADDR (0x40065000u)
 /** Peripheral PCC base pointer */
+#ifdef HOST_BUILD
+extern PCC_Type host_pcc; /* RAM register model of the host build */
+#define PCC (&host_pcc)
+#else
 #define PCC ((PCC_Type *)PCC_BASE_ADDR)
+#endif /* HOST_BUILD */
 
 #endif
\ No newline at end of file
@@ -107,10 +107,19 @@ typedef struct {
 #define PORTE_BASE                               (0x4004D000U)   /**< PORTE base address */
 
 /** @brief Pointers to PORT peripherals */
+#ifdef HOST_BUILD
+extern Port_Type host_port[5]; /* RAM register model of the host build */
+#define PORTA    (&host_port[0])
+#define PORTB    (&host_port[1])
+#define PORTC    (&host_port[2])
+#define PORTD    (&host_port[3])
+#define PORTE    (&host_port[4])
+#else
 #define PORTA    ((Port_Type *)PORTA_BASE)       /**< Pointer to PORTA base address */
 #define PORTB    ((Port_Type *)PORTB_BASE)       /**< Pointer to PORTB base address */
 #define PORTC    ((Port_Type *)PORTC_BASE)       /**< Pointer to PORTC base address */
 #define PORTD    ((Port_Type *)PORTD_BASE)       /**< Pointer to PORTD base address */
 #define PORTE    ((Port_Type *)PORTE_BASE)       /**< Pointer to PORTE base address */
+#endif /* HOST_BUILD */
 
 #endif /* PORT_REGISTER_H */
\ No newline at end of file
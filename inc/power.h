@@ -0,0 +1,59 @@
+/**
+*   @file    power.h
+*   @brief   Declaration of the idle power manager.
+*   @details When the firmware has nothing to do, the power manager sleeps with WFI for short
+*            idle periods and enters VLPS (very low power stop) for long ones. In VLPS the SPLL,
+*            SOSC and all the bus clocks are stopped; the board wakes up on any enabled interrupt
+*            (sensor touch pin PTC3, RX edge on the console LPUART1, RTC seconds) or on the
+*            LPTMR0 wake-up timer programmed for the next software deadline. The keypad has no
+*            pin interrupt: it is scanned from a software timer while a name is entered, so a
+*            key press does not wake the board. On wake the SCG run clock configuration is
+*            restored and the time spent asleep is returned so that the caller can advance its
+*            software timers.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef POWER_H
+#define POWER_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define POWER_IDLE_FOREVER      0xFFFFFFFFU     /* No software deadline */
+#define POWER_VLPS_MIN_IDLE_MS  20U             /* Shorter idle periods only use WFI */
+
+/* Reasons that keep the clocks running (VLPS is not entered while one is held) */
+#define POWER_HOLD_SENSOR       (1U << 0)       /* A sensor reply is expected on LPUART2 */
+#define POWER_HOLD_CONSOLE      (1U << 1)       /* Console bytes are arriving on LPUART1 */
+#define POWER_HOLD_FLASH        (1U << 2)       /* A flash command is running */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Idle statistics.
+ */
+typedef struct {
+    unsigned int wfi_count;         /*!< Number of WFI sleeps */
+    unsigned int vlps_count;        /*!< Number of VLPS sleeps */
+    unsigned int vlps_ms;           /*!< Total time spent in VLPS, in milliseconds */
+    unsigned int wake_us_last;      /*!< Wake-up to clocks ready time of the last VLPS exit, in us */
+    unsigned int wake_us_max;       /*!< Slowest wake-up to clocks ready time, in us */
+} power_stats_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Power_Init(void);
+void Power_Hold(unsigned int reason);
+void Power_Release(unsigned int reason);
+unsigned int Power_Idle(unsigned int idle_ms);
+void Power_ClearWakeTimer(void);
+void Power_GetStats(power_stats_t *stats);
+
+#endif /* POWER_H */
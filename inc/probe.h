@@ -0,0 +1,79 @@
+/**
+*   @file    probe.h
+*   @brief   Declaration of the cycle-count profiling probes.
+*   @details A probe measures the DWT cycles from PROBE_BEGIN() to PROBE_END() of its ID and keeps
+*            their count, minimum, maximum, total and a log2 histogram in RAM. The times include
+*            the interrupts taken in between, and a probe must not be nested with itself. The
+*            begin and end of a probe may run in different contexts, the end is ignored when no
+*            begin is pending. The cycle counter stops in VLPS, so a probe should not span a
+*            sleep; the cycles are those of the clock profile in use, see clock_policy.h.
+*
+*            The probes cost a few dozen cycles each and are compiled out entirely, with their
+*            RAM, unless PROBE_ENABLE is defined to 1 (compiler define PROBE_ENABLE=1). The
+*            interrupt handlers are measured by isr_stats.h, which also gives their latency.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef PROBE_H
+#define PROBE_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#ifndef PROBE_ENABLE
+#define PROBE_ENABLE            0
+#endif
+
+#define PROBE_BUCKETS           32U             /* Bucket k counts 2^k to 2^(k+1) - 1 cycles, 0 and 1 in 0 */
+
+/* Probe IDs */
+#define PROBE_FP_REPLY          0U              /* Sensor command sent to its reply received */
+#define PROBE_LCD_STRING        1U              /* lcd_send_string() */
+#define PROBE_LCD_FLUSH         2U              /* Frame buffer written to the LCD */
+#define PROBE_DISPLAY_TIME      3U              /* display_time() */
+#define PROBE_GET_KEY           4U              /* get_key() keypad scan */
+#define PROBE_UART_STRING       5U              /* LPUART_send_string() */
+#define PROBE_COUNT             6U
+
+#if PROBE_ENABLE
+#define PROBE_INIT()            Probe_Init()
+#define PROBE_BEGIN(id)         Probe_Begin(id)
+#define PROBE_END(id)           Probe_End(id)
+#else
+#define PROBE_INIT()            do { } while (0)
+#define PROBE_BEGIN(id)         do { } while (0)
+#define PROBE_END(id)           do { } while (0)
+#endif
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Statistics of a probe, in core clock cycles.
+ */
+typedef struct {
+    unsigned int count;                     /*!< Measurements */
+    unsigned int min;
+    unsigned int max;
+    unsigned long long total;               /*!< Sum of the measurements, for the mean */
+    unsigned int buckets[PROBE_BUCKETS];    /*!< Log2 histogram */
+} probe_stats_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+#if PROBE_ENABLE
+void Probe_Init(void);
+void Probe_Begin(unsigned int id);
+void Probe_End(unsigned int id);
+void Probe_GetStats(unsigned int id, probe_stats_t *stats);
+const char *Probe_GetName(unsigned int id);
+void Probe_Reset(void);
+#endif
+
+#endif /* PROBE_H */
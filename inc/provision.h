@@ -0,0 +1,85 @@
+/**
+*   @file    provision.h
+*   @brief   Declaration of the bulk stream of the user directory.
+*   @details The directory (name and schedule of each user) is exported and imported as one
+*            binary stream on the console, so that a door is commissioned from a file rather
+*            than one keypad entry at a time. The stream is a sequence of batch frames and one
+*            end frame, multi-byte fields big-endian:
+*
+*              'B' seq (1) length (2) records (length bytes) CRC (2)
+*              'E' count (2) CRC (2)
+*
+*            A record is the user ID (2), the schedule (1), the length of the name (1) and the
+*            name characters. seq counts the batches from 0 modulo 256, count is the number of
+*            records of the stream. The CRC is a CRC-16/CCITT (polynomial 0x1021, initial value
+*            0xFFFF) running over every byte of the stream except the frame types and the CRC
+*            fields, each frame carrying its value at the end of the frame: a batch that is
+*            corrupted, lost or sent twice breaks the chain.
+*
+*            An exported stream is imported as it is. On import the device answers every batch
+*            with PROVISION_REPLY_ACK or PROVISION_REPLY_NAK followed by seq, and the end frame
+*            with PROVISION_REPLY_DONE, the count and a status; the host sends a batch only once
+*            the previous one is acknowledged and sends it again after a NAK. A batch that can
+*            never be applied, such as one with a record out of range, is answered with
+*            PROVISION_REPLY_DONE instead, which closes the stream; the host stops there. The
+*            flash is written while the host waits, so the console buffer never has to absorb
+*            more than one batch.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef PROVISION_H
+#define PROVISION_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define PROVISION_NAME_LENGTH   16U             /* Not null-terminated when this long */
+#define PROVISION_RECORD_SIZE(length)   (4U + (length))
+#define PROVISION_RECORD_MAX_SIZE       PROVISION_RECORD_SIZE(PROVISION_NAME_LENGTH)
+#define PROVISION_BATCH_SIZE    256U            /* Record bytes of a batch at most */
+#define PROVISION_FRAME_SIZE    (4U + PROVISION_BATCH_SIZE + 2U)
+
+/* Frame types */
+#define PROVISION_FRAME_BATCH   'B'
+#define PROVISION_FRAME_END     'E'
+#define PROVISION_REPLY_ACK     'A'             /* seq: the batch is applied */
+#define PROVISION_REPLY_NAK     'N'             /* seq: send the batch again */
+#define PROVISION_REPLY_DONE    'D'             /* count (2), status: the stream is closed */
+
+/* Provision_Receive() */
+#define PROVISION_MORE          0U              /* The frame is not complete */
+#define PROVISION_BATCH         1U              /* A new batch, read with Provision_NextRecord() */
+#define PROVISION_REPEAT        2U              /* The last batch again, its ACK was lost */
+#define PROVISION_BAD           3U              /* A corrupted or out-of-sequence batch */
+#define PROVISION_END           4U              /* The end frame, the stream is complete */
+#define PROVISION_END_BAD       5U              /* An end frame with a wrong count or CRC */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+typedef struct {
+    unsigned short user_id;
+    unsigned char schedule;
+    char name[PROVISION_NAME_LENGTH];   /*!< Padded with null characters */
+} provision_record_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Provision_RxStart(void);
+unsigned char Provision_Receive(unsigned char byte);
+unsigned char Provision_NextRecord(provision_record_t *record);
+void Provision_Accept(void);
+unsigned char Provision_Sequence(void);
+unsigned short Provision_Count(void);
+void Provision_TxStart(void);
+unsigned char Provision_TxAdd(const provision_record_t *record);
+unsigned int Provision_TxBatch(const unsigned char **frame);
+unsigned int Provision_TxEnd(const unsigned char **frame);
+
+#endif /* PROVISION_H */
@@ -0,0 +1,111 @@
+/**
+*   @file    pt.h
+*   @brief   Stackless coroutines (protothreads) running on top of the task scheduler.
+*   @details A protothread is a function written as a sequential flow that can wait for a
+*            condition, for a scheduler event or for a timeout in the middle of its body. Waiting
+*            returns to the caller; the next call resumes the function right after the wait. The
+*            resume point is the only state kept between calls (pt_t, 2 bytes), so a protothread
+*            needs no stack of its own.
+*
+*            Restrictions of the implementation (a switch statement on the resume point):
+*            - Local variables are not preserved across a wait, keep the state in static variables.
+*            - The body between PT_BEGIN and PT_END must not contain a switch statement.
+*            - Only one wait may be written per source line.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef PT_H
+#define PT_H
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "scheduler.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+/* Return values of a protothread */
+#define PT_WAITING          0       /* Blocked in PT_WAIT_UNTIL / PT_WAIT_WHILE */
+#define PT_YIELDED          1       /* Blocked in PT_YIELD / PT_YIELD_UNTIL / PT_WAIT_EVENT */
+#define PT_EXITED           2       /* Left with PT_EXIT */
+#define PT_ENDED            3       /* Reached PT_END */
+
+/* Scheduler event reserved for the protothread timeouts, tasks must not use this bit */
+#define PT_EVT_TIMEOUT      (1U << 31)
+
+/*!
+ * @brief  Declaration and control of a protothread.
+ *
+ * @detail PT_THREAD declares the protothread function, PT_BEGIN and PT_END enclose its body.
+ *         PT_INIT makes the next call start the body from the beginning; PT_RESTART does the
+ *         same from inside the body and PT_EXIT ends the body early.
+ */
+#define PT_THREAD(name_args)            char name_args
+#define PT_INIT(pt)                     ((pt)->lc = 0U)
+#define PT_BEGIN(pt)                    { char pt_yield_flag = 1; (void)pt_yield_flag; \
+                                          switch((pt)->lc) { case 0U:
+#define PT_END(pt)                      } pt_yield_flag = 0; PT_INIT(pt); return PT_ENDED; }
+#define PT_RESTART(pt)                  do { PT_INIT(pt); return PT_WAITING; } while(0)
+#define PT_EXIT(pt)                     do { PT_INIT(pt); return PT_EXITED; } while(0)
+
+/*!
+ * @brief  Waits.
+ *
+ * @detail PT_WAIT_UNTIL continues at once when the condition is already true. PT_YIELD always
+ *         returns to the caller once; PT_YIELD_UNTIL returns once and then waits until the
+ *         condition is true, so the condition is only tested again on a later call.
+ */
+#define PT_WAIT_UNTIL(pt, cond)         do { (pt)->lc = __LINE__; case __LINE__: \
+                                             if(!(cond)) { return PT_WAITING; } } while(0)
+#define PT_WAIT_WHILE(pt, cond)         PT_WAIT_UNTIL((pt), !(cond))
+#define PT_YIELD(pt)                    do { pt_yield_flag = 0; (pt)->lc = __LINE__; case __LINE__: \
+                                             if(pt_yield_flag == 0) { return PT_YIELDED; } } while(0)
+#define PT_YIELD_UNTIL(pt, cond)        do { pt_yield_flag = 0; (pt)->lc = __LINE__; case __LINE__: \
+                                             if((pt_yield_flag == 0) || !(cond)) { return PT_YIELDED; } } while(0)
+
+/*!
+ * @brief  Runs a child protothread.
+ *
+ * @detail PT_WAIT_THREAD calls the child on every call of the parent until the child exits or
+ *         ends. PT_SPAWN first resets the child so that it starts from the beginning.
+ */
+#define PT_WAIT_THREAD(pt, thread)      PT_WAIT_WHILE((pt), (thread) < PT_EXITED)
+#define PT_SPAWN(pt, child, thread)     do { PT_INIT(child); PT_WAIT_THREAD((pt), (thread)); } while(0)
+
+/*!
+ * @brief  Waits for scheduler events.
+ *
+ * @detail These macros are used in a protothread that is called from a task with the events
+ *         delivered to that task. PT_WAIT_EVENT waits for a later call that delivers one of the
+ *         events in mask, so the events of the current call are never taken as the answer to
+ *         an action started in it. PT_WAIT_EVENT_TIMEOUT also gives up after ms milliseconds,
+ *         which PT_TIMED_OUT reports; PT_DELAY only waits for the delay. The timeout is a
+ *         scheduler timer posting PT_EVT_TIMEOUT to task_id; it is cancelled when the wait ends,
+ *         together with a PT_EVT_TIMEOUT that expired meanwhile and is still pending.
+ */
+#define PT_WAIT_EVENT(pt, events, mask) PT_YIELD_UNTIL((pt), ((events) & (mask)) != 0U)
+#define PT_WAIT_EVENT_TIMEOUT(pt, task_id, events, mask, ms) \
+                                        do { Sched_StartTimer((task_id), PT_EVT_TIMEOUT, (ms)); \
+                                             PT_WAIT_EVENT((pt), (events), (mask) | PT_EVT_TIMEOUT); \
+                                             Sched_CancelTimer((task_id), PT_EVT_TIMEOUT); } while(0)
+#define PT_DELAY(pt, task_id, events, ms) \
+                                        PT_WAIT_EVENT_TIMEOUT((pt), (task_id), (events), 0U, (ms))
+#define PT_TIMED_OUT(events)            (((events) & PT_EVT_TIMEOUT) != 0U)
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Protothread state: the source line to resume at, 0 before the first call.
+ */
+typedef struct {
+    unsigned short lc;
+} pt_t;
+
+#endif /* PT_H */
@@ -37,6 +37,11 @@ typedef struct {
 
 #define RTC_BASE    (0x4003D000U)
 /** Peripheral RTC base pointer */
+#ifdef HOST_BUILD
+extern RTC_Type host_rtc; /* RAM register model of the host build */
+#define RTC         (&host_rtc)
+#else
 #define RTC         ((RTC_Type *)RTC_BASE)
+#endif /* HOST_BUILD */
 
 #endif /* RTC_REGISTER_H */
@@ -0,0 +1,55 @@
+/**
+*   @file    scb_registers.h
+*   @brief   Register definitions for the System Control Block (SCB) of the Cortex-M4 core.
+*   @details Defines the structure for the SCB registers used by the firmware (interrupt control,
+*            system control and system handler priorities), base address, and includes guards
+*            to prevent multiple declarations.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef SCB_REGISTER_H
+#define SCB_REGISTER_H
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+/**
+* @brief          SCB structure.
+* @details        Structure defining the SCB registers and their offsets.
+*/
+typedef struct {
+  volatile const unsigned int CPUID;    /* Offset: 0x00 - CPUID Base Register */
+  volatile unsigned int ICSR;           /* Offset: 0x04 - Interrupt Control and State Register */
+  volatile unsigned int VTOR;           /* Offset: 0x08 - Vector Table Offset Register */
+  volatile unsigned int AIRCR;          /* Offset: 0x0C - Application Interrupt and Reset Control Register */
+  volatile unsigned int SCR;            /* Offset: 0x10 - System Control Register */
+  volatile unsigned int CCR;            /* Offset: 0x14 - Configuration and Control Register */
+  volatile unsigned int SHPR1;          /* Offset: 0x18 - System Handler Priority Register 1 */
+  volatile unsigned int SHPR2;          /* Offset: 0x1C - System Handler Priority Register 2 (SVCall) */
+  volatile unsigned int SHPR3;          /* Offset: 0x20 - System Handler Priority Register 3 (PendSV, SysTick) */
+  volatile unsigned int SHCSR;          /* Offset: 0x24 - System Handler Control and State Register */
+} scb_type_t;
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+#define SCB_BASE                (0xE000ED00U) /* Base address for SCB registers */
+/** Pointer to the SCB base address */
+#ifdef HOST_BUILD
+extern scb_type_t host_scb;     /* RAM register model of the host build */
+#define SCB                     (&host_scb)
+#else
+#define SCB                     ((scb_type_t*)(SCB_BASE))
+#endif /* HOST_BUILD */
+
+#define SCB_ICSR_PENDSVSET      (1U << 28U)   /* Set the PendSV exception pending */
+#define SCB_ICSR_PENDSVCLR      (1U << 27U)   /* Clear the pending PendSV exception */
+#define SCB_ICSR_VECTACTIVE     (0x1FFU)      /* Number of the active exception, 0 in thread mode */
+#define SCB_SCR_SLEEPONEXIT     (1U << 1U)    /* Sleep again when returning to thread mode */
+#define SCB_SCR_SLEEPDEEP       (1U << 2U)    /* WFI enters the deep sleep (stop) modes */
+#define SCB_SHPR3_PENDSV_SHIFT  (16U)         /* PendSV priority field */
+#define SCB_SHPR3_SYSTICK_SHIFT (24U)         /* SysTick priority field */
+
+#endif /* SCB_REGISTER_H */
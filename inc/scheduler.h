@@ -0,0 +1,50 @@
+/**
+*   @file    scheduler.h
+*   @brief   Declaration of the cooperative run-to-completion task scheduler.
+*   @details Tasks are plain functions that are called with the set of events posted to them
+*            since their last run. Each task returns as soon as it has handled its events, so the
+*            response to any input is bounded by the longest task step. Events can be posted from
+*            interrupt handlers or from other tasks, and one-shot software timers deliver events
+*            after a delay measured in SysTick milliseconds.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define SCHED_MAX_TASKS     8U      /* Task IDs 0..7, ID 0 has the highest priority */
+#define SCHED_MAX_TIMERS    12U     /* Number of software timers that can run at the same time */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Task entry point.
+ *
+ * @param[in] events: Bit mask of the events posted to the task since its last run.
+ */
+typedef void (*sched_task_t)(unsigned int events);
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Sched_Init(void);
+void Sched_AddTask(unsigned char task_id, sched_task_t task);
+void Sched_PostEvent(unsigned char task_id, unsigned int events);
+void Sched_StartTimer(unsigned char task_id, unsigned int event, unsigned int ms);
+void Sched_StopTimer(unsigned char task_id, unsigned int event);
+void Sched_CancelTimer(unsigned char task_id, unsigned int event);
+void Sched_Tick(void);
+unsigned int Sched_NextTimeout(void);
+void Sched_Run(void);
+void Sched_Idle(void);
+
+#endif /* SCHEDULER_H */
@@ -0,0 +1,77 @@
+/**
+*   @file    smc_registers.h
+*   @brief   Register definitions for the System Mode Controller (SMC) and the Power Management
+*            Controller (PMC).
+*   @details Defines the structures for the SMC and PMC registers used to enter the very low
+*            power modes, base addresses, and includes guards to prevent multiple declarations.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef SMC_REGISTER_H
+#define SMC_REGISTER_H
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+/**
+* @brief          SMC structure.
+* @details        Structure defining the SMC registers and their offsets.
+*/
+typedef struct {
+  volatile const unsigned int VERID;    /* Offset: 0x00 - Version ID Register */
+  volatile const unsigned int PARAM;    /* Offset: 0x04 - Parameter Register */
+  volatile unsigned int PMPROT;         /* Offset: 0x08 - Power Mode Protection Register (write once) */
+  union {
+    volatile unsigned int PMCTRL_Register;  /* Offset: 0x0C - Power Mode Control Register */
+    struct {
+        volatile unsigned int STOPM       : 3;  /* Stop mode entered by WFI with SLEEPDEEP */
+        volatile const unsigned int RESERVED1 : 2;
+        volatile unsigned int RUNM        : 2;  /* Run mode: 0 RUN, 2 VLPR, 3 HSRUN */
+        volatile const unsigned int RESERVED2 : 25;
+    } PMCTRL;
+  };
+  volatile unsigned int STOPCTRL;       /* Offset: 0x10 - Stop Control Register */
+  volatile const unsigned int PMSTAT;   /* Offset: 0x14 - Power Mode Status Register */
+} smc_type_t;
+
+/**
+* @brief          PMC structure.
+* @details        Structure defining the PMC registers and their offsets.
+*/
+typedef struct {
+  volatile unsigned char LVDSC1;        /* Offset: 0x00 - Low Voltage Detect Status and Control 1 */
+  volatile unsigned char LVDSC2;        /* Offset: 0x01 - Low Voltage Detect Status and Control 2 */
+  volatile unsigned char REGSC;         /* Offset: 0x02 - Regulator Status and Control */
+  volatile const unsigned char RESERVED;
+  volatile unsigned char LPOTRIM;       /* Offset: 0x04 - Low Power Oscillator Trim */
+} pmc_type_t;
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+#define SMC_BASE                (0x4007E000U) /* Base address for SMC registers */
+#define PMC_BASE                (0x4007D000U) /* Base address for PMC registers */
+/** Pointers to the SMC and PMC base addresses */
+#ifdef HOST_BUILD
+extern smc_type_t host_smc;     /* RAM register models of the host build */
+extern pmc_type_t host_pmc;
+#define SMC                     (&host_smc)
+#define PMC                     (&host_pmc)
+#else
+#define SMC                     ((smc_type_t*)(SMC_BASE))
+#define PMC                     ((pmc_type_t*)(PMC_BASE))
+#endif /* HOST_BUILD */
+
+#define SMC_PMPROT_AVLP         (1U << 5U)    /* Allow the very low power modes (VLPR, VLPS) */
+#define SMC_STOPM_STOP          (0U)          /* Normal stop */
+#define SMC_STOPM_VLPS          (2U)          /* Very low power stop */
+#define SMC_RUNM_RUN            (0U)
+#define SMC_RUNM_VLPR           (2U)
+#define SMC_PMSTAT_RUN          (0x01U)
+#define SMC_PMSTAT_VLPR         (0x04U)
+#define SMC_PMSTAT_VLPS         (0x10U)
+#define PMC_REGSC_BIASEN        (1U << 0U)    /* Bias enable, required by the very low power modes */
+
+#endif /* SMC_REGISTER_H */
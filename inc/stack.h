@@ -0,0 +1,48 @@
+/**
+*   @file    stack.h
+*   @brief   Declaration of the stack high-water marks.
+*   @details A stack is painted with STACK_PAINT before it is used; the bytes that no longer hold
+*            the pattern have been written at least once, which gives the deepest use of the
+*            stack since it was painted. The kernel paints the thread stacks it is given (see
+*            Kernel_GetStackUsage()); main() paints the main stack, which the interrupt handlers
+*            and the boot use, with Stack_PaintMain() before anything else.
+*
+*            A frame that is reserved but never written (a large local buffer used in part) is
+*            not counted, so the marks are a floor of the real use; keep some margin above them
+*            when the stack reservations of the scatter file or of the threads are shrunk.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef STACK_H
+#define STACK_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define STACK_PAINT             0xDEADBEEFU     /* Pattern of the stack words never written */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Use of a stack, in bytes.
+ */
+typedef struct {
+    unsigned int size;                      /*!< Bytes reserved, 0 if the stack is not watched */
+    unsigned int used;                      /*!< Bytes written since the paint, the high-water mark */
+} stack_usage_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Stack_Paint(unsigned int *base, unsigned int words);
+unsigned int Stack_Used(const unsigned int *base, unsigned int words);
+void Stack_PaintMain(void);
+void Stack_GetMainUsage(stack_usage_t *usage);
+
+#endif /* STACK_H */
@@ -39,7 +39,10 @@ typedef struct {
 void SysTick_Enable();
 void SysTick_Init(systick_config_t config);
 void SysTick_Disable();
-void delay(unsigned int ms, unsigned int core_clock);
+void SysTick_StartTick(void);
+void SysTick_IncTick(void);
+unsigned int SysTick_GetTick(void);
+void delay(unsigned int ms);
 void SysTick_SetReload(unsigned int reload);
 
 #endif /* SYSTICK_H_ */
@@ -52,6 +52,11 @@ typedef struct {
 ==================================================================================================*/
 #define SYSTICK_BASE           (0xE000E010U) /* Base address for SysTick registers */
 /** Pointer to the SysTick base address */
+#ifdef HOST_BUILD
+extern systick_type_t host_systick; /* RAM register model of the host build */
+#define SYSTICK                (&host_systick)
+#else
 #define SYSTICK                ((systick_type_t*)(SYSTICK_BASE))
+#endif /* HOST_BUILD */
 
 #endif /* SYSTICK_REGISTER_H */
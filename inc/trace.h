@@ -0,0 +1,81 @@
+/**
+*   @file    trace.h
+*   @brief   Declaration of the trace ring of the state transitions.
+*   @details Trace_Record() appends a record of the SysTick millisecond, an event ID and two
+*            arguments to a ring of TRACE_RECORDS records, the oldest being overwritten. A
+*            record is claimed with an exclusive load and store of the write count and filled
+*            with two word stores, so threads and interrupt handlers record without masking
+*            the interrupts, in about 20 cycles.
+*
+*            The ring lives in the .bss.noinit section, which the scatter file leaves out of
+*            the zero initialisation: Trace_Init() keeps the records of a ring whose magic is
+*            valid after a warm reset, so the events before a watchdog or a lockup reset can be
+*            read afterwards, and starts an empty ring after a power-on. Each boot records
+*            TRACE_BOOT; the millisecond count restarts there.
+*
+*            Dump stream, multi-byte fields big-endian: TRACE_DUMP_MAGIC, TRACE_DUMP_VERSION,
+*            the number of records (2 bytes), then the records from the oldest, TRACE_DUMP_RECORD
+*            bytes each: millisecond (4), event (1), arg0 (1), arg1 (2). host/trace_decode turns
+*            it into a timeline.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define TRACE_RECORDS           128U            /* Must be a power of two */
+
+/* Events: arg0, arg1 */
+#define TRACE_BOOT              0x01U           /* 0, boots kept by the ring, this one included */
+#define TRACE_FINGER_MODE       0x02U           /* New finger_mode, previous one */
+#define TRACE_FP_COMMAND        0x03U           /* Sensor instruction code, page addressed or 0 */
+#define TRACE_FP_REPLY          0x04U           /* Confirmation code, first data word or 0xFFFF */
+#define TRACE_FP_TIMEOUT        0x05U           /* 0, 0: no valid reply in time */
+#define TRACE_KEY               0x06U           /* Key position (1-16), keytap mode */
+#define TRACE_LCD_FLUSH         0x07U           /* 0, characters written */
+#define TRACE_LOCK              0x08U           /* TRACE_LOCK_xxx, see below */
+
+/* Lock actions, arg0 of TRACE_LOCK */
+#define TRACE_LOCK_OPEN         1U              /* arg1: signal to pin in cycles, 0xFFFF if longer */
+#define TRACE_LOCK_CLOSE        0U              /* arg1: 1 if closed on request, 0 after the hold time */
+
+/* Dump stream */
+#define TRACE_DUMP_MAGIC        'T'
+#define TRACE_DUMP_VERSION      1U
+#define TRACE_DUMP_HEADER       4U              /* Bytes of the header */
+#define TRACE_DUMP_RECORD       8U              /* Bytes of a record */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Trace record.
+ */
+typedef struct {
+    unsigned int ms;                        /*!< SysTick milliseconds since the boot */
+    unsigned char event;                    /*!< TRACE_xxx */
+    unsigned char arg0;
+    unsigned short arg1;
+} trace_record_t;
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void Trace_Init(void);
+void Trace_Record(unsigned char event, unsigned char arg0, unsigned short arg1);
+void Trace_Freeze(unsigned char on);
+void Trace_Clear(void);
+unsigned int Trace_Count(void);
+void Trace_Get(unsigned int index, trace_record_t *record);
+unsigned int Trace_DumpHeader(unsigned char *out);
+unsigned int Trace_DumpRecord(unsigned int index, unsigned char *out);
+
+#endif /* TRACE_H */
@@ -0,0 +1,54 @@
+/**
+*   @file    userdb.h
+*   @brief   Declaration of the log-structured user database in program flash.
+*   @details Every change of a user appends a new version of its record to the sector being
+*            written, and a RAM index gives the offset of the latest version of each user, so
+*            saving, renaming and deleting cost one small append and reading costs the flash
+*            read and the unpacking of the name. Names are stored 6 bits per character, once:
+*            users with the same name share the record of one of them. Sectors full of old
+*            versions are compacted in the background by UserDb_Service(): the live records of
+*            the oldest sector are copied forward, then the sector is erased. Records carry a
+*            CRC, so a version torn by a power cut is ignored and the previous one stays current.
+*
+*            The database is kept in the program flash sectors reserved by the scatter file.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef USERDB_H
+#define USERDB_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define USERDB_BASE             0x00070000U     /* m_userdb_start of the scatter file */
+#define USERDB_SECTORS          16U             /* Program flash sectors, 4 KB each */
+#define USERDB_MAX_USERS        1000U           /* Fingerprint IDs 0..999 */
+#define USERDB_NAME_LENGTH      16U             /* Not null-terminated when this long */
+
+/* Status of the database calls */
+#define USERDB_OK               0U
+#define USERDB_NOT_FOUND        1U              /* The user has no record */
+#define USERDB_INVALID          2U              /* User out of range */
+#define USERDB_FULL             3U              /* No room until UserDb_Service() has compacted */
+#define USERDB_ERROR            4U              /* The flash command failed */
+
+/* Background work left by UserDb_Service() */
+#define USERDB_SERVICE_DONE     0U              /* Nothing left to do */
+#define USERDB_SERVICE_MORE     1U              /* Call again */
+#define USERDB_SERVICE_ERASE    2U              /* A sector waits for an erase the caller did not allow */
+#define USERDB_SERVICE_FAILED   3U              /* The erase failed, the sector is erased again later */
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+void UserDb_Init(void);
+unsigned char UserDb_GetName(unsigned int user_id, char *name);
+unsigned char UserDb_Put(unsigned int user_id, const char *name);
+unsigned char UserDb_Delete(unsigned int user_id);
+unsigned char UserDb_Service(unsigned char may_erase);
+
+#endif /* USERDB_H */
@@ -0,0 +1,51 @@
+/**
+*   @file    users.h
+*   @brief   Declaration of the persistent user names and access schedules.
+*   @details The names are kept by the log-structured user database in program flash
+*            (userdb.h): a name is unpacked from flash when it is read, and saving a name appends
+*            a new version of the user, whose old versions are compacted in the background by
+*            Users_Service().
+*
+*            The access schedule of each user is one byte of the FlexNVM EEPROM emulation, read
+*            in place through the FlexRAM; a user who was never given one reads as
+*            USERS_NO_SCHEDULE.
+*/
+
+/*==================================================================================================
+==================================================================================================*/
+
+#ifndef USERS_H
+#define USERS_H
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define USERS_MAX_USERS         1000U           /* Names of the fingerprint IDs 0..999 */
+#define USERS_NAME_LENGTH       16U             /* Not null-terminated when this long */
+
+/* Status of the users calls */
+#define USERS_OK                0U
+#define USERS_INVALID           1U              /* User out of range */
+#define USERS_ERROR             2U              /* The name or schedule could not be saved */
+
+#define USERS_NO_SCHEDULE       0xFFU           /* Erased EEE: the user was never given a schedule */
+
+/* Background work left by Users_Service(), the values of USERDB_SERVICE_x */
+#define USERS_SERVICE_DONE      0U              /* Nothing left to do */
+#define USERS_SERVICE_MORE      1U              /* Call again */
+#define USERS_SERVICE_ERASE     2U              /* A sector waits for an erase the caller did not allow */
+#define USERS_SERVICE_FAILED    3U              /* The erase failed, to be retried later */
+
+/*==================================================================================================
+*                                    FUNCTION PROTOTYPES
+==================================================================================================*/
+
+unsigned char Users_Init(void);
+void Users_GetName(unsigned int user_id, char *name);
+unsigned char Users_SetName(unsigned int user_id, const char *name);
+unsigned char Users_GetSchedule(unsigned int user_id);
+unsigned char Users_SetSchedule(unsigned int user_id, unsigned char schedule);
+unsigned char Users_Service(unsigned char may_erase);
+
+#endif /* USERS_H */
@@ -4,12 +4,31 @@
 #include "pcc.h"
 #include "port.h"
 #include "lpuart.h"
+#include "fp_reply.h"
 #include "gpio.h"
 #include "clock.h"
 #include "systick.h"
 #include "nvic.h"
 #include "i2c.h"
 #include "RTC.h"
+#include "scheduler.h"
+#include "pt.h"
+#include "kernel.h"
+#include "power.h"
+#include "clock_policy.h"
+#include "access.h"
+#include "flash.h"
+#include "event_log.h"
+#include "users.h"
+#include "hotset.h"
+#include "provision.h"
+#include "probe.h"
+#include "isr_stats.h"
+#include "stack.h"
+#include "trace.h"
+#include "latency.h"
+#include "dwt_registers.h"
+#include "core.h"
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -17,14 +36,197 @@
 /*==================================================================================================
 *                                      DEFINES AND MACROS
 ==================================================================================================*/
-#define CORE_CLOCK 80000000U
 #define IMPORT_FINGERPRINT_MODE 0
 #define SEARCH_FINGERPRINT_MODE 1
 #define CREATE_NEW_USER_NAME_MODE 2
 #define KEYTAP_NUMBER_MODE 0
 #define KEYTAP_CHARACTER_MODE 1
-#define MAX_NUM_USER 100
-#define MAX_NAME_LENGTH 16
+#define MAX_NUM_USER USERS_MAX_USERS
+#define MAX_NAME_LENGTH USERS_NAME_LENGTH
+
+/* Scheduler tasks, the task ID is also the priority (0 = highest) */
+#define TASK_SENSOR 0           /* Fingerprint sensor protocol and lock control */
+#define TASK_KEYPAD 1           /* Keypad scanning and name entry */
+#define TASK_CONSOLE 2          /* LPUART1 admin protocol */
+#define TASK_RTC 3              /* Clock display */
+#define TASK_LCD 4              /* LCD frame buffer renderer */
+#define TASK_LOG 5              /* Event log flash writer */
+
+/* Kernel threads, the thread ID is also the priority (0 = highest) */
+#define THREAD_LOCK 0           /* Lock actuator on GPIOD pin 1 */
+#define THREAD_UI 1             /* Cooperative scheduler running all the tasks, idle thread */
+#ifdef HOST_BUILD
+#define LOCK_STACK_WORDS 16384U        /* The host threads run the C library on these stacks */
+#define UI_STACK_WORDS 16384U
+#else
+#define LOCK_STACK_WORDS 128U
+#define UI_STACK_WORDS 512U
+#endif
+
+/* Lock thread events */
+#define LOCK_EVT_UNLOCK (1U << 0)       /* A search matched, open the door */
+#define LOCK_EVT_LOCK (1U << 1)         /* Close the door at once */
+
+/* Sensor task events */
+#define EVT_FP_MODE (1U << 0)           /* finger_mode changed, start the matching flow */
+#define EVT_FP_REPLY (1U << 1)          /* A valid reply was received, see fp_reply.h */
+#define EVT_FP_DELETE_ALL (1U << 2)     /* Empty the fingerprint library */
+#define EVT_FP_TOUCH (1U << 3)          /* The touch output of the sensor rose */
+
+/* Keypad task events */
+#define EVT_KEY_SCAN (1U << 0)          /* Scan the keypad */
+#define EVT_KEY_MULTITAP (1U << 1)      /* Multi-tap window of a character key elapsed */
+#define EVT_KEY_DONE (1U << 2)          /* "CREATED NAME" display time elapsed */
+
+/* Console, RTC and LCD task events */
+#define EVT_CONSOLE_RX (1U << 0)        /* Bytes are waiting in console_rx */
+#define EVT_CONSOLE_IDLE (1U << 1)      /* No console byte for CONSOLE_IDLE_MS */
+#define EVT_CONSOLE_EXPORT (1U << 2)    /* Send the next records of a log export */
+#define EVT_CONSOLE_USERS (1U << 3)     /* Send the next batch of a directory export */
+#define EVT_CONSOLE_TRACE (1U << 4)     /* Send the next records of a trace dump */
+#define EVT_RTC_SECOND (1U << 0)        /* The RTC seconds counter advanced */
+#define EVT_RTC_RELOCK (1U << 1)        /* Daily relock alarm */
+#define EVT_LCD_DIRTY (1U << 0)         /* The LCD frame buffer changed */
+#define EVT_LCD_INIT (1U << 1)          /* Time for the next LCD initialization command */
+#define EVT_LOG_WORK (1U << 0)          /* Records were staged or a flash command completed */
+#define EVT_LOG_FLUSH (1U << 1)         /* No event for LOG_FLUSH_MS, program the staged records */
+#define EVT_LOG_RETRY (1U << 2)         /* Try the waiting erase of the user database again */
+
+/* Timing of the flows, in milliseconds */
+#define FP_REPLY_TIMEOUT_MS 2000U
+#define FP_SEARCH_TIMEOUT_MS 5000U
+#define FP_HANDSHAKE_TIMEOUT_MS 200U    /* Reply timeout of the boot handshake */
+#define FP_HANDSHAKE_RETRY_MS 50U       /* The sensor ignores commands until it has booted */
+#define FP_POLL_INTERVAL_MS 250U
+#define FP_TOUCH_POLL_MS 1000U          /* Finger poll period when the touch line stays low */
+#define FP_TOUCH_PIN 3U                 /* PTC3, touch output of the sensor */
+#define RESULT_HOLD_MS 1000U
+#define LOCK_HOLD_MS 1000U
+#define KEY_SCAN_INTERVAL_MS 200U
+#define KEY_MULTITAP_MS 500U
+#define LOG_FLUSH_MS 30000U             /* Staged log records are kept in RAM at most this long */
+#define USERS_ERASE_WAIT_MS 500U        /* Poll of the sensor flow while a user database erase waits */
+#define USERS_ERASE_RETRY_MS 5000U      /* Back-off after a failed user database erase */
+#define USERS_ERASE_RETRIES 3U          /* Failed erases in a row before giving up until the next boot */
+
+#define CONSOLE_RX_SIZE 64U             /* Must be a power of two, holds a burst of an import batch */
+#define CONSOLE_IDLE_MS 100U            /* Clocks kept running after a console byte */
+#define CONSOLE_CMD_POWER 0U            /* Console byte that prints the idle statistics */
+#define CONSOLE_ADMIN_START 99U         /* Console byte that starts an admin frame */
+
+/* Admin frames: CONSOLE_ADMIN_START, CMD, LEN, LEN payload bytes, CSUM (sum of CMD to payload) */
+#define ADMIN_MAX_PAYLOAD 8U
+#define ADMIN_CMD_SET_TIME 0x01U        /* Payload: epoch seconds, 4 bytes big-endian */
+#define ADMIN_CMD_GET_TIME 0x02U        /* No payload, prints the date and time */
+#define ADMIN_CMD_SET_SCHEDULE 0x03U    /* Payload: user ID (2 bytes big-endian), schedule */
+#define ADMIN_CMD_EXPORT_LOG 0x04U      /* Payload: from and to epoch seconds, 4 bytes big-endian each */
+#define ADMIN_CMD_ENROLL 0x05U          /* Payload: user ID (2 bytes big-endian), 1 to fp_user_pages - 1 */
+#define ADMIN_CMD_EXPORT_USERS 0x06U    /* No payload, sends the user directory, see provision.h */
+#define ADMIN_CMD_IMPORT_USERS 0x07U    /* No payload, the console then receives a directory stream */
+#define ADMIN_CMD_PROFILE 0x08U         /* Payload: none, or 1 to clear the probe statistics after the dump */
+#define ADMIN_CMD_LATENCY 0x09U         /* No payload, prints the latency percentiles and the unlock latency */
+#define ADMIN_CMD_HEADROOM 0x0AU        /* Payload: none, or 1 to clear the interrupt statistics after the dump */
+#define ADMIN_CMD_TRACE 0x0BU           /* Payload: none, or 1 to clear the trace after the dump, see trace.h */
+
+/* Log export stream: EXPORT_RECORD frames, then one EXPORT_END frame, multi-byte fields big-endian */
+#define EXPORT_RECORD 'R'               /* Time (4 bytes), user ID (2), score (2), result (1) */
+#define EXPORT_END 'E'                  /* Number of records (2 bytes), status (EVENT_LOG_END / _BUSY) */
+#define EXPORT_BATCH 16U                /* Records sent per call of console_task */
+#define EXPORT_RETRY_MS 2U              /* Wait for a flash command before reading on */
+
+/* Directory import: status of the PROVISION_REPLY_DONE frame */
+#define IMPORT_IDLE_MS 2000U            /* Silence of the host that aborts an import */
+#define IMPORT_DONE_OK 0U               /* The end frame matches the batches applied */
+#define IMPORT_DONE_BAD 1U              /* The end frame does not match, a batch is missing */
+#define IMPORT_DONE_TIMEOUT 2U          /* The host went silent before the end frame */
+#define IMPORT_DONE_REJECTED 3U         /* A record has a user or schedule out of range */
+
+/* Access schedules of the application, besides ACCESS_SCHEDULE_ALWAYS and ACCESS_SCHEDULE_NEVER */
+#define SCHEDULE_WORK_HOURS 2U          /* Monday to Friday, 07:00 to 19:00 */
+
+/* Fingerprint ID of a successful search reply, FP_REPLY_NO_WORD if the reply is too short */
+#define FP_MATCH_ID() FpReply_Word(0U)
+#define FP_MATCH_SCORE() FpReply_Word(2U)
+
+/* Library size (number of template pages) of a system parameters reply */
+#define FP_LIBRARY_SIZE() FpReply_Word(4U)
+
+/* User matched by a search reply, through the hot tier map for a hot page */
+#define FP_MATCH_USER() fp_page_user(FP_MATCH_ID())
+
+/* Hot tier: the last HOTSET_SLOTS pages of a library of at least FP_HOT_MIN_LIBRARY pages */
+#define FP_HOT_MIN_LIBRARY (4U * HOTSET_SLOTS)
+#define FP_HOT_NOTEPAD_PAGE 0U          /* Notepad page of the hot tier map */
+#define FP_NOTEPAD_DATA() FpReply_Data(FP_NOTEPAD_SIZE)
+
+/* RTC alarm jobs, the job ID is the RTC alarm slot */
+#define RTC_JOB_RELOCK 0U               /* Forces the door locked once a day */
+#define RTC_JOB_COUNT 1U
+#define AUTO_RELOCK_HOUR 23U            /* Time of day of the daily relock */
+#define AUTO_RELOCK_MINUTE 0U
+
+/*!
+ * @brief  Sends a command to the fingerprint sensor and waits for its reply inside a flow.
+ *
+ * @detail The confirmation code is left in fp_response, FINGERPRINT_UNDEFINED_ERROR if the
+ *         sensor does not answer within timeout_ms, and the timeout is traced. The previous reply is invalidated first
+ *         so that a missing answer is never mistaken for an old one. VLPS is held off while
+ *         the reply is expected, since LPUART2 cannot receive without its clock.
+ */
+#define FP_COMMAND(pt, events, send, timeout_ms) \
+	do { FpReply_Invalidate(); Power_Hold(POWER_HOLD_SENSOR); fp_command_pending = 1; \
+	     PROBE_BEGIN(PROBE_FP_REPLY); send; \
+	     PT_WAIT_EVENT_TIMEOUT((pt), TASK_SENSOR, (events), EVT_FP_REPLY, (timeout_ms)); \
+	     Power_Release(POWER_HOLD_SENSOR); fp_command_pending = 0; \
+	     if (!((events) & EVT_FP_REPLY)) { Trace_Record(TRACE_FP_TIMEOUT, 0U, 0U); } \
+	     fp_response = ((events) & EVT_FP_REPLY) ? FpReply_Code() : FINGERPRINT_UNDEFINED_ERROR; \
+	} while(0)
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+/*!
+ * @brief  Flows run by the sensor task.
+ */
+typedef enum {
+	FP_FLOW_NONE = 0,
+	FP_FLOW_HANDSHAKE,
+	FP_FLOW_SEARCH,
+	FP_FLOW_ENROLL,
+	FP_FLOW_DELETE_ALL
+} fp_flow_t;
+
+/*!
+ * @brief  Receive state of an admin frame on the console.
+ */
+typedef enum {
+	ADMIN_IDLE = 0,           /* Outside a frame */
+	ADMIN_CMD,                /* Waiting for the command byte */
+	ADMIN_LEN,                /* Waiting for the payload length */
+	ADMIN_PAYLOAD,            /* Receiving the payload */
+	ADMIN_CSUM                /* Waiting for the checksum */
+} admin_state_t;
+
+/*!
+ * @brief  Work started by an RTC alarm: the event posted to a task when the alarm is due.
+ */
+typedef struct {
+	unsigned char task_id;
+	unsigned int event;
+} rtc_job_t;
+
+/*!
+ * @brief  Boot phases, timestamped by boot_mark().
+ */
+typedef enum {
+	BOOT_PHASE_CLOCK = 0,     /* Boot clock and 1 ms tick running */
+	BOOT_PHASE_DRIVERS,       /* Peripherals configured, low clock profile in use */
+	BOOT_PHASE_KERNEL,        /* Threads running */
+	BOOT_PHASE_LCD,           /* LCD initialized */
+	BOOT_PHASE_SENSOR,        /* Fingerprint sensor answered */
+	BOOT_PHASE_FIRST_SCAN,    /* First finger scan started, the door is usable */
+	BOOT_PHASE_COUNT
+} boot_phase_t;
 
 /*==================================================================================================
 *                                    FUNCTION PROTOTYPES
@@ -43,6 +245,7 @@ void config_PTC1();
 void config_PTC2();
 void config_PTC16();
 void config_PTC15();
+void config_PTC3();
 void configD1();
 void init_systick();
 unsigned char check_but();
@@ -58,9 +261,28 @@ void init_pcc();
 void init_pinout();
 void init_lpuart();
 void init_flash();
+void init_access();
+void init_event_log();
+void init_tasks();
 void display_time();
-void import_finger_print();
-void search_finger_print();
+void sensor_task(unsigned int events);
+void keypad_task(unsigned int events);
+void console_task(unsigned int events);
+void rtc_task(unsigned int events);
+void lcd_task(unsigned int events);
+void log_task(unsigned int events);
+void init_threads();
+void lock_thread(void *arg);
+void ui_thread(void *arg);
+static void boot_mark(boot_phase_t phase);
+static void report_boot();
+static void rtc_jobs_start();
+static unsigned char access_now(unsigned int user_id);
+static unsigned int fp_page_user(unsigned int page);
+static void log_event(unsigned char result, unsigned int user_id, unsigned int score);
+static unsigned char users_may_erase(void);
+static void set_finger_mode(unsigned char mode);
+static unsigned char assign_schedule(unsigned int user_id, unsigned char schedule);
 
 /*==================================================================================================
 *                                       STATIC VARIABLES
@@ -68,190 +290,392 @@ void search_finger_print();
 static unsigned char MODE = 0;
 static unsigned char button_press_count = 0;
 static unsigned char cursor_position = 0;
-static char name_user[MAX_NUM_USER][MAX_NAME_LENGTH];
+static char name_edit[MAX_NAME_LENGTH];  // Name being entered, saved when it is finalized
 static unsigned char finger_mode = SEARCH_FINGERPRINT_MODE;
-static unsigned char IDStore = 0;
-static unsigned char data_ack[16] = {0};  // Buffer to store acknowledged data
-static unsigned char data_ack_index = 0;  // Index to keep track of data_ack position
-static unsigned int second = 0;
-static unsigned int minute = 0;
-static unsigned int hour = 0;
-static unsigned int totalSeconds;
-static unsigned int totalMinutes;
-static unsigned int totalHours;
-static unsigned char base_second = 0;
-static unsigned char base_minute = 31;
-static unsigned char base_hour = 15;
+static unsigned short IDStore = 0;  // Fingerprint ID being enrolled, 0 when none
+static fp_flow_t fp_flow = FP_FLOW_NONE;  // Flow run by the sensor task
+static pt_t fp_pt;                        // Resume point of the running flow
+static pt_t fp_wait_pt;                   // Resume point of the finger wait of the running flow
+static unsigned char fp_response = FINGERPRINT_UNDEFINED_ERROR;  // Confirmation code of the last command
+static volatile unsigned char fp_search_pending = 0;  // The next sensor reply answers a search command
+static unsigned char fp_command_pending = 0;          // A sensor command waits for its reply
+static unsigned int fp_user_pages = MAX_NUM_USER;     // Library pages that can hold a user
+static unsigned int fp_hot_base = 0xFFFFU;            // First hot page, none before the handshake
+static unsigned char fp_hot_enabled = 0;              // The library is large enough for a hot tier
+static pt_t fp_hot_pt;                    // Resume point of the hot tier move of the search flow
+static unsigned int hot_slot;             // Move in progress: slot and user
+static unsigned int hot_user;
+static unsigned char hot_map[HOTSET_MAP_SIZE];
+static volatile unsigned int fp_touch_ms;             // SysTick time of the last touch line edge
+static volatile unsigned int fp_reply_ms;             // SysTick time of the last complete sensor reply
+static unsigned int fp_wait_ms;                       // Start of the wait for a finger
+static unsigned int fp_image_sent_ms;                 // Last GetImage of the wait
+static unsigned int latency_marks[LATENCY_MARKS];     // Times of the identification in progress
+static kernel_flags_t lock_flags;                     // Events of the lock thread
+static volatile unsigned int lock_signal_cycles = 0;  // DWT cycle count when the unlock was signalled
+static unsigned int lock_latency_cycles = 0;          // Cycles from the sensor reply to the lock output
+static unsigned int lock_latency_max = 0;
+static volatile unsigned int lock_unlock_ms;          // SysTick time of the last lock output low
+static volatile unsigned char lock_open = 0;          // The lock output is low
+static unsigned char users_erase_failures = 0;        // Failed user database erases in a row
+static unsigned char users_erase_backoff = 0;         // A failed erase waits for EVT_LOG_RETRY
+static unsigned int lock_thread_stack[LOCK_STACK_WORDS];
+static unsigned int ui_thread_stack[UI_STACK_WORDS];
+static unsigned char pending_key = 0;     // Character key waiting for its multi-tap window
+static unsigned char console_rx[CONSOLE_RX_SIZE];
+static volatile unsigned char console_rx_head = 0;  // Written by LPUART1_RxTx_IRQHandler
+static volatile unsigned char console_rx_tail = 0;  // Written by console_task
+static unsigned char fp_ready = 0;        // The sensor answered the boot handshake
+static unsigned char lcd_ready = 0;       // The LCD initialization sequence is complete
+static unsigned int boot_time_ms[BOOT_PHASE_COUNT];  // Tick of each boot phase
+static unsigned int boot_done_mask = 0;              // Boot phases already reached
+static admin_state_t admin_state = ADMIN_IDLE;
+static unsigned char admin_cmd;
+static unsigned char admin_len;
+static unsigned char admin_count;         // Payload bytes received
+static unsigned char admin_sum;           // Running checksum of the frame
+static unsigned char admin_payload[ADMIN_MAX_PAYLOAD];
+static unsigned char export_active = 0;   // A log export is being sent
+static event_log_cursor_t export_cursor;
+static unsigned int export_from;
+static unsigned int export_to;
+static unsigned char export_ordered;      // The records are read in time order, see EventLog_Seek()
+static unsigned short export_count;       // Records sent by the export
+static unsigned char users_export_active = 0;   // A directory export is being sent
+static unsigned short users_export_id;    // Next user to look at
+static unsigned char import_active = 0;   // The console bytes go to the directory import
+static unsigned char trace_dump_active = 0;   // A trace dump is being sent, the ring is frozen
+static unsigned char trace_dump_clear;        // Clear the trace once the dump is sent
+static unsigned int trace_dump_index;         // Next record of the dump
+
+/*!
+ * @brief  RTC alarm jobs, indexed by the RTC alarm slot.
+ *
+ * @detail The user database compaction and the erase of the next event log sector are not
+ *         jobs: log_task() runs them as soon as a write leaves work for them (EVT_LOG_WORK),
+ *         the user database erase once the sensor and the lock are idle, so an erased sector
+ *         is ready before the next write rather than once a day.
+ */
+static const rtc_job_t rtc_jobs[RTC_JOB_COUNT] = {
+	{TASK_RTC, EVT_RTC_RELOCK},   /* RTC_JOB_RELOCK */
+};
+
+/*!
+ * @brief  Access windows of SCHEDULE_WORK_HOURS.
+ */
+static const access_window_t work_hours_windows[] = {
+	{ACCESS_WEEKDAYS, 7, 19},
+};
+
+/*!
+ * @brief  Keypad character maps.
+ *
+ * @detail Indexed by the key position returned by get_key() (1-16). A 0 entry means that the
+ *         key has another function in that mode. Character keys yield the first character on a
+ *         short press and the second one when the key is still held after KEY_MULTITAP_MS.
+ */
+static const char keytap_number_map[17] = {
+	0, '1', '2', '3', 0, '4', '5', '6', ' ', '7', '8', '9', 0, 0, '0', 0, 0
+};
+static const char keytap_character_map[17][2] = {
+	{0, 0}, {'A', 'B'}, {'C', 'D'}, {'E', 'G'}, {0, 0}, {'H', 'I'}, {'K', 'L'}, {'M', 'N'},
+	{' ', ' '}, {'O', 'P'}, {'Q', 'R'}, {'S', 'T'}, {0, 0}, {'U', 'V'}, {'X', 'Y'}, {0, 0}, {0, 0}
+};
 
 /*==================================================================================================
 *                                       MAIN FUNCTION
 ==================================================================================================*/
 int main(){
+	Stack_PaintMain();
+	Trace_Init();
+	Sched_Init();
+	Kernel_Init();
+	Kernel_FlagsInit(&lock_flags);
 	init_clock();
+	init_systick();
+	boot_mark(BOOT_PHASE_CLOCK);
+	PROBE_INIT();
+	Latency_Init();
+	Power_Init();
 	init_pcc();
 	init_pinout();
 	init_lpuart();
-	init_systick();
 	init_LPI2C0();
 	RTC_init();
-	init_nvic();	
-	lcd_init();
-	lcd_clear();
-	lcd_put_cur(0, 0);
+	rtc_jobs_start();
+	init_nvic();
+	lcd_fb_init();
 	init_flash();
-	while(1){
-		if(finger_mode == IMPORT_FINGERPRINT_MODE){
-			import_finger_print();
-		}
-		else if(finger_mode == SEARCH_FINGERPRINT_MODE){
-			search_finger_print();
-		}
-		else if (finger_mode == CREATE_NEW_USER_NAME_MODE){
-			handle_keytap();
-			delay(200, CORE_CLOCK);
-		}
-	}
+	init_access();
+	HotSet_Init();
+	init_event_log();
+	Clock_PolicyInit();
+	boot_mark(BOOT_PHASE_DRIVERS);
+	init_tasks();
+	init_threads();
+	Kernel_Start();
 }
 
 /*==================================================================================================
 *                                       GLOBAL FUNCTIONS
 ==================================================================================================*/
+/*!
+ * @brief     Handles the SysTick exception.
+ *
+ * @detail    Advances the millisecond tick, the scheduler software timers and the kernel
+ *            timeouts.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void SysTick_Handler(void){
+	ISR_STATS_ENTER(ISR_SYSTICK);
+	SysTick_IncTick();
+	Sched_Tick();
+	Kernel_Tick();
+	ISR_STATS_EXIT(ISR_SYSTICK);
+}
+
 /*!
  * @brief     Handles the LPUART2 receive and transmit interrupt.
  *
- * @detail    This interrupt service routine reads incoming data from the LPUART2,
- *            stores it in a buffer, and checks for a specific header sequence. If
- *            the header sequence is detected, it resets the data_ack buffer and index.
- *            Incoming data is also stored in the data_ack buffer if space allows.
- *            The buffer index wraps around when it exceeds the buffer size.
+ * @detail    This interrupt service routine passes each byte received from the fingerprint
+ *            sensor to the reply parser (see fp_reply.h) and notifies the sensor task when
+ *            the byte completes a valid reply; line noise and damaged frames are dropped by
+ *            the parser. A successful reply to a search command also signals the lock thread
+ *            directly, so that the door opens without waiting for the tasks of the
+ *            cooperative scheduler, provided that the access schedule of the matched user
+ *            allows the current hour.
  *
  * @param[in]  None
  * @return     void
  */
 void LPUART2_RxTx_IRQHandler(void) {
-	static unsigned char buffer[20] = {0};  /* Buffer to store incoming data */
-	static unsigned char buffer_index = 0;  /* Index to keep track of buffer position */
-	static const unsigned char header[6] = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF};
-
+	ISR_STATS_ENTER(ISR_LPUART2);
 	if (LPUART2->STAT.RDRF) {
-		unsigned char incomingByte = LPUART2->DATA_REGISTER;
-		buffer[buffer_index] = incomingByte;  /* Store incoming byte in buffer */
-		/* Check if buffer has at least 6 bytes for comparison */
-		if (buffer_index >= 5) {
-				/* Check if the last six bytes match the header */
-				if (memcmp(&buffer[buffer_index - 5], header, 6) == 0) {
-						/* Reset data_ack and data_ack_index for new data */
-						memset(data_ack, 0, sizeof(data_ack));
-						data_ack_index = 0;
+		if (FpReply_Feed((unsigned char)LPUART2->DATA_REGISTER)) {
+			if (fp_search_pending) {
+				fp_search_pending = 0;
+				if ((FpReply_Code() == FINGERPRINT_OK) && access_now(FP_MATCH_USER())) {
+					lock_signal_cycles = DWT->CYCCNT;
+					Kernel_FlagsSet(&lock_flags, LOCK_EVT_UNLOCK);
 				}
-		}
-		/* Store incoming byte in data_ack if index is within limit */
-		if (data_ack_index < sizeof(data_ack)) {
-				data_ack[data_ack_index] = incomingByte;
-				data_ack_index++;
-		}
-		buffer_index++;  /* Increment buffer index */
-		/* Wrap around if buffer_index exceeds the size of the buffer */
-		if (buffer_index >= sizeof(buffer)) {
-				buffer_index = 0;
+			}
+			fp_reply_ms = SysTick_GetTick();
+			Trace_Record(TRACE_FP_REPLY, FpReply_Code(), (unsigned short)FpReply_Word(0U));
+			PROBE_END(PROBE_FP_REPLY);
+			Sched_PostEvent(TASK_SENSOR, EVT_FP_REPLY);
 		}
 	}
+	ISR_STATS_EXIT(ISR_LPUART2);
 }
 
 /*!
  * @brief     Handles the LPUART1 receive and transmit interrupt.
  *
- * @detail    This interrupt service routine reads the received byte from the LPUART1
- *            and updates the IDStore variable. Based on the value of the received byte,
- *            it sets the `finger_mode` to either `IMPORT_FINGERPRINT_MODE` or
- *            `SEARCH_FINGERPRINT_MODE`. If the received byte is less than 99, it sets
- *            the mode to import fingerprints; if greater than 99, it sets the mode to
- *            search for fingerprints.
+ * @detail    This interrupt service routine reads the received byte from the LPUART1,
+ *            queues it in the console receive buffer and notifies the console task,
+ *            which interprets it. A byte that arrives while the buffer is full is dropped.
  *
  * @param[in]  None
  * @return     void
  */
 void LPUART1_RxTx_IRQHandler(void){
+	ISR_STATS_ENTER(ISR_LPUART1);
 	if (LPUART1->STAT.RDRF) {
 			unsigned char received = LPUART1->DATA_REGISTER;
-			IDStore = received;
-		if(received < 99){
-			finger_mode = IMPORT_FINGERPRINT_MODE;
-		}else if (received > 99){
-			finger_mode = SEARCH_FINGERPRINT_MODE;
+			unsigned char next = (console_rx_head + 1) & (CONSOLE_RX_SIZE - 1);
+		if (next != console_rx_tail) {
+			console_rx[console_rx_head] = received;
+			console_rx_head = next;
 		}
+		Sched_PostEvent(TASK_CONSOLE, EVT_CONSOLE_RX);
 	}
+	ISR_STATS_EXIT(ISR_LPUART1);
 }
 
 /*!
  * @brief     Handles the RTC seconds interrupt.
  *
- * @detail    This interrupt service routine calculates the total elapsed time in seconds
- *            since the base time, which is stored in `base_hour`, `base_minute`, and
- *            `base_second`. It updates the `second`, `minute`, and `hour` variables based
- *            on the total elapsed time. If the `hour` value equals 24, it resets the RTC
- *            timestamp register (TSR) to 0.
+ * @detail    This interrupt service routine advances the calendar by one second, carrying
+ *            into the minutes, hours and date only when a field wraps, and notifies the RTC
+ *            display task.
  *
  * @param[in]  None
  * @return     void
  */
 void RTC_Seconds_IRQHandler()
 {
-	totalSeconds = base_hour * 3600 + base_minute * 60 + base_second + RTC->TSR;
-	second = totalSeconds % 60;
-	totalMinutes = totalSeconds / 60;
-	minute = totalMinutes % 60;
-	totalHours = totalMinutes / 60;
-	hour = totalHours % 24;
-	if (hour == 24)
-	{
-		RTC->TSR = 0;
+	ISR_STATS_ENTER(ISR_RTC_SECONDS);
+	RTC_Tick();
+	Sched_PostEvent(TASK_RTC, EVT_RTC_SECOND);
+	ISR_STATS_EXIT(ISR_RTC_SECONDS);
+}
+
+/*!
+ * @brief     Handles the RTC alarm interrupt.
+ *
+ * @detail    Posts the event of every RTC job whose alarm is due to its task. The alarm also
+ *            wakes the board from VLPS, so the jobs need no polling.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void RTC_IRQHandler(void)
+{
+	unsigned int due;
+	unsigned char job;
+
+	ISR_STATS_ENTER(ISR_RTC);
+	due = RTC_AlarmService();
+	for (job = 0; job < RTC_JOB_COUNT; job++) {
+		if (due & (1U << job)) {
+			Sched_PostEvent(rtc_jobs[job].task_id, rtc_jobs[job].event);
+		}
+	}
+	ISR_STATS_EXIT(ISR_RTC);
+}
+
+/*!
+ * @brief     Handles the FTFC command complete interrupt.
+ *
+ * @detail    The interrupt is only enabled while an event log flash command runs; it is
+ *            disabled again since CCIF stays set, and the log task is notified.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void FTFC_IRQHandler(void)
+{
+	ISR_STATS_ENTER(ISR_FTFC);
+	Flash_DisableDoneIrq();
+	Sched_PostEvent(TASK_LOG, EVT_LOG_WORK);
+	ISR_STATS_EXIT(ISR_FTFC);
+}
+
+/*!
+ * @brief     Handles the PORTC pin interrupt.
+ *
+ * @detail    A rising edge on the sensor touch line means that a finger was placed on the
+ *            sensor: the sensor task is notified so that it captures the image at once. The
+ *            interrupt also wakes the board from VLPS.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void PORTC_IRQHandler(void){
+	unsigned int flags;
+
+	ISR_STATS_ENTER(ISR_PORTC);
+	flags = PORTC->ISFR;
+	PORTC->ISFR = flags;
+	if (flags & (1U << FP_TOUCH_PIN)) {
+		fp_touch_ms = SysTick_GetTick();
+		Sched_PostEvent(TASK_SENSOR, EVT_FP_TOUCH);
 	}
+	ISR_STATS_EXIT(ISR_PORTC);
+}
+
+/*!
+ * @brief     Handles the LPTMR0 interrupt.
+ *
+ * @detail    LPTMR0 is the wake-up timer of the VLPS idle; the time slept has already been
+ *            accounted for by Power_Idle(), so the interrupt is only acknowledged.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void LPTMR0_IRQHandler(void){
+	ISR_STATS_ENTER(ISR_LPTMR0);
+	Power_ClearWakeTimer();
+	ISR_STATS_EXIT(ISR_LPTMR0);
 }
 
 /*!
  * @brief     Displays the current time on the LCD.
  *
  * @detail    This function formats the current time into a string in the format "HH:MM:SS",
- *            where HH is hours, MM is minutes, and SS is seconds. It then clears the LCD display
- *            and prints the formatted time string at a specific position on the LCD.
+ *            where HH is hours, MM is minutes, and SS is seconds, writes it at the right end
+ *            of the second LCD row in the frame buffer and requests an LCD refresh. Nothing
+ *            is done when the time did not change since it was last displayed; "--:--:--"
+ *            is shown until the time has been set.
  *
  * @param[in]  None
  * @return     void
  */
 void display_time(){
 	char time_str[9];
-  snprintf(time_str, sizeof(time_str), "%02d:%02d:%02d", hour, minute, second);
-  lcd_clear_rtc();
-  lcd_put_cur(1, 8);
-  lcd_send_string(time_str);
+	rtc_time_t now;
+	PROBE_BEGIN(PROBE_DISPLAY_TIME);
+	if (!RTC_GetTime(&now)) {
+		PROBE_END(PROBE_DISPLAY_TIME);
+		return;
+	}
+	if (RTC_IsTimeValid()) {
+		snprintf(time_str, sizeof(time_str), "%02u:%02u:%02u",
+				now.hour % 24U, now.minute % 60U, now.second % 60U);
+	} else {
+		snprintf(time_str, sizeof(time_str), "--:--:--");
+	}
+  lcd_fb_write(1, 8, time_str);
+  Sched_PostEvent(TASK_LCD, EVT_LCD_DIRTY);
+  PROBE_END(PROBE_DISPLAY_TIME);
+}
+
+/*!
+ * @brief     Shows a message on the first LCD row.
+ *
+ * @detail    The message replaces the whole first row of the frame buffer and an LCD
+ *            refresh is requested.
+ *
+ * @param[in]  message The message to show, at most 16 characters are displayed.
+ * @return     void
+ */
+static void show_message(const char *message){
+	lcd_fb_write_field(0, 0, message, LCD_COLS);
+	Sched_PostEvent(TASK_LCD, EVT_LCD_DIRTY);
+}
+
+/*!
+ * @brief     Shows the name being entered on the first LCD row.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void show_name(){
+	lcd_fb_write_field(0, 0, name_edit, MAX_NAME_LENGTH);
+	Sched_PostEvent(TASK_LCD, EVT_LCD_DIRTY);
 }
 
 /*!
  * @brief     Initializes the system clock settings.
  *
- * @detail    This function configures the system clock by initializing the system oscillator
- *            to 8 MHz, setting up the SPLL (System Phase-Locked Loop) to 160 MHz using the
- *            8 MHz oscillator, and setting the clocks to 80 MHz for the system and core,
- *            40 MHz for the bus, and 20 MHz for the flash. It also sets the FIRCDIV (Fixed
- *            Internal Reference Clock Divider) to a division factor of 2.
+ * @detail    The core keeps running from the FIRC (48 MHz), the reset clock, so that the
+ *            boot never waits for an oscillator. This function enables the 8 MHz SIRC
+ *            asynchronous outputs, starts the 8 MHz system oscillator, which stabilizes in the
+ *            background, and configures the SPLL (System Phase-Locked Loop) for 160 MHz without
+ *            enabling it; the clock policy starts it when the 80 MHz profile is requested. It
+ *            also sets the FIRCDIV (Fixed Internal Reference Clock Divider) to a division
+ *            factor of 2.
  *
  * @param[in]  None
  * @return     void
  */
 void init_clock(){
-	SOSC_init_8MHz();
-	SPLL_init_160MHz();
-	NormalRUNmode_80MHz();
+	SIRC_init_8MHz();
+	SOSC_start_8MHz();
+	SPLL_config_160MHz();
 	SCG->FIRCDIV_bits.FIRCDIV_FIRCDIV2 = (1U);
+	Clock_Invalidate();
 }
 
 /*!
  * @brief     Initializes the Nested Vectored Interrupt Controller (NVIC).
  *
- * @detail    This function enables interrupts for LPUART1, LPUART2, and RTC seconds.
- *            It sets up the NVIC to handle these interrupts, allowing the respective
- *            interrupt service routines to be triggered when the associated events occur.
+ * @detail    This function enables interrupts for LPUART1, LPUART2, RTC seconds, the PORTC
+ *            pins and LPTMR0. It sets up the NVIC to handle these interrupts, allowing the
+ *            respective interrupt service routines to be triggered when the associated events
+ *            occur. Each of them also wakes the board from VLPS.
  *
  * @param[in]  None
  * @return     void
@@ -260,6 +684,10 @@ void init_nvic(){
 	NVIC_EnableIRQ(IRQ_LPUART1_RXTX);
 	NVIC_EnableIRQ(IRQ_LPUART2_RXTX);
 	NVIC_EnableIRQ(IRQ_RTC_SECONDS);
+	NVIC_EnableIRQ(IRQ_RTC);
+	NVIC_EnableIRQ(IRQ_FTFC);
+	NVIC_EnableIRQ(IRQ_PORTC);
+	NVIC_EnableIRQ(IRQ_LPTMR0);
 }
 
 /*!
@@ -267,7 +695,7 @@ void init_nvic(){
  *
  * @detail    This function configures and enables the clocks for various peripherals.
  *            It enables the clocks for PORTC, PORTA, and PORTD, sets the clock source
- *            for LPUART1 and LPUART2 to SPLL at 80 MHz, and for LPI2C0 to SIRC divided by 2.
+ *            for LPUART1, LPUART2 and LPI2C0 to SIRC divided by 2 (the low clock profile).
  *            It also enables the clock for the RTC peripheral.
  *
  * @param[in]  None
@@ -277,14 +705,14 @@ void init_pcc(){
 	PCC_EnableClock(&PCC->PCC_PORTC);
 	PCC_EnableClock(&PCC->PCC_PORTA);
 	PCC_EnableClock(&PCC->PCC_PORTD);
-	
-	PCC_SetClockSource(&PCC->PCC_LPUART1, 6); /*SPLL 80MHz*/
+
+	PCC_SetClockSource(&PCC->PCC_LPUART1, 2); /*SIRC_DIV2*/
 	PCC_EnableClock(&PCC->PCC_LPUART1);
-	PCC_SetClockSource(&PCC->PCC_LPUART2, 6); /*SPLL 80MHz*/
+	PCC_SetClockSource(&PCC->PCC_LPUART2, 2); /*SIRC_DIV2*/
 	PCC_EnableClock(&PCC->PCC_LPUART2);
 	PCC_SetClockSource(&PCC->PCC_LPI2C0, 2); /*SIRC_DIV2*/
 	PCC_EnableClock(&PCC->PCC_LPI2C0);
-	
+
 	PCC_EnableClock(&PCC->PCC_RTC);
 }
 
@@ -293,8 +721,9 @@ void init_pcc(){
  *
  * @detail    This function initializes the pin configurations for multiple GPIO pins
  *            by calling specific configuration functions for each pin. The pin configuration
- *            functions configure pins C6, C7, A2, A3, D6, D7, D15, and several pins on PORTC 
- *            and PORTD, setting up their respective modes and functionalities.
+ *            functions configure pins C6, C7, A2, A3, D6, D7, D15, and several pins on PORTC
+ *            and PORTD, setting up their respective modes and functionalities. PTC3 receives
+ *            the touch output of the fingerprint sensor.
  *
  * @param[in]  None
  * @return     void
@@ -315,6 +744,7 @@ void init_pinout(){
 	config_PTC2();
 	config_PTC16();
 	config_PTC15();
+	config_PTC3();
 	configD1();
 }
 
@@ -329,62 +759,299 @@ void init_pinout(){
  * @param[in]  None
  * @return     void
  */
-void init_lpuart(){	
+void init_lpuart(){
 	LPUART_config_baud57600(LPUART1);
 	LPUART1->CTRL.RIE = 1;
 	/*Enable transmitter and receiver*/
 	LPUART1->CTRL.TE = 1;		/*Enable transmitter*/
 	LPUART1->CTRL.RE = 1;		/*Enable receiver*/
-	
+
 	LPUART_config_baud57600(LPUART2);
-	LPUART2->CTRL.RIE = 1;	
+	LPUART2->CTRL.RIE = 1;
 	/*Enable transmitter and receiver*/
 	LPUART2->CTRL.TE = 1;		/*Enable transmitter*/
 	LPUART2->CTRL.RE = 1;		/*Enable receiver*/
 }
 
 /*!
- * @brief     Initializes the user name data in flash memory.
+ * @brief     Initializes the access schedules.
+ *
+ * @detail    Restores the schedule saved for each user, see init_flash(); a user who has none
+ *            may not enter until an enrollment or an admin frame gives them one.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void init_access(){
+	unsigned int user_id;
+
+	Access_Init();
+	Access_DefineSchedule(SCHEDULE_WORK_HOURS, work_hours_windows,
+			sizeof(work_hours_windows) / sizeof(work_hours_windows[0]));
+	for (user_id = 0; user_id < ACCESS_MAX_USERS; user_id++) {
+		(void)Access_AssignUser(user_id, Users_GetSchedule(user_id));  /* USERS_NO_SCHEDULE is refused */
+	}
+}
+
+/*!
+ * @brief     Gives a schedule to a user and saves it.
+ *
+ * @detail    The schedule is saved in the EEPROM emulation, about 100 us when it changes. If
+ *            it cannot be saved, it holds until the next reset.
+ *
+ * @param[in]  user_id Fingerprint ID of the user.
+ * @param[in]  schedule Schedule of the user.
+ * @return     ACCESS_OK, or ACCESS_INVALID if an argument is out of range.
+ */
+static unsigned char assign_schedule(unsigned int user_id, unsigned char schedule){
+	if (Access_AssignUser(user_id, schedule) != ACCESS_OK) {
+		return ACCESS_INVALID;
+	}
+	(void)Users_SetSchedule(user_id, schedule);
+	return ACCESS_OK;
+}
+
+/*!
+ * @brief     Tells whether a user may enter now.
+ *
+ * @detail    Called from the LPUART2 interrupt on the unlock path: two loads and a bit test.
+ *            While the time is not set, only users who may always enter are let in.
+ *
+ * @param[in]  user_id Fingerprint ID of the user.
+ * @return     1 if the door may open, 0 otherwise.
+ */
+static unsigned char access_now(unsigned int user_id){
+	return Access_IsAllowed(user_id, RTC_IsTimeValid() ? RTC_GetHourOfWeek() : ACCESS_HOUR_UNKNOWN);
+}
+
+/*!
+ * @brief     Gives the user whose template a library page holds.
+ *
+ * @detail    Called from the LPUART2 interrupt on the unlock path. A hot page holds a copy of
+ *            the template of the user named by the hot tier map, any other page the template
+ *            of the user with its number.
+ *
+ * @param[in]  page Page of a search reply.
+ * @return     Fingerprint ID, HOTSET_NO_USER for a hot page the map does not name.
+ */
+static unsigned int fp_page_user(unsigned int page){
+	return (page >= fp_hot_base) ? HotSet_GetUser(page - fp_hot_base) : page;
+}
+
+/*!
+ * @brief     Recovers the event log.
+ *
+ * @detail    The sector erase the log may need is started by the log task, not here.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void init_event_log(){
+	EventLog_Init();
+	Sched_PostEvent(TASK_LOG, EVT_LOG_WORK);
+}
+
+/*!
+ * @brief     Records a door event in the event log.
+ *
+ * @detail    Only stages the record; the log task programs it.
+ *
+ * @param[in]  result EVENT_LOG_GRANTED, ...
+ * @param[in]  user_id Fingerprint ID, 0 when there is no match.
+ * @param[in]  score Match score.
+ * @return     void
+ */
+static void log_event(unsigned char result, unsigned int user_id, unsigned int score){
+	EventLog_Append(RTC_GetEpoch(), (unsigned short)user_id, (unsigned short)score, result);
+	Sched_PostEvent(TASK_LOG, EVT_LOG_WORK);
+	Sched_StartTimer(TASK_LOG, EVT_LOG_FLUSH, LOG_FLUSH_MS);
+}
+
+/*!
+ * @brief     Tells whether the user database may erase a flash sector now.
+ *
+ * @detail    An erase masks the interrupts for milliseconds: it waits until no sensor reply is
+ *            expected and the door is closed, so that neither a reply on LPUART2 nor the lock
+ *            thread is held up, and is given up after USERS_ERASE_RETRIES failures in a row.
+ *
+ * @return     1 if the erase may run, 0 otherwise.
+ */
+static unsigned char users_may_erase(void){
+	return (!fp_command_pending && !fp_search_pending && !lock_open && !users_erase_backoff &&
+			(users_erase_failures < USERS_ERASE_RETRIES)) ? 1U : 0U;
+}
+
+/*!
+ * @brief     Switches the sensor flow mode and traces the switch.
  *
- * @detail    This function sets predefined names for users in the `name_user` array. It
- *            assigns specific characters to each element in the array, effectively
- *            initializing user names for the second, third, and fourth users. 
+ * @param[in]  mode SEARCH_FINGERPRINT_MODE, ...
+ * @return     void
+ */
+static void set_finger_mode(unsigned char mode){
+	Trace_Record(TRACE_FINGER_MODE, mode, finger_mode);
+	finger_mode = mode;
+}
+
+/*!
+ * @brief     Initializes the flash driver and the user names and schedules stored in flash
+ *            memory.
+ *
+ * @detail    The names are kept in the user database in program flash, whose index is
+ *            rebuilt here and whose compaction runs in the log task. The schedules are kept in
+ *            the EEPROM emulation, which the first boot of a device partitions; a device on
+ *            which this fails cannot keep the schedules across a reset, which is reported on
+ *            LPUART1.
  *
  * @param[in]  None
  * @return     void
  */
 void init_flash(){
-	name_user[1][0] = 'M';
-	name_user[1][1] = 'E';
-	name_user[1][2] = 'N';
-	
-	name_user[2][0] = 'T';
-	name_user[2][1] = 'H';
-	name_user[2][2] = 'I';
-	name_user[2][3] = 'N';
-	name_user[2][4] = 'H';
-	
-	name_user[3][0] = 'V';
-	name_user[3][1] = 'U';
+	Flash_Init();
+	if (Users_Init() != USERS_OK) {
+		LPUART_send_string(LPUART1, (unsigned char*)"Schedules not kept across resets");
+		LPUART_send_byte(LPUART1, 0x0A);
+	}
 }
 
 /*!
  * @brief     Initializes the SysTick timer with the specified configuration.
  *
- * @detail    This function sets up the SysTick timer using a configuration structure. It
- *            specifies the clock source and interrupt mode for the SysTick timer. The
- *            `SysTick_Init` function is called with the provided configuration to apply
- *            the settings.
+ * @detail    This function starts the SysTick timer as the 1 ms system tick that drives
+ *            the scheduler software timers and `delay`.
  *
  * @param[in]  None
  * @return     void
  */
 void init_systick(){
-	systick_config_t config = {
-			.clk_source = 1,
-			.interrupt_mode = 0,
-	};
-	SysTick_Init(config);
+	SysTick_StartTick();
+}
+
+/*!
+ * @brief     Registers the application tasks with the scheduler.
+ *
+ * @detail    The sensor task gets the highest priority so that the lock reacts first,
+ *            the LCD renderer next to last so that it flushes once all other tasks have
+ *            updated the frame buffer, and the event log writer last. The sensor task starts
+ *            with the sensor handshake and the LCD task with the LCD initialization, which run
+ *            side by side.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void init_tasks(){
+	Sched_AddTask(TASK_SENSOR, sensor_task);
+	Sched_AddTask(TASK_KEYPAD, keypad_task);
+	Sched_AddTask(TASK_CONSOLE, console_task);
+	Sched_AddTask(TASK_RTC, rtc_task);
+	Sched_AddTask(TASK_LCD, lcd_task);
+	Sched_AddTask(TASK_LOG, log_task);
+	Sched_PostEvent(TASK_SENSOR, EVT_FP_MODE);
+	Sched_StartTimer(TASK_LCD, EVT_LCD_INIT, lcd_init_start());
+}
+
+/*!
+ * @brief     Creates the kernel threads.
+ *
+ * @detail    The lock thread preempts the UI thread as soon as it is signalled. The UI thread
+ *            runs the cooperative scheduler with all the tasks; it never blocks on a kernel
+ *            object and is therefore the idle thread of the kernel.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void init_threads(){
+	Kernel_ThreadCreate(THREAD_LOCK, lock_thread, 0, lock_thread_stack, LOCK_STACK_WORDS);
+	Kernel_ThreadCreate(THREAD_UI, ui_thread, 0, ui_thread_stack, UI_STACK_WORDS);
+}
+
+/*!
+ * @brief     Lock thread: drives the lock actuator on GPIOD pin 1.
+ *
+ * @detail    The door is locked (pin set) by default. LOCK_EVT_UNLOCK opens it for
+ *            LOCK_HOLD_MS, restarted by every new unlock; LOCK_EVT_LOCK closes it at once.
+ *            The time from the unlock signal to the pin write is measured with the DWT
+ *            cycle counter. Every opening and closing is traced.
+ *
+ * @param[in]  arg Unused.
+ * @return     This function never returns.
+ */
+void lock_thread(void *arg){
+	unsigned int events;
+	unsigned int latency;
+	(void)arg;
+
+	GPIO_SetOutputPin(GPIOD, 1);
+	while(1){
+		events = Kernel_FlagsWait(&lock_flags, LOCK_EVT_UNLOCK | LOCK_EVT_LOCK, KERNEL_WAIT_FOREVER);
+		if(!(events & LOCK_EVT_UNLOCK)){
+			continue;                       /* Already closed */
+		}
+		while(events & LOCK_EVT_UNLOCK){
+			GPIO_ResetOutputPin(GPIOD, 1);
+			lock_open = 1;
+			lock_unlock_ms = SysTick_GetTick();
+			latency = DWT->CYCCNT - lock_signal_cycles;
+			lock_latency_cycles = latency;
+			if(latency > lock_latency_max){
+				lock_latency_max = latency;
+			}
+			Trace_Record(TRACE_LOCK, TRACE_LOCK_OPEN, (unsigned short)((latency < 0xFFFFU) ? latency : 0xFFFFU));
+			events = Kernel_FlagsWait(&lock_flags, LOCK_EVT_UNLOCK | LOCK_EVT_LOCK, LOCK_HOLD_MS);
+		}
+		GPIO_SetOutputPin(GPIOD, 1);
+		lock_open = 0;
+		Trace_Record(TRACE_LOCK, TRACE_LOCK_CLOSE, (events & LOCK_EVT_LOCK) ? 1U : 0U);
+	}
+}
+
+/*!
+ * @brief     UI thread: runs the cooperative task scheduler.
+ *
+ * @param[in]  arg Unused.
+ * @return     This function never returns.
+ */
+void ui_thread(void *arg){
+	(void)arg;
+	boot_mark(BOOT_PHASE_KERNEL);
+	Sched_Run();
+}
+
+/*!
+ * @brief     Advances the time base by the time spent in VLPS.
+ *
+ * @detail    SysTick is stopped in VLPS; the missed ticks are replayed so that the millisecond
+ *            tick, the scheduler timers and the kernel timeouts stay on time.
+ *
+ * @param[in]  ms Time slept in milliseconds.
+ * @return     void
+ */
+static void advance_time(unsigned int ms){
+	while(ms > 0U){
+		SysTick_IncTick();
+		Sched_Tick();
+		Kernel_Tick();
+		ms--;
+	}
+}
+
+/*!
+ * @brief     Idle hook of the scheduler: puts the board to sleep.
+ *
+ * @detail    Called with interrupts masked when no task is ready; the UI thread is the idle
+ *            thread of the kernel, so no thread is ready either. The board sleeps until the
+ *            next scheduler timer or kernel timeout, in VLPS when that is far enough away.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void Sched_Idle(void){
+	unsigned int idle_ms = Sched_NextTimeout();
+	unsigned int kernel_ms = Kernel_NextTimeout();
+
+	if(kernel_ms < idle_ms){
+		idle_ms = kernel_ms;
+	}
+	advance_time(Power_Idle(idle_ms));
 }
 
 /*!
@@ -398,13 +1065,14 @@ void init_systick(){
  * @param[in]  None
  * @return     1 if any button is pressed, 0 if no button is pressed.
  */
-unsigned char check_but() { 
+unsigned char check_but() {
 	GPIOC->PDOR |= ((1U << 8U) | (1U << 9U) | (1U << 10U) | (1U << 11U)); /* Set GPIOC pins high */
+	CORE_REG_READ(GPIOC->PDIR);
 	unsigned char col0 = (GPIOC->PDIR >> 1U) & 0x01; /* Read column 0 */
 	unsigned char col1 = (GPIOC->PDIR >> 2U) & 0x01; /* Read column 1 */
 	unsigned char col2 = (GPIOC->PDIR >> 16U) & 0x01; /* Read column 2 */
 	unsigned char col3 = (GPIOC->PDIR >> 15U) & 0x01; /* Read column 3 */
-	
+
 	if (col0 || col1 || col2 || col3) return 1; /* A button is pressed */
 	return 0; /* No button is pressed */
 }
@@ -437,11 +1105,12 @@ void scan_row(unsigned char r){
  */
 unsigned char check_col(){
 	unsigned char c=0;
+	CORE_REG_READ(GPIOC->PDIR);
 	unsigned char col0 = (GPIOC->PDIR >> 1U) & 0x01;
 	unsigned char col1 = (GPIOC->PDIR >> 2U) & 0x01;
 	unsigned char col2 = (GPIOC->PDIR >> 16U) & 0x01;
 	unsigned char col3 = (GPIOC->PDIR >> 15U) & 0x01;
-	if(col0)c=1; 
+	if(col0)c=1;
 	else if(col1)c=2;
 	else if(col2)c=3;
 	else if(col3)c=4;
@@ -458,572 +1127,1448 @@ unsigned char check_col(){
  * @param[in]  None
  * @return     The position of the pressed key (1-16), or 0 if no key is pressed.
  */
-unsigned char get_key() { 
-	unsigned char row, col;
-	if (check_but()) { 
-		for (row = 0; row < 4; row++) {
-			scan_row(row); 
-			col = check_col(); 
-			if (col > 0) return ((row * 4) + col); 
-		}
-	}
-	return 0; 
+unsigned char get_key() {
+	unsigned char row, col;
+	unsigned char key = 0;
+	PROBE_BEGIN(PROBE_GET_KEY);
+	if (check_but()) {
+		for (row = 0; (row < 4) && (key == 0); row++) {
+			scan_row(row);
+			col = check_col();
+			if (col > 0) key = (row * 4) + col;
+		}
+	}
+	PROBE_END(PROBE_GET_KEY);
+	return key;
+}
+
+/*!
+ * @brief     Reports the unlock latency and the context switch cost on LPUART1.
+ *
+ * @detail    The unlock latency is counted from the end of the sensor reply to the write of
+ *            the lock output by the lock thread.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void report_lock_latency(){
+	char report[96];
+	kernel_switch_stats_t stats;
+
+	Kernel_GetSwitchStats(&stats);
+	snprintf(report, sizeof(report), "Unlock latency: %u cycles (max %u), switch: %u cycles (max %u)",
+			lock_latency_cycles, lock_latency_max, stats.last, stats.max);
+	LPUART_send_string(LPUART1, (unsigned char*)report);
+	LPUART_send_byte(LPUART1, 0x0A);
+}
+
+/*!
+ * @brief     Records the latency of a granted identification.
+ *
+ * @detail    Called once the search reply is handled; the lock thread, of higher priority,
+ *            has driven the lock output by then. An attempt whose unlock time predates the
+ *            match, the lock thread not having run, is not recorded.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void latency_record(){
+	unsigned int unlock_ms = lock_unlock_ms;
+
+	latency_marks[LATENCY_MARK_MATCH] = fp_reply_ms;
+	if ((unlock_ms - latency_marks[LATENCY_MARK_MATCH]) <= (SysTick_GetTick() - latency_marks[LATENCY_MARK_MATCH])) {
+		latency_marks[LATENCY_MARK_UNLOCK] = unlock_ms;
+		Latency_Record(latency_marks);
+	}
+}
+
+/*!
+ * @brief     Reports the touch to unlock latency percentiles on LPUART1.
+ *
+ * @detail    One line per phase, then the whole, over the last LATENCY_WINDOW granted
+ *            identifications, then the unlock latency of the last one, see
+ *            report_lock_latency().
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void report_latency(){
+	char report[80];
+	latency_report_t stats;
+	unsigned char metric;
+
+	for (metric = 0; metric < LATENCY_METRICS; metric++) {
+		Latency_GetReport(metric, &stats);
+		snprintf(report, sizeof(report), "%s: %u, p50 %u, p90 %u, p99 %u, max %u ms",
+				Latency_GetName(metric), stats.count, stats.p50, stats.p90, stats.p99, stats.max);
+		LPUART_send_string(LPUART1, (unsigned char*)report);
+		LPUART_send_byte(LPUART1, 0x0A);
+	}
+	report_lock_latency();
+}
+
+/*!
+ * @brief     Reports the idle statistics on LPUART1.
+ *
+ * @detail    Prints the uptime, the time spent in VLPS, the number of WFI and VLPS sleeps,
+ *            the time from a VLPS wake-up to the restored run clock, then the time spent in
+ *            the high clock profile and the number of profile switches.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void report_power(){
+	char report[96];
+	power_stats_t stats;
+	clock_stats_t clock_stats;
+
+	Power_GetStats(&stats);
+	snprintf(report, sizeof(report), "Up %u ms, VLPS %u ms (%u), WFI %u, wake %u us (max %u)",
+			SysTick_GetTick(), stats.vlps_ms, stats.vlps_count, stats.wfi_count,
+			stats.wake_us_last, stats.wake_us_max);
+	LPUART_send_string(LPUART1, (unsigned char*)report);
+	LPUART_send_byte(LPUART1, 0x0A);
+	Clock_GetStats(&clock_stats);
+	snprintf(report, sizeof(report), "80 MHz %u ms, %u switches", clock_stats.high_ms,
+			clock_stats.switch_count);
+	LPUART_send_string(LPUART1, (unsigned char*)report);
+	LPUART_send_byte(LPUART1, 0x0A);
+}
+
+/*!
+ * @brief     Reports the stack high-water marks and the interrupt statistics on LPUART1.
+ *
+ * @detail    Prints the bytes used of the main stack (the boot and the interrupt handlers) and
+ *            of each thread stack, out of their size. In a build with PROBE_ENABLE, each handler
+ *            that ran then prints its count, its maximum and mean duration and its worst entry
+ *            latency in cycles, see isr_stats.h for what the latency covers.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void report_headroom(){
+	static const char *const thread_names[] = {"lock", "ui"};
+	char report[96];
+	stack_usage_t usage;
+	unsigned char thread;
+#if PROBE_ENABLE
+	isr_stats_t stats;
+	unsigned int id;
+#endif
+
+	Stack_GetMainUsage(&usage);
+	snprintf(report, sizeof(report), "stack main: %u of %u bytes", usage.used, usage.size);
+	LPUART_send_string(LPUART1, (unsigned char*)report);
+	LPUART_send_byte(LPUART1, 0x0A);
+	for (thread = THREAD_LOCK; thread <= THREAD_UI; thread++) {
+		Kernel_GetStackUsage(thread, &usage);
+		snprintf(report, sizeof(report), "stack %s: %u of %u bytes", thread_names[thread], usage.used,
+				usage.size);
+		LPUART_send_string(LPUART1, (unsigned char*)report);
+		LPUART_send_byte(LPUART1, 0x0A);
+	}
+#if PROBE_ENABLE
+	for (id = 0; id < ISR_COUNT; id++) {
+		IsrStats_Get(id, &stats);
+		if (stats.count == 0U) {
+			continue;
+		}
+		snprintf(report, sizeof(report), "%s: %u, max %u, mean %u, latency max %u (%u) cycles",
+				IsrStats_GetName(id), stats.count, stats.duration_max,
+				(unsigned int)(stats.duration_total / stats.count), stats.latency_max, stats.latency_count);
+		LPUART_send_string(LPUART1, (unsigned char*)report);
+		LPUART_send_byte(LPUART1, 0x0A);
+	}
+#endif
+}
+
+#if PROBE_ENABLE
+/*!
+ * @brief     Reports the statistics of the profiling probes on LPUART1.
+ *
+ * @detail    Each probe that measured something prints its count and its minimum, maximum
+ *            and mean in cycles, then the non-empty buckets of its histogram as "2^k:count",
+ *            k being the log2 of the shortest duration of the bucket.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void report_probes(){
+	char report[96];
+	probe_stats_t stats;
+	unsigned int id;
+	unsigned int bucket;
+	unsigned int length;
+
+	for (id = 0; id < PROBE_COUNT; id++) {
+		Probe_GetStats(id, &stats);
+		if (stats.count == 0U) {
+			continue;
+		}
+		snprintf(report, sizeof(report), "%s: %u, min %u, max %u, mean %u cycles", Probe_GetName(id),
+				stats.count, stats.min, stats.max, (unsigned int)(stats.total / stats.count));
+		LPUART_send_string(LPUART1, (unsigned char*)report);
+		LPUART_send_byte(LPUART1, 0x0A);
+		length = 0;
+		for (bucket = 0; bucket < PROBE_BUCKETS; bucket++) {
+			if (stats.buckets[bucket] == 0U) {
+				continue;
+			}
+			length += snprintf(&report[length], sizeof(report) - length, " 2^%u:%u", bucket,
+					stats.buckets[bucket]);
+			if (length > sizeof(report) - 24U) {
+				LPUART_send_string(LPUART1, (unsigned char*)report);
+				LPUART_send_byte(LPUART1, 0x0A);
+				length = 0;
+			}
+		}
+		if (length > 0U) {
+			LPUART_send_string(LPUART1, (unsigned char*)report);
+			LPUART_send_byte(LPUART1, 0x0A);
+		}
+	}
+}
+#endif
+
+/*!
+ * @brief     Records the time at which a boot phase is reached.
+ *
+ * @detail    Only the first occurrence of each phase is kept. Reaching BOOT_PHASE_FIRST_SCAN
+ *            prints the boot timeline on LPUART1.
+ *
+ * @param[in]  phase The boot phase reached.
+ * @return     void
+ */
+static void boot_mark(boot_phase_t phase){
+	if(boot_done_mask & (1U << phase)){
+		return;
+	}
+	boot_done_mask |= (1U << phase);
+	boot_time_ms[phase] = SysTick_GetTick();
+	if(phase == BOOT_PHASE_FIRST_SCAN){
+		report_boot();
+	}
+}
+
+/*!
+ * @brief     Prints the boot timeline on LPUART1.
+ *
+ * @detail    Times are milliseconds since the start of the SysTick, i.e. from the end of the
+ *            clock setup; a phase that was not reached prints as "-".
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void report_boot(){
+	static const char *const names[BOOT_PHASE_COUNT] = {
+		"clock", "drivers", "kernel", "lcd", "sensor", "first scan"
+	};
+	char report[32];
+	unsigned int i;
+
+	for(i = 0; i < BOOT_PHASE_COUNT; i++){
+		if(boot_done_mask & (1U << i)){
+			snprintf(report, sizeof(report), "Boot %s %u ms", names[i], boot_time_ms[i]);
+		}else{
+			snprintf(report, sizeof(report), "Boot %s -", names[i]);
+		}
+		LPUART_send_string(LPUART1, (unsigned char*)report);
+		LPUART_send_byte(LPUART1, 0x0A);
+	}
+}
+
+/*!
+ * @brief     Waits until a finger is placed on the sensor.
+ *
+ * @detail    Asks the sensor for a fingerprint image until one is captured, printing a dot on
+ *            LPUART1 for every attempt. Between attempts the flow waits for the touch line of
+ *            the sensor, so the board can sleep; it still retries every FP_TOUCH_POLL_MS in
+ *            case an edge was missed. The wait runs in the low clock profile; the high profile
+ *            is requested once the finger is there, for the processing that follows.
+ *
+ * @param[in]  pt Protothread state.
+ * @param[in]  events Events delivered to the sensor task.
+ * @return     Protothread state (PT_WAITING, PT_YIELDED or PT_ENDED).
+ */
+static PT_THREAD(fp_wait_finger(pt_t *pt, unsigned int events)){
+	PT_BEGIN(pt);
+	Clock_Release(CLOCK_REQ_SENSOR);
+	boot_mark(BOOT_PHASE_FIRST_SCAN);
+	fp_wait_ms = SysTick_GetTick();
+	do{
+		LPUART_send_string(LPUART1, (unsigned char*)".");
+		fp_image_sent_ms = SysTick_GetTick();
+		FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_GET_IMAGE), FP_REPLY_TIMEOUT_MS);
+		if(fp_response != FINGERPRINT_OK){
+			PT_WAIT_EVENT_TIMEOUT(pt, TASK_SENSOR, events, EVT_FP_TOUCH, FP_TOUCH_POLL_MS);
+		}
+	}while(fp_response != FINGERPRINT_OK);
+	Clock_Request(CLOCK_REQ_SENSOR);
+	LPUART_send_byte(LPUART1, 0x0A);
+	PT_END(pt);
+}
+
+/*!
+ * @brief     Gives the time at which the finger touched the sensor, after fp_wait_finger().
+ *
+ * @detail    The touch line edge if one came during the wait, before the GetImage that found
+ *            the finger; otherwise that GetImage, the finger having been found by polling.
+ *
+ * @param[in]  None
+ * @return     SysTick time in milliseconds.
+ */
+static unsigned int fp_touch_time(){
+	unsigned int touch_ms = fp_touch_ms;
+
+	return ((touch_ms - fp_wait_ms) <= (fp_image_sent_ms - fp_wait_ms)) ? touch_ms : fp_image_sent_ms;
+}
+
+/*!
+ * @brief     Waits until the finger is removed from the sensor.
+ *
+ * @param[in]  pt Protothread state.
+ * @param[in]  events Events delivered to the sensor task.
+ * @return     Protothread state (PT_WAITING, PT_YIELDED or PT_ENDED).
+ */
+static PT_THREAD(fp_wait_removed(pt_t *pt, unsigned int events)){
+	PT_BEGIN(pt);
+	FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_GET_IMAGE), FP_REPLY_TIMEOUT_MS);
+	while(fp_response == FINGERPRINT_OK){
+		LPUART_send_string(LPUART1, (unsigned char*)"Remove your finger");
+		LPUART_send_byte(LPUART1, 0x0A);
+		PT_DELAY(pt, TASK_SENSOR, events, FP_POLL_INTERVAL_MS);
+		FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_GET_IMAGE), FP_REPLY_TIMEOUT_MS);
+	}
+	PT_END(pt);
+}
+
+/*!
+ * @brief     Waits until the fingerprint sensor answers after power-up.
+ *
+ * @detail    The sensor needs a few hundred milliseconds to boot and ignores the commands sent
+ *            before. The system parameters are read every FP_HANDSHAKE_RETRY_MS until a valid
+ *            reply comes back; the other tasks run in the meantime. The library size gives the
+ *            page layout: the user pages, then the HOTSET_SLOTS hot pages at the end of a large
+ *            enough library, whose map is read back from the sensor notepad. The flow of the
+ *            current finger_mode is then started.
+ *
+ * @param[in]  pt Protothread state.
+ * @param[in]  events Events delivered to the sensor task.
+ * @return     Protothread state (PT_WAITING, PT_YIELDED or PT_ENDED).
+ */
+static PT_THREAD(fp_handshake(pt_t *pt, unsigned int events)){
+	PT_BEGIN(pt);
+	FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_READ_SYS_PARA), FP_HANDSHAKE_TIMEOUT_MS);
+	while((fp_response != FINGERPRINT_OK) || (FP_LIBRARY_SIZE() == FP_REPLY_NO_WORD)){
+		PT_DELAY(pt, TASK_SENSOR, events, FP_HANDSHAKE_RETRY_MS);
+		FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_READ_SYS_PARA), FP_HANDSHAKE_TIMEOUT_MS);
+	}
+	fp_hot_base = FP_LIBRARY_SIZE();
+	fp_hot_enabled = (fp_hot_base >= FP_HOT_MIN_LIBRARY);
+	if(fp_hot_enabled){
+		fp_hot_base -= HOTSET_SLOTS;
+	}
+	fp_user_pages = (fp_hot_base < MAX_NUM_USER) ? fp_hot_base : MAX_NUM_USER;
+	if(fp_hot_enabled){
+		FP_COMMAND(pt, events, sendFPReadNotepadCommand(LPUART2, FP_HOT_NOTEPAD_PAGE), FP_REPLY_TIMEOUT_MS);
+		if((fp_response == FINGERPRINT_OK) && (FP_NOTEPAD_DATA() != 0)){
+			HotSet_LoadMap(FP_NOTEPAD_DATA());
+		}
+	}
+	fp_ready = 1;
+	boot_mark(BOOT_PHASE_SENSOR);
+	Sched_PostEvent(TASK_SENSOR, EVT_FP_MODE);
+	PT_END(pt);
+}
+
+/*!
+ * @brief     Copies the template of hot_user into the hot page of hot_slot.
+ *
+ * @detail    HotSet_Plan() has emptied the slot: the map is saved without it before the page
+ *            is overwritten (LoadChar of the user page into character buffer 1, Store to the
+ *            hot page), and with the slot filled once the copy is done. A failed step leaves
+ *            the slot empty; it is filled at a later rebalance.
+ *
+ * @param[in]  pt Protothread state.
+ * @param[in]  events Events delivered to the sensor task.
+ * @return     Protothread state (PT_WAITING, PT_YIELDED, PT_EXITED or PT_ENDED).
+ */
+static PT_THREAD(fp_hot_move(pt_t *pt, unsigned int events)){
+	PT_BEGIN(pt);
+	HotSet_SaveMap(hot_map);
+	FP_COMMAND(pt, events, sendFPWriteNotepadCommand(LPUART2, FP_HOT_NOTEPAD_PAGE, hot_map), FP_REPLY_TIMEOUT_MS);
+	if(fp_response != FINGERPRINT_OK){
+		PT_EXIT(pt);
+	}
+	FP_COMMAND(pt, events, sendFPLoadCharCommand(LPUART2, hot_user), FP_REPLY_TIMEOUT_MS);
+	if(fp_response != FINGERPRINT_OK){
+		PT_EXIT(pt);
+	}
+	FP_COMMAND(pt, events, sendFPStoreCommand(fp_hot_base + hot_slot, LPUART2), FP_REPLY_TIMEOUT_MS);
+	if(fp_response != FINGERPRINT_OK){
+		PT_EXIT(pt);
+	}
+	HotSet_SetSlot(hot_slot, hot_user);
+	HotSet_SaveMap(hot_map);
+	FP_COMMAND(pt, events, sendFPWriteNotepadCommand(LPUART2, FP_HOT_NOTEPAD_PAGE, hot_map), FP_REPLY_TIMEOUT_MS);
+	PT_END(pt);
+}
+
+/*!
+ * @brief     Performs the fingerprint search operation.
+ *
+ * @detail    This flow performs the following steps, over and over:
+ *            1. Receiving a fingerprint image from the user.
+ *            2. Generating a feature file for the fingerprint.
+ *            3. Searching the hot pages, then the user pages if none of them matches, and
+ *               displaying the result. On a match the LPUART2 interrupt has already made the
+ *               lock thread open the door. A match outside the access schedule of the user
+ *               leaves the door closed. Every result goes to the event log, and the phase
+ *               times of a granted one to the latency statistics (ADMIN_CMD_LATENCY).
+ *            4. Every HOTSET_REBALANCE matches, copying a frequent user into the hot pages.
+ *
+ * @param[in]  pt Protothread state.
+ * @param[in]  events Events delivered to the sensor task.
+ * @return     Protothread state, the flow never ends.
+ */
+static PT_THREAD(search_finger_print(pt_t *pt, unsigned int events)){
+	PT_BEGIN(pt);
+	while(1){
+		/* Step 1: Receive a fingerprint */
+		do{
+			LPUART_send_string(LPUART1, (unsigned char*)"Press your finger to search");
+			show_message("PRESS FINGER");
+			PT_SPAWN(pt, &fp_wait_pt, fp_wait_finger(&fp_wait_pt, events));
+			latency_marks[LATENCY_MARK_TOUCH] = fp_touch_time();
+			latency_marks[LATENCY_MARK_IMAGE] = fp_reply_ms;
+
+			/* Step 2: Generate features file */
+			LPUART_send_string(LPUART1, (unsigned char*)"Receiving your finger image ");
+			LPUART_send_byte(LPUART1, 0x0A);
+			FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_CREATE_CHAR_FILE_1), FP_REPLY_TIMEOUT_MS);
+		}while(fp_response != FINGERPRINT_OK);
+		latency_marks[LATENCY_MARK_FEATURES] = fp_reply_ms;
+		LPUART_send_string(LPUART1, (unsigned char*)"Received your finger image");
+		LPUART_send_byte(LPUART1, 0x0A);
+
+		/* Step 3: Send Search instruction data */
+		LPUART_send_string(LPUART1, (unsigned char*)"Searching finger");
+		LPUART_send_byte(LPUART1, 0x0A);
+		show_message("SEARCHING");
+		fp_response = FINGERPRINT_NO_SEARCH;
+		if(HotSet_Count() > 0U){
+			fp_search_pending = 1;
+			FP_COMMAND(pt, events, sendFPSearchCommand(LPUART2, 1, fp_hot_base, HOTSET_SLOTS), FP_SEARCH_TIMEOUT_MS);
+		}
+		if((fp_response == FINGERPRINT_NO_SEARCH) ||
+				((fp_response == FINGERPRINT_OK) && (FP_MATCH_USER() == HOTSET_NO_USER))){
+			fp_search_pending = 1;
+			FP_COMMAND(pt, events, sendFPSearchCommand(LPUART2, 0, 0, fp_user_pages), FP_SEARCH_TIMEOUT_MS);
+		}
+		fp_search_pending = 0;
+		if((fp_response == FINGERPRINT_OK) && !access_now(FP_MATCH_USER())){
+			log_event(EVENT_LOG_DENIED, FP_MATCH_USER(), FP_MATCH_SCORE());
+			show_message("NO ACCESS NOW");
+		}else if(fp_response == FINGERPRINT_OK){
+			latency_record();
+			log_event(EVENT_LOG_GRANTED, FP_MATCH_USER(), FP_MATCH_SCORE());
+			if(FP_MATCH_USER() < MAX_NUM_USER){
+				char name[MAX_NAME_LENGTH];
+				Users_GetName(FP_MATCH_USER(), name);
+				lcd_fb_write_field(0, 0, name, LCD_COLS);
+				Sched_PostEvent(TASK_LCD, EVT_LCD_DIRTY);
+			}
+		}else{
+			log_event((fp_response == FINGERPRINT_NO_SEARCH) ? EVENT_LOG_NO_MATCH : EVENT_LOG_SENSOR_ERROR, 0, 0);
+			Kernel_FlagsSet(&lock_flags, LOCK_EVT_LOCK);
+			show_message("NOT FOUND");
+		}
+		Clock_Release(CLOCK_REQ_SENSOR);
+
+		/* Step 4: Rebalance the hot pages */
+		if((fp_response == FINGERPRINT_OK) && HotSet_Hit(FP_MATCH_USER()) &&
+				fp_hot_enabled && HotSet_Plan(&hot_slot, &hot_user)){
+			PT_SPAWN(pt, &fp_hot_pt, fp_hot_move(&fp_hot_pt, events));
+		}
+		PT_DELAY(pt, TASK_SENSOR, events, RESULT_HOLD_MS);
+	}
+	PT_END(pt);
+}
+
+/*!
+ * @brief     Imports a fingerprint and stores it in the system.
+ *
+ * @detail    This flow performs the following steps:
+ *            1. Receives a fingerprint image and creates feature file 1.
+ *            2. Receives the same fingerprint again and creates feature file 2.
+ *            3. Generates the template, starting over if the two images do not match.
+ *            4. Saves the fingerprint template to the sensor flash at IDStore, after removing
+ *               a hot tier copy of the template it replaces from the map. A user who has no
+ *               schedule yet is given ACCESS_SCHEDULE_ALWAYS.
+ *            5. Switches to name creation mode.
+ *
+ * @param[in]  pt Protothread state.
+ * @param[in]  events Events delivered to the sensor task.
+ * @return     Protothread state (PT_WAITING, PT_YIELDED or PT_ENDED).
+ */
+static PT_THREAD(import_finger_print(pt_t *pt, unsigned int events)){
+	PT_BEGIN(pt);
+	LPUART_send_string(LPUART1, (unsigned char*)"Give ID to store finger");
+	LPUART_send_byte(LPUART1, 0x0A);
+	do{
+		/* Step 1: Receive a fingerprint and generate features file 1 */
+		do{
+			LPUART_send_string(LPUART1, (unsigned char*)"Press your finger");
+			PT_SPAWN(pt, &fp_wait_pt, fp_wait_finger(&fp_wait_pt, events));
+			LPUART_send_string(LPUART1, (unsigned char*)"Creating Char File 1");
+			LPUART_send_byte(LPUART1, 0x0A);
+			FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_CREATE_CHAR_FILE_1), FP_REPLY_TIMEOUT_MS);
+		}while(fp_response != FINGERPRINT_OK);
+		LPUART_send_string(LPUART1, (unsigned char*)"Created CHAR_FILE_1");
+		LPUART_send_byte(LPUART1, 0x0A);
+		PT_SPAWN(pt, &fp_wait_pt, fp_wait_removed(&fp_wait_pt, events));
+
+		/* Step 2: Receive the same fingerprint and generate features file 2 */
+		do{
+			LPUART_send_string(LPUART1, (unsigned char*)"Press your finger again (1)");
+			PT_SPAWN(pt, &fp_wait_pt, fp_wait_finger(&fp_wait_pt, events));
+			LPUART_send_string(LPUART1, (unsigned char*)"Creating Char File 2");
+			LPUART_send_byte(LPUART1, 0x0A);
+			FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_CREATE_CHAR_FILE_2), FP_REPLY_TIMEOUT_MS);
+		}while(fp_response != FINGERPRINT_OK);
+		LPUART_send_string(LPUART1, (unsigned char*)"Created CHAR_FILE_2");
+		LPUART_send_byte(LPUART1, 0x0A);
+		PT_SPAWN(pt, &fp_wait_pt, fp_wait_removed(&fp_wait_pt, events));
+
+		/* Step 3: Compare char file 1 and char file 2 to generate the template file */
+		LPUART_send_string(LPUART1, (unsigned char*)"Creating template model");
+		LPUART_send_byte(LPUART1, 0x0A);
+		FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_CREATE_TEMPLATE), FP_REPLY_TIMEOUT_MS);
+	}while(fp_response != FINGERPRINT_OK);
+	LPUART_send_string(LPUART1, (unsigned char*)"Created TEMPLATE MODEL");
+	LPUART_send_byte(LPUART1, 0x0A);
+
+	/* Step 4: Save the template file to AS608 FLASH, dropping a hot copy of the old one first */
+	if(HotSet_Forget(IDStore)){
+		do{
+			HotSet_SaveMap(hot_map);
+			FP_COMMAND(pt, events, sendFPWriteNotepadCommand(LPUART2, FP_HOT_NOTEPAD_PAGE, hot_map), FP_REPLY_TIMEOUT_MS);
+		}while(fp_response != FINGERPRINT_OK);
+	}
+	do{
+		LPUART_send_string(LPUART1, (unsigned char*)"Storing");
+		LPUART_send_byte(LPUART1, 0x0A);
+		FP_COMMAND(pt, events, sendFPStoreCommand(IDStore, LPUART2), FP_REPLY_TIMEOUT_MS);
+	}while(fp_response != FINGERPRINT_OK);
+	LPUART_send_string(LPUART1, (unsigned char*)"Storaged");
+	LPUART_send_byte(LPUART1, 0x0A);
+	if (Users_GetSchedule(IDStore) == USERS_NO_SCHEDULE) {
+		(void)assign_schedule(IDStore, ACCESS_SCHEDULE_ALWAYS);  /* A new user may enter at any time */
+	}
+
+	/* Step 5: Switched to name creation mode */
+	set_finger_mode(CREATE_NEW_USER_NAME_MODE);
+	Users_GetName(IDStore, name_edit);
+	cursor_position = 0;
+	show_name();
+	Sched_PostEvent(TASK_KEYPAD, EVT_KEY_SCAN);
+	PT_END(pt);
+}
+
+/*!
+ * @brief     Empties the fingerprint library of the sensor.
+ *
+ * @detail    On success the hot tier map is emptied, "CLEAR ALL FINGER" is shown for
+ *            RESULT_HOLD_MS, then the name being entered is shown again.
+ *
+ * @param[in]  pt Protothread state.
+ * @param[in]  events Events delivered to the sensor task.
+ * @return     Protothread state (PT_WAITING, PT_YIELDED or PT_ENDED).
+ */
+static PT_THREAD(delete_all_finger(pt_t *pt, unsigned int events)){
+	PT_BEGIN(pt);
+	FP_COMMAND(pt, events, sendFPCommand(LPUART2, FP_CMD_DELETE_ALL_FINGER), FP_REPLY_TIMEOUT_MS);
+	if(fp_response == FINGERPRINT_OK){
+		HotSet_Init();
+		HotSet_SaveMap(hot_map);
+		FP_COMMAND(pt, events, sendFPWriteNotepadCommand(LPUART2, FP_HOT_NOTEPAD_PAGE, hot_map), FP_REPLY_TIMEOUT_MS);
+		show_message("CLEAR ALL FINGER");
+		PT_DELAY(pt, TASK_SENSOR, events, RESULT_HOLD_MS);
+		show_name();
+	}
+	PT_END(pt);
+}
+
+/*!
+ * @brief     Sensor task: runs the fingerprint search and enrollment flows.
+ *
+ * @detail    EVT_FP_MODE aborts the running flow and starts the flow of the current
+ *            finger_mode, EVT_FP_DELETE_ALL aborts it and empties the fingerprint library.
+ *            Every other event is passed to the running flow. Until the sensor has answered
+ *            the boot handshake, the handshake is the only flow that runs.
+ *
+ * @param[in]  events Events posted to the task.
+ * @return     void
+ */
+void sensor_task(unsigned int events){
+	char state = PT_ENDED;
+
+	if (events & (EVT_FP_MODE | EVT_FP_DELETE_ALL)) {
+		Sched_CancelTimer(TASK_SENSOR, PT_EVT_TIMEOUT);
+		Power_Release(POWER_HOLD_SENSOR);
+		fp_command_pending = 0;
+		Clock_Release(CLOCK_REQ_SENSOR);
+		events &= ~(EVT_FP_REPLY | EVT_FP_TOUCH | PT_EVT_TIMEOUT);  /* Belong to the aborted flow */
+		if (!fp_ready) {
+			fp_flow = FP_FLOW_HANDSHAKE;
+		} else if (events & EVT_FP_DELETE_ALL) {
+			fp_flow = FP_FLOW_DELETE_ALL;
+		} else if (finger_mode == IMPORT_FINGERPRINT_MODE) {
+			fp_flow = FP_FLOW_ENROLL;
+		} else if (finger_mode == SEARCH_FINGERPRINT_MODE) {
+			fp_flow = FP_FLOW_SEARCH;
+		} else {
+			fp_flow = FP_FLOW_NONE;
+		}
+		PT_INIT(&fp_pt);
+	}
+	if (fp_flow == FP_FLOW_HANDSHAKE) {
+		state = fp_handshake(&fp_pt, events);
+	} else if (fp_flow == FP_FLOW_SEARCH) {
+		state = search_finger_print(&fp_pt, events);
+	} else if (fp_flow == FP_FLOW_ENROLL) {
+		state = import_finger_print(&fp_pt, events);
+	} else if (fp_flow == FP_FLOW_DELETE_ALL) {
+		state = delete_all_finger(&fp_pt, events);
+	}
+	if (state >= PT_EXITED) {
+		fp_flow = FP_FLOW_NONE;
+		Clock_Release(CLOCK_REQ_SENSOR);
+	}
+}
+
+/*!
+ * @brief     Appends a character to the name being entered.
+ *
+ * @param[in]  c The character to append.
+ * @return     void
+ */
+static void keytap_add_char(char c){
+	if (cursor_position < MAX_NAME_LENGTH) {
+		name_edit[cursor_position] = c;
+	}
+	cursor_position++;
+}
+
+/*!
+ * @brief     Clears the name being entered and resets the cursor position.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void keytap_clear_name(){
+	cursor_position = 0;
+	for(unsigned char i = 0; i < MAX_NAME_LENGTH; i++){
+		name_edit[i] = '\0';
+	}
+}
+
+/*!
+ * @brief     Finalizes the name creation.
+ *
+ * @detail    Saves the name to flash memory, where only the part of its record that changed
+ *            is written, and shows "CREATED NAME"; the keypad task switches back to
+ *            fingerprint search mode when EVT_KEY_DONE is delivered RESULT_HOLD_MS later.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void keytap_finish_name(){
+	if (Users_SetName(IDStore, name_edit) == USERS_OK) {
+		show_message("CREATED NAME");
+	} else {
+		show_message("NAME NOT SAVED");
+	}
+	Sched_PostEvent(TASK_LOG, EVT_LOG_WORK);
+	IDStore = 0;
+	Sched_StartTimer(TASK_KEYPAD, EVT_KEY_DONE, RESULT_HOLD_MS);
+}
+
+/*!
+ * @brief     Handles the number input mode for setting a name or performing actions.
+ *
+ * @detail    This function processes user inputs for setting a name, performing operations,
+ *            and interacting with the fingerprint module based on the input value.
+ *
+ *            Actions performed based on input values:
+ *            - 0: No action.
+ *            - 1-3: Add numbers 1-3 to the current position in the user name.
+ *            - 4: Switch to a different mode (MODE = 1).
+ *            - 5-7: Add numbers 4-6 to the current position in the user name.
+ *            - 8: Add a space to the current position in the user name.
+ *            - 9-11: Add numbers 7-9 to the current position in the user name.
+ *            - 12: Clear the user name and reset cursor position.
+ *            - 13: Clear all stored fingerprints.
+ *            - 14: Add number 0 to the current position in the user name.
+ *            - 15: Finalize name creation, switch to fingerprint search mode.
+ *            - 16: Remove the last character from the user name.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void keytap_number_mode(){
+	switch (value) {
+	case 0:
+		break;
+	case 4:
+		MODE = 1;
+		break;
+	case 12:
+		keytap_clear_name();
+		break;
+	case 13:
+		Sched_PostEvent(TASK_SENSOR, EVT_FP_DELETE_ALL);
+		break;
+	case 15:
+		keytap_finish_name();
+		break;
+	case 16:
+		if (cursor_position > 0) {
+			cursor_position--;
+			name_edit[cursor_position] = '\0';
+		}
+		break;
+	default:
+		if ((value < sizeof(keytap_number_map)) && (keytap_number_map[value] != 0)) {
+			keytap_add_char(keytap_number_map[value]);
+		}
+		break;
+	}
+}
+
+/*!
+ * @brief     Handles character input mode for setting a name.
+ *
+ * @detail    This function processes user inputs for setting a name based on the button press
+ *            count. A character key starts a KEY_MULTITAP_MS window; when it closes, the keypad
+ *            task picks the first character of the key if it was released, the second one if
+ *            it is still pressed (see keytap_character_map).
+ *
+ *            Actions performed based on input values:
+ *            - 0: No action.
+ *            - 1: Add characters A or B based on button press count.
+ *            - 2: Add characters C or D based on button press count.
+ *            - 3: Add characters E or G based on button press count.
+ *            - 4: Switch to number mode (MODE = 0).
+ *            - 5: Add characters H or I based on button press count.
+ *            - 6: Add characters K or L based on button press count.
+ *            - 7: Add characters M or N based on button press count.
+ *            - 8: Add a space to the current position in the user name.
+ *            - 9: Add characters O or P based on button press count.
+ *            - 10: Add characters Q or R based on button press count.
+ *            - 11: Add characters S or T based on button press count.
+ *            - 12: Clear the user name and reset cursor position.
+ *            - 13: Add characters U or V based on button press count.
+ *            - 14: Add characters X or Y based on button press count.
+ *            - 15: Finalize name creation, switch to fingerprint search mode.
+ *            - 16: Remove the last character from the user name.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void keytap_character_mode(){
+	switch (value) {
+	case 0:
+		break;
+	case 4:
+		MODE = 0;
+		break;
+	case 8:
+		keytap_add_char(' ');
+		break;
+	case 12:
+		keytap_clear_name();
+		break;
+	case 15:
+		keytap_finish_name();
+		break;
+	case 16:
+		if (cursor_position > 0) {
+			cursor_position--;
+			name_edit[cursor_position] = '\0';
+		}
+		break;
+	default:
+		if ((value < sizeof(keytap_character_map) / 2) && (keytap_character_map[value][0] != 0)) {
+			button_press_count = 1;
+			pending_key = value;
+			Sched_StartTimer(TASK_KEYPAD, EVT_KEY_MULTITAP, KEY_MULTITAP_MS);
+		}
+		break;
+	}
+}
+
+/*!
+ * @brief     Handles keytap input based on the current mode (number or character).
+ *
+ * @detail    This function checks the current mode to determine if the system is in
+ *            number or character input mode. It updates the state of an output pin
+ *            (GPIOD, pin 15) based on the mode, processes the keypress, and updates
+ *            the user name as needed. If the cursor position exceeds the name length,
+ *            it resets the user name.
+ *
+ *            - If in number mode, sets an output pin high.
+ *            - If in character mode, sets the output pin low.
+ *            - Calls the appropriate function to handle key input based on the mode.
+ *            - Resets the user name if cursor position exceeds 16.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+void handle_keytap(){
+	if(MODE == KEYTAP_NUMBER_MODE){
+		GPIO_SetOutputPin(GPIOD, 15);
+	}
+	else {
+		GPIO_ResetOutputPin(GPIOD, 15);
+	}
+	value = get_key();
+	if (value != 0) {
+		Trace_Record(TRACE_KEY, value, MODE);
+	}
+	if (MODE == KEYTAP_NUMBER_MODE){
+		keytap_number_mode();
+	}
+	else if(MODE == KEYTAP_CHARACTER_MODE) {
+		keytap_character_mode();
+	}
+	if(cursor_position > MAX_NAME_LENGTH)
+	{
+		keytap_clear_name();
+	}
+}
+
+/*!
+ * @brief     Keypad task: scans the keypad while a user name is being entered.
+ *
+ * @detail    EVT_KEY_SCAN scans the keypad every KEY_SCAN_INTERVAL_MS. Scanning pauses
+ *            while a character key waits for its multi-tap window (EVT_KEY_MULTITAP)
+ *            and stops when the name is finalized (EVT_KEY_DONE).
+ *
+ * @param[in]  events Events posted to the task.
+ * @return     void
+ */
+void keypad_task(unsigned int events){
+	if (events & EVT_KEY_DONE) {
+		lcd_fb_clear_row(0);
+		set_finger_mode(SEARCH_FINGERPRINT_MODE);
+		Sched_PostEvent(TASK_SENSOR, EVT_FP_MODE);
+		return;
+	}
+	if (finger_mode != CREATE_NEW_USER_NAME_MODE) {
+		return;
+	}
+	if ((events & EVT_KEY_MULTITAP) && (pending_key != 0)) {
+		if (check_but() == 1) {
+			button_press_count++;
+		}
+		keytap_add_char(keytap_character_map[pending_key][button_press_count - 1]);
+		button_press_count = 0;
+		pending_key = 0;
+		if(cursor_position > MAX_NAME_LENGTH)
+		{
+			keytap_clear_name();
+		}
+	} else if (events & EVT_KEY_SCAN) {
+		handle_keytap();
+	}
+	if (finger_mode == CREATE_NEW_USER_NAME_MODE) {
+		if (fp_flow == FP_FLOW_NONE) {
+			show_name();
+		}
+		if ((pending_key == 0) && (IDStore != 0)) {
+			Sched_StartTimer(TASK_KEYPAD, EVT_KEY_SCAN, KEY_SCAN_INTERVAL_MS);
+		}
+	}
+}
+
+/*!
+ * @brief     Returns the next epoch second at which the clock shows a given time of day.
+ *
+ * @param[in]  hour Hour of the day.
+ * @param[in]  minute Minute of the hour.
+ * @return     Epoch second, always in the future.
+ */
+static unsigned int rtc_next_daily(unsigned char hour, unsigned char minute){
+	rtc_time_t at;
+	unsigned int now = RTC_GetEpoch();
+	unsigned int epoch;
+
+	RTC_FromEpoch(now, &at);
+	at.hour = hour;
+	at.minute = minute;
+	at.second = 0;
+	epoch = RTC_ToEpoch(&at);
+	if (epoch <= now) {
+		epoch += 86400U;
+	}
+	return epoch;
+}
+
+/*!
+ * @brief     Schedules the RTC alarm jobs.
+ *
+ * @detail    Called at boot and whenever the time is set. The jobs only run once the time is
+ *            valid, since their times of day mean nothing before.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void rtc_jobs_start(){
+	if (!RTC_IsTimeValid()) {
+		return;
+	}
+	RTC_AlarmSet(RTC_JOB_RELOCK, rtc_next_daily(AUTO_RELOCK_HOUR, AUTO_RELOCK_MINUTE));
+}
+
+/*!
+ * @brief     Prints the date and time on LPUART1.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void report_time(){
+	char report[32];
+	rtc_time_t now;
+
+	if (!RTC_IsTimeValid()) {
+		LPUART_send_string(LPUART1, (unsigned char*)"Time not set");
+	} else {
+		RTC_GetTime(&now);
+		snprintf(report, sizeof(report), "%04u-%02u-%02u %02u:%02u:%02u", now.year, now.month,
+				now.day, now.hour, now.minute, now.second);
+		LPUART_send_string(LPUART1, (unsigned char*)report);
+	}
+	LPUART_send_byte(LPUART1, 0x0A);
+}
+
+/*!
+ * @brief     Returns a big-endian 16-bit field of the admin payload.
+ *
+ * @param[in]  index Index of the first byte of the field.
+ * @return     The field.
+ */
+static unsigned int admin_get_u16(unsigned char index){
+	return ((unsigned int)admin_payload[index] << 8) | admin_payload[index + 1U];
+}
+
+/*!
+ * @brief     Returns a big-endian 32-bit field of the admin payload.
+ *
+ * @param[in]  index Index of the first byte of the field.
+ * @return     The field.
+ */
+static unsigned int admin_get_u32(unsigned char index){
+	return ((unsigned int)admin_payload[index] << 24) | ((unsigned int)admin_payload[index + 1U] << 16) |
+			((unsigned int)admin_payload[index + 2U] << 8) | admin_payload[index + 3U];
+}
+
+/*!
+ * @brief     Sends a big-endian field on LPUART1.
+ *
+ * @param[in]  value The field.
+ * @param[in]  size Size of the field in bytes.
+ * @return     void
+ */
+static void export_send_field(unsigned int value, unsigned char size){
+	while (size > 0U) {
+		size--;
+		LPUART_send_byte(LPUART1, (unsigned char)(value >> (8U * size)));
+	}
+}
+
+/*!
+ * @brief     Sends the next records of a log export.
+ *
+ * @detail    The export starts at the sector found by EventLog_Seek(), skips the records of
+ *            that sector that are older than export_from and ends at the first record newer
+ *            than export_to, so its cost follows the number of records sent rather than the
+ *            size of the log. Once the clock has been set back the records are not in time
+ *            order; the whole log is then read and only the records in the range are sent. At
+ *            most EXPORT_BATCH records are sent per call, the next call is posted as
+ *            EVT_CONSOLE_EXPORT so that the other tasks keep running. The export goes on after
+ *            a flash command of the log completes.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void export_run(){
+	event_log_record_t record;
+	unsigned char status = EVENT_LOG_OK;
+	unsigned char sent = 0;
+
+	while (sent < EXPORT_BATCH) {
+		status = EventLog_ReadNext(&export_cursor, &record);
+		if (status == EVENT_LOG_BUSY) {
+			Sched_StartTimer(TASK_CONSOLE, EVT_CONSOLE_EXPORT, EXPORT_RETRY_MS);
+			return;
+		}
+		if ((status != EVENT_LOG_OK) || (export_ordered && (record.time > export_to))) {
+			status = EVENT_LOG_END;
+			break;
+		}
+		if ((record.time >= export_from) && (record.time <= export_to)) {
+			LPUART_send_byte(LPUART1, EXPORT_RECORD);
+			export_send_field(record.time, 4U);
+			export_send_field(record.user_id, 2U);
+			export_send_field(record.score, 2U);
+			export_send_field(record.result, 1U);
+			export_count++;
+			sent++;
+		}
+	}
+	if (status == EVENT_LOG_END) {
+		LPUART_send_byte(LPUART1, EXPORT_END);
+		export_send_field(export_count, 2U);
+		export_send_field(status, 1U);
+		export_active = 0;
+	} else {
+		Sched_PostEvent(TASK_CONSOLE, EVT_CONSOLE_EXPORT);
+	}
+}
+
+/*!
+ * @brief     Sends a frame of a directory stream or a trace dump on LPUART1.
+ *
+ * @param[in]  frame The frame.
+ * @param[in]  size Its size.
+ * @return     void
+ */
+static void users_send_frame(const unsigned char *frame, unsigned int size){
+	while (size > 0U) {
+		LPUART_send_byte(LPUART1, *frame++);
+		size--;
+	}
+}
+
+/*!
+ * @brief     Sends the next batch of a directory export.
+ *
+ * @detail    Users with neither a name nor a schedule other than ACCESS_SCHEDULE_NEVER are
+ *            left out. One batch frame is sent per call and the next call is posted as
+ *            EVT_CONSOLE_USERS; the call after the last batch sends the end frame.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void users_export_run(){
+	provision_record_t record;
+	const unsigned char *frame;
+	unsigned int size = 0;
+
+	while ((size == 0U) && (users_export_id < USERS_MAX_USERS)) {
+		Users_GetName(users_export_id, record.name);
+		record.user_id = users_export_id;
+		record.schedule = Access_GetUserSchedule(users_export_id);
+		if ((record.name[0] == '\0') && (record.schedule == ACCESS_SCHEDULE_NEVER)) {
+			users_export_id++;
+		} else if (Provision_TxAdd(&record)) {
+			users_export_id++;
+		} else {
+			size = Provision_TxBatch(&frame);
+		}
+	}
+	if (size == 0U) {
+		size = Provision_TxBatch(&frame);
+	}
+	if (size == 0U) {
+		size = Provision_TxEnd(&frame);
+		users_export_active = 0;
+	}
+	users_send_frame(frame, size);
+	if (users_export_active) {
+		Sched_PostEvent(TASK_CONSOLE, EVT_CONSOLE_USERS);
+	}
+}
+
+/*!
+ * @brief     Sends the next records of a trace dump.
+ *
+ * @detail    The ring stays frozen from the header to the last record, so the dump is the
+ *            ring as it was when ADMIN_CMD_TRACE arrived. At most EXPORT_BATCH records are
+ *            sent per call, the next call is posted as EVT_CONSOLE_TRACE. The ring records
+ *            again after the last one, empty if the command asked for it.
+ *
+ * @param[in]  None
+ * @return     void
+ */
+static void trace_dump_run(){
+	unsigned char frame[TRACE_DUMP_RECORD];
+	unsigned char sent = 0;
+
+	while ((sent < EXPORT_BATCH) && (trace_dump_index < Trace_Count())) {
+		users_send_frame(frame, Trace_DumpRecord(trace_dump_index, frame));
+		trace_dump_index++;
+		sent++;
+	}
+	if (trace_dump_index < Trace_Count()) {
+		Sched_PostEvent(TASK_CONSOLE, EVT_CONSOLE_TRACE);
+		return;
+	}
+	if (trace_dump_clear) {
+		Trace_Clear();
+	}
+	Trace_Freeze(0U);
+	trace_dump_active = 0;
+}
+
+/*!
+ * @brief     Closes a directory import.
+ *
+ * @param[in]  status IMPORT_DONE_xxx.
+ * @return     void
+ */
+static void import_finish(unsigned char status){
+	import_active = 0;
+	LPUART_send_byte(LPUART1, PROVISION_REPLY_DONE);
+	export_send_field(Provision_Count(), 2U);
+	LPUART_send_byte(LPUART1, status);
 }
 
 /*!
- * @brief     Performs fingerprint search operation.
+ * @brief     Feeds a console byte to the directory import.
  *
- * @detail    This function coordinates the process of searching for a fingerprint by:
- *            1. Receiving a fingerprint image from the user.
- *            2. Generating a feature file for the fingerprint.
- *            3. Sending a search instruction and displaying the result.
+ * @detail    A batch is applied record by record while the host waits for its reply, the
+ *            names through Users_SetName() (unchanged names are not written again) and the
+ *            schedules through assign_schedule(), which keeps them across resets. A batch
+ *            that hits a full user database is answered with a NAK: the records already
+ *            applied are applied again, to the same effect, when the host sends it again,
+ *            and the log task compacts the database in the meantime. A record with a user
+ *            or a schedule out of range would fail again however often it is sent, so it
+ *            closes the import as IMPORT_DONE_REJECTED instead; the records before it stay
+ *            applied.
  *
- * @param[in]  None
+ * @param[in]  received The byte received.
  * @return     void
  */
-void search_finger_print(){
-	/* Step 1: Receive a fingerprint */
-	do{
-		LPUART_send_string(LPUART1, (unsigned char*)"Press your finger to search");
-		lcd_clear();
-		lcd_put_cur(0, 0);
-		lcd_send_string("PRESS FINGER");
-		display_time();
-		do{	
-			LPUART_send_string(LPUART1, (unsigned char*)".");
-			display_time();
-			GPIO_SetOutputPin(GPIOD, 1);
-		}while(sendFPGetImage(LPUART2, data_ack, CORE_CLOCK) != FINGERPRINT_OK);
-		LPUART_send_byte(LPUART1, 0x0A);
-		
-		/* Step 2: Generate features file */
-		LPUART_send_string(LPUART1, (unsigned char*)"Receiving your finger image ");
-		display_time();
-		LPUART_send_byte(LPUART1, 0x0A);
-	}while(sendFPCreateCharFile1(LPUART2, data_ack, CORE_CLOCK) != FINGERPRINT_OK);
-	LPUART_send_string(LPUART1, (unsigned char*)"Received your finger image");
-	display_time();
-	LPUART_send_byte(LPUART1, 0x0A);
-	
-	/* Step 3: Send Search instruction data */
-	LPUART_send_string(LPUART1, (unsigned char*)"Searching finger");
-	display_time();
-	GPIO_SetOutputPin(GPIOD, 1);
-	lcd_clear();
-	lcd_put_cur(0, 0);
-	lcd_send_string("SEARCHING");
-	LPUART_send_byte(LPUART1, 0x0A);
-	if(sendFPSearchFinger(LPUART2, data_ack, CORE_CLOCK) == FINGERPRINT_OK){
-		lcd_clear();
-		lcd_put_cur(0, 0);
-		lcd_send_string(name_user[data_ack[6]]);
-		GPIO_ResetOutputPin(GPIOD, 1);
-		display_time();
-		delay(1000, CORE_CLOCK);
-	}else{
-		lcd_clear();
-		lcd_put_cur(0, 0);
-		GPIO_SetOutputPin(GPIOD, 1);
-		lcd_send_string("NOT FOUND");
-		display_time();
-		delay(1000, CORE_CLOCK);		
+static void import_receive(unsigned char received){
+	provision_record_t record;
+	char name[USERS_NAME_LENGTH];
+	unsigned char status = Provision_Receive(received);
+	unsigned char applied = 1;
+
+	if (status == PROVISION_BATCH) {
+		while (Provision_NextRecord(&record)) {
+			if (assign_schedule(record.user_id, record.schedule) != ACCESS_OK) {
+				Sched_PostEvent(TASK_LOG, EVT_LOG_WORK);
+				import_finish(IMPORT_DONE_REJECTED);
+				return;
+			}
+			Users_GetName(record.user_id, name);
+			if ((memcmp(name, record.name, USERS_NAME_LENGTH) != 0) &&
+					(Users_SetName(record.user_id, record.name) != USERS_OK)) {
+				applied = 0;
+			}
+		}
+		if (applied) {
+			Provision_Accept();
+		}
+		Sched_PostEvent(TASK_LOG, EVT_LOG_WORK);
+		Sched_StartTimer(TASK_CONSOLE, EVT_CONSOLE_IDLE, IMPORT_IDLE_MS);
+	}
+	if ((status == PROVISION_BATCH) || (status == PROVISION_REPEAT) || (status == PROVISION_BAD)) {
+		LPUART_send_byte(LPUART1, ((status != PROVISION_BAD) && applied) ? PROVISION_REPLY_ACK : PROVISION_REPLY_NAK);
+		LPUART_send_byte(LPUART1, Provision_Sequence());
+	} else if (status == PROVISION_END) {
+		import_finish(IMPORT_DONE_OK);
+	} else if (status == PROVISION_END_BAD) {
+		import_finish(IMPORT_DONE_BAD);
 	}
 }
 
 /*!
- * @brief     Imports a fingerprint and stores it in the system.
- *
- * @detail    This function performs the following steps:
- *            1. Prompts the user to provide an ID for the fingerprint.
- *            2. Receives a fingerprint image and creates feature files.
- *            3. Receives the same fingerprint again to generate a template.
- *            4. Saves the fingerprint template to flash memory.
- *            5. Switches to name creation mode.
+ * @brief     Runs a complete admin frame.
  *
  * @param[in]  None
  * @return     void
  */
-void import_finger_print(){
-	LPUART_send_string(LPUART1, (unsigned char*)"Give ID to store finger");
-	LPUART_send_byte(LPUART1, 0x0A);
-	while(IDStore == 0){} /*Waiting receive data from uart*/
-	do{
-		
-		/* Step 1: Receive a fingerprint */
-		do{
-			LPUART_send_string(LPUART1, (unsigned char*)"Press your finger");
-			do{	
-				LPUART_send_string(LPUART1, (unsigned char*)".");
-			}while(sendFPGetImage(LPUART2, data_ack, CORE_CLOCK) != FINGERPRINT_OK);
-			LPUART_send_byte(LPUART1, 0x0A);
-			
-			/* Step 2: Generate features file 1*/
-			LPUART_send_string(LPUART1, (unsigned char*)"Creating Char File 1");
-			LPUART_send_byte(LPUART1, 0x0A);
-		}while(sendFPCreateCharFile1(LPUART2, data_ack, CORE_CLOCK) != FINGERPRINT_OK);
-		LPUART_send_string(LPUART1, (unsigned char*)"Created CHAR_FILE_1");
+static void admin_execute(){
+	rtc_time_t time;
+	unsigned char frame[TRACE_DUMP_HEADER];
+
+	if ((admin_cmd == ADMIN_CMD_SET_TIME) && (admin_len == 4U)) {
+		RTC_FromEpoch(admin_get_u32(0), &time);
+		RTC_SetTime(&time);
+		rtc_jobs_start();
+		display_time();
+		report_time();
+	} else if ((admin_cmd == ADMIN_CMD_GET_TIME) && (admin_len == 0U)) {
+		report_time();
+	} else if ((admin_cmd == ADMIN_CMD_SET_SCHEDULE) && (admin_len == 3U) &&
+			(assign_schedule(admin_get_u16(0), admin_payload[2]) == ACCESS_OK)) {
+		LPUART_send_string(LPUART1, (unsigned char*)"Schedule set");
 		LPUART_send_byte(LPUART1, 0x0A);
-		while(sendFPGetImage(LPUART2, data_ack, CORE_CLOCK) == FINGERPRINT_OK){
-			LPUART_send_string(LPUART1, (unsigned char*)"Remove your finger");
-			LPUART_send_byte(LPUART1, 0x0A);
+	} else if ((admin_cmd == ADMIN_CMD_EXPORT_LOG) && (admin_len == 8U) && !export_active) {
+		export_from = admin_get_u32(0);
+		export_to = admin_get_u32(4);
+		export_count = 0;
+		export_active = 1;
+		export_ordered = EventLog_Seek(&export_cursor, export_from);
+		Sched_PostEvent(TASK_CONSOLE, EVT_CONSOLE_EXPORT);
+	} else if ((admin_cmd == ADMIN_CMD_ENROLL) && (admin_len == 2U) &&
+			(admin_get_u16(0) > 0U) && (admin_get_u16(0) < fp_user_pages)) {
+		IDStore = (unsigned short)admin_get_u16(0);
+		set_finger_mode(IMPORT_FINGERPRINT_MODE);
+		Sched_PostEvent(TASK_SENSOR, EVT_FP_MODE);
+	} else if ((admin_cmd == ADMIN_CMD_EXPORT_USERS) && (admin_len == 0U) && !users_export_active) {
+		users_export_id = 0;
+		users_export_active = 1;
+		Provision_TxStart();
+		Sched_PostEvent(TASK_CONSOLE, EVT_CONSOLE_USERS);
+	} else if ((admin_cmd == ADMIN_CMD_IMPORT_USERS) && (admin_len == 0U)) {
+		import_active = 1;
+		Provision_RxStart();
+		Sched_StartTimer(TASK_CONSOLE, EVT_CONSOLE_IDLE, IMPORT_IDLE_MS);
+	} else if ((admin_cmd == ADMIN_CMD_TRACE) && (admin_len <= 1U) && !trace_dump_active) {
+		Trace_Freeze(1U);
+		users_send_frame(frame, Trace_DumpHeader(frame));
+		trace_dump_clear = (admin_len == 1U) && (admin_payload[0] == 1U);
+		trace_dump_index = 0;
+		trace_dump_active = 1;
+		Sched_PostEvent(TASK_CONSOLE, EVT_CONSOLE_TRACE);
+	} else if ((admin_cmd == ADMIN_CMD_LATENCY) && (admin_len == 0U)) {
+		report_latency();
+	} else if ((admin_cmd == ADMIN_CMD_HEADROOM) && (admin_len <= 1U)) {
+		report_headroom();
+#if PROBE_ENABLE
+		if ((admin_len == 1U) && (admin_payload[0] == 1U)) {
+			IsrStats_Reset();
 		}
-		/* Step 3: Receive a same fingerprint */
-		do{
-			LPUART_send_string(LPUART1, (unsigned char*)"Press your finger again (1)");
-			do{	
-				LPUART_send_string(LPUART1, (unsigned char*)".");
-			}while(sendFPGetImage(LPUART2, data_ack, CORE_CLOCK) != FINGERPRINT_OK);
-			LPUART_send_byte(LPUART1, 0x0A);
-			
-			/* Step 4: Generate features file 2*/
-			LPUART_send_string(LPUART1, (unsigned char*)"Creating Char File 2");
-			LPUART_send_byte(LPUART1, 0x0A);
-		}while(sendFPCreateCharFile2(LPUART2, data_ack, CORE_CLOCK) != FINGERPRINT_OK);
-		LPUART_send_string(LPUART1, (unsigned char*)"Created CHAR_FILE_2");
-		LPUART_send_byte(LPUART1, 0x0A);
-		while(sendFPGetImage(LPUART2, data_ack, CORE_CLOCK) == FINGERPRINT_OK){
-			LPUART_send_string(LPUART1, (unsigned char*)"Remove your finger");
-			LPUART_send_byte(LPUART1, 0x0A);
+#endif
+#if PROBE_ENABLE
+	} else if ((admin_cmd == ADMIN_CMD_PROFILE) && (admin_len <= 1U)) {
+		report_probes();
+		if ((admin_len == 1U) && (admin_payload[0] == 1U)) {
+			Probe_Reset();
 		}
-		/* Step 5: Compare char file 1 and char file 2 to generate the template file */
-		LPUART_send_string(LPUART1, (unsigned char*)"Creating template model");
+#endif
+	} else {
+		LPUART_send_string(LPUART1, (unsigned char*)"Bad command");
 		LPUART_send_byte(LPUART1, 0x0A);
-	}while(sendFPCreateTemplate(LPUART2, data_ack, CORE_CLOCK) != FINGERPRINT_OK);
-	LPUART_send_string(LPUART1, (unsigned char*)"Created TEMPLATE MODEL");
-	LPUART_send_byte(LPUART1, 0x0A);
-	
-	/* Step 6: Save the template file to AS608 FLASH */
-	do {
-		LPUART_send_string(LPUART1, (unsigned char*)"Storing");
-		LPUART_send_byte(LPUART1, 0x0A);
-	}while(SendStoreFinger(IDStore, LPUART2, data_ack, CORE_CLOCK) != FINGERPRINT_OK);
-	LPUART_send_string(LPUART1, (unsigned char*)"Storaged");
-	LPUART_send_byte(LPUART1, 0x0A);
-	/* Step 7: Switched to name creation mode */
-	finger_mode = CREATE_NEW_USER_NAME_MODE;		
+	}
 }
 
 /*!
- * @brief     Handles the number input mode for setting a name or performing actions.
+ * @brief     Feeds a console byte to the admin frame receiver.
  *
- * @detail    This function processes user inputs for setting a name, performing operations,
- *            and interacting with the fingerprint module based on the input value.
- *            
- *            Actions performed based on input values:
- *            - 0: No action.
- *            - 1-3: Add numbers 1-3 to the current position in the user name.
- *            - 4: Switch to a different mode (MODE = 1).
- *            - 5-7: Add numbers 4-6 to the current position in the user name.
- *            - 8: Add a space to the current position in the user name.
- *            - 9-11: Add numbers 7-9 to the current position in the user name.
- *            - 12: Clear the user name and reset cursor position.
- *            - 13: Clear all stored fingerprints.
- *            - 14: Add number 0 to the current position in the user name.
- *            - 15: Finalize name creation, switch to fingerprint search mode.
- *            - 16: Remove the last character from the user name.
+ * @detail    A frame that is not complete when the console goes idle is dropped, see
+ *            console_task(). A frame with a wrong checksum or a payload longer than
+ *            ADMIN_MAX_PAYLOAD is reported and ignored.
  *
- * @param[in]  None
+ * @param[in]  received The byte received.
  * @return     void
  */
-void keytap_number_mode(){
-	switch (value) {
-	case 0:
-		break;
-	case 1:
-		lcd_send_string("1");
-		name_user[IDStore][cursor_position] = '1';
-		cursor_position++;
-		break;
-	case 2:
-		lcd_send_string("2");
-		name_user[IDStore][cursor_position] = '2';
-		cursor_position++;
-		break;
-	case 3:
-		lcd_send_string("3");
-		name_user[IDStore][cursor_position] = '3';
-		cursor_position++;
-		break;
-	case 4:
-		MODE = 1;
-		break;
-	case 5:
-		lcd_send_string("4");
-		name_user[IDStore][cursor_position] = '4';
-		cursor_position++;
-		break;
-	case 6:
-		lcd_send_string("5");
-		name_user[IDStore][cursor_position] = '5';
-		cursor_position++;
-		break;
-	case 7:
-		lcd_send_string("6");
-		name_user[IDStore][cursor_position] = '6';
-		cursor_position++;
-		break;
-	case 8:
-		lcd_send_string(" ");
-		name_user[IDStore][cursor_position] = ' ';
-		cursor_position++;
-		break;
-	case 9:
-		lcd_send_string("7");
-		name_user[IDStore][cursor_position] = '7';
-		cursor_position++;
-		break;
-	case 10:
-		lcd_send_string("8");
-		name_user[IDStore][cursor_position] = '8';
-		cursor_position++;
+static void admin_receive(unsigned char received){
+	switch (admin_state) {
+	case ADMIN_CMD:
+		admin_cmd = received;
+		admin_sum = received;
+		admin_state = ADMIN_LEN;
 		break;
-	case 11:
-		lcd_send_string("9");
-		name_user[IDStore][cursor_position] = '9';
-		cursor_position++;
+	case ADMIN_LEN:
+		admin_len = received;
+		admin_count = 0;
+		admin_sum += received;
+		admin_state = (received > 0U) ? ADMIN_PAYLOAD : ADMIN_CSUM;
 		break;
-	case 12:
-		lcd_clear();
-		cursor_position = 0;
-		for(unsigned char i = 0; i < MAX_NAME_LENGTH; i++){
-			name_user[IDStore][i] = '\0';
+	case ADMIN_PAYLOAD:
+		if (admin_count < ADMIN_MAX_PAYLOAD) {
+			admin_payload[admin_count] = received;
 		}
-		lcd_put_cur(0,0);
-		break;
-	case 13:
-		if(sendFPDeleteAllFinger(LPUART2, data_ack, CORE_CLOCK) == FINGERPRINT_OK){
-			lcd_clear();
-			lcd_put_cur(0, 0);
-			lcd_send_string("CLEAR ALL FINGER");
-			delay(1000, CORE_CLOCK);
-			lcd_clear();
-			lcd_put_cur(0, 0);
+		admin_count++;
+		admin_sum += received;
+		if (admin_count == admin_len) {
+			admin_state = ADMIN_CSUM;
 		}
 		break;
-	case 14:
-		lcd_send_string("0");
-		name_user[IDStore][cursor_position] = '0';
-		cursor_position++;
-		break;
-	case 15:
-		IDStore = 0;
-		lcd_clear();
-		lcd_put_cur(0, 0);
-		lcd_send_string("CREATED NAME");
-		delay(1000, CORE_CLOCK);
-		lcd_clear();
-		lcd_put_cur(0, 0);
-		finger_mode = SEARCH_FINGERPRINT_MODE;
-		break;
-	case 16:
-		cursor_position--;
-		name_user[IDStore][cursor_position] = '\0';
-		lcd_send_cmd(0x80 | cursor_position);
-		lcd_send_string(" "); 
-		lcd_send_cmd(0x80 | cursor_position);
+	case ADMIN_CSUM:
+		admin_state = ADMIN_IDLE;
+		if ((received != admin_sum) || (admin_len > ADMIN_MAX_PAYLOAD)) {
+			LPUART_send_string(LPUART1, (unsigned char*)"Bad frame");
+			LPUART_send_byte(LPUART1, 0x0A);
+		} else {
+			admin_execute();
+		}
 		break;
 	default:
-		// Handle unexpected values
-		lcd_send_string("Invalid");
+		admin_state = ADMIN_IDLE;
 		break;
 	}
 }
 
 /*!
- * @brief     Handles character input mode for setting a name.
+ * @brief     Console task: interprets the bytes received on LPUART1.
  *
- * @detail    This function processes user inputs for setting a name based on the button press
- *            count. It maps button press counts to specific characters and updates the display
- *            and user name accordingly.
- *            
- *            Actions performed based on input values:
- *            - 0: No action.
- *            - 1: Add characters A, B, or C based on button press count.
- *            - 2: Add characters C or D based on button press count.
- *            - 3: Add characters E or G based on button press count.
- *            - 4: Switch to number mode (MODE = 0).
- *            - 5: Add characters H or I based on button press count.
- *            - 6: Add characters K or L based on button press count.
- *            - 7: Add characters M or N based on button press count.
- *            - 8: Add a space to the current position in the user name.
- *            - 9: Add characters O or P based on button press count.
- *            - 10: Add characters Q or R based on button press count.
- *            - 11: Add characters S or T based on button press count.
- *            - 12: Clear the user name and reset cursor position.
- *            - 13: Add characters U or V based on button press count.
- *            - 14: Add characters X or Y based on button press count.
- *            - 15: Finalize name creation, switch to fingerprint search mode.
- *            - 16: Remove the last character from the user name.
+ * @detail    A byte from 1 to 98 that is also below fp_user_pages is the ID under which the
+ *            next fingerprint is enrolled and starts the enrollment; a byte in that range on a
+ *            hot or missing page is refused with "Bad ID", and larger IDs take
+ *            ADMIN_CMD_ENROLL. A byte above 99 switches to fingerprint search and
+ *            CONSOLE_CMD_POWER prints the idle statistics. CONSOLE_ADMIN_START (99) starts an
+ *            admin frame, see admin_receive(). VLPS is held off until no byte has arrived for
+ *            CONSOLE_IDLE_MS, which also drops an unfinished admin frame; the byte that wakes
+ *            the board from VLPS is lost, so a host sends a dummy byte first after a long
+ *            silence. EVT_CONSOLE_EXPORT sends the next records of a log export,
+ *            EVT_CONSOLE_USERS the next batch of a directory export and EVT_CONSOLE_TRACE the
+ *            next records of a trace dump. During a directory import every byte goes to
+ *            import_receive() and the idle time is IMPORT_IDLE_MS, after which the import is
+ *            closed as IMPORT_DONE_TIMEOUT.
  *
- * @param[in]  None
+ * @param[in]  events Events posted to the task.
  * @return     void
  */
-void keytap_character_mode(){
-	switch (value) {
-	case 0:
-			break;
-	case 1:
-		button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1){
-			lcd_send_string("A");
-			name_user[IDStore][cursor_position] = 'A';
-		}
-		else if (button_press_count == 2) {
-			lcd_send_string("B");
-			name_user[IDStore][cursor_position] = 'B';
-		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 2:
-		 button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1) {
-			lcd_send_string("C");
-			name_user[IDStore][cursor_position] = 'C';
-		}
-		else if (button_press_count == 2) {
-			lcd_send_string("D");
-			name_user[IDStore][cursor_position] = 'D';
-		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 3:
-		button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1) {
-			lcd_send_string("E");
-			name_user[IDStore][cursor_position] = 'E';
-		}
-		else if (button_press_count == 2) {
-			lcd_send_string("G");
-			name_user[IDStore][cursor_position] = 'G';
-		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 4:
-			MODE = 0;
-			break;
-	case 5:
-	 button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1) {
-			lcd_send_string("H");
-			name_user[IDStore][cursor_position] = 'H';
-		}
-		else if (button_press_count == 2) {
-			lcd_send_string("I");
-			name_user[IDStore][cursor_position] = 'I';
-		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 6:
-	 button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1) {
-			lcd_send_string("K");
-			name_user[IDStore][cursor_position] = 'K';
-		}
-		else if (button_press_count == 2) {
-			lcd_send_string("L");
-			name_user[IDStore][cursor_position] = 'L';
-		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 7:
-		button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1){
-			lcd_send_string("M");
-			name_user[IDStore][cursor_position] = 'M';
-		}
-		else if (button_press_count == 2) {
-			lcd_send_string("N");
-			name_user[IDStore][cursor_position] = 'N';
-		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 8:
-		lcd_send_string(" ");
-		name_user[IDStore][cursor_position] = ' ';
-		cursor_position++;
-		break;
-	case 9:
-		 button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1) {
-			lcd_send_string("O");
-			name_user[IDStore][cursor_position] = 'O';
-		}
-		else if (button_press_count == 2) {
-			name_user[IDStore][cursor_position] = 'P';
-			lcd_send_string("P");
-		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 10:
-		button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1) {
-			lcd_send_string("Q");
-			name_user[IDStore][cursor_position] = 'Q';
-		}
-		else if (button_press_count == 2){ 
-			lcd_send_string("R");
-			name_user[IDStore][cursor_position] = 'R';
-		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 11:
-		 button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1) {
-			lcd_send_string("S");
-			name_user[IDStore][cursor_position] = 'S';
-		}
-		else if (button_press_count == 2) {
-			lcd_send_string("T");
-			name_user[IDStore][cursor_position] = 'T';
-		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 12:
-		lcd_clear();
-		cursor_position = 0;
-		for(unsigned char i = 0; i < MAX_NAME_LENGTH; i++){
-			name_user[IDStore][i] = '\0';
-		}
-		lcd_put_cur(0,0);
-		break;
-	case 13:
-	button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
-		}
-		if (button_press_count == 1) {
-			lcd_send_string("U");
-			name_user[IDStore][cursor_position] = 'U';
-		}
-		else if (button_press_count == 2) {
-			lcd_send_string("V");
-			name_user[IDStore][cursor_position] = 'V';
+void console_task(unsigned int events){
+	unsigned char received;
+
+	if (events & EVT_CONSOLE_IDLE) {
+		Power_Release(POWER_HOLD_CONSOLE);
+		admin_state = ADMIN_IDLE;
+		if (import_active) {
+			import_finish(IMPORT_DONE_TIMEOUT);
 		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 14:
-			button_press_count++;
-		delay(500, CORE_CLOCK);
-		if (check_but() == 1){	
-					button_press_count++;
+	}
+	if (events & EVT_CONSOLE_RX) {
+		Power_Hold(POWER_HOLD_CONSOLE);
+		Sched_StartTimer(TASK_CONSOLE, EVT_CONSOLE_IDLE, import_active ? IMPORT_IDLE_MS : CONSOLE_IDLE_MS);
+	}
+	if ((events & EVT_CONSOLE_EXPORT) && export_active) {
+		export_run();
+	}
+	if ((events & EVT_CONSOLE_USERS) && users_export_active) {
+		users_export_run();
+	}
+	if ((events & EVT_CONSOLE_TRACE) && trace_dump_active) {
+		trace_dump_run();
+	}
+	while (console_rx_tail != console_rx_head) {
+		received = console_rx[console_rx_tail];
+		console_rx_tail = (console_rx_tail + 1) & (CONSOLE_RX_SIZE - 1);
+		if (import_active) {
+			import_receive(received);
+		} else if (admin_state != ADMIN_IDLE) {
+			admin_receive(received);
+		} else if (received == CONSOLE_ADMIN_START) {
+			admin_state = ADMIN_CMD;
+		} else if ((received > 0) && (received < 99) && (received < fp_user_pages)) {
+			IDStore = received;
+			set_finger_mode(IMPORT_FINGERPRINT_MODE);
+			Sched_PostEvent(TASK_SENSOR, EVT_FP_MODE);
+		} else if ((received > 0) && (received < 99)) {
+			LPUART_send_string(LPUART1, (unsigned char*)"Bad ID");
+			LPUART_send_byte(LPUART1, 0x0A);
+		} else if (received > 99) {
+			set_finger_mode(SEARCH_FINGERPRINT_MODE);
+			Sched_PostEvent(TASK_SENSOR, EVT_FP_MODE);
+		} else if (received == CONSOLE_CMD_POWER) {
+			report_power();
 		}
-		if (button_press_count == 1) {
-			lcd_send_string("X");
-			name_user[IDStore][cursor_position] = 'X';
+	}
+}
+
+/*!
+ * @brief     RTC task: refreshes the clock on the LCD every second and runs the daily relock.
+ *
+ * @detail    EVT_RTC_RELOCK closes the door whatever the lock thread is doing and schedules
+ *            the relock of the next day.
+ *
+ * @param[in]  events Events posted to the task.
+ * @return     void
+ */
+void rtc_task(unsigned int events){
+	if (events & EVT_RTC_SECOND) {
+		display_time();
+	}
+	if (events & EVT_RTC_RELOCK) {
+		Kernel_FlagsSet(&lock_flags, LOCK_EVT_LOCK);
+		RTC_AlarmSet(RTC_JOB_RELOCK, rtc_next_daily(AUTO_RELOCK_HOUR, AUTO_RELOCK_MINUTE));
+	}
+}
+
+/*!
+ * @brief     LCD task: initializes the LCD, then sends the changed part of the frame buffer.
+ *
+ * @detail    The LCD initialization commands are sent one per EVT_LCD_INIT, each one timed
+ *            after the wait the previous one needs, so the other tasks run during the LCD
+ *            power-up. The frame buffer is flushed once the sequence is complete; a flush that
+ *            writes characters is traced.
+ *
+ * @param[in]  events Events posted to the task.
+ * @return     void
+ */
+void lcd_task(unsigned int events){
+	unsigned int wait_ms;
+	unsigned int written;
+
+	if (events & EVT_LCD_INIT) {
+		wait_ms = lcd_init_step();
+		if (wait_ms != LCD_INIT_DONE) {
+			Sched_StartTimer(TASK_LCD, EVT_LCD_INIT, wait_ms);
+		} else {
+			lcd_ready = 1;
+			boot_mark(BOOT_PHASE_LCD);
+			events |= EVT_LCD_DIRTY;
 		}
-		else if (button_press_count == 2) {
-			lcd_send_string("Y");
-			name_user[IDStore][cursor_position] = 'Y';
+	}
+	if ((events & EVT_LCD_DIRTY) && lcd_ready) {
+		PROBE_BEGIN(PROBE_LCD_FLUSH);
+		written = lcd_fb_flush();
+		PROBE_END(PROBE_LCD_FLUSH);
+		if (written != 0U) {
+			Trace_Record(TRACE_LCD_FLUSH, 0U, (unsigned short)written);
 		}
-		button_press_count = 0;
-		cursor_position++;
-		break;
-	case 15:
-		IDStore = 0;
-		lcd_clear();
-		lcd_put_cur(0, 0);
-		lcd_send_string("CREATED NAME");
-		delay(1000, CORE_CLOCK);
-		lcd_clear();
-		lcd_put_cur(0, 0);
-		finger_mode = SEARCH_FINGERPRINT_MODE;
-		break;
-	case 16:
-		cursor_position--;
-		name_user[IDStore][cursor_position] = '\0';
-		lcd_send_cmd(0x80 | cursor_position);
-		lcd_send_string(" "); 
-		lcd_send_cmd(0x80 | cursor_position);
-		break;
 	}
 }
 
 /*!
- * @brief     Handles keytap input based on the current mode (number or character).
+ * @brief     Log task: programs the staged event log records into the flash.
  *
- * @detail    This function checks the current mode to determine if the system is in
- *            number or character input mode. It updates the state of an output pin
- *            (GPIOD, pin 15) based on the mode, processes the keypress, and updates
- *            the display and user name as needed. If the cursor position exceeds a
- *            certain limit, it clears the display and resets the user name.
- *            
- *            - If in number mode, sets an output pin high.
- *            - If in character mode, sets the output pin low.
- *            - Calls the appropriate function to handle key input based on the mode.
- *            - Clears the LCD and resets the user name if cursor position exceeds 16.
- *            
- * @param[in]  None
+ * @detail    Runs one step of the log writer per flash command; VLPS is held off while a
+ *            command runs. Also runs the compaction of the user database one step per call,
+ *            posting itself EVT_LOG_WORK until it is done. A sector erase waits for
+ *            users_may_erase(): the task polls every USERS_ERASE_WAIT_MS while the sensor or
+ *            the lock is busy, and backs off USERS_ERASE_RETRY_MS after a failed erase.
+ *
+ * @param[in]  events Events posted to the task.
  * @return     void
  */
-void handle_keytap(){
-	if(MODE == KEYTAP_NUMBER_MODE){
-		GPIO_SetOutputPin(GPIOD, 15);
-	}	
-	else {
-		GPIO_ResetOutputPin(GPIOD, 15);
-	}
-	value = get_key();
-	if (MODE == KEYTAP_NUMBER_MODE){
-		keytap_number_mode();
+void log_task(unsigned int events){
+	unsigned char busy;
+	unsigned char work;
+
+	if (events & EVT_LOG_FLUSH) {
+		EventLog_Flush();
 	}
-	else if(MODE == KEYTAP_CHARACTER_MODE) {
-		keytap_character_mode();
+	if (events & EVT_LOG_RETRY) {
+		users_erase_backoff = 0;
 	}
-	if(cursor_position > 16)
-	{
-		lcd_clear();
-		cursor_position = 0;
-		lcd_put_cur(0,0);
-		for(unsigned char i = 0; i < MAX_NAME_LENGTH; i++){
-			name_user[IDStore][i] = '\0';
+	busy = EventLog_Service();
+	work = Users_Service(users_may_erase());
+	if (work == USERS_SERVICE_MORE) {
+		users_erase_failures = 0;
+		busy = 1;
+		Sched_PostEvent(TASK_LOG, EVT_LOG_WORK);
+	} else if (work == USERS_SERVICE_FAILED) {
+		if (++users_erase_failures < USERS_ERASE_RETRIES) {
+			users_erase_backoff = 1;
+			Sched_StartTimer(TASK_LOG, EVT_LOG_RETRY, USERS_ERASE_RETRY_MS);
 		}
+	} else if ((work == USERS_SERVICE_ERASE) && !users_erase_backoff &&
+			(users_erase_failures < USERS_ERASE_RETRIES)) {
+		Sched_StartTimer(TASK_LOG, EVT_LOG_RETRY, USERS_ERASE_WAIT_MS);
+	}
+	if (busy) {
+		Power_Hold(POWER_HOLD_FLASH);
+	} else {
+		Power_Release(POWER_HOLD_FLASH);
 	}
 }
 
@@ -1492,3 +3037,33 @@ void config_PTC15(){
 
 }
 
+
+/**********************************************************************************************
+ * @brief    Configures port C3 (PTC3) for the touch output of the fingerprint sensor.
+ * 
+ * @detail   This function sets up port C3 as a general-purpose input with an interrupt on the
+ *           rising edge, raised when a finger is placed on the sensor.
+ *           
+ *           - `IQRC` is set to 0x9 (interrupt on rising edge).
+ *           - `MUX` is set to 1 (GPIO function).
+ *           - `PullEnable` is set to 1 (enable pull resistor).
+ *           - `PullUpDown` is set to 0 (pull-down, the line idles low).
+ *
+ * @param     None
+ * @return    void
+ */
+void config_PTC3(){
+	Port_Mode_t config_Port = {
+		.IQRC = 0x9,
+		.MUX = 1,
+		.PullEnable = 1,
+		.PullUpDown = 0,
+	};
+	Gpio_ConfigType config_GPIO = {
+		.base = GPIOC,
+		.GPIO_PinMode = 0,
+		.GPIO_PinNumber = FP_TOUCH_PIN,
+	};
+	Gpio_Init(&config_GPIO);
+	Port_Init(PORTC, FP_TOUCH_PIN, config_Port);
+}
@@ -3,12 +3,134 @@
 ==================================================================================================*/
 
 #include "RTC.h"
+#include "core.h"
 
 /*==================================================================================================
 *                                      DEFINES AND MACROS
 ==================================================================================================*/
 
+#ifdef HOST_BUILD
+extern unsigned int host_sim_lpoclks;
+#define SIM_LPOCLKS host_sim_lpoclks
+#else
 #define SIM_LPOCLKS (*(unsigned int*)(0x40048000u + 0x10))
+#endif
+
+#define RTC_SECONDS_PER_DAY 86400U
+#define RTC_EPOCH_WEEKDAY   4U          /* 1970-01-01 was a Thursday */
+
+/* RTC_SR and RTC_IER bits */
+#define RTC_SR_TIF          (1U << 0)   /* Time invalid, set by a power-on reset */
+#define RTC_SR_TCE          (1U << 4)   /* Time counter enable */
+#define RTC_IER_TAIE        (1U << 2)   /* Time alarm interrupt enable */
+#define RTC_IER_TSIE        (1U << 4)   /* Time seconds interrupt enable */
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+/* Days of each month in a common year */
+static const unsigned char rtc_month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+static rtc_time_t rtc_now = {RTC_EPOCH_YEAR, 1, 1, RTC_EPOCH_WEEKDAY, 0, 0, 0};
+static unsigned int rtc_last_tsr = 0;           /* TSR value rtc_now corresponds to */
+static volatile unsigned char rtc_dirty = 1;    /* rtc_now changed since the last RTC_GetTime() */
+static volatile unsigned char rtc_hour_of_week = 0; /* rtc_now.weekday * 24 + rtc_now.hour */
+static unsigned int rtc_alarm_at[RTC_ALARM_SLOTS];  /* Epoch of each alarm, RTC_ALARM_OFF if unused */
+
+/*==================================================================================================
+*                                       LOCAL FUNCTIONS
+==================================================================================================*/
+/**
+ * @brief     Tells whether a year is a leap year.
+ */
+static unsigned char rtc_is_leap(unsigned int year)
+{
+    return (((year % 4U) == 0U) && (((year % 100U) != 0U) || ((year % 400U) == 0U))) ? 1U : 0U;
+}
+
+/**
+ * @brief     Returns the number of days of a month (1 to 12) of a year.
+ */
+static unsigned char rtc_days_in_month(unsigned int year, unsigned char month)
+{
+    if((month == 2U) && rtc_is_leap(year))
+    {
+        return 29U;
+    }
+    return rtc_month_days[month - 1U];
+}
+
+/**
+ * @brief     Programs TAR for the earliest pending alarm.
+ *
+ * @details   The alarm flag is set when TSR increments from the TAR value, so TAR is the
+ *            second before the alarm; an alarm already due fires on the next second. The
+ *            interrupt is disabled when no alarm is pending. Called with interrupts masked.
+ */
+static void rtc_alarm_program(void)
+{
+    unsigned int earliest = RTC_ALARM_OFF;
+    unsigned int tsr = RTC->TSR;
+    unsigned char slot;
+
+    for(slot = 0U; slot < RTC_ALARM_SLOTS; slot++)
+    {
+        if(rtc_alarm_at[slot] < earliest)
+        {
+            earliest = rtc_alarm_at[slot];
+        }
+    }
+    if(earliest == RTC_ALARM_OFF)
+    {
+        RTC->IER &= ~RTC_IER_TAIE;
+        return;
+    }
+    RTC->TAR = ((earliest - 1U) > tsr) ? (earliest - 1U) : tsr;  /* Also clears the alarm flag */
+    RTC->IER |= RTC_IER_TAIE;
+}
+
+/**
+ * @brief     Adds one second to rtc_now.
+ *
+ * @details   Each field only carries into the next one when it wraps, so a call is a few
+ *            compares and increments; the date fields are touched once a day.
+ */
+static void rtc_increment(void)
+{
+    if(++rtc_now.second < 60U)
+    {
+        return;
+    }
+    rtc_now.second = 0;
+    if(++rtc_now.minute < 60U)
+    {
+        return;
+    }
+    rtc_now.minute = 0;
+    if(++rtc_now.hour < 24U)
+    {
+        rtc_hour_of_week++;
+        return;
+    }
+    rtc_now.hour = 0;
+    if(++rtc_now.weekday >= 7U)
+    {
+        rtc_now.weekday = 0;
+    }
+    rtc_hour_of_week = rtc_now.weekday * 24U;
+    if(++rtc_now.day <= rtc_days_in_month(rtc_now.year, rtc_now.month))
+    {
+        return;
+    }
+    rtc_now.day = 1;
+    if(++rtc_now.month <= 12U)
+    {
+        return;
+    }
+    rtc_now.month = 1;
+    rtc_now.year++;
+}
 
 /*==================================================================================================
 *                                       GLOBAL FUNCTIONS
@@ -18,10 +140,16 @@
  *
  * @details   This function configures the RTC module, including selecting the 32kHz LPO clock
  *            for the RTC, resetting various registers, and enabling the RTC module.
+ *
+ *            TSR counts epoch seconds. The RTC is only reset by a power-on reset, which sets
+ *            the time invalid flag: the counter then restarts from 0 (1970, see
+ *            RTC_IsTimeValid()). After a warm reset the counter is still running and is kept,
+ *            and the calendar is rebuilt from it.
  */
 void RTC_init(void)
 {
     unsigned int sim_lpoclks_mask = 0;
+    unsigned char slot;
 
     /* Select 32kHz LPO clock for RTC_CLK */
     sim_lpoclks_mask = SIM_LPOCLKS;
@@ -29,21 +157,253 @@ void RTC_init(void)
     sim_lpoclks_mask |= (1 << 1);
     SIM_LPOCLKS = sim_lpoclks_mask;  /* Write to LPO clock select register */
 
-    /* RTC Initialization */
-    RTC->SR &= ~(1 << 4);     /* Disable RTC module */
-    RTC->TPR = 0;             /* Reset Time Prescaler Register */
-    RTC->TSR = 0;             /* Start count from 0 */
+    if((RTC->SR & RTC_SR_TIF) || !(RTC->SR & RTC_SR_TCE))
+    {
+        /* RTC Initialization */
+        RTC->SR &= ~RTC_SR_TCE;   /* Disable RTC module */
+        RTC->TPR = 0;             /* Reset Time Prescaler Register */
+        RTC->TSR = 0;             /* Start count from 0, clears the time invalid flag */
 
-    /* Configure RTC */
-    RTC->TCR = 0;             /* Set time compensation to 0 */
-    RTC->CR |= (0 << 7);      /* Use RTC_CLK instead of LPO */
-    RTC->CR |= (1 << 5);      /* Select TSIC output for RTC_CLKOUT */
+        /* Configure RTC */
+        RTC->TCR = 0;             /* Set time compensation to 0 */
+        RTC->CR |= (0 << 7);      /* Use RTC_CLK instead of LPO */
+        RTC->CR |= (1 << 5);      /* Select TSIC output for RTC_CLKOUT */
+    }
 
     RTC->IER &= ~(1 << 16);   /* Disable 1Hz output */
     RTC->IER &= ~(1 << 17);   /* Disable 1Hz output */
     RTC->IER &= ~(1 << 18);   /* Disable 1Hz output */
-    RTC->IER |= (1 << 4);     /* Enable alarm interrupt */
+    RTC->IER &= ~RTC_IER_TAIE;    /* No alarm until RTC_AlarmSet() */
+    RTC->IER |= RTC_IER_TSIE;     /* Enable seconds interrupt */
+
+    for(slot = 0U; slot < RTC_ALARM_SLOTS; slot++)
+    {
+        rtc_alarm_at[slot] = RTC_ALARM_OFF;
+    }
 
     /* Enable RTC module */
-    RTC->SR |= (1 << 4);
+    RTC->SR |= RTC_SR_TCE;
+
+    rtc_last_tsr = RTC->TSR;
+    RTC_FromEpoch(rtc_last_tsr, &rtc_now);
+    rtc_hour_of_week = (rtc_now.weekday * 24U) + rtc_now.hour;
+    rtc_dirty = 1;
+}
+
+/**
+ * @brief     Sets the calendar time.
+ *
+ * @details   The epoch of the time is written to the RTC seconds counter, where it survives
+ *            warm resets; the weekday is derived from the date. Pending alarms keep their
+ *            epoch; those that are now in the past fire on the next second.
+ *
+ * @param[in] time: New calendar time.
+ */
+void RTC_SetTime(const rtc_time_t *time)
+{
+    unsigned int primask;
+    unsigned int epoch = RTC_ToEpoch(time);
+    rtc_time_t set;
+
+    RTC_FromEpoch(epoch, &set);
+    CORE_ENTER_CRITICAL(primask);
+    RTC->SR &= ~RTC_SR_TCE;   /* TSR is only writable with the counter stopped */
+    RTC->TPR = 0;
+    RTC->TSR = epoch;
+    RTC->SR |= RTC_SR_TCE;
+    rtc_now = set;
+    rtc_last_tsr = epoch;
+    rtc_hour_of_week = (set.weekday * 24U) + set.hour;
+    rtc_dirty = 1;
+    rtc_alarm_program();
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/**
+ * @brief     Tells whether the time was set since the last power-on reset.
+ *
+ * @return    1 when the time is valid, 0 while it still counts from 1970.
+ */
+unsigned char RTC_IsTimeValid(void)
+{
+    return (RTC->TSR >= RTC_VALID_EPOCH) ? 1U : 0U;
+}
+
+/**
+ * @brief     Reads the calendar time.
+ *
+ * @param[out] time: Current calendar time.
+ * @return    1 when the time changed since the previous call, 0 otherwise.
+ */
+unsigned char RTC_GetTime(rtc_time_t *time)
+{
+    unsigned int primask;
+    unsigned char changed;
+
+    CORE_ENTER_CRITICAL(primask);
+    *time = rtc_now;
+    changed = rtc_dirty;
+    rtc_dirty = 0;
+    CORE_EXIT_CRITICAL(primask);
+    return changed;
+}
+
+/**
+ * @brief     Advances the calendar to the RTC seconds counter.
+ *
+ * @details   Called by the RTC seconds interrupt. Normally the counter moved by one second;
+ *            seconds missed while the interrupt was masked are caught up one by one.
+ */
+void RTC_Tick(void)
+{
+    unsigned int tsr = RTC->TSR;
+
+    while(rtc_last_tsr != tsr)
+    {
+        rtc_last_tsr++;
+        rtc_increment();
+    }
+    rtc_dirty = 1;
+}
+
+/**
+ * @brief     Returns the hour of the week.
+ *
+ * @details   Kept up to date by the seconds interrupt, so reading it costs a single load.
+ *
+ * @return    Weekday * 24 + hour, Sunday = 0.
+ */
+unsigned char RTC_GetHourOfWeek(void)
+{
+    return rtc_hour_of_week;
+}
+
+/**
+ * @brief     Returns the current time in epoch seconds.
+ */
+unsigned int RTC_GetEpoch(void)
+{
+    unsigned int primask;
+    rtc_time_t time;
+
+    CORE_ENTER_CRITICAL(primask);
+    time = rtc_now;
+    CORE_EXIT_CRITICAL(primask);
+    return RTC_ToEpoch(&time);
+}
+
+/**
+ * @brief     Converts a calendar time to epoch seconds.
+ *
+ * @param[in] time: Calendar time, from 1970 to 2105; the weekday field is ignored.
+ * @return    Seconds since 1970-01-01 00:00:00.
+ */
+unsigned int RTC_ToEpoch(const rtc_time_t *time)
+{
+    unsigned int year = time->year;
+    unsigned int days;
+    unsigned char month;
+
+    /* Days before the year: 365 per year plus one per leap year since 1970 */
+    days = (year - RTC_EPOCH_YEAR) * 365U
+         + ((year - 1969U) / 4U) - ((year - 1901U) / 100U) + ((year - 1601U) / 400U);
+    for(month = 1U; month < time->month; month++)
+    {
+        days += rtc_days_in_month(year, month);
+    }
+    days += time->day - 1U;
+    return (days * RTC_SECONDS_PER_DAY) + (time->hour * 3600U) + (time->minute * 60U) + time->second;
+}
+
+/**
+ * @brief     Converts epoch seconds to a calendar time.
+ *
+ * @param[in]  epoch: Seconds since 1970-01-01 00:00:00.
+ * @param[out] time: Calendar time.
+ */
+void RTC_FromEpoch(unsigned int epoch, rtc_time_t *time)
+{
+    unsigned int days = epoch / RTC_SECONDS_PER_DAY;
+    unsigned int rem = epoch % RTC_SECONDS_PER_DAY;
+    unsigned int year = RTC_EPOCH_YEAR;
+    unsigned char month = 1U;
+
+    time->hour = (unsigned char)(rem / 3600U);
+    rem %= 3600U;
+    time->minute = (unsigned char)(rem / 60U);
+    time->second = (unsigned char)(rem % 60U);
+    time->weekday = (unsigned char)((days + RTC_EPOCH_WEEKDAY) % 7U);
+
+    while(days >= (365U + rtc_is_leap(year)))
+    {
+        days -= 365U + rtc_is_leap(year);
+        year++;
+    }
+    while(days >= rtc_days_in_month(year, month))
+    {
+        days -= rtc_days_in_month(year, month);
+        month++;
+    }
+    time->year = (unsigned short)year;
+    time->month = month;
+    time->day = (unsigned char)(days + 1U);
+}
+
+/**
+ * @brief     Sets an alarm.
+ *
+ * @details   The alarm interrupt is raised at the given epoch second, also in VLPS, and
+ *            RTC_AlarmService() then reports the slot. Setting a slot again replaces its alarm.
+ *
+ * @param[in] slot: Alarm slot, below RTC_ALARM_SLOTS.
+ * @param[in] epoch: Epoch second of the alarm.
+ */
+void RTC_AlarmSet(unsigned char slot, unsigned int epoch)
+{
+    unsigned int primask;
+
+    CORE_ENTER_CRITICAL(primask);
+    rtc_alarm_at[slot] = epoch;
+    rtc_alarm_program();
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/**
+ * @brief     Cancels an alarm.
+ *
+ * @param[in] slot: Alarm slot, below RTC_ALARM_SLOTS.
+ */
+void RTC_AlarmCancel(unsigned char slot)
+{
+    unsigned int primask;
+
+    CORE_ENTER_CRITICAL(primask);
+    rtc_alarm_at[slot] = RTC_ALARM_OFF;
+    rtc_alarm_program();
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/**
+ * @brief     Collects the due alarms; called by the RTC alarm interrupt.
+ *
+ * @details   The due alarms are cleared and TAR is programmed for the next one.
+ *
+ * @return    Bit mask of the slots whose alarm is due.
+ */
+unsigned int RTC_AlarmService(void)
+{
+    unsigned int tsr = RTC->TSR;
+    unsigned int due = 0;
+    unsigned char slot;
+
+    for(slot = 0U; slot < RTC_ALARM_SLOTS; slot++)
+    {
+        if(rtc_alarm_at[slot] <= tsr)
+        {
+            rtc_alarm_at[slot] = RTC_ALARM_OFF;
+            due |= (1U << slot);
+        }
+    }
+    rtc_alarm_program();
+    return due;
 }
@@ -0,0 +1,163 @@
+/**
+*   @file    access.c
+*   @brief   Implementation of the per-user weekly access schedules.
+*   @details The bitmaps are compiled when a schedule is defined, never when a match is
+*            checked: Access_IsAllowed() runs in the LPUART2 interrupt on the unlock path.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "access.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define ACCESS_HOURS_PER_DAY    24U
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static unsigned char schedules[ACCESS_MAX_SCHEDULES][ACCESS_BITMAP_BYTES];
+static unsigned char user_schedule[ACCESS_MAX_USERS];
+
+/*==================================================================================================
+*                                       LOCAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Sets the slots of one window in a bitmap.
+ *
+ * @param[in]  bitmap Bitmap of a schedule.
+ * @param[in]  window Window to add.
+ * @return    void
+ */
+static void access_add_window(unsigned char *bitmap, const access_window_t *window){
+    unsigned int span;
+    unsigned int day;
+    unsigned int hour;
+    unsigned int slot;
+
+    span = (window->end_hour + ACCESS_HOURS_PER_DAY - window->start_hour) % ACCESS_HOURS_PER_DAY;
+    if((span == 0U) && (window->end_hour != window->start_hour)){
+        span = ACCESS_HOURS_PER_DAY;    /* 0 to 24 */
+    }
+    for(day = 0U; day < 7U; day++){
+        if((window->days & (1U << day)) == 0U){
+            continue;
+        }
+        slot = (day * ACCESS_HOURS_PER_DAY) + window->start_hour;
+        for(hour = 0U; hour < span; hour++){
+            bitmap[slot >> 3] |= (unsigned char)(1U << (slot & 7U));
+            slot = (slot + 1U) % ACCESS_HOURS_PER_WEEK;  /* Saturday night spans into Sunday */
+        }
+    }
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Initializes the access schedules.
+ *
+ * @detail    Defines ACCESS_SCHEDULE_ALWAYS and ACCESS_SCHEDULE_NEVER and gives every user
+ *            ACCESS_SCHEDULE_NEVER, so that a user whose schedule is not known cannot enter.
+ *            The other schedules start empty.
+ *
+ * @return    void
+ */
+void Access_Init(void){
+    static const access_window_t always = {ACCESS_EVERY_DAY, 0U, 24U};
+    unsigned int i;
+
+    for(i = 0U; i < sizeof(schedules); i++){
+        ((unsigned char *)schedules)[i] = 0U;
+    }
+    for(i = 0U; i < ACCESS_MAX_USERS; i++){
+        user_schedule[i] = ACCESS_SCHEDULE_NEVER;
+    }
+    (void)Access_DefineSchedule(ACCESS_SCHEDULE_ALWAYS, &always, 1U);
+}
+
+/*!
+ * @brief     Compiles a schedule from its access windows.
+ *
+ * @param[in]  schedule Schedule to define, below ACCESS_MAX_SCHEDULES.
+ * @param[in]  windows Access windows, they may overlap.
+ * @param[in]  count Number of windows, 0 for a schedule that never allows access.
+ * @return    ACCESS_OK, or ACCESS_INVALID if an argument is out of range.
+ */
+unsigned char Access_DefineSchedule(unsigned char schedule, const access_window_t *windows,
+                                    unsigned char count){
+    unsigned char bitmap[ACCESS_BITMAP_BYTES] = {0};
+    unsigned int i;
+
+    if(schedule >= ACCESS_MAX_SCHEDULES){
+        return ACCESS_INVALID;
+    }
+    for(i = 0U; i < count; i++){
+        if((windows[i].start_hour >= ACCESS_HOURS_PER_DAY) || (windows[i].end_hour > ACCESS_HOURS_PER_DAY)){
+            return ACCESS_INVALID;
+        }
+        access_add_window(bitmap, &windows[i]);
+    }
+    for(i = 0U; i < ACCESS_BITMAP_BYTES; i++){
+        schedules[schedule][i] = bitmap[i];
+    }
+    return ACCESS_OK;
+}
+
+/*!
+ * @brief     Gives a schedule to a user.
+ *
+ * @param[in]  user_id Fingerprint ID of the user.
+ * @param[in]  schedule Schedule of the user.
+ * @return    ACCESS_OK, or ACCESS_INVALID if an argument is out of range.
+ */
+unsigned char Access_AssignUser(unsigned int user_id, unsigned char schedule){
+    if((user_id >= ACCESS_MAX_USERS) || (schedule >= ACCESS_MAX_SCHEDULES)){
+        return ACCESS_INVALID;
+    }
+    user_schedule[user_id] = schedule;
+    return ACCESS_OK;
+}
+
+/*!
+ * @brief     Returns the schedule of a user.
+ *
+ * @param[in]  user_id Fingerprint ID of the user.
+ * @return    Schedule of the user, ACCESS_SCHEDULE_NEVER for an unknown ID.
+ */
+unsigned char Access_GetUserSchedule(unsigned int user_id){
+    if(user_id >= ACCESS_MAX_USERS){
+        return ACCESS_SCHEDULE_NEVER;
+    }
+    return user_schedule[user_id];
+}
+
+/*!
+ * @brief     Tells whether a user may enter at an hour of the week.
+ *
+ * @detail    When the hour is not known (the clock was never set), only the users with
+ *            ACCESS_SCHEDULE_ALWAYS may enter.
+ *
+ * @param[in]  user_id Fingerprint ID of the user.
+ * @param[in]  hour_of_week Weekday * 24 + hour, Sunday = 0, or ACCESS_HOUR_UNKNOWN.
+ * @return    1 if access is allowed, 0 otherwise.
+ */
+unsigned char Access_IsAllowed(unsigned int user_id, unsigned char hour_of_week){
+    unsigned char schedule;
+
+    if(user_id >= ACCESS_MAX_USERS){
+        return 0U;
+    }
+    schedule = user_schedule[user_id];
+    if(hour_of_week >= ACCESS_HOURS_PER_WEEK){
+        return (schedule == ACCESS_SCHEDULE_ALWAYS) ? 1U : 0U;
+    }
+    return (schedules[schedule][hour_of_week >> 3] >> (hour_of_week & 7U)) & 1U;
+}
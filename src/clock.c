@@ -3,6 +3,7 @@
 ==================================================================================================*/
 
 #include "clock.h"
+#include "core.h"
 
 /*==================================================================================================
 *                                      DEFINES AND MACROS
@@ -19,6 +20,89 @@
 #define SYSTEM_CLOCK_SOURCE_SIRC      2
 #define SYSTEM_CLOCK_SOURCE_FIRC      3
 
+/*!
+ * @brief  Clock source selector values of SCG_CSR.SCS and of the PCC PCS fields.
+ */
+#define SCG_SCS_SOSC    1U
+#define SCG_SCS_SIRC    2U
+#define SCG_SCS_FIRC    3U
+#define SCG_SCS_SPLL    6U
+
+/*!
+ * @brief  Fixed source frequencies.
+ */
+#define CLOCK_SOSC_HZ       8000000U    /* External crystal */
+#define CLOCK_SIRC_HI_HZ    8000000U    /* SIRC high range */
+#define CLOCK_SIRC_LO_HZ    2000000U    /* SIRC low range */
+#define CLOCK_FIRC_HZ       48000000U
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief  Frequencies computed from the SCG registers.
+ */
+typedef struct {
+    unsigned char valid;            /* 0 after a clock change, until the next query */
+    unsigned int core_hz;
+    unsigned int bus_hz;
+    unsigned int flash_hz;
+    unsigned int div2_hz[8];        /* DIV2 output of each source, indexed by PCC PCS */
+} clock_cache_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static clock_cache_t clock_cache;
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief Applies an SCG asynchronous divider.
+ *
+ * @param[in] source_hz: Frequency of the source, 0 if it is not running.
+ * @param[in] div:       Divider field (0: output disabled, n: divide by 2^(n-1)).
+ * @return    Output frequency in Hz.
+ */
+static unsigned int clock_divide(unsigned int source_hz, unsigned int div){
+    return (div == 0U) ? 0U : (source_hz >> (div - 1U));
+}
+
+/*!
+ * @brief Computes all the frequencies from the SCG registers.
+ *
+ * @details The SPLL output is VCO / 2 with VCO = SOSC / (PREDIV + 1) * (MULT + 16). A source
+ *          that is not valid counts as 0 Hz.
+ */
+static void clock_update_cache(void){
+    unsigned int source_hz[8] = {0};
+    unsigned int csr = SCG->SCG_CSR;
+
+    if(SCG->SOSCCSR_bits.SOSCCSR_SOSCVLD){
+        source_hz[SCG_SCS_SOSC] = CLOCK_SOSC_HZ;
+    }
+    source_hz[SCG_SCS_SIRC] = (SCG->SCG_SIRCCFG & 0x1U) ? CLOCK_SIRC_HI_HZ : CLOCK_SIRC_LO_HZ;
+    source_hz[SCG_SCS_FIRC] = CLOCK_FIRC_HZ;
+    if(SCG->SPLLCSR_bits.SPLLCSR_SPLLVLD){
+        source_hz[SCG_SCS_SPLL] = CLOCK_SOSC_HZ / (SCG->SPLLCFG_bits.SPLLCFG_PREDIV + 1U)
+                                  * (SCG->SPLLCFG_bits.SPLLCFG_MULT + 16U) / 2U;
+    }
+
+    clock_cache.core_hz = source_hz[(csr >> 24) & 0xFU] / (((csr >> 16) & 0xFU) + 1U);
+    clock_cache.bus_hz = clock_cache.core_hz / (((csr >> 4) & 0xFU) + 1U);
+    clock_cache.flash_hz = clock_cache.core_hz / ((csr & 0xFU) + 1U);
+
+    clock_cache.div2_hz[SCG_SCS_SOSC] = clock_divide(source_hz[SCG_SCS_SOSC], SCG->SOSCDIV_bits.SOSCDIV_SOSCDIV2);
+    clock_cache.div2_hz[SCG_SCS_SIRC] = clock_divide(source_hz[SCG_SCS_SIRC], SCG->SIRCDIV_bits.SIRCDIV_SIRCDIV2);
+    clock_cache.div2_hz[SCG_SCS_FIRC] = clock_divide(source_hz[SCG_SCS_FIRC], SCG->FIRCDIV_bits.FIRCDIV_FIRCDIV2);
+    clock_cache.div2_hz[SCG_SCS_SPLL] = clock_divide(source_hz[SCG_SCS_SPLL], SCG->SPLLDIV_bits.SPLLDIV_SPLLDIV2);
+    clock_cache.valid = 1;
+}
+
 /*==================================================================================================
 *                                       GLOBAL FUNCTIONS
 ==================================================================================================*/
@@ -31,6 +115,7 @@
  */
 void set_SOSC_source(){
     SCG->RCCR_bits.RCCR_SCS = 1;
+    Clock_Invalidate();
 }
 
 /*!
@@ -42,6 +127,7 @@ void set_SOSC_source(){
 void set_SPLL_source(){
     SCG->RCCR_bits.RCCR_SCS = 6;
     SCG->HCCR_bits.HCCR_SCS = 6;
+    Clock_Invalidate();
 }
 
 /*!
@@ -53,6 +139,7 @@ void set_SPLL_source(){
 void set_SIRC_source(){
     SCG->RCCR_bits.RCCR_SCS = 2;
     SCG->VCCR_bits.VCCR_SCS = 2;
+    Clock_Invalidate();
 }
 
 /*!
@@ -64,6 +151,7 @@ void set_SIRC_source(){
 void set_FIRC_source(){
     SCG->RCCR_bits.RCCR_SCS = 3;
     SCG->HCCR_bits.HCCR_SCS = 3;
+    Clock_Invalidate();
 }
 
 /*!
@@ -102,6 +190,20 @@ void set_system_clock_source(unsigned int source){
  *          until the oscillator is valid.
  */
 void SOSC_init_8MHz(void)
+{
+    SOSC_start_8MHz();
+    while(!(SCG->SOSCCSR_bits.SOSCCSR_SOSCVLD)); /* Wait for SOSC to be valid */
+    Clock_Invalidate();
+}
+
+/*!
+ * @brief Starts the System Oscillator (SOSC) with an 8 MHz external crystal.
+ *
+ * @details Same as SOSC_init_8MHz() without the wait: the crystal starts up in the background
+ *          and SOSCVLD is set once it is stable. The SPLL can be enabled meanwhile; it locks
+ *          after the SOSC is valid.
+ */
+void SOSC_start_8MHz(void)
 {
     /*!
      * SOSC Initialization (8 MHz):
@@ -116,8 +218,7 @@ void SOSC_init_8MHz(void)
 
     while(SCG->SOSCCSR_bits.SOSCCSR_LK); /* Ensure SOSCCSR is unlocked */
     SCG->SOSCCSR_bits.SOSCCSR_SOSCEN = 1; /* Enable the oscillator */
-
-    while(!(SCG->SOSCCSR_bits.SOSCCSR_SOSCVLD)); /* Wait for SOSC to be valid */
+    Clock_Invalidate();
 }
 
 /*!
@@ -128,6 +229,18 @@ void SOSC_init_8MHz(void)
  *          and waits until the PLL output is valid.
  */
 void SPLL_init_160MHz(void)
+{
+    SPLL_config_160MHz();
+    SPLL_enable();
+}
+
+/*!
+ * @brief Configures the System PLL (SPLL) for a 160 MHz clock without enabling it.
+ *
+ * @details This function sets the divider and multiplier values of SPLL_init_160MHz() and
+ *          leaves the PLL disabled; SPLL_enable() starts it when it is needed.
+ */
+void SPLL_config_160MHz(void)
 {
     /*!
      * SPLL Initialization (160 MHz):
@@ -141,11 +254,20 @@ void SPLL_init_160MHz(void)
 
     SCG->SPLLCFG_bits.SPLLCFG_MULT = 24; /* Multiply SOSC by 40 (8 MHz * 40 = 320 MHz) */
     /* SPLL_CLK = 8 MHz / 1 * 40 / 2 = 160 MHz */
+    Clock_Invalidate();
+}
 
-    while(SCG->SPLLCSR_bits.SPLLCSR_LK); /* Ensure SPLLCSR is unlocked */
-    SCG->SPLLCSR_bits.SPLLCSR_SPLLEN = 1; /* Enable the SPLL */
-
-    while(!(SCG->SPLLCSR_bits.SPLLCSR_SPLLVLD)); /* Wait for SPLL to be valid */
+/*!
+ * @brief Enables the Slow IRC (SIRC) asynchronous clock outputs.
+ *
+ * @details Slow IRC is enabled with high range (8 MHz) in reset. This function enables
+ *          SIRCDIV1_CLK and SIRCDIV2_CLK, divided by 1 = 8 MHz asynchronous clock sources.
+ */
+void SIRC_init_8MHz(void)
+{
+    SCG->SIRCDIV_bits.SIRCDIV_SIRCDIV1 = 1;
+    SCG->SIRCDIV_bits.SIRCDIV_SIRCDIV2 = 1;
+    Clock_Invalidate();
 }
 
 /*!
@@ -171,9 +293,123 @@ void NormalRUNmode_80MHz (void)
      * ===================================================
      * Change to Normal RUN mode with 8 MHz SOSC, 160 MHz PLL divided by 2:
      */
-    SCG->SCG_RCCR = 0x06010012U;
+    SCG->SCG_RCCR = SCG_RCCR_SPLL_80MHZ;
+    CORE_REG_WRITTEN(SCG->SCG_RCCR);
     /* DIVCORE=1, div. by 2: Core clock = 160 MHz / 2 = 80 MHz */
     /* Select PLL as clock source */
 
     while (((SCG->SCG_CSR) >> 24 ) != 6) {} /* Wait for system clock source to switch to SPLL */
+    Clock_Invalidate();
+}
+
+/*!
+ * @brief Switches the run mode system clock.
+ *
+ * @details This function writes the Run Clock Control Register (RCCR) and waits until the
+ *          system clock source reported by SCG_CSR is the one requested. The selected source
+ *          must already be valid.
+ *
+ * @param[in] rccr: RCCR value, SCG_RCCR_SPLL_80MHZ or SCG_RCCR_SIRC_8MHZ.
+ */
+void set_run_clock(unsigned int rccr)
+{
+    SCG->SCG_RCCR = rccr;
+    CORE_REG_WRITTEN(SCG->SCG_RCCR);
+    while ((((SCG->SCG_CSR) >> 24) & 0xFU) != ((rccr >> 24) & 0xFU)) {} /* Wait for the switch */
+    Clock_Invalidate();
+}
+
+/*!
+ * @brief Enables the System PLL (SPLL) with its current configuration.
+ *
+ * @details This function enables the SPLL configured by SPLL_init_160MHz() again after
+ *          SPLL_disable() and waits until the PLL output is valid.
+ */
+void SPLL_enable(void)
+{
+    while(SCG->SPLLCSR_bits.SPLLCSR_LK); /* Ensure SPLLCSR is unlocked */
+    SCG->SPLLCSR_bits.SPLLCSR_SPLLEN = 1; /* Enable the SPLL */
+
+    while(!(SCG->SPLLCSR_bits.SPLLCSR_SPLLVLD)); /* Wait for SPLL to be valid */
+    Clock_Invalidate();
+}
+
+/*!
+ * @brief Disables the System PLL (SPLL).
+ *
+ * @details The SPLL must not be the system clock nor the clock of any enabled peripheral.
+ */
+void SPLL_disable(void)
+{
+    while(SCG->SPLLCSR_bits.SPLLCSR_LK); /* Ensure SPLLCSR is unlocked */
+    SCG->SPLLCSR_bits.SPLLCSR_SPLLEN = 0; /* Disable the SPLL */
+    Clock_Invalidate();
+}
+
+/*!
+ * @brief Forgets the cached clock frequencies.
+ *
+ * @details Called by every function of this file that changes the clock tree; code that
+ *          writes the SCG registers directly must call it too.
+ */
+void Clock_Invalidate(void)
+{
+    clock_cache.valid = 0;
+}
+
+/*!
+ * @brief Returns the core (system) clock frequency.
+ *
+ * @return Core clock in Hz.
+ */
+unsigned int Clock_GetCoreFreq(void)
+{
+    if (!clock_cache.valid) {
+        clock_update_cache();
+    }
+    return clock_cache.core_hz;
+}
+
+/*!
+ * @brief Returns the bus clock frequency.
+ *
+ * @return Bus clock in Hz.
+ */
+unsigned int Clock_GetBusFreq(void)
+{
+    if (!clock_cache.valid) {
+        clock_update_cache();
+    }
+    return clock_cache.bus_hz;
+}
+
+/*!
+ * @brief Returns the flash (slow) clock frequency.
+ *
+ * @return Flash clock in Hz.
+ */
+unsigned int Clock_GetFlashFreq(void)
+{
+    if (!clock_cache.valid) {
+        clock_update_cache();
+    }
+    return clock_cache.flash_hz;
+}
+
+/*!
+ * @brief Returns the functional clock frequency of a peripheral.
+ *
+ * @details The source is read from the PCS field of the PCC register of the peripheral; its
+ *          DIV2 output frequency comes from the cache. Peripherals without a PCS field run
+ *          from the bus clock and must use Clock_GetBusFreq() instead.
+ *
+ * @param[in] pcc: PCC register of the peripheral, e.g. &PCC->PCC_LPUART1.
+ * @return    Functional clock in Hz, 0 if the selected source is off.
+ */
+unsigned int Clock_GetPeripheralFreq(volatile unsigned int *pcc)
+{
+    if (!clock_cache.valid) {
+        clock_update_cache();
+    }
+    return clock_cache.div2_hz[(*pcc >> 24) & 0x7U];
 }
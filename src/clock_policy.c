@@ -0,0 +1,202 @@
+/**
+*   @file    clock_policy.c
+*   @brief   Implementation of the clock policy manager.
+*   @details A switch to the high profile first enables the SPLL and waits for it to lock with
+*            interrupts enabled; the system clock and the peripheral clocks are then switched
+*            together with interrupts masked, once the LPUART transmitters are idle. A switch to
+*            the low profile stops the SPLL once nothing uses it any more.
+*
+*            LPUART1 and LPUART2 run from SPLLDIV2 (40 MHz) in the high profile and from
+*            SIRCDIV2 (8 MHz) in the low one. LPI2C0 stays on SIRCDIV2, which runs in both.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "clock_policy.h"
+#include "clock.h"
+#include "core.h"
+#include "pcc.h"
+#include "lpuart.h"
+#include "i2c.h"
+#include "systick.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+/* PCC peripheral clock sources (PCS field) */
+#define CLOCK_PCS_SIRCDIV2      2U
+#define CLOCK_PCS_SPLLDIV2      6U
+#define CLOCK_PCS(pcc)          (((pcc) >> 24U) & 0x7U)
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Clock settings of a profile.
+ *
+ * @detail The resulting frequencies are read back from the clock tree by the drivers.
+ */
+typedef struct {
+    unsigned int rccr;                          /*!< Run clock control register value */
+    unsigned int lpuart_pcs;                    /*!< PCC clock source of LPUART1 and LPUART2 */
+    unsigned int lpi2c_pcs;                     /*!< PCC clock source of LPI2C0 */
+} clock_profile_config_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static const clock_profile_config_t profiles[CLOCK_PROFILE_COUNT] = {
+    /* CLOCK_PROFILE_LOW */
+    { SCG_RCCR_SIRC_8MHZ,  CLOCK_PCS_SIRCDIV2, CLOCK_PCS_SIRCDIV2 },
+    /* CLOCK_PROFILE_HIGH */
+    { SCG_RCCR_SPLL_80MHZ, CLOCK_PCS_SPLLDIV2, CLOCK_PCS_SIRCDIV2 },
+};
+
+static clock_profile_t current = CLOCK_PROFILE_COUNT;    /* Boot clock (FIRC) until Clock_PolicyInit() */
+static unsigned int request_mask = 0;
+static unsigned int high_start_ms = 0;
+static clock_stats_t stats;
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Changes the functional clock source of a peripheral.
+ *
+ * @detail    The PCC source may only be changed with the peripheral clock gated; the
+ *            peripheral keeps its registers meanwhile. Nothing is done if the source is
+ *            already selected.
+ *
+ * @param[in] pcc: PCC register of the peripheral.
+ * @param[in] pcs: Clock source.
+ * @return    void
+ */
+static void clock_set_source(volatile unsigned int *pcc, unsigned int pcs){
+    if(CLOCK_PCS(*pcc) != pcs){
+        PCC_DisableClock(pcc);
+        PCC_SetClockSource(pcc, pcs);
+        PCC_EnableClock(pcc);
+    }
+}
+
+/*!
+ * @brief     Switches to a profile.
+ *
+ * @param[in] profile: Profile to use.
+ * @return    void
+ */
+static void clock_switch(clock_profile_t profile){
+    const clock_profile_config_t *config = &profiles[profile];
+    unsigned int primask;
+
+    if(profile == CLOCK_PROFILE_HIGH){
+        SPLL_enable();
+    }
+
+    CORE_ENTER_CRITICAL(primask);
+    while(LPUART1->STAT.TC == 0){}
+    while(LPUART2->STAT.TC == 0){}
+    set_run_clock(config->rccr);
+
+    clock_set_source(&PCC->PCC_LPUART1, config->lpuart_pcs);
+    clock_set_source(&PCC->PCC_LPUART2, config->lpuart_pcs);
+    LPUART_config_baud(LPUART1, CLOCK_LPUART_BAUD);
+    LPUART_config_baud(LPUART2, CLOCK_LPUART_BAUD);
+    clock_set_source(&PCC->PCC_LPI2C0, config->lpi2c_pcs);
+    LPI2C0_set_timing();
+    SysTick_StartTick();
+
+    if(profile == CLOCK_PROFILE_HIGH){
+        high_start_ms = SysTick_GetTick();
+    }else if(current == CLOCK_PROFILE_HIGH){
+        stats.high_ms += SysTick_GetTick() - high_start_ms;
+    }
+    stats.switch_count++;
+    current = profile;
+    CORE_EXIT_CRITICAL(primask);
+
+    if(profile == CLOCK_PROFILE_LOW){
+        SPLL_disable();
+    }
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Starts the clock policy.
+ *
+ * @detail    Must be called once the clocks, LPUART1, LPUART2, LPI2C0 and SysTick are set up
+ *            for the boot clock (FIRC 48 MHz, SPLL configured but stopped); switches to the
+ *            low profile.
+ *
+ * @return    void
+ */
+void Clock_PolicyInit(void){
+    current = CLOCK_PROFILE_COUNT;
+    request_mask = 0;
+    clock_switch(CLOCK_PROFILE_LOW);
+}
+
+/*!
+ * @brief     Requests the high profile.
+ *
+ * @detail    Switches at once if the low profile is in use. Called from task context only:
+ *            the call waits for the SPLL to lock.
+ *
+ * @param[in] reason: One of the CLOCK_REQ_x bits.
+ * @return    void
+ */
+void Clock_Request(unsigned int reason){
+    request_mask |= reason;
+    if(current != CLOCK_PROFILE_HIGH){
+        clock_switch(CLOCK_PROFILE_HIGH);
+    }
+}
+
+/*!
+ * @brief     Releases a reason given to Clock_Request().
+ *
+ * @detail    Switches to the low profile when no reason is left. Called from task context only.
+ *
+ * @param[in] reason: One of the CLOCK_REQ_x bits.
+ * @return    void
+ */
+void Clock_Release(unsigned int reason){
+    request_mask &= ~reason;
+    if((request_mask == 0U) && (current != CLOCK_PROFILE_LOW)){
+        clock_switch(CLOCK_PROFILE_LOW);
+    }
+}
+
+/*!
+ * @brief     Gives the profile in use.
+ *
+ * @return    Current profile.
+ */
+clock_profile_t Clock_GetProfile(void){
+    return current;
+}
+
+/*!
+ * @brief     Reads the clock policy statistics.
+ *
+ * @param[out] stats_out: Statistics.
+ * @return    void
+ */
+void Clock_GetStats(clock_stats_t *stats_out){
+    unsigned int primask;
+    CORE_ENTER_CRITICAL(primask);
+    *stats_out = stats;
+    if(current == CLOCK_PROFILE_HIGH){
+        stats_out->high_ms += SysTick_GetTick() - high_start_ms;
+    }
+    CORE_EXIT_CRITICAL(primask);
+}
@@ -0,0 +1,689 @@
+/**
+*   @file    event_log.c
+*   @brief   Implementation of the access event log.
+*   @details Layout of each 2 KB FlexNVM sector of the ring:
+*            - phrase 0, the header: 'L', sequence number (2 bytes), base time (4 bytes), the
+*              time of the last record written before the sector;
+*            - phrases 1 to 255, the records. A record never spans two phrases, so every phrase
+*              is written by a single program command. Unused bytes at the end of a phrase are
+*              left at 0xFF.
+*            The last byte of every phrase is the number of zero bits of the other seven. A
+*            program or erase cut by a power loss leaves some bits at 1 that should be 0, which
+*            lowers the count of the data or raises the check byte, so a torn phrase never
+*            passes the check. A torn header voids its sector; a torn record phrase ends the
+*            records of its sector and writing goes on in the next sector.
+*            A record starts with a tag byte: the result of an event, followed by the varints of
+*            the time since the previous record, the fingerprint ID and the score; or
+*            LOG_TAG_TIME followed by an absolute time, when the delta does not fit or makes the
+*            record longer than a phrase.
+*            The sector that follows the one being written is erased ahead of time, so an append
+*            never waits for an erase. After a reset the sector with the highest sequence number
+*            is the one being written, and its first erased phrase is where writing resumes.
+*            All multi-byte fields are little-endian.
+*            A RAM index keeps the first and last record time of every sector; while the sectors
+*            are in time order, a time range query binary-searches it for the first sector to
+*            read instead of decoding the whole log.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "event_log.h"
+#include "flash.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define LOG_BASE            FLASH_DFLASH_BASE
+#define LOG_PHRASES         (FLASH_DFLASH_SECTOR / FLASH_PHRASE_SIZE)  /* Per sector, 0 is the header */
+#define LOG_MAGIC           'L'
+#define LOG_PAYLOAD         (FLASH_PHRASE_SIZE - 1U)    /* Bytes of a phrase before its check byte */
+#define LOG_TAG_PAD         0xFFU       /* Erased byte: no more records in the phrase */
+#define LOG_TAG_TIME        0xFEU       /* Absolute time record, 4 bytes follow */
+#define LOG_TIME_RECORD     5U          /* Size of an absolute time record */
+#define LOG_DELTA_MAX       0x1FFFFFU   /* Largest time delta of a 3 byte varint */
+#define LOG_VALUE_MAX       0x3FFFU     /* Largest ID or score of a 2 byte varint */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/* Index entry of a sector */
+typedef struct {
+    unsigned int   first;           /* Time of the first record */
+    unsigned int   last;            /* Time of the last record */
+    unsigned short records;         /* Number of records, 0 for a sector without records */
+    unsigned char  valid;           /* The sector has a header */
+    unsigned char  ordered;         /* No record is older than the one before it */
+} log_index_t;
+
+/* Flash command in progress */
+typedef enum {
+    LOG_OP_NONE = 0,
+    LOG_OP_PROGRAM,         /* Programming the oldest staged phrase */
+    LOG_OP_HEADER,          /* Programming the header of the next sector */
+    LOG_OP_ERASE            /* Erasing the next sector */
+} log_op_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+/* Staged phrases: stage_count complete ones from stage_head, then the one being filled */
+static unsigned char stage[EVENT_LOG_STAGE_PHRASES][FLASH_PHRASE_SIZE];
+static unsigned int stage_base[EVENT_LOG_STAGE_PHRASES];   /* Time before the first record */
+static unsigned char stage_head = 0;
+static unsigned char stage_count = 0;
+static unsigned char fill_len = 0;          /* Bytes used in the phrase being filled */
+static unsigned int last_time = 0;          /* Time of the last record appended */
+
+static unsigned char cur_sector;            /* Sector being written */
+static unsigned short cur_seq;              /* Its sequence number */
+static unsigned short cur_phrase;           /* Next phrase to program, LOG_PHRASES when full */
+static unsigned char next_erased;           /* The sector after cur_sector is erased */
+static log_op_t op = LOG_OP_NONE;
+static event_log_stats_t stats;
+static log_index_t sector_index[EVENT_LOG_SECTORS];
+
+/*==================================================================================================
+*                                       LOCAL FUNCTIONS
+==================================================================================================*/
+
+static unsigned int log_address(unsigned char sector, unsigned short phrase){
+    return LOG_BASE + (sector * FLASH_DFLASH_SECTOR) + (phrase * FLASH_PHRASE_SIZE);
+}
+
+static const unsigned char *log_phrase(unsigned char sector, unsigned short phrase){
+    return FLASH_MAP(log_address(sector, phrase));
+}
+
+static unsigned char log_next_sector(unsigned char sector){
+    return (unsigned char)((sector + 1U) % EVENT_LOG_SECTORS);
+}
+
+static unsigned int log_get_u32(const unsigned char *p){
+    return p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static void log_put_u32(unsigned char *p, unsigned int value){
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+/*!
+ * @brief     Counts the zero bits of a phrase before its check byte.
+ *
+ * @return    The value of the check byte of the phrase.
+ */
+static unsigned char log_zero_bits(const unsigned char *p){
+    unsigned char count = 0U;
+    unsigned char bits;
+    unsigned char i;
+
+    for(i = 0U; i < LOG_PAYLOAD; i++){
+        for(bits = (unsigned char)~p[i]; bits != 0U; bits &= (unsigned char)(bits - 1U)){
+            count++;
+        }
+    }
+    return count;
+}
+
+/* Tells whether a phrase was programmed completely; an erased phrase is not */
+static unsigned char log_phrase_intact(const unsigned char *p){
+    return p[LOG_PAYLOAD] == log_zero_bits(p);
+}
+
+/*!
+ * @brief     Reads the header of a sector.
+ *
+ * @return    1 if the sector has a valid header, 0 otherwise.
+ */
+static unsigned char log_read_header(unsigned char sector, unsigned short *seq, unsigned int *base){
+    const unsigned char *p = log_phrase(sector, 0U);
+
+    if((p[0] != LOG_MAGIC) || !log_phrase_intact(p)){
+        return 0U;
+    }
+    *seq = (unsigned short)(p[1] | (p[2] << 8));
+    *base = log_get_u32(&p[3]);
+    return 1U;
+}
+
+static unsigned char log_phrase_erased(const unsigned char *p){
+    unsigned char i;
+
+    for(i = 0U; i < FLASH_PHRASE_SIZE; i++){
+        if(p[i] != 0xFFU){
+            return 0U;
+        }
+    }
+    return 1U;
+}
+
+static unsigned char log_sector_erased(unsigned char sector){
+    unsigned short phrase;
+
+    for(phrase = 0U; phrase < LOG_PHRASES; phrase++){
+        if(!log_phrase_erased(log_phrase(sector, phrase))){
+            return 0U;
+        }
+    }
+    return 1U;
+}
+
+/*!
+ * @brief     Writes a varint: 7 bits per byte, least significant first, bit 7 set on all
+ *            bytes but the last.
+ *
+ * @return    Number of bytes written.
+ */
+static unsigned char log_put_varint(unsigned char *p, unsigned int value){
+    unsigned char len = 0U;
+
+    while(value >= 0x80U){
+        p[len++] = (unsigned char)(value | 0x80U);
+        value >>= 7;
+    }
+    p[len++] = (unsigned char)value;
+    return len;
+}
+
+/*!
+ * @brief     Reads a varint that ends inside the phrase.
+ *
+ * @return    1 if a varint was read, 0 if the phrase ends first.
+ */
+static unsigned char log_get_varint(const unsigned char *p, unsigned char *offset, unsigned int *value){
+    unsigned char shift = 0U;
+    unsigned char byte;
+
+    *value = 0U;
+    do{
+        if((*offset >= LOG_PAYLOAD) || (shift > 21U)){
+            return 0U;
+        }
+        byte = p[(*offset)++];
+        *value |= (unsigned int)(byte & 0x7FU) << shift;
+        shift += 7U;
+    }while(byte & 0x80U);
+    return 1U;
+}
+
+/*!
+ * @brief     Encodes an event record; IDs and scores above LOG_VALUE_MAX are stored as that.
+ *
+ * @return    Number of bytes written, up to FLASH_PHRASE_SIZE.
+ */
+static unsigned char log_encode(unsigned char *p, unsigned int delta, unsigned short user_id,
+                                unsigned short score, unsigned char result){
+    unsigned char len = 1U;
+
+    p[0] = result;
+    len += log_put_varint(&p[len], delta);
+    len += log_put_varint(&p[len], (user_id > LOG_VALUE_MAX) ? LOG_VALUE_MAX : user_id);
+    len += log_put_varint(&p[len], (score > LOG_VALUE_MAX) ? LOG_VALUE_MAX : score);
+    return len;
+}
+
+/*!
+ * @brief     Decodes the next event record of a phrase.
+ *
+ * @param[in]      p The phrase.
+ * @param[in,out]  offset Position in the phrase, LOG_PAYLOAD once the phrase is done.
+ * @param[in,out]  time Time of the previous record.
+ * @param[out]     record The decoded event.
+ * @return    1 if an event was decoded, 0 at the end of the phrase.
+ */
+static unsigned char log_decode(const unsigned char *p, unsigned char *offset, unsigned int *time,
+                                event_log_record_t *record){
+    unsigned int delta;
+    unsigned int user_id;
+    unsigned int score;
+    unsigned char tag;
+
+    while(*offset < LOG_PAYLOAD){
+        tag = p[*offset];
+        if(tag == LOG_TAG_PAD){
+            break;
+        }
+        if(tag == LOG_TAG_TIME){
+            if((*offset + LOG_TIME_RECORD) > LOG_PAYLOAD){
+                break;
+            }
+            *time = log_get_u32(&p[*offset + 1U]);
+            *offset += LOG_TIME_RECORD;
+            continue;
+        }
+        (*offset)++;
+        if(!log_get_varint(p, offset, &delta) || !log_get_varint(p, offset, &user_id) ||
+           !log_get_varint(p, offset, &score)){
+            break;
+        }
+        *time += delta;
+        record->time = *time;
+        record->user_id = (unsigned short)user_id;
+        record->score = (unsigned short)score;
+        record->result = tag;
+        return 1U;
+    }
+    *offset = LOG_PAYLOAD;
+    return 0U;
+}
+
+/*!
+ * @brief     Adds the records of a phrase to the index of its sector.
+ *
+ * @param[in]      sector Sector of the phrase.
+ * @param[in]      p The phrase.
+ * @param[in,out]  time Time of the previous record, updated to the last record of the phrase.
+ * @return    void
+ */
+static void log_index_phrase(unsigned char sector, const unsigned char *p, unsigned int *time){
+    event_log_record_t record;
+    unsigned char offset = 0U;
+
+    while(log_decode(p, &offset, time, &record)){
+        if(sector_index[sector].records == 0U){
+            sector_index[sector].first = record.time;
+            sector_index[sector].ordered = 1U;
+        }else if(record.time < sector_index[sector].last){
+            sector_index[sector].ordered = 0U;
+        }
+        sector_index[sector].last = record.time;
+        sector_index[sector].records++;
+    }
+}
+
+/*!
+ * @brief     Indexes a sector with a valid header.
+ *
+ * @param[in]      sector The sector.
+ * @param[in,out]  time Base time of the sector, updated to the time of its last record.
+ * @return    Index of the first erased phrase, LOG_PHRASES if the sector is full or its
+ *            records end with a torn phrase.
+ */
+static unsigned short log_index_sector(unsigned char sector, unsigned int *time){
+    const unsigned char *p;
+    unsigned short phrase;
+
+    sector_index[sector].valid = 1U;
+    sector_index[sector].records = 0U;
+    for(phrase = 1U; phrase < LOG_PHRASES; phrase++){
+        p = log_phrase(sector, phrase);
+        if(!log_phrase_intact(p)){
+            return log_phrase_erased(p) ? phrase : LOG_PHRASES;
+        }
+        log_index_phrase(sector, p, time);
+    }
+    return phrase;
+}
+
+/*!
+ * @brief     Tells whether the record times increase along the log.
+ *
+ * @detail    They no longer do once the clock has been set back, by hand or by a power-on
+ *            reset that restarts the RTC at 1970, until the ring has reused the sectors of the
+ *            records written before.
+ *
+ * @return    1 if every indexed sector is in order and starts at or after the last record of
+ *            the sector before it, 0 otherwise.
+ */
+static unsigned char log_index_ordered(void){
+    unsigned int last = 0U;
+    unsigned char k;
+    unsigned char sector;
+
+    for(k = 1U; k <= EVENT_LOG_SECTORS; k++){
+        sector = (unsigned char)((cur_sector + k) % EVENT_LOG_SECTORS);
+        if(!sector_index[sector].valid || (sector_index[sector].records == 0U)){
+            continue;
+        }
+        if(!sector_index[sector].ordered || (sector_index[sector].first < last)){
+            return 0U;
+        }
+        last = sector_index[sector].last;
+    }
+    return 1U;
+}
+
+/*!
+ * @brief     Queues the phrase being filled for programming.
+ *
+ * @return    1 if the phrase was queued or is empty, 0 if no staging phrase is free.
+ */
+static unsigned char log_close_fill(void){
+    unsigned char fill = (unsigned char)((stage_head + stage_count) % EVENT_LOG_STAGE_PHRASES);
+
+    if(fill_len == 0U){
+        return 1U;
+    }
+    if(stage_count >= (EVENT_LOG_STAGE_PHRASES - 1U)){
+        return 0U;
+    }
+    while(fill_len < LOG_PAYLOAD){
+        stage[fill][fill_len++] = LOG_TAG_PAD;
+    }
+    stage[fill][LOG_PAYLOAD] = log_zero_bits(stage[fill]);
+    stage_count++;
+    fill_len = 0U;
+    return 1U;
+}
+
+/*!
+ * @brief     Adds an encoded record to the staged phrases.
+ *
+ * @return    EVENT_LOG_OK, or EVENT_LOG_FULL if no staging phrase is free.
+ */
+static unsigned char log_stage(const unsigned char *bytes, unsigned char len){
+    unsigned char fill;
+    unsigned char i;
+
+    if((fill_len + len) > LOG_PAYLOAD){
+        if(!log_close_fill()){
+            return EVENT_LOG_FULL;
+        }
+    }
+    fill = (unsigned char)((stage_head + stage_count) % EVENT_LOG_STAGE_PHRASES);
+    if(fill_len == 0U){
+        stage_base[fill] = last_time;
+    }
+    for(i = 0U; i < len; i++){
+        stage[fill][fill_len++] = bytes[i];
+    }
+    if(fill_len == LOG_PAYLOAD){
+        (void)log_close_fill();
+    }
+    return EVENT_LOG_OK;
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Recovers the log from the flash.
+ *
+ * @detail    Finds the sector being written and its first free phrase, and replays its records
+ *            to get the time of the last one. A header left half programmed by a power loss
+ *            voids its sector; a record phrase left half programmed ends the records of its
+ *            sector, and the next append opens a new one. Must be called once Flash_Init() has
+ *            run and before any other call.
+ *
+ * @return    void
+ */
+void EventLog_Init(void){
+    unsigned char found = 0U;
+    unsigned char sector;
+    unsigned short seq;
+    unsigned short phrase;
+    unsigned int time;
+
+    /* Empty log: the first append opens sector 0 with sequence number 0 */
+    cur_sector = EVENT_LOG_SECTORS - 1U;
+    cur_seq = 0xFFFFU;
+    cur_phrase = LOG_PHRASES;
+    last_time = 0U;
+    for(sector = 0U; sector < EVENT_LOG_SECTORS; sector++){
+        sector_index[sector].valid = 0U;
+        if(!log_read_header(sector, &seq, &time)){
+            continue;
+        }
+        phrase = log_index_sector(sector, &time);
+        if(!found || ((short)(seq - cur_seq) > 0)){
+            found = 1U;
+            cur_sector = sector;
+            cur_seq = seq;
+            cur_phrase = phrase;
+            last_time = time;
+        }
+    }
+    next_erased = log_sector_erased(log_next_sector(cur_sector));
+    stage_head = 0U;
+    stage_count = 0U;
+    fill_len = 0U;
+    op = LOG_OP_NONE;
+}
+
+/*!
+ * @brief     Appends a door event to the log.
+ *
+ * @detail    Encodes the record into the RAM staging buffer; a bounded number of steps,
+ *            whatever the state of the flash. EventLog_Service() must then be called to
+ *            program it. Fingerprint IDs and scores above 16383 are stored as 16383.
+ *
+ * @param[in]  time Epoch seconds of the event.
+ * @param[in]  user_id Fingerprint ID, 0 when there is no match.
+ * @param[in]  score Match score.
+ * @param[in]  result EVENT_LOG_GRANTED, ...
+ * @return     EVENT_LOG_OK, or EVENT_LOG_FULL if the record was dropped.
+ */
+unsigned char EventLog_Append(unsigned int time, unsigned short user_id, unsigned short score,
+                              unsigned char result){
+    unsigned char bytes[FLASH_PHRASE_SIZE];
+    unsigned char len = 0U;
+
+    if((time >= last_time) && ((time - last_time) <= LOG_DELTA_MAX)){
+        len = log_encode(bytes, time - last_time, user_id, score, result);
+    }
+    if((len == 0U) || (len > LOG_PAYLOAD)){
+        bytes[0] = LOG_TAG_TIME;
+        log_put_u32(&bytes[1], time);
+        if(log_stage(bytes, LOG_TIME_RECORD) != EVENT_LOG_OK){
+            stats.dropped++;
+            return EVENT_LOG_FULL;
+        }
+        last_time = time;
+        len = log_encode(bytes, 0U, user_id, score, result);
+    }
+    if(log_stage(bytes, len) != EVENT_LOG_OK){
+        stats.dropped++;
+        return EVENT_LOG_FULL;
+    }
+    last_time = time;
+    stats.appended++;
+    return EVENT_LOG_OK;
+}
+
+/*!
+ * @brief     Queues the partly filled phrase for programming.
+ *
+ * @detail    The rest of the phrase is left unused. Called when no event has been appended for
+ *            a while, so that the staged records do not wait in RAM for long.
+ *
+ * @return    void
+ */
+void EventLog_Flush(void){
+    (void)log_close_fill();
+}
+
+/*!
+ * @brief     Programs the staged phrases.
+ *
+ * @detail    Completes the last flash command and launches the next one: programming the oldest
+ *            staged phrase, opening the next sector when the current one is full, or erasing
+ *            the sector after the current one ahead of time. Never waits for the flash; the
+ *            caller calls it again when the command has completed (FTFC command complete
+ *            interrupt, enabled here). A failed command is counted and not retried until the
+ *            next call.
+ *
+ * @return    1 while a flash command runs, 0 when there is nothing more to do.
+ */
+unsigned char EventLog_Service(void){
+    unsigned char status = Flash_GetStatus();
+    unsigned char header[FLASH_PHRASE_SIZE];
+    unsigned char next = log_next_sector(cur_sector);
+    unsigned short seq;
+
+    if(status == FLASH_BUSY){
+        Flash_EnableDoneIrq();
+        return 1U;
+    }
+    if(op != LOG_OP_NONE){
+        if(status == FLASH_ERROR){
+            stats.flash_errors++;
+            if(op == LOG_OP_PROGRAM){
+                cur_phrase = LOG_PHRASES;   /* The phrase may be torn, retry it in the next sector */
+            }else if(op == LOG_OP_HEADER){
+                next_erased = 0U;           /* The header may be torn, erase the sector again */
+            }
+            op = LOG_OP_NONE;
+            return 0U;
+        }
+        if(op == LOG_OP_PROGRAM){
+            log_index_phrase(cur_sector, stage[stage_head], &stage_base[stage_head]);
+            stage_head = (unsigned char)((stage_head + 1U) % EVENT_LOG_STAGE_PHRASES);
+            stage_count--;
+            cur_phrase++;
+        }else if(op == LOG_OP_HEADER){
+            cur_sector = next;
+            cur_seq++;
+            cur_phrase = 1U;
+            next_erased = 0U;
+            next = log_next_sector(cur_sector);
+            sector_index[cur_sector].valid = 1U;
+            sector_index[cur_sector].records = 0U;
+        }else{
+            next_erased = 1U;
+            sector_index[next].valid = 0U;
+        }
+        op = LOG_OP_NONE;
+    }
+
+    if((stage_count > 0U) && (cur_phrase < LOG_PHRASES)){
+        (void)Flash_StartProgramPhrase(log_address(cur_sector, cur_phrase), stage[stage_head]);
+        op = LOG_OP_PROGRAM;
+    }else if((stage_count > 0U) && next_erased){
+        seq = (unsigned short)(cur_seq + 1U);
+        header[0] = LOG_MAGIC;
+        header[1] = (unsigned char)seq;
+        header[2] = (unsigned char)(seq >> 8);
+        log_put_u32(&header[3], stage_base[stage_head]);
+        header[LOG_PAYLOAD] = log_zero_bits(header);
+        (void)Flash_StartProgramPhrase(log_address(next, 0U), header);
+        op = LOG_OP_HEADER;
+    }else if(!next_erased){
+        sector_index[next].valid = 0U;  /* Its records are gone from now on */
+        (void)Flash_StartEraseSector(log_address(next, 0U));
+        op = LOG_OP_ERASE;
+    }else{
+        return 0U;
+    }
+    Flash_EnableDoneIrq();
+    return 1U;
+}
+
+/*!
+ * @brief     Starts reading the log from the oldest record.
+ *
+ * @param[out] cursor Read position.
+ * @return    void
+ */
+void EventLog_ReadFirst(event_log_cursor_t *cursor){
+    cursor->sector = cur_sector;
+    cursor->sectors_left = EVENT_LOG_SECTORS;
+    cursor->phrase = LOG_PHRASES;           /* The next read moves to the oldest sector */
+    cursor->offset = 0U;
+    cursor->time = 0U;
+}
+
+/*!
+ * @brief     Reads the next record of the log.
+ *
+ * @detail    Only the records already programmed are read, the staged ones are not.
+ *
+ * @param[in,out] cursor Read position, see EventLog_ReadFirst().
+ * @param[out]    record The record read.
+ * @return    EVENT_LOG_OK, EVENT_LOG_END after the newest record, or EVENT_LOG_BUSY while a
+ *            flash command runs (the FlexNVM cannot be read then).
+ */
+unsigned char EventLog_ReadNext(event_log_cursor_t *cursor, event_log_record_t *record){
+    const unsigned char *p;
+    unsigned short seq;
+
+    if(Flash_IsBusy()){
+        return EVENT_LOG_BUSY;
+    }
+    while(1){
+        if(cursor->phrase >= LOG_PHRASES){
+            if(cursor->sectors_left == 0U){
+                return EVENT_LOG_END;
+            }
+            cursor->sectors_left--;
+            cursor->sector = log_next_sector(cursor->sector);
+            if(!log_read_header(cursor->sector, &seq, &cursor->time)){
+                continue;
+            }
+            cursor->phrase = 1U;
+            cursor->offset = 0U;
+        }
+        p = log_phrase(cursor->sector, cursor->phrase);
+        if((cursor->offset == 0U) && !log_phrase_intact(p)){
+            cursor->phrase = LOG_PHRASES;   /* End of the records of this sector, erased or torn */
+            continue;
+        }
+        if(log_decode(p, &cursor->offset, &cursor->time, record)){
+            return EVENT_LOG_OK;
+        }
+        cursor->phrase++;
+        cursor->offset = 0U;
+    }
+}
+
+/*!
+ * @brief     Starts reading the log at the records of a time.
+ *
+ * @detail    Binary-searches the sector index for the oldest sector whose last record is at
+ *            or after the time; the records of that sector that are older than the time are
+ *            still returned by EventLog_ReadNext() and must be skipped by the caller. The
+ *            search needs record times that increase along the log; after the clock has been
+ *            set back they do not, and the cursor is left at the oldest record instead.
+ *
+ * @param[out] cursor Read position.
+ * @param[in]  time Epoch seconds of the first record wanted.
+ * @return     1 if the records read from the cursor are in time order, so the caller may stop
+ *             at the first one after its range; 0 if the whole log must be read.
+ */
+unsigned char EventLog_Seek(event_log_cursor_t *cursor, unsigned int time){
+    unsigned char lo = 0U;
+    unsigned char hi = EVENT_LOG_SECTORS;
+    unsigned char mid;
+    unsigned char sector;
+
+    EventLog_ReadFirst(cursor);
+    if(!log_index_ordered()){
+        return 0U;
+    }
+    /* Ring position k (0 = oldest) is sector (cur_sector + 1 + k); the leading ones may be erased */
+    while((lo < EVENT_LOG_SECTORS) && !sector_index[(cur_sector + 1U + lo) % EVENT_LOG_SECTORS].valid){
+        lo++;
+    }
+    while(lo < hi){
+        mid = (unsigned char)((lo + hi) / 2U);
+        sector = (unsigned char)((cur_sector + 1U + mid) % EVENT_LOG_SECTORS);
+        if(sector_index[sector].valid && (sector_index[sector].records != 0U) &&
+           (sector_index[sector].last < time)){
+            lo = mid + 1U;
+        }else{
+            hi = mid;
+        }
+    }
+    /* Start just before ring position lo, so that the next read enters it */
+    cursor->sector = (unsigned char)((cur_sector + lo) % EVENT_LOG_SECTORS);
+    cursor->sectors_left = (unsigned char)(EVENT_LOG_SECTORS - lo);
+    return 1U;
+}
+
+/*!
+ * @brief     Returns the event log statistics.
+ *
+ * @param[out] stats_out Statistics.
+ * @return    void
+ */
+void EventLog_GetStats(event_log_stats_t *stats_out){
+    *stats_out = stats;
+    stats_out->phrases_left = LOG_PHRASES - cur_phrase;
+}
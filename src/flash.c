@@ -0,0 +1,358 @@
+/**
+*   @file    flash.c
+*   @brief   Implementation of the FTFC flash driver.
+*   @details Commands are written to the FCCOB registers and launched by clearing CCIF. The
+*            FTFC addresses the FlexNVM from 0x800000, bit 23 selecting it over the program
+*            flash.
+*
+*            The program flash cannot be read while one of its commands runs, so these commands
+*            are launched and waited for by a function in RAM with the interrupts masked.
+*
+*            The EEPROM emulation is 2 KB of FlexRAM backed by 32 KB of FlexNVM, which spreads
+*            the wear of each FlexRAM word over 16 times its size of flash.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "flash.h"
+#include "pcc.h"
+#include "core.h"
+#include "ftfc_registers.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define FLASH_FTFC_DFLASH       0x800000U       /* FTFC address of the FlexNVM */
+#define FLASH_FSTAT_ERRORS      (FTFC_FSTAT_ACCERR | FTFC_FSTAT_FPVIOL | FTFC_FSTAT_RDCOLERR)
+
+/* Program Partition parameters */
+#define FLASH_EEE_SIZE_CODE     0x03U           /* EEESIZE: 2 KB of EEPROM emulation */
+#define FLASH_DEPART_CODE       0x03U           /* DEPART: 32 KB data flash, 32 KB EEE backup */
+#define FLASH_LOAD_EEE_AT_RESET 0x00U           /* The FlexRAM is loaded from the backup at reset */
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+/* The last program or erase command failed; kept across EEE writes, which overwrite FSTAT */
+static volatile unsigned char command_failed = 0U;
+
+/*==================================================================================================
+*                                       LOCAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Writes the command and address of a flash command.
+ *
+ * @param[in]  command FTFC command code.
+ * @param[in]  address Program flash or FlexNVM address in the system memory map.
+ * @return     void
+ */
+static void flash_set_command(unsigned char command, unsigned int address){
+    unsigned int ftfc_address = address;
+
+    if(address >= FLASH_DFLASH_BASE){
+        ftfc_address = FLASH_FTFC_DFLASH + (address - FLASH_DFLASH_BASE);
+    }
+    FTFC->FSTAT = FLASH_FSTAT_ERRORS;   /* Clear the errors of the previous command */
+    CORE_REG_WRITTEN(FTFC->FSTAT);
+    FTFC_FCCOB(0) = command;
+    FTFC_FCCOB(1) = (unsigned char)(ftfc_address >> 16);
+    FTFC_FCCOB(2) = (unsigned char)(ftfc_address >> 8);
+    FTFC_FCCOB(3) = (unsigned char)ftfc_address;
+}
+
+/*!
+ * @brief     Returns the status of the last FTFC command from FSTAT.
+ *
+ * @return     FLASH_BUSY, FLASH_ERROR or FLASH_OK.
+ */
+static unsigned char flash_fstat_status(void){
+    unsigned char fstat = FTFC->FSTAT;
+
+    if((fstat & FTFC_FSTAT_CCIF) == 0U){
+        return FLASH_BUSY;
+    }
+    if(fstat & (FLASH_FSTAT_ERRORS | FTFC_FSTAT_MGSTAT0)){
+        return FLASH_ERROR;
+    }
+    return FLASH_OK;
+}
+
+/*!
+ * @brief     Waits for the end of a running command and keeps its result.
+ *
+ * @detail    Used before a command that is waited for, which overwrites FSTAT.
+ *
+ * @return     void
+ */
+static void flash_wait_idle(void){
+    while(Flash_IsBusy());
+    if(flash_fstat_status() == FLASH_ERROR){
+        command_failed = 1U;
+    }
+}
+
+/*!
+ * @brief     Launches a command and waits for its end, executing from RAM.
+ *
+ * @detail    Called with the interrupts masked: neither this function nor an interrupt
+ *            handler may fetch from the program flash until the command has completed.
+ *
+ * @return     void
+ */
+__attribute__((section(".code_ram"), noinline)) static void flash_launch_from_ram(void){
+    FTFC->FSTAT = FTFC_FSTAT_CCIF;
+    CORE_REG_WRITTEN(FTFC->FSTAT);
+    while((FTFC->FSTAT & FTFC_FSTAT_CCIF) == 0U);
+}
+
+/*!
+ * @brief     Runs a program flash command whose FCCOB registers are written.
+ *
+ * @return     FLASH_OK or FLASH_ERROR.
+ */
+static unsigned char flash_run_pflash_command(void){
+    unsigned int primask;
+
+    CORE_ENTER_CRITICAL(primask);
+    flash_launch_from_ram();
+    CORE_EXIT_CRITICAL(primask);
+    return flash_fstat_status();
+}
+
+/*!
+ * @brief     Runs a FTFC command whose FCCOB registers are written, and waits for its end.
+ *
+ * @return     FLASH_OK or FLASH_ERROR.
+ */
+static unsigned char flash_run_command(void){
+    FTFC->FSTAT = FTFC_FSTAT_CCIF;
+    CORE_REG_WRITTEN(FTFC->FSTAT);
+    while((FTFC->FSTAT & FTFC_FSTAT_CCIF) == 0U);
+    return flash_fstat_status();
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Initializes the flash driver.
+ *
+ * @detail    Enables the FTFC clock and waits for a command left running by a reset.
+ *
+ * @return    void
+ */
+void Flash_Init(void){
+    PCC_EnableClock(&PCC->PCC_FTFC);
+    FTFC->FCNFG &= ~FTFC_FCNFG_CCIE;
+    while((FTFC->FSTAT & FTFC_FSTAT_CCIF) == 0U);
+}
+
+/*!
+ * @brief     Tells whether a flash command is running.
+ *
+ * @return    1 while a command is running, 0 otherwise.
+ */
+unsigned char Flash_IsBusy(void){
+    return ((FTFC->FSTAT & FTFC_FSTAT_CCIF) == 0U) ? 1U : 0U;
+}
+
+/*!
+ * @brief     Returns the result of the last program or erase command.
+ *
+ * @return    FLASH_BUSY while it runs, FLASH_ERROR if it failed, FLASH_OK otherwise.
+ */
+unsigned char Flash_GetStatus(void){
+    unsigned char status = flash_fstat_status();
+
+    if((status == FLASH_OK) && command_failed){
+        status = FLASH_ERROR;
+    }
+    return status;
+}
+
+/*!
+ * @brief     Starts programming a phrase of the FlexNVM.
+ *
+ * @detail    The phrase must be erased; a phrase can only be programmed once between two
+ *            erases of its sector.
+ *
+ * @param[in]  address Address of the phrase, a multiple of FLASH_PHRASE_SIZE.
+ * @param[in]  data The FLASH_PHRASE_SIZE bytes to program.
+ * @return     FLASH_OK if the command was launched, FLASH_BUSY if a command is running.
+ */
+unsigned char Flash_StartProgramPhrase(unsigned int address, const unsigned char *data){
+    unsigned char i;
+
+    if(Flash_IsBusy()){
+        return FLASH_BUSY;
+    }
+    flash_set_command(FTFC_CMD_PROGRAM_PHRASE, address);
+    command_failed = 0U;
+    for(i = 0U; i < FLASH_PHRASE_SIZE; i++){
+        FTFC_FCCOB(4U + i) = data[i];   /* FCCOB4 holds the byte at the lowest address */
+    }
+    FTFC->FSTAT = FTFC_FSTAT_CCIF;
+    CORE_REG_WRITTEN(FTFC->FSTAT);
+    return FLASH_OK;
+}
+
+/*!
+ * @brief     Starts erasing a sector of the FlexNVM.
+ *
+ * @param[in]  address Address of the sector, a multiple of FLASH_DFLASH_SECTOR.
+ * @return     FLASH_OK if the command was launched, FLASH_BUSY if a command is running.
+ */
+unsigned char Flash_StartEraseSector(unsigned int address){
+    if(Flash_IsBusy()){
+        return FLASH_BUSY;
+    }
+    flash_set_command(FTFC_CMD_ERASE_SECTOR, address);
+    command_failed = 0U;
+    FTFC->FSTAT = FTFC_FSTAT_CCIF;
+    CORE_REG_WRITTEN(FTFC->FSTAT);
+    return FLASH_OK;
+}
+
+/*!
+ * @brief     Enables the command complete interrupt.
+ *
+ * @detail    CCIF stays set while no command runs, so the interrupt handler disables the
+ *            interrupt with Flash_DisableDoneIrq() before it returns.
+ *
+ * @return    void
+ */
+void Flash_EnableDoneIrq(void){
+    FTFC->FCNFG |= FTFC_FCNFG_CCIE;
+}
+
+/*!
+ * @brief     Disables the command complete interrupt.
+ *
+ * @return    void
+ */
+void Flash_DisableDoneIrq(void){
+    FTFC->FCNFG &= ~FTFC_FCNFG_CCIE;
+}
+
+/*!
+ * @brief     Makes the FlexRAM available for EEPROM emulation.
+ *
+ * @detail    A partitioned FlexNVM is loaded into the FlexRAM by the reset, so nothing is
+ *            done then. A blank device is partitioned first; this is done once in the life of
+ *            the device and takes some milliseconds. If the EEE cannot be started, the FlexRAM
+ *            is made traditional RAM so that it can still be used, without persistence.
+ *            Called before the FlexNVM is used otherwise.
+ *
+ * @return     FLASH_OK if the FlexRAM is EEPROM, FLASH_ERROR if it is traditional RAM.
+ */
+unsigned char Flash_EeeInit(void){
+    if(FTFC->FCNFG & FTFC_FCNFG_EEERDY){
+        return FLASH_OK;
+    }
+    FTFC->FSTAT = FLASH_FSTAT_ERRORS;
+    CORE_REG_WRITTEN(FTFC->FSTAT);
+    FTFC_FCCOB(0) = FTFC_CMD_PROGRAM_PARTITION;
+    FTFC_FCCOB(1) = 0x00U;                      /* No CSEc key storage */
+    FTFC_FCCOB(2) = 0x00U;                      /* No security flag extension */
+    FTFC_FCCOB(3) = FLASH_LOAD_EEE_AT_RESET;
+    FTFC_FCCOB(4) = FLASH_EEE_SIZE_CODE;
+    FTFC_FCCOB(5) = FLASH_DEPART_CODE;
+    (void)flash_run_command();                  /* Fails if already partitioned, which is fine */
+
+    FTFC->FSTAT = FLASH_FSTAT_ERRORS;
+    CORE_REG_WRITTEN(FTFC->FSTAT);
+    FTFC_FCCOB(0) = FTFC_CMD_SET_FLEXRAM;
+    FTFC_FCCOB(1) = FTFC_FLEXRAM_EEE;
+    if((flash_run_command() == FLASH_OK) && (FTFC->FCNFG & FTFC_FCNFG_EEERDY)){
+        return FLASH_OK;
+    }
+
+    FTFC->FSTAT = FLASH_FSTAT_ERRORS;
+    CORE_REG_WRITTEN(FTFC->FSTAT);
+    FTFC_FCCOB(0) = FTFC_CMD_SET_FLEXRAM;
+    FTFC_FCCOB(1) = FTFC_FLEXRAM_RAM;
+    (void)flash_run_command();
+    return FLASH_ERROR;
+}
+
+/*!
+ * @brief     Writes data to the EEPROM emulation.
+ *
+ * @detail    Only the 32-bit words that differ from the FlexRAM are written, each one being
+ *            a flash record of the EEE backup, so rewriting unchanged data costs no wear.
+ *            Each write waits until the FTFC has saved it, about 100 us. A program or erase
+ *            command that is running is waited for first, and its result is kept for
+ *            Flash_GetStatus().
+ *
+ * @param[in]  address FlexRAM address, a multiple of 4.
+ * @param[in]  data The data, aligned on 4 bytes.
+ * @param[in]  size Size of the data in bytes, a multiple of 4.
+ * @return     FLASH_OK, or FLASH_ERROR if a write failed.
+ */
+unsigned char Flash_EeeWrite(unsigned int address, const unsigned char *data, unsigned int size){
+    volatile unsigned int *eee = (volatile unsigned int *)FLASH_MAP(address);
+    const unsigned int *words = (const unsigned int *)data;
+    unsigned int i;
+
+    for(i = 0U; i < size / 4U; i++){
+        if(eee[i] == words[i]){
+            continue;
+        }
+        flash_wait_idle();
+        while((FTFC->FCNFG & FTFC_FCNFG_EEERDY) == 0U);
+        FTFC->FSTAT = FLASH_FSTAT_ERRORS;
+        CORE_REG_WRITTEN(FTFC->FSTAT);
+        eee[i] = words[i];
+        CORE_REG_WRITTEN(eee[i]);
+        while(Flash_IsBusy());
+        if(flash_fstat_status() != FLASH_OK){
+            return FLASH_ERROR;
+        }
+    }
+    return FLASH_OK;
+}
+
+/*!
+ * @brief     Programs a phrase of the program flash.
+ *
+ * @detail    Blocks with the interrupts masked for the program time, under 100 us. A
+ *            FlexNVM command that is running is waited for first, and its result is kept for
+ *            Flash_GetStatus().
+ *
+ * @param[in]  address Address of the phrase, a multiple of FLASH_PHRASE_SIZE. The phrase must
+ *                     be erased.
+ * @param[in]  data The FLASH_PHRASE_SIZE bytes to program.
+ * @return     FLASH_OK, or FLASH_ERROR if the command failed.
+ */
+unsigned char Flash_ProgramPFlashPhrase(unsigned int address, const unsigned char *data){
+    unsigned char i;
+
+    flash_wait_idle();
+    flash_set_command(FTFC_CMD_PROGRAM_PHRASE, address);
+    for(i = 0U; i < FLASH_PHRASE_SIZE; i++){
+        FTFC_FCCOB(4U + i) = data[i];
+    }
+    return flash_run_pflash_command();
+}
+
+/*!
+ * @brief     Erases a sector of the program flash.
+ *
+ * @detail    Blocks with the interrupts masked for the erase time, several milliseconds, so
+ *            it is only called where no interrupt has a deadline that short. A FlexNVM
+ *            command that is running is waited for first.
+ *
+ * @param[in]  address Address of the sector, a multiple of FLASH_PFLASH_SECTOR.
+ * @return     FLASH_OK, or FLASH_ERROR if the command failed.
+ */
+unsigned char Flash_ErasePFlashSector(unsigned int address){
+    flash_wait_idle();
+    flash_set_command(FTFC_CMD_ERASE_SECTOR, address);
+    return flash_run_pflash_command();
+}
@@ -0,0 +1,175 @@
+/**
+*   @file    fp_reply.c
+*   @brief   Implementation of the parser of the fingerprint sensor replies.
+*   @details The header is matched byte by byte; a byte that breaks the match restarts it, at
+*            that byte if it is the first header byte. Once the header is matched the frame is
+*            delimited by its length field alone: a payload may contain the header bytes (a
+*            notepad page often does), so the match is not run inside a frame. A frame with a
+*            length out of range is dropped as soon as the length is known, one with a wrong
+*            sum at its end.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "fp_reply.h"
+#include "lpuart.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+/* Frame after the header: identifier, length (2), code, data, sum (2) */
+#define FRAME_PID               0U
+#define FRAME_CODE              3U
+#define FRAME_DATA              4U
+#define FRAME_MIN_LENGTH        3U              /* Code and sum */
+#define FRAME_MAX_LENGTH        (FRAME_MIN_LENGTH + FP_REPLY_MAX_DATA)
+#define FRAME_SIZE              (3U + FRAME_MAX_LENGTH)
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static const unsigned char header[FP_REPLY_HEADER_SIZE] = {0xEF, 0x01, 0xFF, 0xFF, 0xFF, 0xFF};
+
+/* Frame being received */
+static unsigned char matched;                   /* Header bytes matched in a row */
+static unsigned char count;                     /* Frame bytes received after the header */
+static unsigned char end;                       /* Frame bytes announced by the length field */
+static unsigned short sum;
+static unsigned char frame[FRAME_SIZE];
+
+/* Last reply accepted */
+static unsigned char reply[FRAME_SIZE];
+static unsigned char reply_data;                /* Data bytes, after the code */
+static unsigned char reply_valid;
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Drops the frame being received and the last reply.
+ *
+ * @return    void
+ */
+void FpReply_Reset(void){
+    matched = 0U;
+    count = 0U;
+    reply_valid = 0U;
+}
+
+/*!
+ * @brief     Parses a byte received from the sensor.
+ *
+ * @detail    Called from the LPUART2 interrupt. When the byte completes a valid reply, the
+ *            reply replaces the last one.
+ *
+ * @param[in]  byte The byte received.
+ * @return    1 if the byte completed a valid reply, 0 otherwise.
+ */
+unsigned char FpReply_Feed(unsigned char byte){
+    unsigned int length;
+    unsigned int i;
+
+    if(matched < FP_REPLY_HEADER_SIZE){
+        if(byte == header[matched]){
+            matched++;
+        }else{
+            matched = (byte == header[0]) ? 1U : 0U;
+        }
+        count = 0U;
+        sum = 0U;
+        return 0U;
+    }
+
+    frame[count++] = byte;
+    if(count < FRAME_CODE){
+        sum += byte;
+        return 0U;
+    }
+    if(count == FRAME_CODE){
+        sum += byte;
+        length = ((unsigned int)frame[1] << 8) | byte;
+        if((frame[FRAME_PID] != FP_REPLY_PID_ACK) || (length < FRAME_MIN_LENGTH) || (length > FRAME_MAX_LENGTH)){
+            matched = (byte == header[0]) ? 1U : 0U;
+            return 0U;
+        }
+        end = (unsigned char)(FRAME_CODE + length);
+        return 0U;
+    }
+    if(count <= end - 2U){
+        sum += byte;
+        return 0U;
+    }
+    if(count < end){
+        return 0U;
+    }
+
+    matched = 0U;
+    if((((unsigned int)frame[end - 2U] << 8) | frame[end - 1U]) != sum){
+        return 0U;
+    }
+    for(i = 0U; i < end; i++){
+        reply[i] = frame[i];
+    }
+    reply_data = (unsigned char)(end - FRAME_DATA - 2U);
+    reply_valid = 1U;
+    return 1U;
+}
+
+/*!
+ * @brief     Forgets the last reply, so that it is not mistaken for the answer to the next
+ *            command.
+ *
+ * @return    void
+ */
+void FpReply_Invalidate(void){
+    reply_valid = 0U;
+}
+
+/*!
+ * @brief     Gives the confirmation code of the last reply.
+ *
+ * @return    The code, FINGERPRINT_UNDEFINED_ERROR if there is no reply.
+ */
+unsigned char FpReply_Code(void){
+    return reply_valid ? reply[FRAME_CODE] : FINGERPRINT_UNDEFINED_ERROR;
+}
+
+/*!
+ * @brief     Gives the number of data bytes of the last reply, after the confirmation code.
+ *
+ * @return    The number of bytes, 0 if there is no reply.
+ */
+unsigned int FpReply_DataLength(void){
+    return reply_valid ? reply_data : 0U;
+}
+
+/*!
+ * @brief     Reads a big-endian 16-bit word of the data of the last reply.
+ *
+ * @param[in]  offset Offset of the word in the data, after the confirmation code.
+ * @return    The word, FP_REPLY_NO_WORD if the reply does not carry it.
+ */
+unsigned int FpReply_Word(unsigned int offset){
+    if(!reply_valid || (offset + 2U > reply_data)){
+        return FP_REPLY_NO_WORD;
+    }
+    return ((unsigned int)reply[FRAME_DATA + offset] << 8) | reply[FRAME_DATA + offset + 1U];
+}
+
+/*!
+ * @brief     Gives the data of the last reply.
+ *
+ * @param[in]  size Number of bytes the caller reads.
+ * @return    The data, 0 if the reply carries fewer bytes.
+ */
+const unsigned char *FpReply_Data(unsigned int size){
+    if(!reply_valid || (size > reply_data)){
+        return 0;
+    }
+    return &reply[FRAME_DATA];
+}
@@ -0,0 +1,239 @@
+/**
+*   @file    hotset.c
+*   @brief   Implementation of the hot tier of the fingerprint library.
+*   @details Saved map: 'H' 'T', then the user of each slot (u16, little-endian, HOTSET_NO_USER
+*            when empty). The hit counts are halved at every rebalance, so they follow the
+*            recent entries rather than the whole history.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "hotset.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define HOTSET_MAX_HITS         0xFFU
+#define HOTSET_MARGIN           2U              /* Hits a user needs above a slot to take it */
+
+#if (2U + (HOTSET_SLOTS * 2U)) > HOTSET_MAP_SIZE
+#error "The map must fit in one notepad page"
+#endif
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static unsigned short slot_user[HOTSET_SLOTS];
+static unsigned char hits[HOTSET_MAX_USERS];
+static unsigned char identifications;             /* Since the last rebalance */
+
+/*==================================================================================================
+*                                       LOCAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Finds the slot of a user.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @return    The slot, HOTSET_SLOTS if the user has none.
+ */
+static unsigned int hotset_find(unsigned int user_id){
+    unsigned int slot;
+
+    for(slot = 0U; (slot < HOTSET_SLOTS) && (slot_user[slot] != user_id); slot++){
+    }
+    return slot;
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Empties the slots and clears the hit counts.
+ *
+ * @return    void
+ */
+void HotSet_Init(void){
+    unsigned int i;
+
+    for(i = 0U; i < HOTSET_SLOTS; i++){
+        slot_user[i] = HOTSET_NO_USER;
+    }
+    for(i = 0U; i < HOTSET_MAX_USERS; i++){
+        hits[i] = 0U;
+    }
+    identifications = 0U;
+}
+
+/*!
+ * @brief     Restores the map saved in the sensor notepad.
+ *
+ * @detail    A page without the signature (never written) leaves every slot empty; a user
+ *            out of range or named twice empties its slot.
+ *
+ * @param[in]  map HOTSET_MAP_SIZE bytes.
+ * @return    void
+ */
+void HotSet_LoadMap(const unsigned char *map){
+    unsigned int slot;
+    unsigned int user_id;
+
+    for(slot = 0U; slot < HOTSET_SLOTS; slot++){
+        slot_user[slot] = HOTSET_NO_USER;
+    }
+    if((map[0] != 'H') || (map[1] != 'T')){
+        return;
+    }
+    for(slot = 0U; slot < HOTSET_SLOTS; slot++){
+        user_id = (unsigned int)(map[2U + 2U * slot] | (map[3U + 2U * slot] << 8));
+        if((user_id < HOTSET_MAX_USERS) && (hotset_find(user_id) == HOTSET_SLOTS)){
+            slot_user[slot] = (unsigned short)user_id;
+        }
+    }
+}
+
+/*!
+ * @brief     Builds the map to save in the sensor notepad.
+ *
+ * @param[out] map HOTSET_MAP_SIZE bytes.
+ * @return    void
+ */
+void HotSet_SaveMap(unsigned char *map){
+    unsigned int i;
+
+    for(i = 0U; i < HOTSET_MAP_SIZE; i++){
+        map[i] = 0xFFU;
+    }
+    map[0] = 'H';
+    map[1] = 'T';
+    for(i = 0U; i < HOTSET_SLOTS; i++){
+        map[2U + 2U * i] = (unsigned char)slot_user[i];
+        map[3U + 2U * i] = (unsigned char)(slot_user[i] >> 8);
+    }
+}
+
+/*!
+ * @brief     Returns the user whose template a hot page holds.
+ *
+ * @detail    Called from the LPUART2 interrupt on the unlock path.
+ *
+ * @param[in]  slot Hot page, from the first one.
+ * @return    The fingerprint ID, HOTSET_NO_USER for an empty slot or a slot out of range.
+ */
+unsigned int HotSet_GetUser(unsigned int slot){
+    return (slot < HOTSET_SLOTS) ? slot_user[slot] : HOTSET_NO_USER;
+}
+
+/*!
+ * @brief     Counts the filled slots.
+ *
+ * @return    The number of slots, 0 when the hot search is not worth sending.
+ */
+unsigned char HotSet_Count(void){
+    unsigned char slot;
+    unsigned char count = 0U;
+
+    for(slot = 0U; slot < HOTSET_SLOTS; slot++){
+        if(slot_user[slot] != HOTSET_NO_USER){
+            count++;
+        }
+    }
+    return count;
+}
+
+/*!
+ * @brief     Empties the slot of a user whose template is about to be replaced.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @return    1 if the map changed and must be saved, 0 otherwise.
+ */
+unsigned char HotSet_Forget(unsigned int user_id){
+    unsigned int slot = hotset_find(user_id);
+
+    if(slot == HOTSET_SLOTS){
+        return 0U;
+    }
+    slot_user[slot] = HOTSET_NO_USER;
+    return 1U;
+}
+
+/*!
+ * @brief     Counts an identification of a user.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @return    1 when a rebalance is due, see HotSet_Plan(); 0 otherwise.
+ */
+unsigned char HotSet_Hit(unsigned int user_id){
+    if((user_id < HOTSET_MAX_USERS) && (hits[user_id] < HOTSET_MAX_HITS)){
+        hits[user_id]++;
+    }
+    if(++identifications < HOTSET_REBALANCE){
+        return 0U;
+    }
+    identifications = 0U;
+    return 1U;
+}
+
+/*!
+ * @brief     Chooses the next template to move into the hot pages, then ages the counts.
+ *
+ * @detail    The most frequent user without a slot takes an empty slot, or the slot of the
+ *            least frequent hot user if it has HOTSET_MARGIN more hits, so that two users of
+ *            the same frequency do not swap at every rebalance. The chosen slot is emptied
+ *            at once: the caller saves the map, copies the template, then fills the slot with
+ *            HotSet_SetSlot().
+ *
+ * @param[out] slot The slot to fill.
+ * @param[out] user_id The user to copy into it.
+ * @return    1 if a template should be moved, 0 otherwise.
+ */
+unsigned char HotSet_Plan(unsigned int *slot, unsigned int *user_id){
+    unsigned int best = HOTSET_NO_USER;
+    unsigned int victim = 0U;
+    unsigned int i;
+    unsigned char move;
+
+    for(i = 0U; i < HOTSET_MAX_USERS; i++){
+        if((hits[i] > ((best == HOTSET_NO_USER) ? 0U : hits[best])) && (hotset_find(i) == HOTSET_SLOTS)){
+            best = i;
+        }
+    }
+    for(i = 1U; i < HOTSET_SLOTS; i++){
+        if((slot_user[victim] != HOTSET_NO_USER) &&
+           ((slot_user[i] == HOTSET_NO_USER) || (hits[slot_user[i]] < hits[slot_user[victim]]))){
+            victim = i;
+        }
+    }
+    move = ((best != HOTSET_NO_USER) &&
+            ((slot_user[victim] == HOTSET_NO_USER) ||
+             (hits[best] >= hits[slot_user[victim]] + HOTSET_MARGIN))) ? 1U : 0U;
+
+    for(i = 0U; i < HOTSET_MAX_USERS; i++){
+        hits[i] >>= 1;
+    }
+    if(!move){
+        return 0U;
+    }
+    slot_user[victim] = HOTSET_NO_USER;
+    *slot = victim;
+    *user_id = best;
+    return 1U;
+}
+
+/*!
+ * @brief     Fills a slot once the template of the user has been copied to its page.
+ *
+ * @param[in]  slot The slot.
+ * @param[in]  user_id Fingerprint ID.
+ * @return    void
+ */
+void HotSet_SetSlot(unsigned int slot, unsigned int user_id){
+    if((slot < HOTSET_SLOTS) && (user_id < HOTSET_MAX_USERS) && (hotset_find(user_id) == HOTSET_SLOTS)){
+        slot_user[slot] = (unsigned short)user_id;
+    }
+}
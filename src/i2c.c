@@ -15,6 +15,10 @@
 
 #include "i2c.h"
 #include "systick.h"
+#include "clock.h"
+#include "pcc.h"
+#include "probe.h"
+#include "core.h"
 
 /*==================================================================================================
 *                                      DEFINES AND MACROS
@@ -40,11 +44,45 @@ enum err
 /* I2C address of the LCD display */
 #define SLAVE_ADDRESS_LCD 0x4E 
 
+/* Module clock the MCCR0/MCCR1 counts are computed for */
+#define LPI2C0_TIMING_CLOCK 8000000U
+
+/* Power-on wait of the LCD controller before the first command */
+#define LCD_POWER_ON_MS 50U /* wait for >40ms*/
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/* One command of the LCD initialization and the wait that follows it */
+typedef struct {
+	unsigned char cmd;
+	unsigned char wait_ms;
+} lcd_init_step_t;
+
 /*==================================================================================================
 *                                       STATIC VARIABLES
 ==================================================================================================*/
 static unsigned char error = 0;
 
+/* LCD initialization sequence (HD44780 in 4 bit mode) */
+static const lcd_init_step_t lcd_init_steps[] = {
+	{0x30, 5},   /* wait for >4.1ms*/
+	{0x30, 1},   /* wait for >100us*/
+	{0x30, 10},
+	{0x20, 10},  /* 4bit mode*/
+	{0x28, 1},   /* Function set --> DL=0 (4 bit mode), N = 1 (2 line display) F = 0 (5x8 characters)*/
+	{0x08, 1},   /*Display on/off control --> D=0,C=0, B=0  ---> display off*/
+	{0x01, 2},   /* clear display*/
+	{0x06, 1},   /*Entry mode set --> I/D = 1 (increment cursor) & S = 0 (no shift)*/
+	{0x0C, 0}    /*Display on/off control --> D = 1, C and B = 0. (Cursor and blink, last two bits)*/
+};
+static unsigned char lcd_init_index = 0;
+
+/* Frame buffer: what the application wants on the LCD, and what the LCD currently shows */
+static char lcd_fb[LCD_ROWS][LCD_COLS];
+static char lcd_shadow[LCD_ROWS][LCD_COLS];
+
 /*==================================================================================================
 *                                       GLOBAL FUNCTIONS
 ==================================================================================================*/
@@ -52,7 +90,8 @@ static unsigned char error = 0;
 /*******************************************************************************
 Function Name : LPI2C0_init
 Notes         : BAUD RATE: 400 kbps
-                I2C module frequency 8Mhz (SIRCDIV2_CLK)
+                I2C module frequency 8Mhz (SIRCDIV2_CLK), higher clocks are prescaled
+                by LPI2C0_set_timing()
                 PRESCALER:0x00; FILTSCL/SDA:0x0/0x0; SETHOLD:0x4; CLKLO:0x0B; CLKHI:0x05; DATAVD:0x02
                 See Table 50-10 Example timing configuration in S32K1xx Reference manual rev.9
  *******************************************************************************/
@@ -124,6 +163,30 @@ void init_LPI2C0(void)
     // [2] DOZEN = 0 (Master is disabled in Doze mode)
     // [1] RST = 0   (Master logic is not reset)
     // [0] MEN = 1   (Master logic is enabled)
+
+    LPI2C0_set_timing();
+}
+
+/**
+* @brief    Adapts the LPI2C0 timing to its functional clock.
+* @return   None
+* @details  The CLKLO/CLKHI/SETHOLD/DATAVD counts of init_LPI2C0() are given for an 8 MHz
+*           module clock. The prescaler is set to the smallest division that brings the
+*           functional clock (read from the clock tree) down to 8 MHz or less, so the bus stays
+*           at or below 400 kbps. Must be called after a change of the functional clock, never
+*           during a transfer.
+*/
+void LPI2C0_set_timing(void)
+{
+    unsigned int fclk = Clock_GetPeripheralFreq(&PCC->PCC_LPI2C0);
+    unsigned int prescale = 0;
+
+    while (((fclk >> prescale) > LPI2C0_TIMING_CLOCK) && (prescale < 7U)) {
+        prescale++;
+    }
+    LPI2C0->MCR_REGISTER &= ~0x1U;              // MEN = 0 while the timing changes
+    LPI2C0->MCFGR1_REGISTER = (LPI2C0->MCFGR1_REGISTER & ~0x7U) | prescale;
+    LPI2C0->MCR_REGISTER |= 0x1U;               // MEN = 1
 }
 
 /**
@@ -157,6 +220,7 @@ Notes         : Generate (repeated) START and transmit address in DATA[7:0]
 void generate_start_ACK(unsigned char address)
 {
     LPI2C0->MTDR_REGISTER =  (unsigned int)((4U << 8U) | (address & 0xFF));
+    CORE_REG_WRITTEN(LPI2C0->MTDR_REGISTER);
 }
 
 /**
@@ -169,6 +233,7 @@ void transmit_data(unsigned char data)
 {
 	//while(!LPI2C0->MSR.TDF);
     LPI2C0->MTDR_REGISTER = (unsigned int)((0U << 8U) | (data & 0xFF));
+    CORE_REG_WRITTEN(LPI2C0->MTDR_REGISTER);
 }
 
 /**
@@ -185,6 +250,7 @@ unsigned char generate_stop(void)
     unsigned char stop_sent_err   = 0;
 
     LPI2C0->MTDR_REGISTER = 0x0200; //command
+    CORE_REG_WRITTEN(LPI2C0->MTDR_REGISTER);
 
     while((!(LPI2C0->MSR.SDF)) && (!stop_sent_err))
     {
@@ -352,30 +418,46 @@ void lcd_clear_rtc (void)
 * @brief    Initializes the LCD for 4-bit communication.
 * @details  Sends a sequence of commands to initialize the LCD in 4-bit mode and set up 
 *           the display parameters, including cursor increment and display on/off settings.
+*           Blocks for about 80 ms; lcd_init_start() and lcd_init_step() run the same
+*           sequence without blocking.
 */
 void lcd_init (void)
 {
-	/* 4 bit initialisation*/
-	delay(50, 80000000); /* wait for >40ms*/
-	lcd_send_cmd (0x30);
-	delay(5, 80000000);  /* wait for >4.1ms*/
-	lcd_send_cmd (0x30);
-	delay(1, 80000000);  /* wait for >100us*/
-	lcd_send_cmd (0x30);
-	delay(10, 80000000);
-	lcd_send_cmd (0x20); /* 4bit mode*/
-	delay(10, 80000000);
-
-  // dislay initialisation
-	lcd_send_cmd (0x28); /* Function set --> DL=0 (4 bit mode), N = 1 (2 line display) F = 0 (5x8 characters)*/
-	delay(1, 80000000);
-	lcd_send_cmd (0x08); /*Display on/off control --> D=0,C=0, B=0  ---> display off*/
-	delay(1, 80000000);
-	lcd_send_cmd (0x01);  /* clear display*/
-	delay(2, 80000000);
-	lcd_send_cmd (0x06); /*Entry mode set --> I/D = 1 (increment cursor) & S = 0 (no shift)*/
-	delay(1, 80000000);
-	lcd_send_cmd (0x0C); /*Display on/off control --> D = 1, C and B = 0. (Cursor and blink, last two bits)*/
+	unsigned int wait_ms = lcd_init_start();
+	while (wait_ms != LCD_INIT_DONE)
+	{
+		delay(wait_ms);
+		wait_ms = lcd_init_step();
+	}
+}
+
+/**
+* @brief    Starts the non-blocking LCD initialization.
+* @return   Time to wait before the first call of lcd_init_step(), in ms.
+* @details  The caller waits the returned time (from power-up) and then calls
+*           lcd_init_step() after each returned wait until it returns LCD_INIT_DONE.
+*/
+unsigned int lcd_init_start(void)
+{
+	lcd_init_index = 0;
+	return LCD_POWER_ON_MS;
+}
+
+/**
+* @brief    Sends the next command of the LCD initialization.
+* @return   Time to wait before the next call in ms, LCD_INIT_DONE after the last command.
+*/
+unsigned int lcd_init_step(void)
+{
+	const lcd_init_step_t *step = &lcd_init_steps[lcd_init_index];
+
+	lcd_send_cmd(step->cmd);
+	lcd_init_index++;
+	if (lcd_init_index >= (sizeof(lcd_init_steps) / sizeof(lcd_init_steps[0])))
+	{
+		return LCD_INIT_DONE;
+	}
+	return step->wait_ms;
 }
 
 /**
@@ -385,8 +467,113 @@ void lcd_init (void)
 */
 void lcd_send_string (char *str)
 {
+	PROBE_BEGIN(PROBE_LCD_STRING);
 	while (*str) lcd_send_data (*str++);
+	PROBE_END(PROBE_LCD_STRING);
+}
+
+/**
+* @brief    Initializes the LCD frame buffer.
+* @details  Fills the frame buffer and its shadow copy with blank spaces. Must be called right
+*           after lcd_init(), which leaves the display cleared.
+*/
+void lcd_fb_init(void)
+{
+	unsigned char row, col;
+	for (row = 0; row < LCD_ROWS; row++)
+	{
+		for (col = 0; col < LCD_COLS; col++)
+		{
+			lcd_fb[row][col] = ' ';
+			lcd_shadow[row][col] = ' ';
+		}
+	}
 }
 
+/**
+* @brief    Fills one row of the frame buffer with blank spaces.
+* @param    row: The row number (0 or 1).
+*/
+void lcd_fb_clear_row(unsigned char row)
+{
+	unsigned char col;
+	if (row >= LCD_ROWS) return;
+	for (col = 0; col < LCD_COLS; col++)
+	{
+		lcd_fb[row][col] = ' ';
+	}
+}
 
+/**
+* @brief    Writes a string into the frame buffer.
+* @param    row: The row number (0 or 1).
+* @param    col: The first column (0-15).
+* @param    str: Pointer to the null-terminated string. Characters past the end of the row are dropped.
+* @details  Only the frame buffer is modified; the display is updated by lcd_fb_flush().
+*/
+void lcd_fb_write(unsigned char row, unsigned char col, const char *str)
+{
+	if (row >= LCD_ROWS) return;
+	while ((*str) && (col < LCD_COLS))
+	{
+		lcd_fb[row][col++] = *str++;
+	}
+}
+
+/**
+* @brief    Writes a fixed-width field into the frame buffer.
+* @param    row:   The row number (0 or 1).
+* @param    col:   The first column (0-15).
+* @param    str:   Pointer to the string. It does not need to be null-terminated if it is at least
+*                  width characters long.
+* @param    width: Width of the field. The string is padded with blank spaces up to this width.
+*/
+void lcd_fb_write_field(unsigned char row, unsigned char col, const char *str, unsigned char width)
+{
+	unsigned char i;
+	if (row >= LCD_ROWS) return;
+	for (i = 0; (i < width) && (col < LCD_COLS); i++, col++)
+	{
+		if (*str)
+		{
+			lcd_fb[row][col] = *str++;
+		}
+		else
+		{
+			lcd_fb[row][col] = ' ';
+		}
+	}
+}
+
+/**
+* @brief    Sends the changed part of the frame buffer to the LCD.
+* @return   Returns the number of characters written to the LCD.
+* @details  Compares the frame buffer with the shadow copy of the display and only sends the
+*           characters that differ. The cursor is repositioned only when the next changed
+*           character is not at the current cursor position.
+*/
+unsigned int lcd_fb_flush(void)
+{
+	unsigned char row, col;
+	unsigned char cursor_row = LCD_ROWS;
+	unsigned char cursor_col = 0;
+	unsigned int written = 0;
 
+	for (row = 0; row < LCD_ROWS; row++)
+	{
+		for (col = 0; col < LCD_COLS; col++)
+		{
+			if (lcd_fb[row][col] == lcd_shadow[row][col]) continue;
+			if ((cursor_row != row) || (cursor_col != col))
+			{
+				lcd_put_cur(row, col);
+				cursor_row = row;
+			}
+			lcd_send_data(lcd_fb[row][col]);
+			lcd_shadow[row][col] = lcd_fb[row][col];
+			cursor_col = col + 1;
+			written++;
+		}
+	}
+	return written;
+}
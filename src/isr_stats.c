@@ -0,0 +1,180 @@
+/**
+*   @file    isr_stats.c
+*   @brief   Implementation of the interrupt latency and duration statistics.
+*   @details The handlers at the same priority run one at a time, so the module keeps one start
+*            stamp per handler and one waiting stamp per request, without locking. The NVIC
+*            pending bits of the watched interrupts are read at the entry and at the exit of
+*            every handler; when none is pending, which is the common case, that is two loads.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "isr_stats.h"
+
+#if PROBE_ENABLE
+
+#include "core.h"
+#include "dwt_registers.h"
+#include "nvic.h"
+#include "nvic_registers.h"
+#include "systick_registers.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define IRQ_BIT(irq)            (1U << ((unsigned int)(irq) & 31U))
+
+/* Watched interrupts in the pending registers 0 (IRQ 0-31) and 1 (IRQ 32-63) */
+#define WATCHED_0               IRQ_BIT(IRQ_FTFC)
+#define WATCHED_1               (IRQ_BIT(IRQ_LPUART1_RXTX) | IRQ_BIT(IRQ_LPUART2_RXTX) | \
+                                 IRQ_BIT(IRQ_RTC) | IRQ_BIT(IRQ_RTC_SECONDS) | \
+                                 IRQ_BIT(IRQ_PORTC) | IRQ_BIT(IRQ_LPTMR0))
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+typedef struct {
+    unsigned int start;                     /* Cycle counter at the entry */
+    unsigned int since;                     /* Cycle counter from which the request waits */
+    unsigned char waiting;                  /* The request was seen pending behind a handler */
+    isr_stats_t stats;
+} isr_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static isr_t isrs[ISR_COUNT];
+
+/* NVIC interrupt of each handler, SysTick is a core exception */
+static const unsigned char isr_irqs[ISR_COUNT] = {
+    0U, IRQ_LPUART2_RXTX, IRQ_LPUART1_RXTX, IRQ_RTC_SECONDS, IRQ_RTC, IRQ_FTFC, IRQ_PORTC, IRQ_LPTMR0
+};
+
+static const char *const isr_names[ISR_COUNT] = {
+    "isr systick", "isr lpuart2", "isr lpuart1", "isr rtc seconds", "isr rtc", "isr ftfc",
+    "isr portc", "isr lptmr0"
+};
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+/* Starts the wait of the watched requests pending behind the running handler */
+static void isr_mark_waiting(unsigned int since){
+    unsigned int pending[2];
+    unsigned int id;
+
+    pending[0] = NVIC->NVIC_ISPR[0] & WATCHED_0;
+    pending[1] = NVIC->NVIC_ISPR[1] & WATCHED_1;
+    if((pending[0] | pending[1]) == 0U){
+        return;
+    }
+    for(id = ISR_SYSTICK + 1U; id < ISR_COUNT; id++){
+        if(!isrs[id].waiting && (pending[isr_irqs[id] >> 5] & IRQ_BIT(isr_irqs[id]))){
+            isrs[id].waiting = 1U;
+            isrs[id].since = since;
+        }
+    }
+}
+
+static void isr_add_latency(isr_t *isr, unsigned int cycles){
+    isr->stats.latency_count++;
+    if(cycles > isr->stats.latency_max){
+        isr->stats.latency_max = cycles;
+    }
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Starts the measurement of a handler, first thing in the handler.
+ *
+ * @param[in]  id ISR_xxx ID.
+ * @return    void
+ */
+void IsrStats_Enter(unsigned int id){
+    unsigned int now = DWT->CYCCNT;
+    isr_t *isr = &isrs[id];
+
+    isr->start = now;
+    if(id == ISR_SYSTICK){
+        isr_add_latency(isr, SYSTICK->SYST_RVR.RELOAD - SYSTICK->SYST_CVR.CURRENT);
+    }else if(isr->waiting){
+        isr->waiting = 0U;
+        isr_add_latency(isr, now - isr->since);
+    }
+    isr_mark_waiting(now);
+}
+
+/*!
+ * @brief     Ends the measurement of a handler, last thing in the handler.
+ *
+ * @param[in]  id ISR_xxx ID.
+ * @return    void
+ */
+void IsrStats_Exit(unsigned int id){
+    isr_t *isr = &isrs[id];
+    unsigned int cycles = DWT->CYCCNT - isr->start;
+
+    isr_mark_waiting(isr->start);
+    isr->stats.count++;
+    isr->stats.duration_total += cycles;
+    if(cycles > isr->stats.duration_max){
+        isr->stats.duration_max = cycles;
+    }
+}
+
+/*!
+ * @brief     Copies the statistics of a handler.
+ *
+ * @param[in]  id ISR_xxx ID.
+ * @param[out] stats The statistics.
+ * @return    void
+ */
+void IsrStats_Get(unsigned int id, isr_stats_t *stats){
+    unsigned int primask;
+
+    CORE_ENTER_CRITICAL(primask);
+    *stats = isrs[id].stats;
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Returns the name of a handler, for the reports.
+ *
+ * @param[in]  id ISR_xxx ID.
+ * @return    The name.
+ */
+const char *IsrStats_GetName(unsigned int id){
+    return isr_names[id];
+}
+
+/*!
+ * @brief     Clears the statistics of every handler.
+ *
+ * @return    void
+ */
+void IsrStats_Reset(void){
+    unsigned int primask;
+    unsigned int id;
+
+    CORE_ENTER_CRITICAL(primask);
+    for(id = 0U; id < ISR_COUNT; id++){
+        isrs[id].waiting = 0U;
+        isrs[id].stats.count = 0U;
+        isrs[id].stats.duration_max = 0U;
+        isrs[id].stats.duration_total = 0U;
+        isrs[id].stats.latency_count = 0U;
+        isrs[id].stats.latency_max = 0U;
+    }
+    CORE_EXIT_CRITICAL(primask);
+}
+
+#endif /* PROBE_ENABLE */
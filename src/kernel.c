@@ -0,0 +1,681 @@
+/**
+*   @file    kernel.c
+*   @brief   Implementation of the preemptive fixed-priority micro-kernel.
+*   @details The thread ID is the priority, as for the scheduler tasks: a ready bit mask gives
+*            the highest priority ready thread with a count-trailing-zeros. Every kernel object
+*            keeps a bit mask of its waiting threads, so waking the highest priority waiter costs
+*            the same whatever the number of threads. Kernel state is only changed with
+*            interrupts masked. A change that makes a higher priority thread ready pends PendSV;
+*            PendSV runs at the lowest exception priority, so the switch happens as soon as the
+*            last interrupt handler returns or the running thread leaves its critical section.
+*
+*            The context switch (PendSV handler, initial stack frame, start) is the port layer;
+*            in a host build it is provided by the behavioural model in host/kernel_model.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "kernel.h"
+#include "core.h"
+#ifndef HOST_BUILD
+#include "scb_registers.h"
+#include "dwt_registers.h"
+#endif
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief Thread control block.
+ */
+typedef struct {
+    unsigned int          *sp;          /*!< Saved stack pointer, must stay the first member (PendSV) */
+    volatile unsigned int *wait_list;   /*!< Waiters mask of the object waited for, 0 if not waiting */
+    unsigned int           timeout;     /*!< Milliseconds left before the wait times out */
+    unsigned int           wait_mask;   /*!< Event flags waited for */
+    unsigned int           result;      /*!< Flags or message handed over by the waker */
+    unsigned int           status;      /*!< Status of the last wait */
+    unsigned int          *stack;       /*!< Stack storage, for the high-water mark */
+    unsigned int           stack_words; /*!< Size of the stack storage in words, 0 if no thread */
+} kernel_thread_t;
+
+/*==================================================================================================
+*                                       GLOBAL VARIABLES
+==================================================================================================*/
+
+/* Used by the PendSV handler */
+__attribute__((used)) kernel_thread_t *kernel_current = 0;
+__attribute__((used)) kernel_switch_stats_t kernel_switch_stats;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static kernel_thread_t threads[KERNEL_MAX_THREADS];
+static volatile unsigned int ready_mask = 0;
+static volatile unsigned int sleepers = 0;      /* Threads in Kernel_Delay() */
+
+/*==================================================================================================
+*                                         PORT LAYER
+==================================================================================================*/
+
+#ifdef HOST_BUILD
+
+void kernel_port_pend(void);
+unsigned int *kernel_port_init_stack(unsigned char thread_id, kernel_entry_t entry, void *arg,
+                                     unsigned int *stack, unsigned int stack_words);
+void kernel_port_start(void) __attribute__((noreturn));
+
+#else
+
+static void kernel_thread_exit(void);
+
+/*!
+ * @brief     Requests a context switch.
+ *
+ * @return    void
+ */
+static void kernel_port_pend(void){
+    SCB->ICSR = SCB_ICSR_PENDSVSET;
+}
+
+/*!
+ * @brief     Builds the initial stack frame of a thread.
+ *
+ * @detail    The frame is the one the PendSV handler restores: R4-R11 and EXC_RETURN, then the
+ *            exception frame popped by the core on return. EXC_RETURN selects thread mode with
+ *            the process stack and no FPU context.
+ *
+ * @param[in] thread_id:   Thread ID.
+ * @param[in] entry:       Thread entry point.
+ * @param[in] arg:         Argument passed in R0.
+ * @param[in] stack:       Stack storage.
+ * @param[in] stack_words: Size of the stack storage in words.
+ * @return    Initial stack pointer of the thread.
+ */
+static unsigned int *kernel_port_init_stack(unsigned char thread_id, kernel_entry_t entry, void *arg,
+                                            unsigned int *stack, unsigned int stack_words){
+    unsigned int *sp = (unsigned int *)((unsigned int)(stack + stack_words) & ~7U);
+    unsigned char i;
+    (void)thread_id;
+
+    *(--sp) = 0x01000000U;                              /* xPSR: Thumb state */
+    *(--sp) = (unsigned int)entry & ~1U;                /* PC */
+    *(--sp) = (unsigned int)kernel_thread_exit;         /* LR */
+    for(i = 0; i < 4U; i++){
+        *(--sp) = 0U;                                   /* R12, R3, R2, R1 */
+    }
+    *(--sp) = (unsigned int)arg;                        /* R0 */
+    *(--sp) = 0xFFFFFFFDU;                              /* EXC_RETURN */
+    for(i = 0; i < 8U; i++){
+        *(--sp) = 0U;                                   /* R11..R4 */
+    }
+    return sp;
+}
+
+/*!
+ * @brief     Starts the first thread.
+ *
+ * @detail    Gives PendSV the lowest exception priority, starts the DWT cycle counter used by
+ *            the switch statistics and pends the first switch. The handler does not save the
+ *            caller context since kernel_current is 0; the main stack is left to the interrupt
+ *            handlers.
+ *
+ * @return    This function never returns.
+ */
+__attribute__((noreturn)) static void kernel_port_start(void){
+    SCB->SHPR3 |= (0xFFU << SCB_SHPR3_PENDSV_SHIFT);
+    DEMCR |= DEMCR_TRCENA;
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA;
+
+    CORE_DISABLE_IRQ();
+    kernel_current = 0;
+    kernel_port_pend();
+    CORE_ENABLE_IRQ();
+    while(1){}
+}
+
+/*!
+ * @brief     Handles the PendSV exception: switches to the highest priority ready thread.
+ *
+ * @detail    Saves R4-R11, EXC_RETURN and, when the thread used the FPU, S16-S31 on the process
+ *            stack of the running thread, lets Kernel_SwitchContext() pick the next thread and
+ *            restores its context the same way. The duration of the handler is measured with
+ *            the DWT cycle counter into kernel_switch_stats.
+ *
+ * @return    void
+ */
+__attribute__((naked)) void PendSV_Handler(void){
+    __asm volatile (
+        "cpsid    i                                         \n"
+        "movw     r3, #0x1004                               \n"   /* DWT->CYCCNT */
+        "movt     r3, #0xE000                               \n"
+        "ldr      r12, [r3]                                 \n"
+        "movw     r1, #:lower16:kernel_switch_stats         \n"
+        "movt     r1, #:upper16:kernel_switch_stats         \n"
+        "str      r12, [r1]                                 \n"   /* start */
+        "mrs      r0, psp                                   \n"
+        "movw     r2, #:lower16:kernel_current              \n"
+        "movt     r2, #:upper16:kernel_current              \n"
+        "ldr      r2, [r2]                                  \n"
+        "cbz      r2, 1f                                    \n"   /* First switch: nothing to save */
+        "tst      lr, #0x10                                 \n"
+        "it       eq                                        \n"
+        "vstmdbeq r0!, {s16-s31}                            \n"
+        "stmdb    r0!, {r4-r11, lr}                         \n"
+        "1:                                                 \n"
+        "bl       Kernel_SwitchContext                      \n"
+        "ldmia    r0!, {r4-r11, lr}                         \n"
+        "tst      lr, #0x10                                 \n"
+        "it       eq                                        \n"
+        "vldmiaeq r0!, {s16-s31}                            \n"
+        "msr      psp, r0                                   \n"
+        "movw     r3, #0x1004                               \n"
+        "movt     r3, #0xE000                               \n"
+        "ldr      r3, [r3]                                  \n"
+        "movw     r1, #:lower16:kernel_switch_stats         \n"
+        "movt     r1, #:upper16:kernel_switch_stats         \n"
+        "ldr      r2, [r1]                                  \n"
+        "subs     r3, r3, r2                                \n"
+        "str      r3, [r1, #4]                              \n"   /* last */
+        "ldr      r2, [r1, #8]                              \n"
+        "cmp      r3, r2                                    \n"
+        "it       hi                                        \n"
+        "strhi    r3, [r1, #8]                              \n"   /* max */
+        "cpsie    i                                         \n"
+        "bx       lr                                        \n"
+    );
+}
+
+#endif /* HOST_BUILD */
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Returns the highest priority thread of a non-empty thread mask.
+ *
+ * @param[in] mask: Thread bit mask.
+ * @return    Thread ID.
+ */
+static unsigned char kernel_highest(unsigned int mask){
+    return (unsigned char)__builtin_ctz(mask);
+}
+
+/*!
+ * @brief     Pends a context switch if a thread of higher priority than the running one is ready.
+ *
+ * @detail    Must be called with interrupts masked.
+ *
+ * @return    void
+ */
+static void kernel_reschedule(void){
+    unsigned int current_id;
+    if(kernel_current == 0){
+        return;
+    }
+    current_id = (unsigned int)(kernel_current - threads);
+    if((ready_mask & ((1U << current_id) - 1U)) != 0U){
+        kernel_port_pend();
+    }
+}
+
+/*!
+ * @brief     Blocks the running thread on a kernel object.
+ *
+ * @detail    Must be called with interrupts masked; the switch happens when the caller leaves
+ *            its critical section with kernel_wait_end(). The status of the wait is
+ *            KERNEL_TIMEOUT unless the waker changes it.
+ *
+ * @param[in] wait_list: Waiters mask of the object.
+ * @param[in] timeout:   Timeout in milliseconds, or KERNEL_WAIT_FOREVER.
+ * @return    void
+ */
+static void kernel_wait(volatile unsigned int *wait_list, unsigned int timeout){
+    unsigned int bit = 1U << (unsigned int)(kernel_current - threads);
+    *wait_list |= bit;
+    kernel_current->wait_list = wait_list;
+    kernel_current->timeout = timeout;
+    kernel_current->status = KERNEL_TIMEOUT;
+    ready_mask &= ~bit;
+    kernel_port_pend();
+}
+
+/*!
+ * @brief     Leaves the critical section of a blocking call and lets the switch happen.
+ *
+ * @param[in] primask: PRIMASK saved when the critical section was entered.
+ * @return    Status of the wait, once the thread runs again.
+ */
+static unsigned int kernel_wait_end(unsigned int primask){
+    CORE_EXIT_CRITICAL(primask);
+    CORE_ISB();
+    return kernel_current->status;
+}
+
+/*!
+ * @brief     Makes a waiting thread ready.
+ *
+ * @detail    Must be called with interrupts masked.
+ *
+ * @param[in] thread_id: Waiting thread.
+ * @param[in] status:    Status returned by the wait.
+ * @return    void
+ */
+static void kernel_wake(unsigned char thread_id, unsigned int status){
+    kernel_thread_t *thread = &threads[thread_id];
+    unsigned int bit = 1U << thread_id;
+    *thread->wait_list &= ~bit;
+    thread->wait_list = 0;
+    thread->status = status;
+    ready_mask |= bit;
+}
+
+#ifndef HOST_BUILD
+/*!
+ * @brief     Called when a thread function returns: the thread is never scheduled again.
+ *
+ * @return    This function never returns.
+ */
+static void kernel_thread_exit(void){
+    unsigned int primask;
+    CORE_ENTER_CRITICAL(primask);
+    ready_mask &= ~(1U << (unsigned int)(kernel_current - threads));
+    kernel_port_pend();
+    CORE_EXIT_CRITICAL(primask);
+    while(1){}
+}
+#endif
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Initializes the kernel.
+ *
+ * @return    void
+ */
+void Kernel_Init(void){
+    unsigned char i;
+    for(i = 0; i < KERNEL_MAX_THREADS; i++){
+        threads[i].sp = 0;
+        threads[i].wait_list = 0;
+        threads[i].stack_words = 0;
+    }
+    kernel_current = 0;
+    ready_mask = 0;
+    sleepers = 0;
+    kernel_switch_stats.last = 0;
+    kernel_switch_stats.max = 0;
+}
+
+/*!
+ * @brief     Creates a thread.
+ *
+ * @detail    The thread is ready at once; it runs when Kernel_Start() is called or, if the
+ *            kernel already runs, as soon as it is the highest priority ready thread. The stack
+ *            is painted first, see Kernel_GetStackUsage().
+ *
+ * @param[in] thread_id:   Thread ID, from 0 to KERNEL_MAX_THREADS - 1. It is also the priority.
+ * @param[in] entry:       Thread entry point.
+ * @param[in] arg:         Argument passed to the entry point.
+ * @param[in] stack:       Stack storage, must remain valid for the life of the thread.
+ * @param[in] stack_words: Size of the stack storage in words.
+ * @return    void
+ */
+void Kernel_ThreadCreate(unsigned char thread_id, kernel_entry_t entry, void *arg,
+                         unsigned int *stack, unsigned int stack_words){
+    unsigned int primask;
+    if(thread_id >= KERNEL_MAX_THREADS){
+        return;
+    }
+    Stack_Paint(stack, stack_words);
+    CORE_ENTER_CRITICAL(primask);
+    threads[thread_id].stack = stack;
+    threads[thread_id].stack_words = stack_words;
+    threads[thread_id].sp = kernel_port_init_stack(thread_id, entry, arg, stack, stack_words);
+    threads[thread_id].wait_list = 0;
+    ready_mask |= (1U << thread_id);
+    kernel_reschedule();
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Starts the kernel with the highest priority ready thread.
+ *
+ * @return    This function never returns.
+ */
+void Kernel_Start(void){
+    kernel_port_start();
+}
+
+/*!
+ * @brief     Saves the stack pointer of the running thread and selects the next thread.
+ *
+ * @detail    Called by the context switch with interrupts masked.
+ *
+ * @param[in] sp: Stack pointer of the running thread after its context was saved.
+ * @return    Stack pointer of the thread to run.
+ */
+unsigned int *Kernel_SwitchContext(unsigned int *sp){
+    if(kernel_current != 0){
+        kernel_current->sp = sp;
+    }
+    kernel_current = &threads[kernel_highest(ready_mask)];
+    return kernel_current->sp;
+}
+
+/*!
+ * @brief     Returns the ID of the running thread.
+ *
+ * @return    Thread ID.
+ */
+unsigned char Kernel_CurrentThread(void){
+    return (unsigned char)(kernel_current - threads);
+}
+
+/*!
+ * @brief     Advances the timeouts by one millisecond.
+ *
+ * @detail    Must be called from the SysTick interrupt handler. Threads whose wait times out
+ *            are made ready.
+ *
+ * @return    void
+ */
+void Kernel_Tick(void){
+    unsigned int primask;
+    unsigned char i;
+
+    CORE_ENTER_CRITICAL(primask);
+    for(i = 0; i < KERNEL_MAX_THREADS; i++){
+        if((threads[i].wait_list != 0) && (threads[i].timeout != KERNEL_WAIT_FOREVER)){
+            threads[i].timeout--;
+            if(threads[i].timeout == 0U){
+                kernel_wake(i, KERNEL_TIMEOUT);
+            }
+        }
+    }
+    kernel_reschedule();
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Gives the time left before the next wait times out.
+ *
+ * @return    Milliseconds to the first timeout, KERNEL_WAIT_FOREVER when no wait can time out.
+ */
+unsigned int Kernel_NextTimeout(void){
+    unsigned int next = KERNEL_WAIT_FOREVER;
+    unsigned char i;
+    for(i = 0; i < KERNEL_MAX_THREADS; i++){
+        if((threads[i].wait_list != 0) && (threads[i].timeout < next)){
+            next = threads[i].timeout;
+        }
+    }
+    return next;
+}
+
+/*!
+ * @brief     Suspends the running thread.
+ *
+ * @param[in] ms: Delay in milliseconds.
+ * @return    void
+ */
+void Kernel_Delay(unsigned int ms){
+    unsigned int primask;
+    if(ms == 0U){
+        return;
+    }
+    CORE_ENTER_CRITICAL(primask);
+    kernel_wait(&sleepers, ms);
+    (void)kernel_wait_end(primask);
+}
+
+/*!
+ * @brief     Initializes a counting semaphore.
+ *
+ * @param[in] sem:   Semaphore.
+ * @param[in] count: Initial number of units.
+ * @return    void
+ */
+void Kernel_SemInit(kernel_sem_t *sem, unsigned int count){
+    sem->count = count;
+    sem->waiters = 0;
+}
+
+/*!
+ * @brief     Gives one unit of a semaphore.
+ *
+ * @detail    The highest priority waiting thread, if any, receives the unit. May be called from
+ *            interrupt handlers.
+ *
+ * @param[in] sem: Semaphore.
+ * @return    void
+ */
+void Kernel_SemGive(kernel_sem_t *sem){
+    unsigned int primask;
+    CORE_ENTER_CRITICAL(primask);
+    if(sem->waiters != 0U){
+        kernel_wake(kernel_highest(sem->waiters), KERNEL_OK);
+        kernel_reschedule();
+    }else{
+        sem->count++;
+    }
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Takes one unit of a semaphore, waiting for it if needed.
+ *
+ * @detail    Must be called from a thread with interrupts enabled.
+ *
+ * @param[in] sem:     Semaphore.
+ * @param[in] timeout: Timeout in milliseconds, KERNEL_NO_WAIT or KERNEL_WAIT_FOREVER.
+ * @return    KERNEL_OK, or KERNEL_TIMEOUT if no unit was given in time.
+ */
+unsigned int Kernel_SemTake(kernel_sem_t *sem, unsigned int timeout){
+    unsigned int primask;
+    unsigned int status = KERNEL_OK;
+    CORE_ENTER_CRITICAL(primask);
+    if(sem->count > 0U){
+        sem->count--;
+    }else if(timeout == KERNEL_NO_WAIT){
+        status = KERNEL_TIMEOUT;
+    }else{
+        kernel_wait(&sem->waiters, timeout);
+        return kernel_wait_end(primask);
+    }
+    CORE_EXIT_CRITICAL(primask);
+    return status;
+}
+
+/*!
+ * @brief     Initializes event flags.
+ *
+ * @param[in] flags: Event flags.
+ * @return    void
+ */
+void Kernel_FlagsInit(kernel_flags_t *flags){
+    flags->flags = 0;
+    flags->waiters = 0;
+}
+
+/*!
+ * @brief     Sets event flags.
+ *
+ * @detail    Waiting threads are served by priority; each one receives, and clears, the set
+ *            flags it waits for. May be called from interrupt handlers.
+ *
+ * @param[in] flags: Event flags.
+ * @param[in] mask:  Flags to set.
+ * @return    void
+ */
+void Kernel_FlagsSet(kernel_flags_t *flags, unsigned int mask){
+    unsigned int primask;
+    unsigned int waiters;
+    unsigned int received;
+    unsigned char thread_id;
+
+    CORE_ENTER_CRITICAL(primask);
+    flags->flags |= mask;
+    waiters = flags->waiters;
+    while(waiters != 0U){
+        thread_id = kernel_highest(waiters);
+        waiters &= waiters - 1U;
+        received = flags->flags & threads[thread_id].wait_mask;
+        if(received != 0U){
+            flags->flags &= ~received;
+            threads[thread_id].result = received;
+            kernel_wake(thread_id, KERNEL_OK);
+        }
+    }
+    kernel_reschedule();
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Waits for any of the given event flags.
+ *
+ * @detail    The received flags are cleared. Must be called from a thread with interrupts
+ *            enabled.
+ *
+ * @param[in] flags:   Event flags.
+ * @param[in] mask:    Flags to wait for.
+ * @param[in] timeout: Timeout in milliseconds, KERNEL_NO_WAIT or KERNEL_WAIT_FOREVER.
+ * @return    The received flags, 0 on timeout.
+ */
+unsigned int Kernel_FlagsWait(kernel_flags_t *flags, unsigned int mask, unsigned int timeout){
+    unsigned int primask;
+    unsigned int received;
+
+    CORE_ENTER_CRITICAL(primask);
+    received = flags->flags & mask;
+    if((received == 0U) && (timeout != KERNEL_NO_WAIT)){
+        kernel_current->wait_mask = mask;
+        kernel_wait(&flags->waiters, timeout);
+        if(kernel_wait_end(primask) != KERNEL_OK){
+            return 0U;
+        }
+        return kernel_current->result;
+    }
+    flags->flags &= ~received;
+    CORE_EXIT_CRITICAL(primask);
+    return received;
+}
+
+/*!
+ * @brief     Initializes a message queue.
+ *
+ * @param[in] queue:  Message queue.
+ * @param[in] buffer: Message storage, must remain valid for the life of the queue.
+ * @param[in] size:   Number of messages the storage holds.
+ * @return    void
+ */
+void Kernel_QueueInit(kernel_queue_t *queue, unsigned int *buffer, unsigned char size){
+    queue->buffer = buffer;
+    queue->size = size;
+    queue->head = 0;
+    queue->count = 0;
+    queue->waiters = 0;
+}
+
+/*!
+ * @brief     Puts a message at the end of a queue.
+ *
+ * @detail    If a thread waits for a message, the highest priority one receives it at once.
+ *            Never blocks; may be called from interrupt handlers.
+ *
+ * @param[in] queue:   Message queue.
+ * @param[in] message: Message.
+ * @return    KERNEL_OK, or KERNEL_FULL if the queue has no free slot.
+ */
+unsigned int Kernel_QueuePut(kernel_queue_t *queue, unsigned int message){
+    unsigned int primask;
+    unsigned int status = KERNEL_OK;
+    unsigned char thread_id;
+
+    CORE_ENTER_CRITICAL(primask);
+    if(queue->waiters != 0U){
+        thread_id = kernel_highest(queue->waiters);
+        threads[thread_id].result = message;
+        kernel_wake(thread_id, KERNEL_OK);
+        kernel_reschedule();
+    }else if(queue->count >= queue->size){
+        status = KERNEL_FULL;
+    }else{
+        queue->buffer[(queue->head + queue->count) % queue->size] = message;
+        queue->count++;
+    }
+    CORE_EXIT_CRITICAL(primask);
+    return status;
+}
+
+/*!
+ * @brief     Gets the oldest message of a queue, waiting for one if needed.
+ *
+ * @detail    Must be called from a thread with interrupts enabled.
+ *
+ * @param[in]  queue:   Message queue.
+ * @param[out] message: Received message.
+ * @param[in]  timeout: Timeout in milliseconds, KERNEL_NO_WAIT or KERNEL_WAIT_FOREVER.
+ * @return    KERNEL_OK, or KERNEL_TIMEOUT if no message arrived in time.
+ */
+unsigned int Kernel_QueueGet(kernel_queue_t *queue, unsigned int *message, unsigned int timeout){
+    unsigned int primask;
+    unsigned int status = KERNEL_OK;
+
+    CORE_ENTER_CRITICAL(primask);
+    if(queue->count > 0U){
+        *message = queue->buffer[queue->head];
+        queue->head = (unsigned char)((queue->head + 1U) % queue->size);
+        queue->count--;
+    }else if(timeout == KERNEL_NO_WAIT){
+        status = KERNEL_TIMEOUT;
+    }else{
+        kernel_wait(&queue->waiters, timeout);
+        status = kernel_wait_end(primask);
+        if(status == KERNEL_OK){
+            *message = kernel_current->result;
+        }
+        return status;
+    }
+    CORE_EXIT_CRITICAL(primask);
+    return status;
+}
+
+/*!
+ * @brief     Reads the context switch statistics.
+ *
+ * @param[out] stats: Cycles of the last and of the slowest context switch.
+ * @return    void
+ */
+void Kernel_GetSwitchStats(kernel_switch_stats_t *stats){
+    unsigned int primask;
+    CORE_ENTER_CRITICAL(primask);
+    *stats = kernel_switch_stats;
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Gives the size of the stack of a thread and its high-water mark.
+ *
+ * @param[in]  thread_id: Thread ID.
+ * @param[out] usage:     The size and the bytes of the stack used, 0 and 0 if there is no such
+ *                        thread.
+ * @return    void
+ */
+void Kernel_GetStackUsage(unsigned char thread_id, stack_usage_t *usage){
+    if((thread_id >= KERNEL_MAX_THREADS) || (threads[thread_id].stack_words == 0U)){
+        usage->size = 0U;
+        usage->used = 0U;
+        return;
+    }
+    usage->size = threads[thread_id].stack_words * 4U;
+    usage->used = Stack_Used(threads[thread_id].stack, threads[thread_id].stack_words);
+}
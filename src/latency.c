@@ -0,0 +1,143 @@
+/**
+*   @file    latency.c
+*   @brief   Implementation of the touch to unlock latency statistics.
+*   @details The durations are kept in a ring per metric; a report sorts a copy of the ring, so
+*            the cost of the percentiles is only paid when they are asked for.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "latency.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#if (LATENCY_WINDOW & (LATENCY_WINDOW - 1U)) != 0U
+#error "LATENCY_WINDOW must be a power of two"
+#endif
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static unsigned short window[LATENCY_METRICS][LATENCY_WINDOW];
+static unsigned int count;                      /* Attempts recorded */
+
+static const char *const metric_names[LATENCY_METRICS] = {
+    "image", "features", "search", "unlock", "total"
+};
+
+/*==================================================================================================
+*                                       LOCAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Returns a duration in the unit of the window.
+ *
+ * @param[in]  from Start, milliseconds.
+ * @param[in]  to End, milliseconds.
+ * @return    to - from, LATENCY_MAX_MS at most.
+ */
+static unsigned short latency_duration(unsigned int from, unsigned int to){
+    unsigned int ms = to - from;
+
+    return (ms > LATENCY_MAX_MS) ? (unsigned short)LATENCY_MAX_MS : (unsigned short)ms;
+}
+
+/*!
+ * @brief     Returns a percentile of sorted durations.
+ *
+ * @param[in]  sorted The durations, in increasing order.
+ * @param[in]  size Their number, at least 1.
+ * @param[in]  percent The percentile.
+ * @return    The smallest duration that percent % of the durations do not exceed.
+ */
+static unsigned short latency_percentile(const unsigned short *sorted, unsigned int size, unsigned int percent){
+    return sorted[(percent * size + 99U) / 100U - 1U];
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Clears the statistics.
+ *
+ * @return    void
+ */
+void Latency_Init(void){
+    unsigned char metric;
+    unsigned int i;
+
+    for(metric = 0U; metric < LATENCY_METRICS; metric++){
+        for(i = 0U; i < LATENCY_WINDOW; i++){
+            window[metric][i] = 0U;
+        }
+    }
+    count = 0U;
+}
+
+/*!
+ * @brief     Records a granted attempt.
+ *
+ * @param[in]  marks The LATENCY_MARK_xxx times, in order.
+ * @return    void
+ */
+void Latency_Record(const unsigned int marks[LATENCY_MARKS]){
+    unsigned int slot = count & (LATENCY_WINDOW - 1U);
+    unsigned char metric;
+
+    for(metric = 0U; metric < LATENCY_TOTAL; metric++){
+        window[metric][slot] = latency_duration(marks[metric], marks[metric + 1U]);
+    }
+    window[LATENCY_TOTAL][slot] = latency_duration(marks[LATENCY_MARK_TOUCH], marks[LATENCY_MARK_UNLOCK]);
+    count++;
+}
+
+/*!
+ * @brief     Computes the percentiles of a metric over the last LATENCY_WINDOW attempts.
+ *
+ * @param[in]  metric LATENCY_xxx metric.
+ * @param[out] report The percentiles, all 0 before the first attempt.
+ * @return    void
+ */
+void Latency_GetReport(unsigned char metric, latency_report_t *report){
+    unsigned short sorted[LATENCY_WINDOW];
+    unsigned short value;
+    unsigned int size = (count < LATENCY_WINDOW) ? count : LATENCY_WINDOW;
+    unsigned int i;
+    unsigned int j;
+
+    report->count = count;
+    report->p50 = 0U;
+    report->p90 = 0U;
+    report->p99 = 0U;
+    report->max = 0U;
+    if((metric >= LATENCY_METRICS) || (size == 0U)){
+        return;
+    }
+    for(i = 0U; i < size; i++){
+        value = window[metric][i];
+        for(j = i; (j > 0U) && (sorted[j - 1U] > value); j--){
+            sorted[j] = sorted[j - 1U];
+        }
+        sorted[j] = value;
+    }
+    report->p50 = latency_percentile(sorted, size, 50U);
+    report->p90 = latency_percentile(sorted, size, 90U);
+    report->p99 = latency_percentile(sorted, size, 99U);
+    report->max = sorted[size - 1U];
+}
+
+/*!
+ * @brief     Returns the name of a metric, for the reports.
+ *
+ * @param[in]  metric LATENCY_xxx metric.
+ * @return    The name.
+ */
+const char *Latency_GetName(unsigned char metric){
+    return (metric < LATENCY_METRICS) ? metric_names[metric] : "";
+}
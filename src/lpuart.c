@@ -4,7 +4,10 @@
 
 #include "lpuart.h"
 #include "pcc.h"
-#include "systick.h"
+#include "clock.h"
+#include "probe.h"
+#include "trace.h"
+#include "core.h"
 
 /*==================================================================================================
 *                                      DEFINES AND MACROS
@@ -40,8 +43,44 @@ unsigned char FPCreateCharFile2[7]={0x01,0x00,0x04,0x02,0x02,0x00,0x09};
 unsigned char FPCreateCharFile3[7]={0x01,0x00,0x04,0x02,0x03,0x00,0x0A};
 unsigned char FPCreateTemplate[6]={0x01,0x00,0x03,0x05,0x00,0x09};
 unsigned char FPDeleteAllFinger[6]={0x01,0x00,0x03,0x0D,0x00,0x11};
-unsigned char FPSearchFinger[11]={0x01,0x00,0x08,0x04,0x01,0x00,0x00,0x00,0x40,0x00,0x4E};
+unsigned char FPSearchFinger[11]={0x01,0x00,0x08,0x04,0x01,0x00,0x00,0x03,0xE8,0x00,0xF9};
 unsigned char FPGetNumberOfFinger[6]={0x01,0x00,0x03,0x1D,0x00,0x21};
+unsigned char FPReadSysPara[6]={0x01,0x00,0x03,0x0F,0x00,0x13};
+
+/*!
+ * @brief  Command table indexed by fp_command_t.
+ *
+ * @detail Packet (without header) and packet length of each fixed command, used by the
+ *         non-blocking sendFPCommand().
+ *
+ */
+static unsigned char* const FPCommandPacket[FP_CMD_COUNT] = {
+	FPGetImage, FPCreateCharFile1, FPCreateCharFile2, FPCreateTemplate,
+	FPDeleteAllFinger, FPSearchFinger, FPGetNumberOfFinger, FPReadSysPara
+};
+static const unsigned char FPCommandLength[FP_CMD_COUNT] = {
+	sizeof(FPGetImage), sizeof(FPCreateCharFile1), sizeof(FPCreateCharFile2), sizeof(FPCreateTemplate),
+	sizeof(FPDeleteAllFinger), sizeof(FPSearchFinger), sizeof(FPGetNumberOfFinger),
+	sizeof(FPReadSysPara)
+};
+
+/*==================================================================================================
+*                                       STATIC FUNCTIONS
+==================================================================================================*/
+/*!
+ * @brief     Gives the PCC register of an LPUART module.
+ *
+ * @param[in] LPUARTx Pointer to the LPUART module.
+ * @return    PCC register of the module.
+ */
+static volatile unsigned int* LPUART_pcc(LPUART_t* LPUARTx){
+	if(LPUARTx == LPUART0){
+		return &PCC->PCC_LPUART0;
+	}else if(LPUARTx == LPUART1){
+		return &PCC->PCC_LPUART1;
+	}
+	return &PCC->PCC_LPUART2;
+}
 
 /*==================================================================================================
 *                                       GLOBAL FUNCTIONS
@@ -70,13 +109,7 @@ void LPUART_init_clock(volatile unsigned int* PCC_LPUARTx){
  * @return    void
  */
 void LPUART_config_baud9600(LPUART_t* LPUARTx){
-	/* BAUD rate = Fclk /(OSR *(SBR + 1)*/
-	/* Fclk = 40000000, Baud rate = 9600, OSR = 16 -->  SBR = 260*/
-	LPUARTx->BAUD.SBR = 260;
-	LPUARTx->BAUD.OSR = 15;
-	LPUARTx->BAUD.SBNS = 0; /*1 stop bit*/
-	LPUARTx->CTRL.M = 0;		/*8 bit data*/
-	LPUARTx->CTRL.PE = 0; 	/*No parity enable*/
+	LPUART_config_baud(LPUARTx, 9600);
 }
 
 /*!
@@ -88,13 +121,58 @@ void LPUART_config_baud9600(LPUART_t* LPUARTx){
  * @return    void
  */
 void LPUART_config_baud57600(LPUART_t* LPUARTx){
-	/* BAUD rate = Fclk /(OSR *(SBR + 1)*/
-	/* Fclk = 40000000, Baud rate = 57600, OSR = 16 -->  SBR = 42*/
-	LPUARTx->BAUD.SBR = 42;
-	LPUARTx->BAUD.OSR = 15;
+	LPUART_config_baud(LPUARTx, 57600);
+}
+
+/*!
+ * @brief     Configures the LPUART module for any baud rate from its functional clock.
+ *
+ * @detail    The functional clock is read from the clock tree (PCC source of the module).
+ *            Picks the oversampling ratio (4 to 32) and the divider that give the baud rate
+ *            closest to the requested one: BAUD rate = Fclk / (OSR * SBR). Oversampling ratios
+ *            below 8 sample on both edges. The transmitter and the receiver are stopped while
+ *            the BAUD register is written and restored afterwards; the caller makes sure no
+ *            frame is in progress. Must be called again after a change of the functional clock.
+ *
+ * @param[in] LPUARTx Pointer to the LPUART module.
+ * @param[in] baud    Baud rate.
+ * @return    void
+ */
+void LPUART_config_baud(LPUART_t* LPUARTx, unsigned int baud){
+	unsigned int fclk = Clock_GetPeripheralFreq(LPUART_pcc(LPUARTx));
+	unsigned int osr;
+	unsigned int sbr;
+	unsigned int error;
+	unsigned int best_osr = 16;
+	unsigned int best_sbr = 1;
+	unsigned int best_error = 0xFFFFFFFFU;
+	unsigned char te = LPUARTx->CTRL.TE;
+	unsigned char re = LPUARTx->CTRL.RE;
+
+	for(osr = 4; osr <= 32; osr++){
+		sbr = (fclk + (osr * baud) / 2) / (osr * baud);
+		if((sbr == 0) || (sbr > 0x1FFF)){
+			continue;
+		}
+		error = fclk / (osr * sbr);
+		error = (error > baud) ? (error - baud) : (baud - error);
+		if(error < best_error){
+			best_error = error;
+			best_osr = osr;
+			best_sbr = sbr;
+		}
+	}
+
+	LPUARTx->CTRL.TE = 0;
+	LPUARTx->CTRL.RE = 0;
+	LPUARTx->BAUD.OSR = best_osr - 1;
+	LPUARTx->BAUD.SBR = best_sbr;
+	LPUARTx->BAUD.BOTHEDGE = (best_osr < 8) ? 1 : 0;
 	LPUARTx->BAUD.SBNS = 0; /*1 stop bit*/
 	LPUARTx->CTRL.M = 0;		/*8 bit data*/
 	LPUARTx->CTRL.PE = 0; 	/*No parity enable*/
+	LPUARTx->CTRL.TE = te;
+	LPUARTx->CTRL.RE = re;
 }
 
 /*!
@@ -135,7 +213,8 @@ void LPUART_enable_receiver(LPUART_t* LPUARTx){
  */
 void LPUART_send_byte(LPUART_t* LPUARTx, unsigned char send){
 	while (!(LPUARTx->STAT.TDRE));
-	LPUARTx->DATA_REGISTER |= send;
+	LPUARTx->DATA_REGISTER = send;
+	CORE_REG_WRITTEN(LPUARTx->DATA_REGISTER);
 }
 
 /*!
@@ -150,10 +229,12 @@ void LPUART_send_byte(LPUART_t* LPUARTx, unsigned char send){
  */
 void LPUART_send_string(LPUART_t* LPUARTx, unsigned char data_string[])  {  /* Function to Transmit whole string */
 	unsigned int i=0;
+	PROBE_BEGIN(PROBE_UART_STRING);
 	while(data_string[i] != '\0')  {           /* Send chars one at a time */
 		LPUART_send_byte(LPUARTx, data_string[i]);
 		i++;
 	}
+	PROBE_END(PROBE_UART_STRING);
 }
 
 /*!
@@ -173,327 +254,144 @@ void sendFPHeader(LPUART_t* LPUARTx){
 }
 
 /*!
- * @brief     Sends the 'Get Image' command to the fingerprint module.
+ * @brief     Sends a fixed command to the fingerprint module without waiting for the reply.
  *
- * @detail    This function sends the 'Get Image' command to the fingerprint module
- *            and waits for an acknowledgment.
+ * @detail    This function sends the header and the command packet and returns as soon as the
+ *            last byte is in the transmitter. The reply is collected by the LPUART receive
+ *            interrupt through FpReply_Feed(); the caller reads the confirmation code with
+ *            FpReply_Code() once a valid reply is complete.
+ *            The instruction is recorded in the trace ring.
  *
  * @param[in] LPUARTx Pointer to the LPUART module.
- * @param[in] ack Acknowledgment array from the fingerprint module.
- * @param[in] current_core_clock The current core clock frequency.
- * @return    The status of the fingerprint operation.
+ * @param[in] command The command to send.
+ * @return    void
  */
-unsigned char sendFPGetImage(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock){
-	sendFPHeader(LPUARTx);
+void sendFPCommand(LPUART_t* LPUARTx, fp_command_t command){
 	unsigned char i;
-	for(i = 0; i < 6; i++){
-		LPUART_send_byte(LPUARTx, FPGetImage[i]);
+	if(command >= FP_CMD_COUNT){
+		return;
+	}
+	Trace_Record(TRACE_FP_COMMAND, FPCommandPacket[command][3], 0);
+	sendFPHeader(LPUARTx);
+	for(i = 0; i < FPCommandLength[command]; i++){
+		LPUART_send_byte(LPUARTx, FPCommandPacket[command][i]);
 	}
-	delay(2000, current_core_clock);
-	if(ack[1] == 0x07)
-    return ack[4];
-  else return FINGERPRINT_UNDEFINED_ERROR;
 }
 
 /*!
- * @brief     Sends the 'Create Character File 1' command to the fingerprint module.
+ * @brief     Sends a command packet to the fingerprint module without waiting for the reply.
  *
- * @detail    This function sends the 'Create Character File 1' command to the fingerprint
- *            module and waits for an acknowledgment.
+ * @detail    Adds the header, the packet identifier, the length and the checksum, and records
+ *            the instruction in the trace ring.
  *
  * @param[in] LPUARTx Pointer to the LPUART module.
- * @param[in] ack Acknowledgment array from the fingerprint module.
- * @param[in] current_core_clock The current core clock frequency.
- * @return    The status of the fingerprint operation.
+ * @param[in] params Instruction code followed by its parameters.
+ * @param[in] count Number of bytes in params.
+ * @param[in] page Library or notepad page addressed, for the trace.
+ * @return    void
  */
-unsigned char sendFPCreateCharFile1(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock){
-	sendFPHeader(LPUARTx);
+static void sendFPPacket(LPUART_t* LPUARTx, const unsigned char params[], unsigned char count, unsigned short page){
+	unsigned short Sum = 0x01 + 0x00 + count + 2;
 	unsigned char i;
-	for(i = 0; i < 7; i++){
-		LPUART_send_byte(LPUARTx, FPCreateCharFile1[i]);
-	}
-	delay(2000, current_core_clock);
-	if(ack[1] == 0x07)
-    return ack[4];
-  else return FINGERPRINT_UNDEFINED_ERROR;
-}
-
-/*!
- * @brief Sends the "Create Character File 2" command to the fingerprint sensor.
- * @detail This function sends the "Create Character File 2" command and waits for an acknowledgment.
- * @param[in] LPUARTx Pointer to the LPUART instance.
- * @param[out] ack Array to store the acknowledgment response.
- * @param[in] current_core_clock The current core clock for delay calculation.
- * @return The result of the operation (e.g., FP_OK, FP_ERROR).
- */
-unsigned char sendFPCreateCharFile2(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock){
+	Trace_Record(TRACE_FP_COMMAND, params[0], page);
 	sendFPHeader(LPUARTx);
-	unsigned char i;
-	for(i = 0; i < 7; i++){
-		LPUART_send_byte(LPUARTx, FPCreateCharFile2[i]);
+	LPUART_send_byte(LPUARTx, 0x01);
+	LPUART_send_byte(LPUARTx, 0x00);
+	LPUART_send_byte(LPUARTx, count + 2);
+	for(i = 0; i < count; i++){
+		LPUART_send_byte(LPUARTx, params[i]);
+		Sum += params[i];
 	}
-	delay(2000, current_core_clock);
-	if(ack[1] == 0x07)
-    return ack[4];
-  else return FINGERPRINT_UNDEFINED_ERROR;
+	LPUART_send_byte(LPUARTx, Sum >> 8);
+	LPUART_send_byte(LPUARTx, Sum & 0xFF);
 }
 
 /*!
- * @brief Sends the "Create Template" command to the fingerprint sensor.
+ * @brief     Sends the 'Store' command to the fingerprint module without waiting for the reply.
  *
- * @detail This function sends the "Create Template" command, which combines two character files 
- *         into one template. The function waits for an acknowledgment after sending the command.
+ * @detail    Stores the template of character buffer 1 at the given page ID.
  *
- * @param[in] LPUARTx Pointer to the LPUART instance.
- * @param[out] ack Array to store the acknowledgment response.
- * @param[in] current_core_clock The current core clock for delay calculation.
- * @return The result of the operation (e.g., FP_OK, FP_ERROR).
+ * @param[in] IDStore The ID at which to store the fingerprint template, 16-bit.
+ * @param[in] LPUARTx Pointer to the LPUART module.
+ * @return    void
  */
-unsigned char sendFPCreateTemplate(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock){
-	sendFPHeader(LPUARTx);
-	unsigned char i;
-	for(i = 0; i < 6; i++){
-		LPUART_send_byte(LPUARTx, FPCreateTemplate[i]);
-	}
-	delay(2000, current_core_clock);
-	if(ack[1] == 0x07)
-    return ack[4];
-  else return FINGERPRINT_UNDEFINED_ERROR;
+void sendFPStoreCommand(unsigned short IDStore, LPUART_t* LPUARTx){
+	unsigned char params[4] = {0x06, 0x01, 0x00, 0x00};
+	params[2] = IDStore >> 8;
+	params[3] = IDStore & 0xFF;
+	sendFPPacket(LPUARTx, params, sizeof(params), IDStore);
 }
 
 /*!
- * @brief Sends the "Delete All Fingerprints" command to the fingerprint sensor.
+ * @brief     Sends a search of character buffer 1 over a page range without waiting for the reply.
  *
- * @detail This function sends the command to delete all fingerprints stored in the fingerprint 
- *         sensor's memory. The function waits for an acknowledgment after sending the command.
+ * @detail    The high speed search (HighSpeedSearch) stops at the first page that matches
+ *            and is meant for a short range; the reply is the same as for a Search.
  *
- * @param[in] LPUARTx Pointer to the LPUART instance.
- * @param[out] ack Array to store the acknowledgment response.
- * @param[in] current_core_clock The current core clock for delay calculation.
- * @return The result of the operation (e.g., FP_OK, FP_ERROR).
+ * @param[in] LPUARTx Pointer to the LPUART module.
+ * @param[in] high_speed 1 for a HighSpeedSearch, 0 for a Search.
+ * @param[in] start First page searched.
+ * @param[in] pages Number of pages searched.
+ * @return    void
  */
-unsigned char sendFPDeleteAllFinger(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock){
-	sendFPHeader(LPUARTx);
-	unsigned char i;
-	for(i = 0; i < 6; i++){
-		LPUART_send_byte(LPUARTx, FPDeleteAllFinger[i]);
+void sendFPSearchCommand(LPUART_t* LPUARTx, unsigned char high_speed, unsigned short start, unsigned short pages){
+	unsigned char params[6] = {0x04, 0x01, 0x00, 0x00, 0x00, 0x00};
+	if(high_speed){
+		params[0] = 0x1B;
 	}
-	delay(2000, current_core_clock);
-	if(ack[1] == 0x07)
-    return ack[4];
-  else return FINGERPRINT_UNDEFINED_ERROR;
+	params[2] = start >> 8;
+	params[3] = start & 0xFF;
+	params[4] = pages >> 8;
+	params[5] = pages & 0xFF;
+	sendFPPacket(LPUARTx, params, sizeof(params), start);
 }
 
 /*!
- * @brief Sends the "Search Finger" command to the fingerprint sensor.
+ * @brief     Sends the 'LoadChar' command without waiting for the reply.
  *
- * @detail This function sends the "Search Finger" command to identify if the fingerprint matches 
- *         a stored template in the fingerprint sensor. If a match is found, the ID is sent via 
- *         LPUART. The function waits for an acknowledgment after sending the command.
+ * @detail    Loads the template stored at a page into character buffer 1.
  *
- * @param[in] LPUARTx Pointer to the LPUART instance.
- * @param[out] ack Array to store the acknowledgment response.
- * @param[in] current_core_clock The current core clock for delay calculation.
- * @return The result of the operation (e.g., FP_OK, FP_ERROR).
+ * @param[in] LPUARTx Pointer to the LPUART module.
+ * @param[in] page Page of the template.
+ * @return    void
  */
-unsigned char sendFPSearchFinger(LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock){
-	sendFPHeader(LPUARTx);
-	unsigned char i;
-	for(i = 0; i < 11; i++){
-		LPUART_send_byte(LPUARTx, FPSearchFinger[i]);
-	}
-	delay(5000, current_core_clock);
-	if(ack[1] == 0x07){
-		if(ack[3] == 0x07){
-			LPUART_send_byte(LPUART1, ack[5] + 0x30);
-			LPUART_send_byte(LPUART1, 0x0A);
-			LPUART_send_byte(LPUART1, ack[6] + 0x30);
-			LPUART_send_byte(LPUART1, 0x0A);
-    return ack[4];
-		}
-		else return FINGERPRINT_UNDEFINED_ERROR;
-	}
-  else return FINGERPRINT_UNDEFINED_ERROR;
+void sendFPLoadCharCommand(LPUART_t* LPUARTx, unsigned short page){
+	unsigned char params[4] = {0x07, 0x01, 0x00, 0x00};
+	params[2] = page >> 8;
+	params[3] = page & 0xFF;
+	sendFPPacket(LPUARTx, params, sizeof(params), page);
 }
 
 /*!
- * @brief Sends the "Store Fingerprint" command to the fingerprint sensor.
- *
- * @detail This function sends the command to store the fingerprint template at a specified 
- *         ID in the fingerprint sensor's memory. The function waits for an acknowledgment 
- *         after sending the command.
+ * @brief     Sends the 'WriteNotepad' command without waiting for the reply.
  *
- * @param[in] IDStore The ID at which to store the fingerprint template.
- * @param[in] LPUARTx Pointer to the LPUART instance.
- * @param[out] ack Array to store the acknowledgment response.
- * @param[in] current_core_clock The current core clock for delay calculation.
- * @return The result of the operation (e.g., FP_OK, FP_ERROR).
+ * @param[in] LPUARTx Pointer to the LPUART module.
+ * @param[in] page Notepad page, 0 to FP_NOTEPAD_PAGES - 1.
+ * @param[in] data FP_NOTEPAD_SIZE bytes.
+ * @return    void
  */
-unsigned char SendStoreFinger(unsigned char IDStore, LPUART_t* LPUARTx, unsigned char ack[], unsigned int current_core_clock)
-{
-	sendFPHeader(LPUARTx);
-	unsigned char Sum= 0x01 + 0x00 + 0x06 + 0x06 + 0x01 +0x00 + IDStore;;
-	LPUART_send_byte(LPUARTx, 0x01);
-	LPUART_send_byte(LPUARTx, 0x00);
-	LPUART_send_byte(LPUARTx, 0x06);
-	LPUART_send_byte(LPUARTx, 0x06);
-	LPUART_send_byte(LPUARTx, 0x01);
-	LPUART_send_byte(LPUARTx, 0x00);
-	LPUART_send_byte(LPUARTx, IDStore);
-	LPUART_send_byte(LPUARTx, 0x00);
-	LPUART_send_byte(LPUARTx, Sum);
-	delay(2000, current_core_clock);
-	if(ack[1] == 0x07)
-    return ack[4];
-  else return FINGERPRINT_UNDEFINED_ERROR;
+void sendFPWriteNotepadCommand(LPUART_t* LPUARTx, unsigned char page, const unsigned char data[]){
+	unsigned char params[2 + FP_NOTEPAD_SIZE];
+	unsigned char i;
+	params[0] = 0x18;
+	params[1] = page;
+	for(i = 0; i < FP_NOTEPAD_SIZE; i++){
+		params[2 + i] = data[i];
+	}
+	sendFPPacket(LPUARTx, params, sizeof(params), page);
 }
 
 /*!
- * @brief Checks the fingerprint sensor's response and prints corresponding messages via LPUART.
+ * @brief     Sends the 'ReadNotepad' command without waiting for the reply.
  *
- * @detail This function interprets the response code from the fingerprint sensor and prints 
- *         an appropriate message over LPUART1. It handles various error and success cases.
+ * @detail    The FP_NOTEPAD_SIZE bytes of the page follow the confirmation code of the reply.
  *
- * @param[in] response The response code from the fingerprint sensor.
- * @return void
+ * @param[in] LPUARTx Pointer to the LPUART module.
+ * @param[in] page Notepad page, 0 to FP_NOTEPAD_PAGES - 1.
+ * @return    void
  */
-void check_response_fingerprint(unsigned char response) {
-    switch (response) {
-        case FINGERPRINT_OK:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_OK");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_RECEIVE_ERROR:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_RECEIVE_ERROR");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_NO_FINGER:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_NO_FINGER");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_IMAGE_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_IMAGE_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_IMAGE_TOO_LIGHT:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_IMAGE_TOO_LIGHT");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_IMAGE_TOO_BLURRY:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_IMAGE_TOO_BLURRY");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_IMAGE_AMORPHOUS:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_IMAGE_AMORPHOUS");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_IMAGE_TOO_SMALL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_IMAGE_TOO_SMALL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_UNMATCHED:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_UNMATCHED");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_NO_SEARCH:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_NO_SEARCH");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_MERGE_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_MERGE_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_ADDRESS_SN_OUT_OF_RANGE:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_ADDRESS_SN_OUT_OF_RANGE");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_TEMPLATE_ERROR:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_TEMPLATE_ERROR");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_UPLOAD_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_UPLOAD_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_CONTINUE_PACKET_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_CONTINUE_PACKET_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_IMAGE_UPLOAD_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_IMAGE_UPLOAD_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_DELETE_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_DELETE_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_DB_CLEAR_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_DB_CLEAR_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_LOW_POWER_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_LOW_POWER_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_PASSWORD_INCORRECT:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_PASSWORD_INCORRECT");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_RESET_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_RESET_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_NO_VALID_IMAGE:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_NO_VALID_IMAGE");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_UPGRADE_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_UPGRADE_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_INCOMPLETE:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_INCOMPLETE");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_FLASH_ERROR:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_FLASH_ERROR");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_CONTINUE_ACK_0XF0:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_CONTINUE_ACK_0XF0");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_CONTINUE_ACK_0XF1:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_CONTINUE_ACK_0XF1");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_SUM_ERROR:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_SUM_ERROR");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_PACKET_FLAG_ERROR:
-           LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_PACKET_FLAG_ERROR");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_PACKET_LENGTH_ERROR:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_PACKET_LENGTH_ERROR");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_CODE_LENGTH_ERROR:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_CODE_LENGTH_ERROR");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_FLASH_BURN_FAIL:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_FLASH_BURN_FAIL");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        case FINGERPRINT_UNDEFINED_ERROR:
-            LPUART_send_string(LPUART1, (unsigned char*)"FINGERPRINT_UNDEFINED_ERROR");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-        default:
-            LPUART_send_string(LPUART1, (unsigned char*)"UNKNOWN_RESPONSE_CODE");
-						LPUART_send_byte(LPUART1, 0x0A);
-            break;
-    }
+void sendFPReadNotepadCommand(LPUART_t* LPUARTx, unsigned char page){
+	unsigned char params[2] = {0x19, 0x00};
+	params[1] = page;
+	sendFPPacket(LPUARTx, params, sizeof(params), page);
 }
@@ -0,0 +1,87 @@
+/**
+*   @file    namepack.c
+*   @brief   Implementation of the 6-bit packed encoding of the user names.
+*   @details Characters outside the SIXBIT range are stored as '?', lowercase letters as
+*            their uppercase form.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "namepack.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define NAMEPACK_FIRST          0x20U           /* ASCII of code 0, the space */
+#define NAMEPACK_LAST           0x5FU           /* ASCII of code 63 */
+#define NAMEPACK_MASK           0x3FU
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Packs a name.
+ *
+ * @param[in]  name The name, NAMEPACK_MAX_LENGTH characters or null-terminated.
+ * @param[out] packed NAMEPACK_SIZE() bytes of the returned length, the unused bits cleared.
+ * @return    The length of the name in characters.
+ */
+unsigned char NamePack_Encode(const char *name, unsigned char *packed){
+    unsigned int bits = 0U;
+    unsigned char count = 0U;
+    unsigned char length;
+    unsigned char code;
+    unsigned char c;
+
+    for(length = 0U; (length < NAMEPACK_MAX_LENGTH) && (name[length] != '\0'); length++){
+        c = (unsigned char)name[length];
+        if((c >= 'a') && (c <= 'z')){
+            c = (unsigned char)(c - 'a' + 'A');
+        }
+        code = ((c >= NAMEPACK_FIRST) && (c <= NAMEPACK_LAST)) ? (unsigned char)(c - NAMEPACK_FIRST)
+                                                              : (unsigned char)('?' - NAMEPACK_FIRST);
+        bits |= (unsigned int)code << count;
+        count += 6U;
+        while(count >= 8U){
+            *packed++ = (unsigned char)bits;
+            bits >>= 8;
+            count -= 8U;
+        }
+    }
+    if(count > 0U){
+        *packed = (unsigned char)bits;
+    }
+    return length;
+}
+
+/*!
+ * @brief     Unpacks a name.
+ *
+ * @param[in]  packed The packed name.
+ * @param[in]  length Its length in characters, NAMEPACK_MAX_LENGTH at most.
+ * @param[out] name NAMEPACK_MAX_LENGTH characters, padded with null characters.
+ * @return    void
+ */
+void NamePack_Decode(const unsigned char *packed, unsigned char length, char *name){
+    unsigned int bits = 0U;
+    unsigned char count = 0U;
+    unsigned char i;
+
+    for(i = 0U; i < NAMEPACK_MAX_LENGTH; i++){
+        if(i >= length){
+            name[i] = '\0';
+            continue;
+        }
+        if(count < 6U){
+            bits |= (unsigned int)*packed++ << count;
+            count += 8U;
+        }
+        name[i] = (char)((bits & NAMEPACK_MASK) + NAMEPACK_FIRST);
+        bits >>= 6;
+        count -= 6U;
+    }
+}
@@ -0,0 +1,192 @@
+/**
+*   @file    power.c
+*   @brief   Implementation of the idle power manager.
+*   @details VLPS is entered from a SIRC run clock: the system clock is switched from SPLL to
+*            SIRC before the stop and back after the wake, once SOSC and SPLL are valid again.
+*            The SPLL and SOSC enables are left as they are, so the oscillators that were
+*            running restart by themselves on VLPS exit. In the low profile, where the SPLL is
+*            stopped, the wake does not wait for the crystal at all.
+*            LPTMR0 runs from the 1 kHz LPO, which keeps running in VLPS: it wakes the board at
+*            the next software deadline and tells how long the board slept.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "power.h"
+#include "core.h"
+#include "pcc.h"
+#include "clock.h"
+#include "lpuart.h"
+#include "smc_registers.h"
+#include "scb_registers.h"
+#include "dwt_registers.h"
+#include "lptmr_registers.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define POWER_SIRC_MHZ      8U              /* Core clock while the clocks are restored */
+#define POWER_SCS(rccr)     (((rccr) >> 24U) & 0xFU)    /* System clock source of an RCCR value */
+#define POWER_SCS_SOSC      1U
+#define POWER_SCS_SPLL      6U
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static volatile unsigned int hold_mask = 0;
+static power_stats_t stats;
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Initializes the power manager.
+ *
+ * @detail    Allows the very low power modes, enables the regulator bias they need and sets up
+ *            LPTMR0 as a 1 ms wake-up timer clocked by the LPO.
+ *
+ * @return    void
+ */
+void Power_Init(void){
+    SMC->PMPROT = SMC_PMPROT_AVLP;
+    PMC->REGSC |= PMC_REGSC_BIASEN;
+
+    PCC_EnableClock(&PCC->PCC_LPTMR0);
+    LPTMR0->CSR_Register = 0;
+    LPTMR0->PSR.PCS = LPTMR_PCS_LPO1K;
+    LPTMR0->PSR.PBYP = 1;               /* 1 count per ms */
+}
+
+/*!
+ * @brief     Prevents VLPS until the same reason is released.
+ *
+ * @param[in] reason: One of the POWER_HOLD_x bits.
+ * @return    void
+ */
+void Power_Hold(unsigned int reason){
+    unsigned int primask;
+    CORE_ENTER_CRITICAL(primask);
+    hold_mask |= reason;
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Releases a reason given to Power_Hold().
+ *
+ * @param[in] reason: One of the POWER_HOLD_x bits.
+ * @return    void
+ */
+void Power_Release(unsigned int reason){
+    unsigned int primask;
+    CORE_ENTER_CRITICAL(primask);
+    hold_mask &= ~reason;
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Sleeps until the next interrupt.
+ *
+ * @detail    Must be called with interrupts masked; the interrupt that ends the sleep is taken
+ *            when the caller unmasks them. With a hold, or a deadline closer than
+ *            POWER_VLPS_MIN_IDLE_MS, the core only stops with WFI. Otherwise the board enters
+ *            VLPS with LPTMR0 set to wake it at the deadline:
+ *            1. Waits for the console to finish its last byte and arms the LPUART1 RX edge wake.
+ *            2. Switches the system clock to SIRC.
+ *            3. Enters VLPS.
+ *            4. On wake, reads the time slept from LPTMR0 and restores the run clock. SOSC is
+ *               waited for only if the SPLL is enabled or the run clock is SOSC or SPLL, so a
+ *               wake in the low profile never hangs on a crystal that does not start.
+ *            The time from the wake to the restored run clock is recorded in the statistics.
+ *
+ * @param[in] idle_ms: Time to the next software deadline in ms, or POWER_IDLE_FOREVER.
+ * @return    Time spent in VLPS in ms, 0 after a WFI sleep.
+ */
+unsigned int Power_Idle(unsigned int idle_ms){
+    unsigned int rccr;
+    unsigned int spll_on;
+    unsigned int wake_cycles;
+    unsigned int slept_ms;
+    unsigned int wake_us;
+
+    if((hold_mask != 0U) || (idle_ms < POWER_VLPS_MIN_IDLE_MS)){
+        stats.wfi_count++;
+        CORE_WFI();
+        return 0U;
+    }
+
+    /* Step 1: Console and wake-up timer */
+    while(LPUART1->STAT.TC == 0){}
+    LPUART1->BAUD.RXEDGIE = 1;
+    LPTMR0->CSR_Register = 0;
+    LPTMR0->CMR = ((idle_ms > 0xFFFFU) ? 0xFFFFU : idle_ms) - 1U;
+    LPTMR0->CSR.TIE = 1;
+    LPTMR0->CSR.TEN = 1;
+
+    /* Step 2: Run from SIRC */
+    rccr = SCG->SCG_RCCR;
+    set_run_clock(SCG_RCCR_SIRC_8MHZ);
+
+    /* Step 3: VLPS */
+    SMC->PMCTRL.STOPM = SMC_STOPM_VLPS;
+    (void)SMC->PMCTRL_Register;         /* Make sure the mode is set before WFI */
+    SCB->SCR |= SCB_SCR_SLEEPDEEP;
+    CORE_WFI();
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP;
+    wake_cycles = DWT->CYCCNT;
+
+    /* Step 4: Time slept and run clock */
+    LPTMR0->CNR = 0;                    /* Latch the counter */
+    CORE_REG_WRITTEN(LPTMR0->CNR);
+    slept_ms = (LPTMR0->CSR.TCF != 0U) ? (LPTMR0->CMR + 1U) : LPTMR0->CNR;
+    LPTMR0->CSR_Register = 0;
+    LPUART1->BAUD.RXEDGIE = 0;
+    LPUART1->STAT.RXEDGIF = 1;
+
+    spll_on = SCG->SPLLCSR_bits.SPLLCSR_SPLLEN;
+    if(spll_on || (POWER_SCS(rccr) == POWER_SCS_SOSC) || (POWER_SCS(rccr) == POWER_SCS_SPLL)){
+        while(!(SCG->SOSCCSR_bits.SOSCCSR_SOSCVLD)){}
+    }
+    if(spll_on){
+        while(!(SCG->SPLLCSR_bits.SPLLCSR_SPLLVLD)){}
+    }
+    set_run_clock(rccr);
+
+    wake_us = (DWT->CYCCNT - wake_cycles) / POWER_SIRC_MHZ;
+    stats.vlps_count++;
+    stats.vlps_ms += slept_ms;
+    stats.wake_us_last = wake_us;
+    if(wake_us > stats.wake_us_max){
+        stats.wake_us_max = wake_us;
+    }
+    return slept_ms;
+}
+
+/*!
+ * @brief     Clears the wake-up timer flag.
+ *
+ * @detail    To be called by the LPTMR0 interrupt handler. Power_Idle() has already accounted
+ *            for the wake-up, the handler only acknowledges it.
+ *
+ * @return    void
+ */
+void Power_ClearWakeTimer(void){
+    LPTMR0->CSR.TCF = 1;
+}
+
+/*!
+ * @brief     Reads the idle statistics.
+ *
+ * @param[out] stats_out: Statistics.
+ * @return    void
+ */
+void Power_GetStats(power_stats_t *stats_out){
+    unsigned int primask;
+    CORE_ENTER_CRITICAL(primask);
+    *stats_out = stats;
+    CORE_EXIT_CRITICAL(primask);
+}
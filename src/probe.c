@@ -0,0 +1,142 @@
+/**
+*   @file    probe.c
+*   @brief   Implementation of the cycle-count profiling probes.
+*   @details The begin of a probe only stores the cycle counter; the end does the statistics,
+*            with a CLZ for the histogram bucket and no division.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "probe.h"
+
+#if PROBE_ENABLE
+
+#include "core.h"
+#include "dwt_registers.h"
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+typedef struct {
+    unsigned int start;                     /* Cycle counter at the begin */
+    unsigned char running;                  /* A begin is pending */
+    probe_stats_t stats;
+} probe_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static probe_t probes[PROBE_COUNT];
+
+static const char *const probe_names[PROBE_COUNT] = {
+    "fp reply", "lcd string", "lcd flush", "display time", "get key", "uart string"
+};
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Starts the DWT cycle counter and clears the statistics.
+ *
+ * @return    void
+ */
+void Probe_Init(void){
+    DEMCR |= DEMCR_TRCENA;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA;
+    Probe_Reset();
+}
+
+/*!
+ * @brief     Starts a measurement.
+ *
+ * @param[in]  id PROBE_xxx ID.
+ * @return    void
+ */
+void Probe_Begin(unsigned int id){
+    probes[id].start = DWT->CYCCNT;
+    probes[id].running = 1U;
+}
+
+/*!
+ * @brief     Ends a measurement and adds it to the statistics.
+ *
+ * @param[in]  id PROBE_xxx ID.
+ * @return    void
+ */
+void Probe_End(unsigned int id){
+    unsigned int cycles = DWT->CYCCNT;
+    probe_t *probe = &probes[id];
+
+    if(!probe->running){
+        return;
+    }
+    probe->running = 0U;
+    cycles -= probe->start;
+    if((probe->stats.count == 0U) || (cycles < probe->stats.min)){
+        probe->stats.min = cycles;
+    }
+    if(cycles > probe->stats.max){
+        probe->stats.max = cycles;
+    }
+    probe->stats.count++;
+    probe->stats.total += cycles;
+    probe->stats.buckets[31U - CORE_CLZ(cycles | 1U)]++;
+}
+
+/*!
+ * @brief     Copies the statistics of a probe.
+ *
+ * @param[in]  id PROBE_xxx ID.
+ * @param[out] stats The statistics.
+ * @return    void
+ */
+void Probe_GetStats(unsigned int id, probe_stats_t *stats){
+    unsigned int primask;
+
+    CORE_ENTER_CRITICAL(primask);
+    *stats = probes[id].stats;
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Returns the name of a probe, for the reports.
+ *
+ * @param[in]  id PROBE_xxx ID.
+ * @return    The name.
+ */
+const char *Probe_GetName(unsigned int id){
+    return probe_names[id];
+}
+
+/*!
+ * @brief     Clears the statistics of every probe.
+ *
+ * @detail    A pending begin is dropped.
+ *
+ * @return    void
+ */
+void Probe_Reset(void){
+    unsigned int primask;
+    unsigned int id;
+    unsigned int bucket;
+
+    CORE_ENTER_CRITICAL(primask);
+    for(id = 0U; id < PROBE_COUNT; id++){
+        probes[id].running = 0U;
+        probes[id].stats.count = 0U;
+        probes[id].stats.min = 0U;
+        probes[id].stats.max = 0U;
+        probes[id].stats.total = 0U;
+        for(bucket = 0U; bucket < PROBE_BUCKETS; bucket++){
+            probes[id].stats.buckets[bucket] = 0U;
+        }
+    }
+    CORE_EXIT_CRITICAL(primask);
+}
+
+#endif /* PROBE_ENABLE */
@@ -0,0 +1,378 @@
+/**
+*   @file    provision.c
+*   @brief   Implementation of the bulk stream of the user directory.
+*   @details The receiver keeps the CRC of the stream up to the last accepted batch and up to
+*            the batch before it, so that a batch sent again after a lost ACK is recognised
+*            and not applied twice. A batch is checked as a whole, records included, before
+*            any of it is handed to the application.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "provision.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define PROVISION_CRC_INIT      0xFFFFU
+#define PROVISION_CRC_POLY      0x1021U
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+typedef enum {
+    RX_TYPE = 0,              /* Waiting for a frame type */
+    RX_SEQ,
+    RX_LENGTH_HIGH,
+    RX_LENGTH_LOW,
+    RX_DATA,
+    RX_COUNT_HIGH,
+    RX_COUNT_LOW,
+    RX_CRC_HIGH,
+    RX_CRC_LOW
+} provision_rx_state_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static provision_rx_state_t rx_state = RX_TYPE;
+static unsigned char rx_type;
+static unsigned char rx_seq;
+static unsigned char rx_next_seq;               /* seq of the next new batch */
+static unsigned char rx_started;                /* A batch has been accepted */
+static unsigned char rx_batch[PROVISION_BATCH_SIZE];
+static unsigned short rx_length;                /* Of the batch, or the count of the end frame */
+static unsigned short rx_index;
+static unsigned short rx_frame_crc;             /* CRC field of the frame */
+static unsigned short rx_crc;                   /* Up to the last accepted batch */
+static unsigned short rx_prev_crc;              /* Up to the batch before it */
+static unsigned short rx_pending_crc;           /* Up to the batch being applied */
+static unsigned short rx_records;               /* Of the batch being applied */
+static unsigned short rx_read;                  /* Offset of the next record to read */
+static unsigned short rx_count;                 /* Records accepted */
+
+static unsigned char tx_frame[PROVISION_FRAME_SIZE];
+static unsigned short tx_length;                /* Record bytes of the batch being built */
+static unsigned short tx_crc;
+static unsigned char tx_seq;
+static unsigned short tx_count;
+
+/*==================================================================================================
+*                                       LOCAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Runs the CRC of the stream over bytes.
+ *
+ * @param[in]  crc The CRC so far.
+ * @param[in]  data The bytes.
+ * @param[in]  size Their number.
+ * @return    The CRC with the bytes.
+ */
+static unsigned short provision_crc(unsigned short crc, const unsigned char *data, unsigned int size){
+    unsigned char bit;
+
+    while(size > 0U){
+        crc ^= (unsigned short)(*data++ << 8);
+        for(bit = 0U; bit < 8U; bit++){
+            crc = (crc & 0x8000U) ? (unsigned short)((crc << 1) ^ PROVISION_CRC_POLY) : (unsigned short)(crc << 1);
+        }
+        size--;
+    }
+    return crc;
+}
+
+/*!
+ * @brief     Runs the CRC of the stream over a 16-bit field.
+ *
+ * @param[in]  crc The CRC so far.
+ * @param[in]  value The field.
+ * @return    The CRC with the field, most significant byte first.
+ */
+static unsigned short provision_crc_u16(unsigned short crc, unsigned int value){
+    unsigned char bytes[2];
+
+    bytes[0] = (unsigned char)(value >> 8);
+    bytes[1] = (unsigned char)value;
+    return provision_crc(crc, bytes, 2U);
+}
+
+/*!
+ * @brief     Counts the records of the received batch.
+ *
+ * @return    The number of records, 0xFFFF if the last one is cut or a name is too long.
+ */
+static unsigned short provision_count_records(void){
+    unsigned short offset = 0U;
+    unsigned short records = 0U;
+
+    while(offset < rx_length){
+        if((offset + PROVISION_RECORD_SIZE(0U) > rx_length) ||
+           (rx_batch[offset + 3U] > PROVISION_NAME_LENGTH) ||
+           (offset + PROVISION_RECORD_SIZE(rx_batch[offset + 3U]) > rx_length)){
+            return 0xFFFFU;
+        }
+        offset += (unsigned short)PROVISION_RECORD_SIZE(rx_batch[offset + 3U]);
+        records++;
+    }
+    return records;
+}
+
+/*!
+ * @brief     Checks a complete batch frame.
+ *
+ * @return    PROVISION_BATCH, PROVISION_REPEAT or PROVISION_BAD.
+ */
+static unsigned char provision_check_batch(void){
+    unsigned short crc;
+    unsigned char repeat;
+
+    if(rx_length > PROVISION_BATCH_SIZE){
+        return PROVISION_BAD;
+    }
+    repeat = (rx_started && (rx_seq == (unsigned char)(rx_next_seq - 1U))) ? 1U : 0U;
+    if(!repeat && (rx_seq != rx_next_seq)){
+        return PROVISION_BAD;
+    }
+    crc = provision_crc(repeat ? rx_prev_crc : rx_crc, &rx_seq, 1U);
+    crc = provision_crc_u16(crc, rx_length);
+    crc = provision_crc(crc, rx_batch, rx_length);
+    if(crc != rx_frame_crc){
+        return PROVISION_BAD;
+    }
+    if(repeat){
+        return PROVISION_REPEAT;
+    }
+    rx_records = provision_count_records();
+    if(rx_records == 0xFFFFU){
+        return PROVISION_BAD;
+    }
+    rx_pending_crc = crc;
+    rx_read = 0U;
+    return PROVISION_BATCH;
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Starts the reception of a stream.
+ *
+ * @return    void
+ */
+void Provision_RxStart(void){
+    rx_state = RX_TYPE;
+    rx_next_seq = 0U;
+    rx_started = 0U;
+    rx_crc = PROVISION_CRC_INIT;
+    rx_prev_crc = PROVISION_CRC_INIT;
+    rx_records = 0U;
+    rx_length = 0U;
+    rx_read = 0U;
+    rx_count = 0U;
+}
+
+/*!
+ * @brief     Feeds a byte of the stream to the receiver.
+ *
+ * @detail    Bytes outside a frame other than a frame type are ignored. A PROVISION_BATCH is
+ *            followed by Provision_NextRecord() until it returns 0, then by Provision_Accept()
+ *            if every record was applied; a batch that is not accepted is expected again.
+ *
+ * @param[in]  byte The byte received.
+ * @return    PROVISION_MORE until a frame is complete, then its outcome.
+ */
+unsigned char Provision_Receive(unsigned char byte){
+    switch(rx_state){
+    case RX_TYPE:
+        if((byte == PROVISION_FRAME_BATCH) || (byte == PROVISION_FRAME_END)){
+            rx_type = byte;
+            rx_state = (byte == PROVISION_FRAME_BATCH) ? RX_SEQ : RX_COUNT_HIGH;
+        }
+        break;
+    case RX_SEQ:
+        rx_seq = byte;
+        rx_state = RX_LENGTH_HIGH;
+        break;
+    case RX_LENGTH_HIGH:
+    case RX_COUNT_HIGH:
+        rx_length = (unsigned short)(byte << 8);
+        rx_state = (rx_state == RX_LENGTH_HIGH) ? RX_LENGTH_LOW : RX_COUNT_LOW;
+        break;
+    case RX_LENGTH_LOW:
+        rx_length |= byte;
+        rx_index = 0U;
+        rx_state = (rx_length > 0U) ? RX_DATA : RX_CRC_HIGH;
+        break;
+    case RX_COUNT_LOW:
+        rx_length |= byte;
+        rx_state = RX_CRC_HIGH;
+        break;
+    case RX_DATA:
+        if(rx_index < PROVISION_BATCH_SIZE){
+            rx_batch[rx_index] = byte;
+        }
+        if(++rx_index == rx_length){
+            rx_state = RX_CRC_HIGH;
+        }
+        break;
+    case RX_CRC_HIGH:
+        rx_frame_crc = (unsigned short)(byte << 8);
+        rx_state = RX_CRC_LOW;
+        break;
+    case RX_CRC_LOW:
+        rx_frame_crc |= byte;
+        rx_state = RX_TYPE;
+        if(rx_type == PROVISION_FRAME_BATCH){
+            return provision_check_batch();
+        }
+        return ((rx_length == rx_count) && (provision_crc_u16(rx_crc, rx_length) == rx_frame_crc))
+               ? PROVISION_END : PROVISION_END_BAD;
+    default:
+        rx_state = RX_TYPE;
+        break;
+    }
+    return PROVISION_MORE;
+}
+
+/*!
+ * @brief     Reads the next record of the batch received.
+ *
+ * @param[out] record The record.
+ * @return    1 if a record was read, 0 at the end of the batch.
+ */
+unsigned char Provision_NextRecord(provision_record_t *record){
+    const unsigned char *p = &rx_batch[rx_read];
+    unsigned char i;
+
+    if(rx_read >= rx_length){
+        return 0U;
+    }
+    record->user_id = (unsigned short)((p[0] << 8) | p[1]);
+    record->schedule = p[2];
+    for(i = 0U; i < PROVISION_NAME_LENGTH; i++){
+        record->name[i] = (i < p[3]) ? (char)p[4U + i] : '\0';
+    }
+    rx_read += (unsigned short)PROVISION_RECORD_SIZE(p[3]);
+    return 1U;
+}
+
+/*!
+ * @brief     Accepts the batch received once its records are applied.
+ *
+ * @return    void
+ */
+void Provision_Accept(void){
+    rx_prev_crc = rx_crc;
+    rx_crc = rx_pending_crc;
+    rx_count += rx_records;
+    rx_records = 0U;
+    rx_next_seq++;
+    rx_started = 1U;
+}
+
+/*!
+ * @brief     Returns the seq of the last batch frame received, for the reply.
+ *
+ * @return    The seq.
+ */
+unsigned char Provision_Sequence(void){
+    return rx_seq;
+}
+
+/*!
+ * @brief     Returns the number of records accepted since Provision_RxStart().
+ *
+ * @return    The number of records.
+ */
+unsigned short Provision_Count(void){
+    return rx_count;
+}
+
+/*!
+ * @brief     Starts the transmission of a stream.
+ *
+ * @return    void
+ */
+void Provision_TxStart(void){
+    tx_length = 0U;
+    tx_crc = PROVISION_CRC_INIT;
+    tx_seq = 0U;
+    tx_count = 0U;
+}
+
+/*!
+ * @brief     Adds a record to the batch being built.
+ *
+ * @param[in]  record The record, a name of PROVISION_NAME_LENGTH characters or null-terminated.
+ * @return    1 if it was added, 0 if the batch is full and must be sent first.
+ */
+unsigned char Provision_TxAdd(const provision_record_t *record){
+    unsigned char *p = &tx_frame[4U + tx_length];
+    unsigned char length;
+
+    for(length = 0U; (length < PROVISION_NAME_LENGTH) && (record->name[length] != '\0'); length++){
+    }
+    if(tx_length + PROVISION_RECORD_SIZE(length) > PROVISION_BATCH_SIZE){
+        return 0U;
+    }
+    p[0] = (unsigned char)(record->user_id >> 8);
+    p[1] = (unsigned char)record->user_id;
+    p[2] = record->schedule;
+    p[3] = length;
+    for(length = 0U; length < p[3]; length++){
+        p[4U + length] = (unsigned char)record->name[length];
+    }
+    tx_length += (unsigned short)PROVISION_RECORD_SIZE(p[3]);
+    tx_count++;
+    return 1U;
+}
+
+/*!
+ * @brief     Closes the batch being built.
+ *
+ * @param[out] frame The batch frame, valid until the next call of the module.
+ * @return    The size of the frame, 0 if the batch holds no record.
+ */
+unsigned int Provision_TxBatch(const unsigned char **frame){
+    unsigned int size;
+
+    if(tx_length == 0U){
+        return 0U;
+    }
+    tx_frame[0] = PROVISION_FRAME_BATCH;
+    tx_frame[1] = tx_seq++;
+    tx_frame[2] = (unsigned char)(tx_length >> 8);
+    tx_frame[3] = (unsigned char)tx_length;
+    tx_crc = provision_crc(tx_crc, &tx_frame[1], 3U + tx_length);
+    size = 4U + tx_length;
+    tx_frame[size++] = (unsigned char)(tx_crc >> 8);
+    tx_frame[size++] = (unsigned char)tx_crc;
+    tx_length = 0U;
+    *frame = tx_frame;
+    return size;
+}
+
+/*!
+ * @brief     Builds the end frame, once the last batch is sent.
+ *
+ * @param[out] frame The end frame, valid until the next call of the module.
+ * @return    The size of the frame.
+ */
+unsigned int Provision_TxEnd(const unsigned char **frame){
+    unsigned short crc = provision_crc_u16(tx_crc, tx_count);
+
+    tx_frame[0] = PROVISION_FRAME_END;
+    tx_frame[1] = (unsigned char)(tx_count >> 8);
+    tx_frame[2] = (unsigned char)tx_count;
+    tx_frame[3] = (unsigned char)(crc >> 8);
+    tx_frame[4] = (unsigned char)crc;
+    *frame = tx_frame;
+    return 5U;
+}
@@ -0,0 +1,268 @@
+/**
+*   @file    scheduler.c
+*   @brief   Implementation of the cooperative run-to-completion task scheduler.
+*   @details The scheduler keeps one pending-event mask per task and a ready bit mask. The
+*            dispatcher always runs the highest priority ready task (lowest task ID) and calls
+*            the idle hook when nothing is pending. Software timers are decremented from the
+*            SysTick interrupt and post their event to the owning task when they expire.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "scheduler.h"
+#include "core.h"
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/*!
+ * @brief One-shot software timer.
+ *
+ * @detail A timer is free when its event mask is 0. The remaining time is counted down by
+ *         Sched_Tick() once per millisecond.
+ */
+typedef struct {
+    unsigned int  remaining;    /*!< Milliseconds left before the event is posted */
+    unsigned int  event;        /*!< Event posted to the task on expiry, 0 if the timer is free */
+    unsigned char task_id;      /*!< Task that owns the timer */
+} sched_timer_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static sched_task_t tasks[SCHED_MAX_TASKS];
+static volatile unsigned int task_events[SCHED_MAX_TASKS];
+static volatile unsigned int ready_mask = 0;
+static sched_timer_t timers[SCHED_MAX_TIMERS];
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Initializes the scheduler.
+ *
+ * @detail    Removes all tasks, clears every pending event and stops all software timers.
+ *
+ * @return    void
+ */
+void Sched_Init(void){
+    unsigned char i;
+    for(i = 0; i < SCHED_MAX_TASKS; i++){
+        tasks[i] = 0;
+        task_events[i] = 0;
+    }
+    for(i = 0; i < SCHED_MAX_TIMERS; i++){
+        timers[i].event = 0;
+    }
+    ready_mask = 0;
+}
+
+/*!
+ * @brief     Registers a task.
+ *
+ * @detail    The task ID is also the task priority: ID 0 is dispatched before ID 1 and so on.
+ *
+ * @param[in] task_id: Task ID, from 0 to SCHED_MAX_TASKS - 1.
+ * @param[in] task:    Task entry point.
+ * @return    void
+ */
+void Sched_AddTask(unsigned char task_id, sched_task_t task){
+    if(task_id < SCHED_MAX_TASKS){
+        tasks[task_id] = task;
+    }
+}
+
+/*!
+ * @brief     Posts events to a task.
+ *
+ * @detail    The events are merged into the pending mask of the task and the task is marked
+ *            ready. This function may be called from interrupt handlers.
+ *
+ * @param[in] task_id: Task that receives the events.
+ * @param[in] events:  Bit mask of events to post.
+ * @return    void
+ */
+void Sched_PostEvent(unsigned char task_id, unsigned int events){
+    unsigned int primask;
+    if((task_id >= SCHED_MAX_TASKS) || (events == 0)){
+        return;
+    }
+    CORE_ENTER_CRITICAL(primask);
+    task_events[task_id] |= events;
+    ready_mask |= (1U << task_id);
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Starts a one-shot software timer.
+ *
+ * @detail    After ms milliseconds the event is posted to the task. Starting a timer that is
+ *            already running for the same task and event restarts it with the new delay.
+ *
+ * @param[in] task_id: Task that receives the event.
+ * @param[in] event:   Event to post on expiry.
+ * @param[in] ms:      Delay in milliseconds, 0 posts the event at the next tick.
+ * @return    void
+ */
+void Sched_StartTimer(unsigned char task_id, unsigned int event, unsigned int ms){
+    unsigned int primask;
+    unsigned char i;
+    unsigned char free_slot = SCHED_MAX_TIMERS;
+
+    CORE_ENTER_CRITICAL(primask);
+    for(i = 0; i < SCHED_MAX_TIMERS; i++){
+        if((timers[i].event == event) && (timers[i].task_id == task_id)){
+            free_slot = i;  /* Restart the running timer */
+            break;
+        }
+        if((timers[i].event == 0) && (free_slot == SCHED_MAX_TIMERS)){
+            free_slot = i;
+        }
+    }
+    if(free_slot < SCHED_MAX_TIMERS){
+        timers[free_slot].task_id = task_id;
+        timers[free_slot].event = event;
+        timers[free_slot].remaining = ms;
+    }
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Stops a software timer.
+ *
+ * @detail    Stops the timer that would post the event to the task. An event that already
+ *            expired and is pending is not removed.
+ *
+ * @param[in] task_id: Task that owns the timer.
+ * @param[in] event:   Event of the timer.
+ * @return    void
+ */
+void Sched_StopTimer(unsigned char task_id, unsigned int event){
+    unsigned int primask;
+    unsigned char i;
+
+    CORE_ENTER_CRITICAL(primask);
+    for(i = 0; i < SCHED_MAX_TIMERS; i++){
+        if((timers[i].event == event) && (timers[i].task_id == task_id)){
+            timers[i].event = 0;
+        }
+    }
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Stops a software timer and drops its event if it already expired.
+ *
+ * @detail    Unlike Sched_StopTimer(), an expired event still pending for the task is removed,
+ *            so a timer started later for the same event is not answered by the old one.
+ *
+ * @param[in] task_id: Task that owns the timer.
+ * @param[in] event:   Event of the timer.
+ * @return    void
+ */
+void Sched_CancelTimer(unsigned char task_id, unsigned int event){
+    unsigned int primask;
+
+    if(task_id >= SCHED_MAX_TASKS){
+        return;
+    }
+    CORE_ENTER_CRITICAL(primask);
+    Sched_StopTimer(task_id, event);
+    task_events[task_id] &= ~event;
+    if(task_events[task_id] == 0){
+        ready_mask &= ~(1U << task_id);
+    }
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Advances the software timers by one millisecond.
+ *
+ * @detail    Must be called from the SysTick interrupt handler. Expired timers post their event
+ *            and are freed.
+ *
+ * @return    void
+ */
+void Sched_Tick(void){
+    unsigned char i;
+    for(i = 0; i < SCHED_MAX_TIMERS; i++){
+        if(timers[i].event != 0){
+            if(timers[i].remaining > 0){
+                timers[i].remaining--;
+            }
+            if(timers[i].remaining == 0){
+                Sched_PostEvent(timers[i].task_id, timers[i].event);
+                timers[i].event = 0;
+            }
+        }
+    }
+}
+
+/*!
+ * @brief     Gives the time left before the next timer expires.
+ *
+ * @detail    Used by the idle hook to know how long the board may sleep.
+ *
+ * @return    Milliseconds to the first expiry, 0xFFFFFFFF when no timer runs.
+ */
+unsigned int Sched_NextTimeout(void){
+    unsigned int next = 0xFFFFFFFFU;
+    unsigned char i;
+    for(i = 0; i < SCHED_MAX_TIMERS; i++){
+        if((timers[i].event != 0) && (timers[i].remaining < next)){
+            next = timers[i].remaining;
+        }
+    }
+    return next;
+}
+
+/*!
+ * @brief     Idle hook.
+ *
+ * @detail    Called by the dispatcher with interrupts masked when no task is ready. The default
+ *            implementation sleeps with WFI; a pending interrupt wakes the core even though it
+ *            is masked, and it is serviced as soon as the dispatcher unmasks interrupts. The
+ *            application may provide its own implementation.
+ *
+ * @return    void
+ */
+__attribute__((weak)) void Sched_Idle(void){
+    CORE_WFI();
+}
+
+/*!
+ * @brief     Runs the dispatcher loop.
+ *
+ * @detail    Repeatedly takes the highest priority ready task, clears its pending events and
+ *            calls it with those events. This function never returns.
+ *
+ * @return    void
+ */
+void Sched_Run(void){
+    unsigned int primask;
+    unsigned int events;
+    unsigned char task_id;
+
+    while(1){
+        CORE_ENTER_CRITICAL(primask);
+        if(ready_mask == 0){
+            Sched_Idle();
+            CORE_EXIT_CRITICAL(primask);
+            continue;
+        }
+        for(task_id = 0; (ready_mask & (1U << task_id)) == 0; task_id++){}
+        events = task_events[task_id];
+        task_events[task_id] = 0;
+        ready_mask &= ~(1U << task_id);
+        CORE_EXIT_CRITICAL(primask);
+
+        if(tasks[task_id] != 0){
+            tasks[task_id](events);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/**
+*   @file    stack.c
+*   @brief   Implementation of the stack high-water marks.
+*   @details The stacks grow down, so the painted words left are counted from the lowest
+*            address up to the first word that was written.
+*
+*            The main stack is the ARM_LIB_STACK region of the scatter file. In a host build the
+*            main stack is the one of the host process and is not watched.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "stack.h"
+#include "core.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#ifndef HOST_BUILD
+/* Main stack region, from the linker */
+extern unsigned int Image$$ARM_LIB_STACK$$ZI$$Base[];
+extern unsigned int Image$$ARM_LIB_STACK$$ZI$$Limit[];
+
+#define MAIN_STACK_BASE         Image$$ARM_LIB_STACK$$ZI$$Base
+#define MAIN_STACK_WORDS        ((unsigned int)(Image$$ARM_LIB_STACK$$ZI$$Limit - Image$$ARM_LIB_STACK$$ZI$$Base))
+#endif
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Paints a stack that is not in use.
+ *
+ * @param[in]  base Lowest word of the stack.
+ * @param[in]  words Size of the stack in words.
+ * @return    void
+ */
+void Stack_Paint(unsigned int *base, unsigned int words){
+    unsigned int i;
+
+    for(i = 0U; i < words; i++){
+        base[i] = STACK_PAINT;
+    }
+}
+
+/*!
+ * @brief     Measures the high-water mark of a painted stack.
+ *
+ * @param[in]  base Lowest word of the stack.
+ * @param[in]  words Size of the stack in words.
+ * @return    The bytes written since the paint, from the top of the stack.
+ */
+unsigned int Stack_Used(const unsigned int *base, unsigned int words){
+    unsigned int unused = 0U;
+
+    while((unused < words) && (base[unused] == STACK_PAINT)){
+        unused++;
+    }
+    return (words - unused) * 4U;
+}
+
+/*!
+ * @brief     Paints the free part of the main stack.
+ *
+ * @detail    Paints from the bottom of the main stack up to the stack pointer; the frames of the
+ *            callers above it are in use and are counted as written. The loop makes no call,
+ *            whose frame would be below the stack pointer read. Must be called first in main(),
+ *            with the interrupts still masked by the reset handler.
+ *
+ * @return    void
+ */
+void Stack_PaintMain(void){
+#ifndef HOST_BUILD
+    unsigned int sp;
+    unsigned int *word;
+
+    CORE_GET_SP(sp);
+    for(word = MAIN_STACK_BASE; word < (unsigned int *)sp; word++){
+        *word = STACK_PAINT;
+    }
+#endif
+}
+
+/*!
+ * @brief     Measures the high-water mark of the main stack.
+ *
+ * @param[out] usage The size and the use of the main stack, 0 and 0 in a host build.
+ * @return    void
+ */
+void Stack_GetMainUsage(stack_usage_t *usage){
+#ifdef HOST_BUILD
+    usage->size = 0U;
+    usage->used = 0U;
+#else
+    usage->size = MAIN_STACK_WORDS * 4U;
+    usage->used = Stack_Used(MAIN_STACK_BASE, MAIN_STACK_WORDS);
+#endif
+}
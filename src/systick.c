@@ -3,6 +3,14 @@
 ==================================================================================================*/
 
 #include "systick.h"
+#include "clock.h"
+#include "core.h"
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static volatile unsigned int systick_ms = 0;   /* Milliseconds elapsed since SysTick_StartTick() */
 
 /*==================================================================================================
 *                                      GLOBAL FUNCTIONS
@@ -42,22 +50,69 @@ void SysTick_Disable(){
     SYSTICK->SYST_CSR.ENABLE = 0;
 }
 
+/*!
+ * @brief Starts the 1 ms system tick.
+ *
+ * This function programs the SysTick reload value for a 1 ms period at the current core clock
+ * and enables the SysTick exception. SysTick_Handler() must call SysTick_IncTick(). It must be
+ * called again after every change of the core clock.
+ */
+void SysTick_StartTick(void){
+    unsigned int core_clock = Clock_GetCoreFreq();
+    systick_config_t config;
+    config.clk_source = 1;               /* Use core clock as SysTick clock source */
+    config.interrupt_mode = 1;           /* Raise the SysTick exception every period */
+
+    SYSTICK->SYST_RVR.RELOAD = core_clock / 1000 - 1;
+    SYSTICK->SYST_CVR.CURRENT = 0;       /* Any write clears the counter */
+    SysTick_Init(config);
+}
+
+/*!
+ * @brief Advances the millisecond tick counter.
+ *
+ * This function must be called once per SysTick exception.
+ */
+void SysTick_IncTick(void){
+    systick_ms++;
+}
+
+/*!
+ * @brief Returns the number of milliseconds elapsed since SysTick_StartTick().
+ *
+ * The counter wraps around after about 49 days; compute intervals by subtraction.
+ *
+ * @return The millisecond tick counter.
+ */
+unsigned int SysTick_GetTick(void){
+    return systick_ms;
+}
+
 /*!
  * @brief Delays execution for a specified number of milliseconds.
  *
- * This function uses the SysTick timer to create a delay for a given number of milliseconds.
- * The delay is based on the provided core clock frequency.
+ * When the 1 ms tick is running the delay waits on the tick counter and leaves SysTick
+ * untouched. Otherwise the SysTick timer is programmed for a 1 ms period at the current core
+ * clock frequency and polled.
  *
  * @param[in] ms:         Number of milliseconds to delay.
- * @param[in] core_clock: The core clock frequency in Hz. Assumed to be 48 MHz.
  */
-void delay(unsigned int ms, unsigned int core_clock){
+void delay(unsigned int ms){
     systick_config_t config_ms;
+
+    if(SYSTICK->SYST_CSR.TICKINT){
+        unsigned int start = systick_ms;
+        while((systick_ms - start) < ms){
+            CORE_REG_READ(SYSTICK->SYST_CVR_Register);
+        }
+        return;
+    }
+
     config_ms.clk_source = 1;            /* Use core clock as SysTick clock source */
     config_ms.interrupt_mode = 0;        /* Disable SysTick interrupts */
     
     /* Set the reload value to generate 1 ms delay */
-    SYSTICK->SYST_RVR.RELOAD = core_clock / 1000 - 1;
+    SYSTICK->SYST_RVR.RELOAD = Clock_GetCoreFreq() / 1000 - 1;
     
     /* Initialize SysTick timer with the configuration */
     SysTick_Init(config_ms);
@@ -0,0 +1,192 @@
+/**
+*   @file    trace.c
+*   @brief   Implementation of the trace ring of the state transitions.
+*   @details The write count only grows; the slot of a record is the count modulo the ring
+*            size, so writers never wait for one another. A writer interrupted between its
+*            claim and its stores leaves its slot stale until it resumes, so a reader freezes
+*            the ring first (Trace_Freeze()); a reset in between leaves that one slot stale.
+*
+*            The SRAM ECC is not initialised by a power-on and a read of a word never written
+*            would be an ECC error, so after a power-on or a low voltage reset the ring is
+*            written before it is read. The other resets keep the RAM and its ECC.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "trace.h"
+#include "core.h"
+#include "systick.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define TRACE_MAGIC             0x54524331U     /* "TRC1", the ring holds records */
+#define TRACE_SLOT(count)       ((count) & (TRACE_RECORDS - 1U))
+
+/* Sticky reset source of the RCM: power-on and low voltage resets lose the RAM */
+#define RCM_SRS_POR             (1U << 7)
+#define RCM_SRS_LVD             (1U << 1)
+#ifdef HOST_BUILD
+#define TRACE_RAM_LOST()        0U
+#else
+#define RCM_SRS                 (*(volatile unsigned int*)(0x4007F008U))
+#define TRACE_RAM_LOST()        ((RCM_SRS & (RCM_SRS_POR | RCM_SRS_LVD)) != 0U)
+#endif /* HOST_BUILD */
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+typedef struct {
+    unsigned int magic;
+    unsigned int boots;                         /* Boots since the ring was cleared */
+    volatile unsigned int count;                /* Records written since the ring was cleared */
+    unsigned int slots[TRACE_RECORDS][2];       /* Millisecond, event | arg0 << 8 | arg1 << 16 */
+} trace_ring_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+/* Not zeroed at reset, see the scatter file */
+static trace_ring_t ring __attribute__((section(".bss.noinit")));
+static volatile unsigned char frozen = 0U;
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Keeps the ring of the previous boot if it is valid, and records the boot.
+ *
+ * @detail    Called once at boot, before any other Trace_xxx() call. The ring is not read
+ *            after a reset that lost the RAM.
+ *
+ * @return    void
+ */
+void Trace_Init(void){
+    if(TRACE_RAM_LOST() || (ring.magic != TRACE_MAGIC)){
+        Trace_Clear();
+    }
+    ring.boots++;
+    Trace_Record(TRACE_BOOT, 0U, (unsigned short)ring.boots);
+}
+
+/*!
+ * @brief     Appends a record to the ring.
+ *
+ * @detail    May be called from the threads and the interrupt handlers. Does nothing while
+ *            the ring is frozen.
+ *
+ * @param[in]  event TRACE_xxx ID.
+ * @param[in]  arg0 First argument of the event.
+ * @param[in]  arg1 Second argument of the event.
+ * @return    void
+ */
+void Trace_Record(unsigned char event, unsigned char arg0, unsigned short arg1){
+    unsigned int count;
+    unsigned int *slot;
+
+    if(frozen){
+        return;
+    }
+    CORE_FETCH_INC(ring.count, count);
+    slot = ring.slots[TRACE_SLOT(count)];
+    slot[0] = SysTick_GetTick();
+    slot[1] = (unsigned int)event | ((unsigned int)arg0 << 8) | ((unsigned int)arg1 << 16);
+}
+
+/*!
+ * @brief     Freezes the ring while it is read, or releases it.
+ *
+ * @detail    The events of a frozen ring are dropped.
+ *
+ * @param[in]  on 1 to freeze, 0 to record again.
+ * @return    void
+ */
+void Trace_Freeze(unsigned char on){
+    frozen = on;
+}
+
+/*!
+ * @brief     Empties the ring and restarts the boot count.
+ *
+ * @return    void
+ */
+void Trace_Clear(void){
+    unsigned int primask;
+
+    CORE_ENTER_CRITICAL(primask);
+    ring.count = 0U;
+    ring.boots = 0U;
+    ring.magic = TRACE_MAGIC;
+    CORE_EXIT_CRITICAL(primask);
+}
+
+/*!
+ * @brief     Gives the number of records held.
+ *
+ * @return    The records held, at most TRACE_RECORDS.
+ */
+unsigned int Trace_Count(void){
+    unsigned int count = ring.count;
+
+    return (count < TRACE_RECORDS) ? count : TRACE_RECORDS;
+}
+
+/*!
+ * @brief     Reads a record, the ring being frozen.
+ *
+ * @param[in]  index Record from the oldest held, below Trace_Count().
+ * @param[out] record The record.
+ * @return    void
+ */
+void Trace_Get(unsigned int index, trace_record_t *record){
+    const unsigned int *slot = ring.slots[TRACE_SLOT(ring.count - Trace_Count() + index)];
+
+    record->ms = slot[0];
+    record->event = (unsigned char)slot[1];
+    record->arg0 = (unsigned char)(slot[1] >> 8);
+    record->arg1 = (unsigned short)(slot[1] >> 16);
+}
+
+/*!
+ * @brief     Encodes the header of the dump stream, the ring being frozen.
+ *
+ * @param[out] out TRACE_DUMP_HEADER bytes.
+ * @return    TRACE_DUMP_HEADER
+ */
+unsigned int Trace_DumpHeader(unsigned char *out){
+    unsigned int count = Trace_Count();
+
+    out[0] = TRACE_DUMP_MAGIC;
+    out[1] = TRACE_DUMP_VERSION;
+    out[2] = (unsigned char)(count >> 8);
+    out[3] = (unsigned char)count;
+    return TRACE_DUMP_HEADER;
+}
+
+/*!
+ * @brief     Encodes a record for the dump stream, the ring being frozen.
+ *
+ * @param[in]  index Record from the oldest held, below Trace_Count().
+ * @param[out] out TRACE_DUMP_RECORD bytes.
+ * @return    TRACE_DUMP_RECORD
+ */
+unsigned int Trace_DumpRecord(unsigned int index, unsigned char *out){
+    trace_record_t record;
+
+    Trace_Get(index, &record);
+    out[0] = (unsigned char)(record.ms >> 24);
+    out[1] = (unsigned char)(record.ms >> 16);
+    out[2] = (unsigned char)(record.ms >> 8);
+    out[3] = (unsigned char)record.ms;
+    out[4] = record.event;
+    out[5] = record.arg0;
+    out[6] = (unsigned char)(record.arg1 >> 8);
+    out[7] = (unsigned char)record.arg1;
+    return TRACE_DUMP_RECORD;
+}
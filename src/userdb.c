@@ -0,0 +1,731 @@
+/**
+*   @file    userdb.c
+*   @brief   Implementation of the log-structured user database in program flash.
+*   @details Sector format (all multi-byte fields little-endian, every item a whole number of
+*            8-byte phrases, programmed once):
+*            - Phrase 0, header: 'U' 'D', sequence number (u16), 0, CRC, 0.
+*              The sector with the highest sequence number is the one being written.
+*            - USERDB_TAG_PUT, 16 bytes for a name of up to 12 characters, 24 bytes above: tag,
+*              name length, user ID (u16), packed name (namepack.h) padded with 0, CRC, 0.
+*            - USERDB_TAG_REF, 8 bytes: tag, owner ID bits 0-7, user ID (u16), owner ID bits
+*              8-15, CRC, 0. The user has the name of the owner, whose latest item is a PUT.
+*            - USERDB_TAG_DELETE, 8 bytes: tag, 0, user ID (u16), 0, CRC, 0.
+*            - USERDB_TAG_RETIRE, 8 bytes: tag, 0, sequence number (u16), 0, CRC, 0. Written
+*              when compaction has copied the live records of that sector, before it is erased:
+*              a sector whose erase was cut by a power loss is then never read again.
+*            The CRC (CRC-16/CCITT) covers the bytes before it; the zero byte after it is
+*            programmed with it and marks the item complete, since the CRC of a torn item could
+*            happen to equal the erased CRC field. An erased phrase ends the records of a sector;
+*            an item with a wrong CRC or marker was torn by a power cut and is skipped.
+*
+*            A name already held by another user is not stored again: the user gets a REF to
+*            that owner. Before an owner changes, the first user referring to it gets a PUT of
+*            the name and the others are pointed to that user, so every step keeps each user
+*            with its old or its new name across a power cut.
+*
+*            One erased sector is always kept for compaction: a change that would have to take
+*            it gets USERDB_FULL until compaction has freed a sector. The live records of all
+*            the users leave at least one sector of the others for old versions, so a round of
+*            compaction always frees a sector.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "userdb.h"
+#include "flash.h"
+#include "namepack.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#define USERDB_SECTOR_SIZE      FLASH_PFLASH_SECTOR
+#define USERDB_NO_SECTOR        0xFFU
+#define USERDB_NO_RECORD        0U              /* Offset 0 is a header, never a record */
+#define USERDB_NO_USER          0xFFFFU
+
+#define USERDB_TAG_PUT          0xA5U
+#define USERDB_TAG_REF          0xC3U
+#define USERDB_TAG_DELETE       0x5AU
+#define USERDB_TAG_RETIRE       0x3CU
+#define USERDB_SHORT_SIZE       8U              /* Header, reference, delete and retire items */
+#define USERDB_MAX_ITEM_SIZE    USERDB_PUT_SIZE(USERDB_NAME_LENGTH)
+#define USERDB_NAME_OFFSET      4U
+#define USERDB_TRAILER_SIZE     3U              /* CRC and marker */
+
+/* Size of a PUT item for a name length, rounded up to whole phrases */
+#define USERDB_PUT_SIZE(length) (((USERDB_NAME_OFFSET + NAMEPACK_SIZE(length) + USERDB_TRAILER_SIZE + \
+                                   FLASH_PHRASE_SIZE - 1U) / FLASH_PHRASE_SIZE) * FLASH_PHRASE_SIZE)
+
+/* Owner of a REF item */
+#define USERDB_REF_OWNER(p)     ((unsigned int)((p)[1] | ((p)[4] << 8)))
+
+/* Flash contents */
+#define USERDB_MAP(address)     FLASH_MAP(address)
+
+#if USERDB_NAME_LENGTH != NAMEPACK_MAX_LENGTH
+#error "The names are packed with namepack.h"
+#endif
+#if (USERDB_MAX_USERS * USERDB_MAX_ITEM_SIZE) > ((USERDB_SECTORS - 2U) * (USERDB_SECTOR_SIZE - FLASH_PHRASE_SIZE))
+#error "The live records must leave a sector for old versions besides the spare one"
+#endif
+#if (USERDB_SECTORS * USERDB_SECTOR_SIZE) > 0x10000U
+#error "The record offsets are 16-bit"
+#endif
+
+/*==================================================================================================
+*                                STRUCTURES AND OTHER TYPEDEFS
+==================================================================================================*/
+
+/* State of a sector */
+typedef enum {
+    USERDB_SECTOR_ERASED = 0,
+    USERDB_SECTOR_VALID,            /* Valid header, not retired */
+    USERDB_SECTOR_DIRTY             /* Neither erased nor valid: to be erased */
+} userdb_sector_state_t;
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static unsigned short record_offset[USERDB_MAX_USERS];     /* From USERDB_BASE, latest PUT or REF */
+static unsigned char sector_state[USERDB_SECTORS];
+static unsigned short sector_seq[USERDB_SECTORS];
+static unsigned char active = USERDB_NO_SECTOR;            /* Sector being written */
+static unsigned short write_offset;                        /* Next free offset in it */
+static unsigned short last_seq;                            /* Highest sequence number used */
+static unsigned char retire_seen;                          /* UserDb_Init() found a RETIRE item */
+static unsigned short retire_seq;                          /* Newest sequence number retired */
+
+/*==================================================================================================
+*                                       LOCAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Computes the CRC-16/CCITT of a buffer.
+ *
+ * @param[in]  data The buffer.
+ * @param[in]  size Its size in bytes.
+ * @return    The CRC.
+ */
+static unsigned short userdb_crc(const unsigned char *data, unsigned char size){
+    unsigned short crc = 0xFFFFU;
+    unsigned char bit;
+
+    while(size > 0U){
+        crc ^= (unsigned short)(*data++ << 8);
+        for(bit = 0U; bit < 8U; bit++){
+            crc = (crc & 0x8000U) ? (unsigned short)((crc << 1) ^ 0x1021U) : (unsigned short)(crc << 1);
+        }
+        size--;
+    }
+    return crc;
+}
+
+/*!
+ * @brief     Returns the flash address of an offset of the database.
+ *
+ * @param[in]  offset Offset from USERDB_BASE.
+ * @return    The address.
+ */
+static unsigned int userdb_address(unsigned int offset){
+    return USERDB_BASE + offset;
+}
+
+/*!
+ * @brief     Returns the size of an item from its first bytes.
+ *
+ * @param[in]  p The item.
+ * @return    The size, 0 for an unknown tag or a PUT with a bad name length.
+ */
+static unsigned char userdb_item_size(const unsigned char *p){
+    if(p[0] == USERDB_TAG_PUT){
+        return ((p[1] > 0U) && (p[1] <= USERDB_NAME_LENGTH)) ? (unsigned char)USERDB_PUT_SIZE(p[1]) : 0U;
+    }
+    if((p[0] == USERDB_TAG_REF) || (p[0] == USERDB_TAG_DELETE) || (p[0] == USERDB_TAG_RETIRE)){
+        return USERDB_SHORT_SIZE;
+    }
+    return 0U;
+}
+
+/*!
+ * @brief     Checks that an item is complete.
+ *
+ * @param[in]  p The item.
+ * @param[in]  size Its size.
+ * @return    1 if the CRC matches and the marker is programmed, 0 otherwise.
+ */
+static unsigned char userdb_item_ok(const unsigned char *p, unsigned char size){
+    unsigned short crc = userdb_crc(p, (unsigned char)(size - USERDB_TRAILER_SIZE));
+
+    return ((p[size - 3U] == (unsigned char)crc) && (p[size - 2U] == (unsigned char)(crc >> 8)) &&
+            (p[size - 1U] == 0U)) ? 1U : 0U;
+}
+
+/*!
+ * @brief     Writes the CRC and the marker of an item being built.
+ *
+ * @param[in,out] p The item, its trailing 3 bytes are written.
+ * @param[in]     size Its size.
+ * @return    void
+ */
+static void userdb_seal(unsigned char *p, unsigned char size){
+    unsigned short crc = userdb_crc(p, (unsigned char)(size - USERDB_TRAILER_SIZE));
+
+    p[size - 3U] = (unsigned char)crc;
+    p[size - 2U] = (unsigned char)(crc >> 8);
+    p[size - 1U] = 0U;
+}
+
+/*!
+ * @brief     Builds a sealed 8-byte item.
+ *
+ * @param[out] item The item.
+ * @param[in]  tag Its tag.
+ * @param[in]  id User ID or sequence number.
+ * @param[in]  extra Owner ID of a REF, 0 otherwise.
+ * @return    void
+ */
+static void userdb_short_item(unsigned char *item, unsigned char tag, unsigned int id, unsigned int extra){
+    item[0] = tag;
+    item[1] = (unsigned char)extra;
+    item[2] = (unsigned char)id;
+    item[3] = (unsigned char)(id >> 8);
+    item[4] = (unsigned char)(extra >> 8);
+    userdb_seal(item, USERDB_SHORT_SIZE);
+}
+
+/*!
+ * @brief     Tells whether a flash area is erased.
+ *
+ * @param[in]  offset Offset of the area from USERDB_BASE.
+ * @param[in]  size Its size.
+ * @return    1 if every byte is 0xFF, 0 otherwise.
+ */
+static unsigned char userdb_erased(unsigned int offset, unsigned int size){
+    const unsigned char *p = USERDB_MAP(userdb_address(offset));
+    unsigned int i;
+
+    for(i = 0U; i < size; i++){
+        if(p[i] != 0xFFU){
+            return 0U;
+        }
+    }
+    return 1U;
+}
+
+/*!
+ * @brief     Reads the state of a sector from its header.
+ *
+ * @param[in]  sector The sector.
+ * @return    void
+ */
+static void userdb_read_header(unsigned char sector){
+    const unsigned char *p = USERDB_MAP(userdb_address(sector * USERDB_SECTOR_SIZE));
+
+    if(userdb_erased(sector * USERDB_SECTOR_SIZE, USERDB_SECTOR_SIZE)){
+        sector_state[sector] = USERDB_SECTOR_ERASED;
+    }else if((p[0] == 'U') && (p[1] == 'D') && (p[4] == 0U) && userdb_item_ok(p, USERDB_SHORT_SIZE)){
+        sector_state[sector] = USERDB_SECTOR_VALID;
+        sector_seq[sector] = (unsigned short)(p[2] | (p[3] << 8));
+    }else{
+        sector_state[sector] = USERDB_SECTOR_DIRTY;
+    }
+}
+
+/*!
+ * @brief     Walks the items of a sector.
+ *
+ * @detail    With apply set, the PUT, REF and DELETE items update the index; otherwise only the
+ *            RETIRE items are looked at, to update retire_seen and retire_seq.
+ *
+ * @param[in]  sector A valid sector.
+ * @param[in]  apply 1 to update the index, 0 to look for RETIRE items.
+ * @return    Offset of the first free phrase of the sector, from the sector start.
+ */
+static unsigned short userdb_walk(unsigned char sector, unsigned char apply){
+    unsigned int base = sector * USERDB_SECTOR_SIZE;
+    unsigned int offset = FLASH_PHRASE_SIZE;
+    const unsigned char *p;
+    unsigned int id;
+    unsigned char size;
+
+    while(offset < USERDB_SECTOR_SIZE){
+        if(userdb_erased(base + offset, FLASH_PHRASE_SIZE)){
+            break;
+        }
+        p = USERDB_MAP(userdb_address(base + offset));
+        size = userdb_item_size(p);
+        if((size == 0U) || (offset + size > USERDB_SECTOR_SIZE)){
+            offset += FLASH_PHRASE_SIZE;            /* Garbage of a torn item */
+            continue;
+        }
+        if(userdb_item_ok(p, size)){
+            id = (unsigned int)(p[2] | (p[3] << 8));
+            if(p[0] == USERDB_TAG_RETIRE){
+                if(!apply && (!retire_seen || ((short)(id - retire_seq) > 0))){
+                    retire_seen = 1U;
+                    retire_seq = (unsigned short)id;
+                }
+            }else if(apply && (id < USERDB_MAX_USERS)){
+                record_offset[id] = (p[0] == USERDB_TAG_DELETE) ? USERDB_NO_RECORD
+                                                                : (unsigned short)(base + offset);
+            }
+        }
+        offset += size;
+    }
+    return (unsigned short)offset;
+}
+
+/*!
+ * @brief     Counts the sectors in a state.
+ *
+ * @param[in]  state The state.
+ * @return    The number of sectors.
+ */
+static unsigned char userdb_count(userdb_sector_state_t state){
+    unsigned char sector;
+    unsigned char count = 0U;
+
+    for(sector = 0U; sector < USERDB_SECTORS; sector++){
+        if(sector_state[sector] == state){
+            count++;
+        }
+    }
+    return count;
+}
+
+/*!
+ * @brief     Finds the valid sector with the lowest sequence number.
+ *
+ * @return    The sector, USERDB_NO_SECTOR if none is valid.
+ */
+static unsigned char userdb_oldest(void){
+    unsigned char sector;
+    unsigned char oldest = USERDB_NO_SECTOR;
+
+    for(sector = 0U; sector < USERDB_SECTORS; sector++){
+        if((sector_state[sector] == USERDB_SECTOR_VALID) &&
+           ((oldest == USERDB_NO_SECTOR) || ((short)(sector_seq[sector] - sector_seq[oldest]) < 0))){
+            oldest = sector;
+        }
+    }
+    return oldest;
+}
+
+/*!
+ * @brief     Programs an item at a database offset.
+ *
+ * @param[in]  offset Offset of the item, on a phrase boundary.
+ * @param[in]  item The item.
+ * @param[in]  size Its size, a multiple of FLASH_PHRASE_SIZE.
+ * @return    FLASH_OK or FLASH_ERROR.
+ */
+static unsigned char userdb_program(unsigned int offset, const unsigned char *item, unsigned char size){
+    unsigned char i;
+
+    for(i = 0U; i < size; i += FLASH_PHRASE_SIZE){
+        if(Flash_ProgramPFlashPhrase(userdb_address(offset + i), &item[i]) != FLASH_OK){
+            return FLASH_ERROR;
+        }
+    }
+    return FLASH_OK;
+}
+
+/*!
+ * @brief     Opens an erased sector for writing.
+ *
+ * @param[in]  reserve Erased sectors that must be left.
+ * @return    USERDB_OK, USERDB_FULL or USERDB_ERROR.
+ */
+static unsigned char userdb_open_sector(unsigned char reserve){
+    unsigned char header[USERDB_SHORT_SIZE];
+    unsigned char sector;
+
+    if(userdb_count(USERDB_SECTOR_ERASED) <= reserve){
+        return USERDB_FULL;
+    }
+    for(sector = 0U; sector_state[sector] != USERDB_SECTOR_ERASED; sector++){
+    }
+    last_seq++;
+    header[0] = 'U';
+    header[1] = 'D';
+    header[2] = (unsigned char)last_seq;
+    header[3] = (unsigned char)(last_seq >> 8);
+    header[4] = 0U;
+    userdb_seal(header, USERDB_SHORT_SIZE);
+    if(userdb_program(sector * USERDB_SECTOR_SIZE, header, USERDB_SHORT_SIZE) != FLASH_OK){
+        sector_state[sector] = USERDB_SECTOR_DIRTY;
+        return USERDB_ERROR;
+    }
+    sector_state[sector] = USERDB_SECTOR_VALID;
+    sector_seq[sector] = last_seq;
+    active = sector;
+    write_offset = FLASH_PHRASE_SIZE;
+    return USERDB_OK;
+}
+
+/*!
+ * @brief     Appends an item to the sector being written.
+ *
+ * @param[in]  item The sealed item.
+ * @param[in]  size Its size.
+ * @param[in]  reserve Erased sectors that must be left if a sector has to be opened: 1 for a
+ *                     change of a user, 0 for compaction.
+ * @param[out] offset Database offset of the item.
+ * @return    USERDB_OK, USERDB_FULL or USERDB_ERROR.
+ */
+static unsigned char userdb_append(const unsigned char *item, unsigned char size, unsigned char reserve,
+                                   unsigned short *offset){
+    unsigned char status;
+
+    if((active == USERDB_NO_SECTOR) || (write_offset + size > USERDB_SECTOR_SIZE)){
+        status = userdb_open_sector(reserve);
+        if(status != USERDB_OK){
+            return status;
+        }
+    }
+    *offset = (unsigned short)(active * USERDB_SECTOR_SIZE + write_offset);
+    write_offset += size;               /* A failed item is skipped like a torn one */
+    return (userdb_program(*offset, item, size) == FLASH_OK) ? USERDB_OK : USERDB_ERROR;
+}
+
+/*!
+ * @brief     Returns the latest item of a user.
+ *
+ * @param[in]  user_id Fingerprint ID, in range.
+ * @return    The PUT or REF item, 0 if the user has no record.
+ */
+static const unsigned char *userdb_item(unsigned int user_id){
+    if(record_offset[user_id] == USERDB_NO_RECORD){
+        return 0;
+    }
+    return USERDB_MAP(userdb_address(record_offset[user_id]));
+}
+
+/*!
+ * @brief     Returns the item holding the name of a user, following a REF to its owner.
+ *
+ * @param[in]  user_id Fingerprint ID, in range.
+ * @return    The PUT item, 0 if the user has no name.
+ */
+static const unsigned char *userdb_name_item(unsigned int user_id){
+    const unsigned char *p = userdb_item(user_id);
+
+    if((p != 0) && (p[0] == USERDB_TAG_REF)){
+        p = (USERDB_REF_OWNER(p) < USERDB_MAX_USERS) ? userdb_item(USERDB_REF_OWNER(p)) : 0;
+    }
+    return ((p != 0) && (p[0] == USERDB_TAG_PUT)) ? p : 0;
+}
+
+/*!
+ * @brief     Tells whether a PUT item holds a given packed name.
+ *
+ * @param[in]  p The PUT item, or 0.
+ * @param[in]  length Length of the name.
+ * @param[in]  packed The packed name, its unused bits cleared.
+ * @return    1 if it does, 0 otherwise.
+ */
+static unsigned char userdb_same_name(const unsigned char *p, unsigned char length, const unsigned char *packed){
+    unsigned char i;
+
+    if((p == 0) || (p[1] != length)){
+        return 0U;
+    }
+    for(i = 0U; i < NAMEPACK_SIZE(length); i++){
+        if(p[USERDB_NAME_OFFSET + i] != packed[i]){
+            return 0U;
+        }
+    }
+    return 1U;
+}
+
+/*!
+ * @brief     Appends a new version of a user and makes it the latest one.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @param[in]  item The sealed PUT, REF or DELETE item.
+ * @param[in]  size Its size.
+ * @return    USERDB_OK, USERDB_FULL or USERDB_ERROR.
+ */
+static unsigned char userdb_set(unsigned int user_id, const unsigned char *item, unsigned char size){
+    unsigned short offset;
+    unsigned char status = userdb_append(item, size, 1U, &offset);
+
+    if(status == USERDB_OK){
+        record_offset[user_id] = (item[0] == USERDB_TAG_DELETE) ? USERDB_NO_RECORD : offset;
+    }
+    return status;
+}
+
+/*!
+ * @brief     Moves the users that share the name of a user away from it before it changes.
+ *
+ * @detail    The first user referring to it gets a PUT of the name, the others a REF to that
+ *            user.
+ *
+ * @param[in]  user_id Fingerprint ID, in range.
+ * @return    USERDB_OK, USERDB_FULL or USERDB_ERROR.
+ */
+static unsigned char userdb_release(unsigned int user_id){
+    unsigned char item[USERDB_MAX_ITEM_SIZE];
+    const unsigned char *owner = userdb_item(user_id);
+    const unsigned char *p;
+    unsigned int heir = USERDB_NO_USER;
+    unsigned int id;
+    unsigned char status;
+    unsigned char size;
+    unsigned char i;
+
+    if((owner == 0) || (owner[0] != USERDB_TAG_PUT)){
+        return USERDB_OK;
+    }
+    for(id = 0U; id < USERDB_MAX_USERS; id++){
+        p = userdb_item(id);
+        if((p == 0) || (p[0] != USERDB_TAG_REF) || (USERDB_REF_OWNER(p) != user_id)){
+            continue;
+        }
+        if(heir == USERDB_NO_USER){
+            size = userdb_item_size(owner);
+            for(i = 0U; i < size; i++){
+                item[i] = owner[i];
+            }
+            item[2] = (unsigned char)id;
+            item[3] = (unsigned char)(id >> 8);
+            userdb_seal(item, size);
+            heir = id;
+        }else{
+            size = USERDB_SHORT_SIZE;
+            userdb_short_item(item, USERDB_TAG_REF, id, heir);
+        }
+        status = userdb_set(id, item, size);
+        if(status != USERDB_OK){
+            return status;
+        }
+    }
+    return USERDB_OK;
+}
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Builds the index of the database from the flash.
+ *
+ * @detail    Reads every sector once. The sectors are applied oldest first, so the latest
+ *            version of each user wins; retired sectors are left for UserDb_Service() to erase.
+ *
+ * @return    void
+ */
+void UserDb_Init(void){
+    unsigned char sector;
+    unsigned char next;
+    unsigned char count;
+    unsigned int id;
+
+    for(id = 0U; id < USERDB_MAX_USERS; id++){
+        record_offset[id] = USERDB_NO_RECORD;
+    }
+    active = USERDB_NO_SECTOR;
+    last_seq = 0xFFFFU;                 /* The first sector opened gets sequence number 0 */
+    retire_seen = 0U;
+    for(sector = 0U; sector < USERDB_SECTORS; sector++){
+        userdb_read_header(sector);
+        if(sector_state[sector] == USERDB_SECTOR_VALID){
+            (void)userdb_walk(sector, 0U);
+        }
+    }
+
+    /* Drop the retired sectors, which are always the oldest ones */
+    if(retire_seen){
+        last_seq = retire_seq;
+        for(sector = 0U; sector < USERDB_SECTORS; sector++){
+            if((sector_state[sector] == USERDB_SECTOR_VALID) &&
+               ((short)(sector_seq[sector] - retire_seq) <= 0)){
+                sector_state[sector] = USERDB_SECTOR_DIRTY;
+            }
+        }
+    }
+
+    /* Apply the others oldest first; the newest one is the sector being written */
+    for(count = userdb_count(USERDB_SECTOR_VALID); count > 0U; count--){
+        next = USERDB_NO_SECTOR;
+        for(sector = 0U; sector < USERDB_SECTORS; sector++){
+            if((sector_state[sector] == USERDB_SECTOR_VALID) &&
+               ((active == USERDB_NO_SECTOR) || ((short)(sector_seq[sector] - last_seq) > 0)) &&
+               ((next == USERDB_NO_SECTOR) || ((short)(sector_seq[sector] - sector_seq[next]) < 0))){
+                next = sector;
+            }
+        }
+        active = next;
+        last_seq = sector_seq[active];
+        write_offset = userdb_walk(active, 1U);
+    }
+}
+
+/*!
+ * @brief     Reads the name of a user.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @param[out] name USERDB_NAME_LENGTH characters, padded with null characters.
+ * @return    USERDB_OK, USERDB_NOT_FOUND if the user has no record or USERDB_INVALID.
+ */
+unsigned char UserDb_GetName(unsigned int user_id, char *name){
+    const unsigned char *p;
+
+    if(user_id >= USERDB_MAX_USERS){
+        return USERDB_INVALID;
+    }
+    p = userdb_name_item(user_id);
+    if(p == 0){
+        return USERDB_NOT_FOUND;
+    }
+    NamePack_Decode(&p[USERDB_NAME_OFFSET], p[1], name);
+    return USERDB_OK;
+}
+
+/*!
+ * @brief     Saves a user.
+ *
+ * @detail    Nothing is written if the user already has this name. A name held by another
+ *            user costs a REF of one phrase; otherwise the packed name takes 2 phrases, 3 for
+ *            more than 12 characters. Users sharing the old name are moved first, see
+ *            userdb_release(). Blocks for the program time of each phrase.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @param[in]  name The name, padded with null characters to USERDB_NAME_LENGTH.
+ * @return    USERDB_OK, USERDB_INVALID (also for an empty name), USERDB_FULL or USERDB_ERROR.
+ */
+unsigned char UserDb_Put(unsigned int user_id, const char *name){
+    unsigned char item[USERDB_MAX_ITEM_SIZE];
+    const unsigned char *p;
+    unsigned char length;
+    unsigned char status;
+    unsigned char size;
+    unsigned char i;
+    unsigned int id;
+
+    if(user_id >= USERDB_MAX_USERS){
+        return USERDB_INVALID;
+    }
+    for(i = 0U; i < USERDB_MAX_ITEM_SIZE; i++){
+        item[i] = 0U;
+    }
+    length = NamePack_Encode(name, &item[USERDB_NAME_OFFSET]);
+    if(length == 0U){
+        return USERDB_INVALID;
+    }
+    if(userdb_same_name(userdb_name_item(user_id), length, &item[USERDB_NAME_OFFSET])){
+        return USERDB_OK;
+    }
+    status = userdb_release(user_id);
+    if(status != USERDB_OK){
+        return status;
+    }
+
+    /* Share the name of a user that already has it */
+    for(id = 0U; id < USERDB_MAX_USERS; id++){
+        p = userdb_item(id);
+        if((id != user_id) && (p != 0) && (p[0] == USERDB_TAG_PUT) &&
+           userdb_same_name(p, length, &item[USERDB_NAME_OFFSET])){
+            userdb_short_item(item, USERDB_TAG_REF, user_id, id);
+            return userdb_set(user_id, item, USERDB_SHORT_SIZE);
+        }
+    }
+
+    item[0] = USERDB_TAG_PUT;
+    item[1] = length;
+    item[2] = (unsigned char)user_id;
+    item[3] = (unsigned char)(user_id >> 8);
+    size = (unsigned char)USERDB_PUT_SIZE(length);
+    userdb_seal(item, size);
+    return userdb_set(user_id, item, size);
+}
+
+/*!
+ * @brief     Deletes a user.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @return    USERDB_OK, USERDB_INVALID, USERDB_FULL or USERDB_ERROR.
+ */
+unsigned char UserDb_Delete(unsigned int user_id){
+    unsigned char item[USERDB_SHORT_SIZE];
+    unsigned char status;
+
+    if(user_id >= USERDB_MAX_USERS){
+        return USERDB_INVALID;
+    }
+    if(record_offset[user_id] == USERDB_NO_RECORD){
+        return USERDB_OK;
+    }
+    status = userdb_release(user_id);
+    if(status != USERDB_OK){
+        return status;
+    }
+    userdb_short_item(item, USERDB_TAG_DELETE, user_id, 0U);
+    return userdb_set(user_id, item, USERDB_SHORT_SIZE);
+}
+
+/*!
+ * @brief     Runs one step of the background work.
+ *
+ * @detail    A step erases a retired or damaged sector, or copies one live record of the
+ *            oldest sector forward when the spare sector is the only erased one left, or
+ *            retires that sector once it holds no live record. An erase masks the interrupts
+ *            for several milliseconds, see Flash_ErasePFlashSector(), so it only runs when the
+ *            caller allows it; nothing else is done while a sector waits for one.
+ *
+ * @param[in]  may_erase 1 if a sector may be erased in this step.
+ * @return    USERDB_SERVICE_MORE while work remains, USERDB_SERVICE_ERASE if a sector waits for
+ *            an erase that was not allowed, USERDB_SERVICE_FAILED if the erase failed,
+ *            USERDB_SERVICE_DONE otherwise.
+ */
+unsigned char UserDb_Service(unsigned char may_erase){
+    unsigned char item[USERDB_SHORT_SIZE];
+    const unsigned char *p;
+    unsigned char sector;
+    unsigned char oldest;
+    unsigned short offset;
+    unsigned int start;
+    unsigned int id;
+
+    for(sector = 0U; sector < USERDB_SECTORS; sector++){
+        if(sector_state[sector] == USERDB_SECTOR_DIRTY){
+            if(!may_erase){
+                return USERDB_SERVICE_ERASE;
+            }
+            (void)Flash_ErasePFlashSector(userdb_address(sector * USERDB_SECTOR_SIZE));
+            userdb_read_header(sector);
+            if(sector_state[sector] != USERDB_SECTOR_ERASED){
+                sector_state[sector] = USERDB_SECTOR_DIRTY;     /* Retried on a later step */
+                return USERDB_SERVICE_FAILED;
+            }
+            return USERDB_SERVICE_MORE;
+        }
+    }
+    oldest = userdb_oldest();
+    if((userdb_count(USERDB_SECTOR_ERASED) > 1U) || (oldest == active)){
+        return USERDB_SERVICE_DONE;
+    }
+
+    start = oldest * USERDB_SECTOR_SIZE;
+    for(id = 0U; id < USERDB_MAX_USERS; id++){
+        if((record_offset[id] != USERDB_NO_RECORD) && (record_offset[id] >= start) &&
+           (record_offset[id] < start + USERDB_SECTOR_SIZE)){
+            p = userdb_item(id);
+            if(userdb_append(p, userdb_item_size(p), 0U, &offset) == USERDB_OK){
+                record_offset[id] = offset;
+            }
+            return USERDB_SERVICE_MORE;
+        }
+    }
+
+    userdb_short_item(item, USERDB_TAG_RETIRE, sector_seq[oldest], 0U);
+    if(userdb_append(item, USERDB_SHORT_SIZE, 0U, &offset) == USERDB_OK){
+        sector_state[oldest] = USERDB_SECTOR_DIRTY;
+    }
+    return USERDB_SERVICE_MORE;
+}
@@ -0,0 +1,152 @@
+/**
+*   @file    users.c
+*   @brief   Implementation of the persistent user names and access schedules.
+*   @details The names are kept by the user database in program flash (userdb.h), packed 6
+*            bits per character; a user without a record has an empty name. The schedule of
+*            user n is the byte at n in the FlexRAM; the EEE is written by 32-bit words, so a
+*            schedule is saved as the word that holds it.
+*/
+
+/*==================================================================================================
+*                                        INCLUDE FILES
+==================================================================================================*/
+
+#include "users.h"
+#include "userdb.h"
+#include "flash.h"
+
+/*==================================================================================================
+*                                      DEFINES AND MACROS
+==================================================================================================*/
+
+#if (USERS_MAX_USERS > USERDB_MAX_USERS) || (USERS_NAME_LENGTH != USERDB_NAME_LENGTH)
+#error "The user names do not fit in the user database"
+#endif
+#if USERS_MAX_USERS > FLASH_EEE_SIZE
+#error "The schedules do not fit in the EEPROM emulation"
+#endif
+
+#define USERS_SCHEDULE_ADDRESS(id) (FLASH_FLEXRAM_BASE + (id))
+
+/*==================================================================================================
+*                                       STATIC VARIABLES
+==================================================================================================*/
+
+static unsigned char schedules_kept = 0U;     /* The FlexRAM is EEPROM, not plain RAM */
+
+/*==================================================================================================
+*                                       GLOBAL FUNCTIONS
+==================================================================================================*/
+
+/*!
+ * @brief     Makes the user names and schedules available.
+ *
+ * @detail    Starts the EEPROM emulation, see Flash_EeeInit(), which partitions the FlexNVM
+ *            on the first boot of a device, and rebuilds the index of the user database, see
+ *            UserDb_Init(). Called before the FlexNVM is used otherwise.
+ *
+ * @return    USERS_OK, or USERS_ERROR if the EEE could not be started: no schedule is
+ *            read or saved then.
+ */
+unsigned char Users_Init(void){
+    schedules_kept = (Flash_EeeInit() == FLASH_OK) ? 1U : 0U;
+    UserDb_Init();
+    return schedules_kept ? USERS_OK : USERS_ERROR;
+}
+
+/*!
+ * @brief     Reads the name of a user.
+ *
+ * @detail    The user database unpacks the name straight from flash into the buffer.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @param[out] name USERS_NAME_LENGTH characters, padded with null characters; empty for a user
+ *                  out of range or without a name.
+ * @return     void
+ */
+void Users_GetName(unsigned int user_id, char *name){
+    unsigned char i;
+
+    if((user_id < USERS_MAX_USERS) && (UserDb_GetName(user_id, name) == USERDB_OK)){
+        return;
+    }
+    for(i = 0U; i < USERS_NAME_LENGTH; i++){
+        name[i] = '\0';
+    }
+}
+
+/*!
+ * @brief     Saves the name of a user.
+ *
+ * @detail    Appends a new version of the user to the database, where an empty name deletes
+ *            the user; saving the same name writes nothing. Blocks for about 100 us per phrase
+ *            written.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @param[in]  name The name, padded with null characters to USERS_NAME_LENGTH.
+ * @return     USERS_OK, USERS_INVALID or USERS_ERROR.
+ */
+unsigned char Users_SetName(unsigned int user_id, const char *name){
+    unsigned char status;
+
+    if(user_id >= USERS_MAX_USERS){
+        return USERS_INVALID;
+    }
+    status = (name[0] == '\0') ? UserDb_Delete(user_id) : UserDb_Put(user_id, name);
+    return (status == USERDB_OK) ? USERS_OK : USERS_ERROR;
+}
+
+/*!
+ * @brief     Reads the schedule of a user.
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @return     The schedule saved, USERS_NO_SCHEDULE for a user who has none, a user out of
+ *             range, or when the EEE is not started.
+ */
+unsigned char Users_GetSchedule(unsigned int user_id){
+    if((user_id >= USERS_MAX_USERS) || !schedules_kept){
+        return USERS_NO_SCHEDULE;
+    }
+    return *FLASH_MAP(USERS_SCHEDULE_ADDRESS(user_id));
+}
+
+/*!
+ * @brief     Saves the schedule of a user.
+ *
+ * @detail    Nothing is written when the schedule does not change; otherwise blocks for about
+ *            100 us, see Flash_EeeWrite().
+ *
+ * @param[in]  user_id Fingerprint ID.
+ * @param[in]  schedule The schedule, USERS_NO_SCHEDULE to forget it.
+ * @return     USERS_OK, USERS_INVALID or USERS_ERROR.
+ */
+unsigned char Users_SetSchedule(unsigned int user_id, unsigned char schedule){
+    unsigned int word;
+    unsigned char *bytes = (unsigned char *)&word;
+    unsigned int address = USERS_SCHEDULE_ADDRESS(user_id) & ~3U;
+    unsigned char i;
+
+    if(user_id >= USERS_MAX_USERS){
+        return USERS_INVALID;
+    }
+    if(!schedules_kept){
+        return USERS_ERROR;
+    }
+    for(i = 0U; i < 4U; i++){
+        bytes[i] = FLASH_MAP(address)[i];
+    }
+    bytes[user_id & 3U] = schedule;
+    return (Flash_EeeWrite(address, bytes, 4U) == FLASH_OK) ? USERS_OK : USERS_ERROR;
+}
+
+/*!
+ * @brief     Runs one step of the background work of the store.
+ *
+ * @detail    The compaction of the user database, see UserDb_Service().
+ *
+ * @param[in]  may_erase 1 if a flash sector may be erased in this step.
+ * @return    One of USERS_SERVICE_x.
+ */
+unsigned char Users_Service(unsigned char may_erase){
+    return UserDb_Service(may_erase);
+}